@@ -0,0 +1,402 @@
+/*
+ * ai.cc - Computer controlled players
+ *
+ * Copyright (C) 2026  freeserf developers
+ *
+ * This file is part of freeserf.
+ *
+ * freeserf is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * freeserf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with freeserf.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/ai.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "src/pathfinder.h"
+#include "src/thread-pool.h"
+
+/* Number of ticks between the plans of a player. */
+#define AI_PLAN_INTERVAL  300
+/* Number of map positions to scan between checks of the budget. */
+#define AI_SCAN_CHUNK  64
+/* Number of spiral positions to search for a flag to connect to. */
+#define AI_FLAG_SEARCH  61
+/* Maximum number of buildings under construction at once. */
+#define AI_MAX_CONSTRUCTION  4
+/* Minimum number of knights to send to an attack. */
+#define AI_MIN_ATTACKERS  2
+
+AI::Budget::Budget(unsigned int usec)
+  : deadline(Clock::now() + std::chrono::microseconds(usec))
+  , unlimited(usec == 0) {
+}
+
+AIBasic::AIBasic()
+  : phase(PhaseStart)
+  , cursor(0)
+  , wanted(Building::TypeNone) {
+}
+
+bool
+AIBasic::plan(Game *game, Player *player, const Budget &budget,
+              Actions *actions) {
+  PMap map = game->get_map();
+  unsigned int size = map->get_cols() * map->get_rows();
+
+  if (phase == PhaseStart) {
+    cursor = 0;
+    wanted = Building::TypeNone;
+    targets.clear();
+    phase = player->has_castle() ? PhaseBuilding : PhaseCastle;
+  }
+
+  if (phase == PhaseCastle) {
+    MapPos pos = bad_map_pos;
+    if (find_castle_pos(game, player, budget, &pos)) {
+      actions->push_back([pos](Game *game, Player *player) {
+        if (game->can_build_castle(pos, player)) {
+          game->build_castle(pos, player);
+        }
+      });
+    } else if (cursor < size) {
+      return false;
+    }
+
+    /* Nothing else to do before the castle is built. */
+    phase = PhaseStart;
+    return true;
+  }
+
+  if (phase == PhaseBuilding) {
+    if (cursor == 0 && wanted == Building::TypeNone) {
+      wanted = choose_building(player);
+    }
+
+    MapPos pos = bad_map_pos;
+    Road road;
+    if (wanted == Building::TypeNone) {
+      /* Wait for the current construction to complete. */
+    } else if (find_building_pos(game, player, budget, &pos, &road)) {
+      Building::Type type = wanted;
+      actions->push_back([pos, type, road](Game *game, Player *player) {
+        if (!game->build_building(pos, type, player)) {
+          return;
+        }
+        if (road.is_valid() && !game->build_road(road, player)) {
+          game->demolish_building(pos, player);
+        }
+      });
+    } else if (cursor < size) {
+      return false;
+    }
+
+    cursor = 0;
+    find_attack_targets(game, player);
+    phase = PhaseAttack;
+  }
+
+  /* Attack the first target that enough knights are available for. */
+  while (!targets.empty()) {
+    if (budget.expired()) {
+      return false;
+    }
+
+    MapPos pos = targets.front();
+    targets.pop_front();
+    if (player->knights_available_for_attack(pos) < AI_MIN_ATTACKERS) {
+      continue;
+    }
+
+    /* Checked again as the attack box does, the game went on since. */
+    actions->push_back([pos](Game *game, Player *player) {
+      PMap map = game->get_map();
+      if (!map->has_building(pos)) {
+        return;
+      }
+      Building *building = game->get_building(map->get_obj_index(pos));
+      if (!player->can_attack(building)) {
+        return;
+      }
+      if (player->prepare_attack(building) < AI_MIN_ATTACKERS ||
+          player->attacking_building_count == 0) {
+        return;
+      }
+      player->start_attack();
+    });
+    break;
+  }
+
+  phase = PhaseStart;
+  return true;
+}
+
+/* Decide what to build next, or TypeNone to let the current construction
+   finish first. */
+Building::Type
+AIBasic::choose_building(Player *player) {
+  int constructing = 0;
+  for (int i = 0; i < 24; i++) {
+    constructing += player->get_incomplete_building_count(i);
+  }
+  if (constructing >= AI_MAX_CONSTRUCTION) {
+    return Building::TypeNone;
+  }
+
+  auto count = [player](Building::Type type) {
+    return player->get_completed_building_count(type) +
+           player->get_incomplete_building_count(type);
+  };
+
+  if (count(Building::TypeLumberjack) < 2) return Building::TypeLumberjack;
+  if (count(Building::TypeStonecutter) < 1) return Building::TypeStonecutter;
+  if (count(Building::TypeSawmill) < 1) return Building::TypeSawmill;
+  if (count(Building::TypeForester) < 1) return Building::TypeForester;
+
+  return Building::TypeHut;
+}
+
+/* Scan the map for a castle position, continuing at cursor. The scan starts
+   at a different place for each player to keep the castles apart. */
+bool
+AIBasic::find_castle_pos(Game *game, Player *player, const Budget &budget,
+                         MapPos *pos) {
+  PMap map = game->get_map();
+  unsigned int size = map->get_cols() * map->get_rows();
+  unsigned int start = (size / GAME_MAX_PLAYER_COUNT) * player->get_index() +
+                       (size / (2 * GAME_MAX_PLAYER_COUNT));
+
+  while (cursor < size) {
+    MapPos p = (start + cursor++) % size;
+    if (game->can_build_castle(p, player)) {
+      *pos = p;
+      return true;
+    }
+    if ((cursor % AI_SCAN_CHUNK) == 0 && budget.expired()) {
+      break;
+    }
+  }
+
+  return false;
+}
+
+/* Scan the territory of player for a position where the wanted building can
+   be built and connected to the road network, continuing at cursor. */
+bool
+AIBasic::find_building_pos(Game *game, Player *player, const Budget &budget,
+                           MapPos *pos, Road *road) {
+  PMap map = game->get_map();
+  unsigned int size = map->get_cols() * map->get_rows();
+
+  while (cursor < size) {
+    MapPos p = cursor++;
+    if (map->get_owner(p) == player->get_index() &&
+        game->can_player_build(p, player) &&
+        game->can_build_building(p, wanted, player)) {
+      MapPos flag_pos = map->move_down_right(p);
+      if (map->has_flag(flag_pos)) {
+        *pos = p;
+        road->invalidate();
+        return true;
+      }
+
+      *road = find_road(game, player, p);
+      if (road->is_valid()) {
+        *pos = p;
+        return true;
+      }
+    }
+    if ((cursor % AI_SCAN_CHUNK) == 0 && budget.expired()) {
+      break;
+    }
+  }
+
+  return false;
+}
+
+/* Find a road from the flag of a new building at pos to the nearest flag of
+   player. Returns an invalid road if there is none. */
+Road
+AIBasic::find_road(Game *game, Player *player, MapPos pos) {
+  PMap map = game->get_map();
+  MapPos flag_pos = map->move_down_right(pos);
+
+  for (unsigned int i = 1; i < AI_FLAG_SEARCH; i++) {
+    MapPos dest = map->pos_add_spirally(flag_pos, i);
+    if (!map->has_flag(dest) || map->get_owner(dest) != player->get_index()) {
+      continue;
+    }
+
+    Road road = pathfinder_map(map.get(), flag_pos, dest);
+    if (road.get_length() != 0 && !road.has_pos(map.get(), pos)) {
+      return road;
+    }
+    /* Only try the nearest flag, the path search is expensive. */
+    break;
+  }
+
+  Road road;
+  return road;
+}
+
+/* Collect the enemy buildings that can be attacked. */
+void
+AIBasic::find_attack_targets(Game *game, Player *player) {
+  targets.clear();
+  for (Building *building : game->get_buildings()) {
+    if (player->can_attack(building)) {
+      targets.push_back(building->get_position());
+    }
+  }
+}
+
+AIScheduler::AIScheduler(unsigned int _budget)
+  : budget(_budget)
+  , last_tick(0) {
+}
+
+AIScheduler::~AIScheduler() {
+  /* Slices still running use the jobs. */
+  std::unique_lock<std::mutex> lock(mutex);
+  slice_done.wait(lock, [this]() {
+    for (const std::unique_ptr<Job> &job : jobs) {
+      if (job->busy) return false;
+    }
+    return true;
+  });
+}
+
+void
+AIScheduler::add_player(unsigned int player, PAI ai) {
+  if (!ai) {
+    ai = std::make_shared<AIBasic>();
+  }
+
+  std::unique_ptr<Job> job(new Job());
+  job->player = player;
+  job->ai = ai;
+  job->finished = false;
+  job->busy = false;
+  job->next_plan = 0;
+  job->stats = Stats();
+
+  std::lock_guard<std::mutex> lock(mutex);
+  jobs.push_back(std::move(job));
+}
+
+bool
+AIScheduler::has_player(unsigned int player) {
+  std::lock_guard<std::mutex> lock(mutex);
+  for (const std::unique_ptr<Job> &job : jobs) {
+    if (job->player == player) return true;
+  }
+  return false;
+}
+
+void
+AIScheduler::update(Game *game) {
+  /* Nothing happens while the game is paused. */
+  if (game->get_tick() == last_tick) {
+    return;
+  }
+  last_tick = game->get_tick();
+
+  for (std::unique_ptr<Job> &job_ : jobs) {
+    Job *job = job_.get();
+    Player *player = game->get_player(job->player);
+    if (player == nullptr) {
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    if (job->busy) {
+      job->stats.missed_ticks++;
+      continue;
+    }
+
+    if (job->finished) {
+      /* Apply the completed plan to the game. */
+      AI::Actions actions;
+      std::swap(actions, job->actions);
+      job->finished = false;
+      job->snapshot.reset();
+      job->next_plan = game->get_tick() + AI_PLAN_INTERVAL;
+      job->stats.actions += static_cast<unsigned int>(actions.size());
+      lock.unlock();
+
+      for (AI::Action &action : actions) {
+        action(game, player);
+      }
+      continue;
+    }
+
+    if (!job->snapshot) {
+      if (static_cast<int>(game->get_tick() - job->next_plan) < 0) {
+        continue;
+      }
+      job->snapshot = game->fork();
+    }
+
+    job->busy = true;
+    lock.unlock();
+
+    if (budget == 0) {
+      run_slice(job);
+    } else {
+      ThreadPool::get_instance().run([this, job]() { run_slice(job); });
+    }
+  }
+}
+
+AIScheduler::Stats
+AIScheduler::get_stats(unsigned int player) {
+  std::lock_guard<std::mutex> lock(mutex);
+  for (const std::unique_ptr<Job> &job : jobs) {
+    if (job->player == player) return job->stats;
+  }
+  return Stats();
+}
+
+/* Run one slice of planning for job. The job is owned by the slice until
+   busy is cleared. */
+void
+AIScheduler::run_slice(Job *job) {
+  typedef std::chrono::steady_clock Clock;
+  Clock::time_point start = Clock::now();
+
+  bool done = true;
+  Player *player = job->snapshot->get_player(job->player);
+  if (player != nullptr) {
+    AI::Budget slice_budget(budget);
+    done = job->ai->plan(job->snapshot.get(), player, slice_budget,
+                         &job->actions);
+  }
+
+  uint64_t used = std::chrono::duration_cast<std::chrono::microseconds>(
+                                                  Clock::now() - start).count();
+
+  std::lock_guard<std::mutex> lock(mutex);
+  job->stats.slices++;
+  job->stats.time_used += used;
+  job->stats.max_slice = std::max(job->stats.max_slice, used);
+  if (budget != 0 && used > budget) {
+    job->stats.overruns++;
+  }
+  if (done) {
+    job->stats.plans++;
+    job->finished = true;
+  }
+  job->busy = false;
+  slice_done.notify_all();
+}
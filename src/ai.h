@@ -0,0 +1,168 @@
+/*
+ * ai.h - Computer controlled players
+ *
+ * Copyright (C) 2026  freeserf developers
+ *
+ * This file is part of freeserf.
+ *
+ * freeserf is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * freeserf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with freeserf.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SRC_AI_H_
+#define SRC_AI_H_
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "src/building.h"
+#include "src/game.h"
+#include "src/map.h"
+
+/* Default planning time per AI player and tick in microseconds. */
+#define AI_DEFAULT_BUDGET  2000
+
+// Controller for a computer player.
+//
+// Planning happens on a snapshot of the game that is private to the
+// controller, so it can run on a worker thread while the game continues.
+// The plan consists of actions that are applied to the live game once the
+// plan is complete. Planning must be resumable: plan() returns as soon as the
+// budget has expired and is called again with the same snapshot to continue.
+class AI {
+ public:
+  typedef std::function<void(Game *game, Player *player)> Action;
+  typedef std::vector<Action> Actions;
+
+  class Budget {
+   protected:
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point deadline;
+    bool unlimited;
+
+   public:
+    /* Budget of usec microseconds from now, zero means no limit. */
+    explicit Budget(unsigned int usec);
+
+    bool expired() const {
+      return !unlimited && (Clock::now() >= deadline);
+    }
+  };
+
+  virtual ~AI() {}
+
+  /* Continue planning for player on game. Returns true when the plan is
+     complete; its actions have then been added to actions. */
+  virtual bool plan(Game *game, Player *player, const Budget &budget,
+                    Actions *actions) = 0;
+};
+
+typedef std::shared_ptr<AI> PAI;
+
+// Simple economic and military strategy: place the castle, keep a basic
+// construction material economy going, expand the territory with huts and
+// attack enemy buildings when enough knights are available.
+class AIBasic : public AI {
+ protected:
+  typedef enum Phase {
+    PhaseStart,
+    PhaseCastle,
+    PhaseBuilding,
+    PhaseAttack,
+  } Phase;
+
+  Phase phase;
+  unsigned int cursor;
+  Building::Type wanted;
+  std::list<MapPos> targets;
+
+ public:
+  AIBasic();
+
+  virtual bool plan(Game *game, Player *player, const Budget &budget,
+                    Actions *actions);
+
+ protected:
+  Building::Type choose_building(Player *player);
+  bool find_castle_pos(Game *game, Player *player, const Budget &budget,
+                       MapPos *pos);
+  bool find_building_pos(Game *game, Player *player, const Budget &budget,
+                         MapPos *pos, Road *road);
+  Road find_road(Game *game, Player *player, MapPos pos);
+  void find_attack_targets(Game *game, Player *player);
+};
+
+// Runs the AI controllers of a game in time slices. Every tick each
+// controller gets at most one slice of the budget on the shared thread pool;
+// the game never waits for a slice to finish, so the AI does not add to the
+// tick latency. With a zero budget the planning instead runs to completion
+// within the tick, which keeps the game reproducible.
+class AIScheduler {
+ public:
+  typedef struct Stats {
+    unsigned int slices;        /* Planning slices run */
+    unsigned int plans;         /* Plans completed */
+    unsigned int actions;       /* Actions applied to the game */
+    unsigned int overruns;      /* Slices that ran past the budget */
+    unsigned int missed_ticks;  /* Ticks skipped while a slice was running */
+    uint64_t time_used;         /* Total planning time in microseconds */
+    uint64_t max_slice;         /* Longest slice in microseconds */
+  } Stats;
+
+ protected:
+  class Job {
+   public:
+    unsigned int player;
+    PAI ai;
+    PGame snapshot;
+    AI::Actions actions;
+    bool finished;
+    bool busy;
+    unsigned int next_plan;
+    Stats stats;
+  };
+  typedef std::vector<std::unique_ptr<Job>> Jobs;
+
+  Jobs jobs;
+  unsigned int budget;
+  unsigned int last_tick;
+
+  std::mutex mutex;
+  std::condition_variable slice_done;
+
+ public:
+  explicit AIScheduler(unsigned int budget = AI_DEFAULT_BUDGET);
+  virtual ~AIScheduler();
+
+  unsigned int get_budget() const { return budget; }
+
+  /* Let ai control player, or AIBasic if no AI is given. */
+  void add_player(unsigned int player, PAI ai = PAI());
+  bool has_player(unsigned int player);
+
+  /* Called once every game tick. */
+  void update(Game *game);
+
+  Stats get_stats(unsigned int player);
+
+ protected:
+  void run_slice(Job *job);
+};
+
+#endif  // SRC_AI_H_
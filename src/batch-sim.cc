@@ -0,0 +1,273 @@
+/*
+ * batch-sim.cc - Run many games without user interface
+ *
+ * Copyright (C) 2026  freeserf developers
+ *
+ * This file is part of freeserf.
+ *
+ * freeserf is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * freeserf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with freeserf.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <fstream>
+#include <iostream>
+#include <istream>
+#include <string>
+#include <vector>
+
+#include "src/command_line.h"
+#include "src/log.h"
+#include "src/version.h"
+#include "src/mission.h"
+#include "src/game.h"
+#include "src/ai.h"
+#include "src/thread-pool.h"
+
+/* Number of random positions to try when placing a castle. */
+#define CASTLE_PLACEMENT_TRIES  10000
+
+typedef struct PlayerResult {
+  unsigned int face;
+  int land_area;
+  int building_score;
+  int military_score;
+  int score;
+} PlayerResult;
+
+typedef struct GameResult {
+  std::string seed;
+  bool valid;
+  unsigned int ticks;
+  std::vector<PlayerResult> players;
+} GameResult;
+
+/* Build castles for the players that have no preset castle position. The
+   positions are drawn from rnd so the result only depends on the seed. */
+static bool
+place_castles(PGame game, Random *rnd) {
+  PMap map = game->get_map();
+  for (unsigned int i = 0; game->get_player(i) != nullptr; i++) {
+    Player *player = game->get_player(i);
+    for (int t = 0; t < CASTLE_PLACEMENT_TRIES && !player->has_castle();
+         t++) {
+      int col, row;
+      MapPos pos = map->get_rnd_coord(&col, &row, rnd);
+      if (game->can_build_castle(pos, player)) {
+        game->build_castle(pos, player);
+      }
+    }
+    if (!player->has_castle()) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+static void
+run_game(const Random &seed, PGameInfo preset, unsigned int map_size,
+         unsigned int ticks, GameResult *result) {
+  result->seed = seed;
+  result->valid = false;
+
+  PGameInfo game_info = std::make_shared<GameInfo>(seed);
+  game_info->set_map_size(map_size);
+  if (preset) {
+    game_info->remove_all_players();
+    for (size_t i = 0; i < preset->get_player_count(); i++) {
+      game_info->add_player(preset->get_player(i));
+    }
+  }
+
+  PGame game = game_info->instantiate();
+  if (!game) {
+    Log::Warn["batch"] << "Unable to create game " << result->seed;
+    return;
+  }
+  game->set_random(seed);
+
+  Random rnd = seed;
+  if (!place_castles(game, &rnd)) {
+    Log::Warn["batch"] << "Unable to place castles in game " << result->seed;
+    return;
+  }
+
+  /* All players are computer controlled. Planning runs to completion within
+     each tick so the result only depends on the seed. */
+  game->start_ai(0);
+  for (unsigned int i = 0; game->get_player(i) != nullptr; i++) {
+    if (!game->get_ai()->has_player(i)) {
+      game->get_ai()->add_player(i);
+    }
+  }
+
+  for (unsigned int i = 0; i < ticks; i++) {
+    game->update();
+  }
+
+  result->valid = true;
+  result->ticks = ticks;
+  for (unsigned int i = 0; game->get_player(i) != nullptr; i++) {
+    Player *player = game->get_player(i);
+    PlayerResult player_result;
+    player_result.face = player->get_face();
+    player_result.land_area = player->get_land_area();
+    player_result.building_score = player->get_building_score();
+    player_result.military_score = player->get_military_score();
+    player_result.score = player->get_score();
+    result->players.push_back(player_result);
+
+    AIScheduler::Stats stats = game->get_ai()->get_stats(i);
+    Log::Debug["batch"] << "Game " << result->seed << " player " << i
+                        << ": " << stats.plans << " plans, " << stats.actions
+                        << " actions, " << stats.time_used << " us planning";
+  }
+
+  Log::Info["batch"] << "Game " << result->seed << " done";
+}
+
+/* Games that could not be set up get a single row with valid set to 0 and
+   the other fields empty. */
+static void
+write_results(std::ostream *os, const std::vector<GameResult> &results) {
+  *os << "seed,valid,ticks,player,face,land_area,building_score,"
+      << "military_score,score\n";
+  for (const GameResult &result : results) {
+    if (!result.valid) {
+      *os << result.seed << ",0,,,,,,,\n";
+      continue;
+    }
+    for (size_t i = 0; i < result.players.size(); i++) {
+      const PlayerResult &player = result.players[i];
+      *os << result.seed << ",1," << result.ticks << ',' << i << ','
+          << player.face << ',' << player.land_area << ','
+          << player.building_score << ',' << player.military_score << ','
+          << player.score << '\n';
+    }
+  }
+}
+
+int
+main(int argc, char *argv[]) {
+  std::vector<Random> seeds;
+  std::string output_file;
+  unsigned int ticks = 10000;
+  unsigned int map_size = 3;
+  unsigned int thread_count = 0;
+  int mission = -1;
+
+  CommandLine command_line;
+  command_line.add_option('c', "Add a number of generated seeds")
+                .add_parameter("COUNT", [&seeds](std::istream& s) {
+                  unsigned int count = 0;
+                  s >> count;
+                  /* An all zero state would only produce zeros. */
+                  size_t first = seeds.size() + 1;
+                  for (unsigned int i = 0; i < count; i++) {
+                    seeds.push_back(Random(static_cast<uint16_t>(first + i)));
+                  }
+                  return true;
+                });
+  command_line.add_option('h', "Show this help text", [&command_line](){
+                  command_line.show_help();
+                  exit(EXIT_SUCCESS);
+                });
+  command_line.add_option('j', "Number of games to run at once")
+                .add_parameter("THREADS", [&thread_count](std::istream& s) {
+                  s >> thread_count;
+                  return true;
+                });
+  command_line.add_option('m', "Use players of mission preset")
+                .add_parameter("NUM", [&mission](std::istream& s) {
+                  s >> mission;
+                  return true;
+                });
+  command_line.add_option('o', "Write results to file instead of stdout")
+                .add_parameter("FILE", [&output_file](std::istream& s) {
+                  std::getline(s, output_file);
+                  return true;
+                });
+  command_line.add_option('s', "Add comma separated list of seeds")
+                .add_parameter("SEEDS", [&seeds](std::istream& s) {
+                  std::string seed;
+                  while (std::getline(s, seed, ',')) {
+                    if (seed.length() != 16) {
+                      return false;
+                    }
+                    seeds.push_back(Random(seed));
+                  }
+                  return true;
+                });
+  command_line.add_option('t', "Number of ticks to run each game")
+                .add_parameter("TICKS", [&ticks](std::istream& s) {
+                  s >> ticks;
+                  return true;
+                });
+  command_line.add_option('z', "Map size (3-10)")
+                .add_parameter("SIZE", [&map_size](std::istream& s) {
+                  s >> map_size;
+                  return (map_size >= 3 && map_size <= 10);
+                });
+  command_line.set_comment("Please report bugs to <" PACKAGE_BUGREPORT ">");
+  if (!command_line.process(argc, argv) || seeds.empty()) {
+    return EXIT_FAILURE;
+  }
+
+  /* Keep the log out of the results. */
+  Log::set_file(&std::cerr);
+  Log::Info["batch"] << "starts " << FREESERF_VERSION;
+
+  PGameInfo preset;
+  if (mission >= 0) {
+    preset = GameInfo::get_mission(mission);
+    if (!preset) {
+      Log::Error["batch"] << "No such mission: " << mission;
+      return EXIT_FAILURE;
+    }
+  }
+
+  std::vector<GameResult> results(seeds.size());
+  {
+    ThreadPool pool(thread_count);
+    Log::Info["batch"] << "Running " << seeds.size() << " games on "
+                       << pool.get_thread_count() << " threads";
+    for (size_t i = 0; i < seeds.size(); i++) {
+      GameResult *result = &results[i];
+      Random seed = seeds[i];
+      pool.run([seed, preset, map_size, ticks, result]() {
+        run_game(seed, preset, map_size, ticks, result);
+      });
+    }
+    pool.wait();
+  }
+
+  size_t failures = 0;
+  for (const GameResult &result : results) {
+    if (!result.valid) failures++;
+  }
+  Log::Info["batch"] << "Ran " << (results.size() - failures) << " of "
+                     << results.size() << " games";
+
+  if (output_file.empty()) {
+    write_results(&std::cout, results);
+  } else {
+    std::ofstream file(output_file);
+    if (!file.is_open()) {
+      Log::Error["batch"] << "Unable to open " << output_file;
+      return EXIT_FAILURE;
+    }
+    write_results(&file, results);
+  }
+
+  return (failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
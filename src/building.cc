@@ -1448,9 +1448,7 @@ operator >> (SaveReaderText &reader, Building &building) {
   reader.value("progress") >> building.progress;
 
   if (reader.has_value("inventory")) {
-    unsigned int inventory_index;
-    reader.value("inventory") >> inventory_index;
-    building.inventory = building.game->create_inventory(inventory_index);
+    /* Linked by load_links(). */
   } else if (building.burning) {
     reader.value("tick") >> building.u.tick;
   } else {
@@ -1460,8 +1458,17 @@ operator >> (SaveReaderText &reader, Building &building) {
   return reader;
 }
 
+void
+Building::load_links(SaveReaderText *reader) {
+  if (reader->has_value("inventory")) {
+    unsigned int inventory_index;
+    reader->value("inventory") >> inventory_index;
+    inventory = game->create_inventory(inventory_index);
+  }
+}
+
 SaveWriterText&
-operator << (SaveWriterText &writer, Building &building) {
+operator << (SaveWriterText &writer, const Building &building) {
   writer.value("pos") << building.game->get_map()->pos_col(building.pos);
   writer.value("pos") << building.game->get_map()->pos_row(building.pos);
   writer.value("type") << building.type;
@@ -246,8 +246,10 @@ class Building : public GameObject {
     operator >> (SaveReaderBinary &reader, Building &building);
   friend SaveReaderText&
     operator >> (SaveReaderText &reader, Building &building);
+  /* Resolve the inventory read by operator >>. */
+  void load_links(SaveReaderText *reader);
   friend SaveWriterText&
-    operator << (SaveWriterText &writer, Building &building);
+    operator << (SaveWriterText &writer, const Building &building);
 
  private:
   void update();
@@ -260,6 +262,10 @@ class Building : public GameObject {
 
   bool send_serf_to_building(Serf::Type type, Resource::Type res1,
                              Resource::Type res2);
+
+ protected:
+  Building(const Building &that) = default;
+  template<class T, size_t growth> friend class Collection;
 };
 
 
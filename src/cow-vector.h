@@ -0,0 +1,103 @@
+/*
+ * cow-vector.h - Chunked copy-on-write array
+ *
+ * Copyright (C) 2026  freeserf developers
+ *
+ * This file is part of freeserf.
+ *
+ * freeserf is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * freeserf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with freeserf.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SRC_COW_VECTOR_H_
+#define SRC_COW_VECTOR_H_
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+
+// Fixed size array split into chunks of 2^shift elements. Copying the array
+// only copies references to the chunks; a chunk is duplicated the first time
+// it is accessed for writing through a copy that still shares it. This makes
+// copying large arrays (like the map tiles) cheap when only a small part of
+// them is modified afterwards.
+//
+// Access through the non-const operator[] counts as a write, so read-only
+// code should use a const reference to the array.
+template<class T, unsigned int shift = 12>
+class CowVector {
+ protected:
+  typedef std::vector<T> Chunk;
+  typedef std::shared_ptr<Chunk> PChunk;
+  typedef std::vector<PChunk> Chunks;
+
+  static const size_t chunk_size = static_cast<size_t>(1) << shift;
+  static const size_t chunk_mask = chunk_size - 1;
+
+  Chunks chunks;
+  size_t count;
+
+ public:
+  CowVector() : count(0) {}
+
+  // Replace content with values.
+  CowVector &operator = (const std::vector<T> &values) {
+    chunks.clear();
+    count = values.size();
+    for (size_t i = 0; i < count; i += chunk_size) {
+      size_t end = std::min(i + chunk_size, count);
+      chunks.push_back(std::make_shared<Chunk>(values.begin() + i,
+                                               values.begin() + end));
+    }
+    return *this;
+  }
+
+  // Resize to size elements. Any previous content is dropped.
+  void resize(size_t size) {
+    chunks.clear();
+    count = size;
+    for (size_t i = 0; i < count; i += chunk_size) {
+      chunks.push_back(std::make_shared<Chunk>(std::min(chunk_size,
+                                                        count - i)));
+    }
+  }
+
+  size_t size() const { return count; }
+
+  const T &operator[] (size_t index) const {
+    return (*chunks[index >> shift])[index & chunk_mask];
+  }
+
+  T &operator[] (size_t index) {
+    PChunk &chunk = chunks[index >> shift];
+    if (chunk.use_count() > 1) {
+      chunk = std::make_shared<Chunk>(*chunk);
+    }
+    return (*chunk)[index & chunk_mask];
+  }
+
+  // Number of chunks currently shared with another copy.
+  size_t shared_chunk_count() const {
+    return std::count_if(chunks.begin(), chunks.end(),
+                         [](const PChunk &chunk) {
+                           return chunk.use_count() > 1; });
+  }
+};
+
+template<class T, unsigned int shift>
+const size_t CowVector<T, shift>::chunk_size;
+
+template<class T, unsigned int shift>
+const size_t CowVector<T, shift>::chunk_mask;
+
+#endif  // SRC_COW_VECTOR_H_
@@ -274,6 +274,7 @@ bool
 DataSourceAmiga::load() {
   try {
     gfxfast = std::make_shared<Buffer>(path + "/gfxfast", Buffer::EndianessBig);
+    data_hash = hash_data(gfxfast->get_data(), gfxfast->get_size());
     gfxfast = decode(gfxfast);
     gfxfast = unpack(gfxfast);
     Log::Debug["data"] << "Data file 'gfxfast' loaded (size = "
@@ -285,6 +286,7 @@ DataSourceAmiga::load() {
 
   try {
     gfxchip = std::make_shared<Buffer>(path + "/gfxchip", Buffer::EndianessBig);
+    data_hash = hash_data(gfxchip->get_data(), gfxchip->get_size(), data_hash);
     gfxchip = decode(gfxchip);
     gfxchip = unpack(gfxchip);
     Log::Debug["data"] << "Data file 'gfxchip' loaded (size = "
@@ -302,6 +304,8 @@ DataSourceAmiga::load() {
     Log::Error["data"] << "Failed to load 'gfxheader'";
     return false;
   }
+  data_hash = hash_data(gfxheader->get_data(), gfxheader->get_size(),
+                        data_hash);
 
   // Prepare icons catalog
   size_t icon_catalog_offset = gfxheader->pop<uint16_t>();
@@ -355,6 +359,8 @@ DataSourceAmiga::load() {
   try {
     PBuffer gfxpics = std::make_shared<Buffer>(path + "/gfxpics",
                                                Buffer::EndianessBig);
+    data_hash = hash_data(gfxpics->get_data(), gfxpics->get_size(),
+                          data_hash);
     for (size_t i = 0; i < 14; i++) {
       uint32_t offset = gfxpics->pop<uint32_t>();
       uint32_t size = gfxpics->pop<uint32_t>();
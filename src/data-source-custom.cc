@@ -150,6 +150,7 @@ DataSourceCustom::get_music(size_t index) {
 
 DataSourceCustom::ResInfo *
 DataSourceCustom::get_info(Data::Resource res) {
+  std::lock_guard<std::mutex> lock(infos_mutex);
   if (infos.find(res) == infos.end()) {
     std::string dir_name = meta_main->value("resources",
                                             Data::get_resource_name(res),
@@ -24,6 +24,7 @@
 
 #include <string>
 #include <map>
+#include <mutex>  // NOLINT(build/c++11)
 
 #include "src/data-source.h"
 #include "src/configfile.h"
@@ -40,6 +41,8 @@ class DataSourceCustom : public DataSource {
   unsigned int scale;
   std::string name;
   std::map<Data::Resource, ResInfo> infos;
+  /* Guards infos, which is filled as sprites are decoded on any thread. */
+  std::mutex infos_mutex;
 
  public:
   explicit DataSourceCustom(const std::string &path);
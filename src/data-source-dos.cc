@@ -129,6 +129,7 @@ DataSourceDOS::load() {
   } catch (...) {
     return false;
   }
+  data_hash = hash_data(spae->get_data(), spae->get_size());
 
   // Check that data file is decompressed
   try {
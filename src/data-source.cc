@@ -25,6 +25,7 @@
 #include <sys/stat.h>
 
 #include <algorithm>
+#include <cstring>
 #include <fstream>
 
 #include "src/freeserf_endian.h"
@@ -33,10 +34,18 @@
 #include "src/data.h"
 #include "src/sfx2wav.h"
 #include "src/xmi2mid.h"
+#include "src/sprite-kernels.h"
+#include "src/sprite-cache.h"
+
+/* Memory for decoded sprite parts, enough for the sprites of the game view
+   that are decoded ahead of drawing. */
+#define DECODED_SPRITES_BUDGET  (32*1024*1024)
 
 DataSource::DataSource(const std::string &_path)
   : path(_path)
-  , loaded(false) {
+  , loaded(false)
+  , data_hash(0)
+  , decoded_sprites(DECODED_SPRITES_BUDGET) {
 }
 
 bool
@@ -122,12 +131,20 @@ Sprite::get_masked(PSprite mask) {
 
   uint32_t *m_pos = reinterpret_cast<uint32_t*>(mask->get_data());
 
+  const SpriteKernels &kernels = SpriteKernels::get_instance();
   for (size_t y = 0; y < masked->get_height(); y++) {
-    for (size_t x = 0; x < masked->get_width(); x++) {
+    size_t x = 0;
+    while (x < masked->get_width()) {
       if (s_pos >= s_end) {
         s_pos = s_beg;
       }
-      *pos++ = *s_pos++ & *m_pos++;
+      size_t count = std::min(masked->get_width() - x,
+                              static_cast<size_t>(s_end - s_pos));
+      kernels.mask(pos, s_pos, m_pos, count);
+      pos += count;
+      s_pos += count;
+      m_pos += count;
+      x += count;
     }
     s_pos += s_delta;
   }
@@ -147,13 +164,7 @@ Sprite::create_mask(PSprite other) {
   uint32_t *src2 = reinterpret_cast<uint32_t*>(other->get_data());
   uint32_t *res = reinterpret_cast<uint32_t*>(result->get_data());
 
-  for (unsigned int i = 0; i < width * height; i++) {
-    if (*src1++ == *src2++) {
-      *res++ = 0x00000000;
-    } else {
-      *res++ = 0xFFFFFFFF;
-    }
-  }
+  SpriteKernels::get_instance().compare(res, src1, src2, width * height);
 
   return result;
 }
@@ -168,14 +179,10 @@ Sprite::fill(Sprite::Color color) {
 
 void
 Sprite::fill_masked(Sprite::Color color) {
-  Color *res = reinterpret_cast<Color*>(data);
-
-  for (unsigned int i = 0; i < width * height; i++) {
-    if ((res->alpha & 0xFF) != 0x00) {
-      *res = color;
-    }
-    res++;
-  }
+  uint32_t value;
+  std::memcpy(&value, &color, sizeof(value));
+  SpriteKernels::get_instance().fill_masked(reinterpret_cast<uint32_t*>(data),
+                                            value, width * height);
 }
 
 void
@@ -187,11 +194,7 @@ Sprite::add(PSprite other) {
   uint32_t *src = reinterpret_cast<uint32_t*>(other->get_data());
   uint32_t *res = reinterpret_cast<uint32_t*>(data);
 
-  for (unsigned int i = 0; i < width * height; i++) {
-    *res++ += *src++;
-  }
-
-  return;
+  SpriteKernels::get_instance().add(res, src, width * height);
 }
 
 void
@@ -203,14 +206,7 @@ Sprite::del(PSprite other) {
   uint32_t *src = reinterpret_cast<uint32_t*>(other->get_data());
   uint32_t *res = reinterpret_cast<uint32_t*>(data);
 
-  for (unsigned int i = 0; i < width * height; i++) {
-    if (*src++ == 0xFFFFFFFF) {
-      *res = 0x00000000;
-    }
-    res++;
-  }
-
-  return;
+  SpriteKernels::get_instance().del(res, src, width * height);
 }
 
 void
@@ -219,40 +215,9 @@ Sprite::blend(PSprite other) {
     return;
   }
 
-#define UNMULTIPLY(color, a) ((0xFF * (color)) / (a))
-#define BLEND(back, front, a) (((front) * (a)) + ((back) * (0xFF - (a)))) / 0xFF
-
-  Color *c = reinterpret_cast<Color*>(data);
-  Color *o = reinterpret_cast<Color*>(other->get_data());
-  for (unsigned int i = 0; i < width * height; i++) {
-    const uint32_t alpha = o->alpha;
-
-    if (alpha == 0x00) {
-      c++;
-      o++;
-      continue;
-    }
-
-    if (alpha == 0xFF) {
-      *c++ = *o++;
-      continue;
-    }
-
-    const uint8_t backR = c->red;
-    const uint8_t backG = c->green;
-    const uint8_t backB = c->blue;
-
-    const uint8_t frontR = UNMULTIPLY(o->red, alpha);
-    const uint8_t frontG = UNMULTIPLY(o->green, alpha);
-    const uint8_t frontB = UNMULTIPLY(o->blue, alpha);
-
-    const uint32_t R = BLEND(backR, frontR, alpha);
-    const uint32_t G = BLEND(backG, frontG, alpha);
-    const uint32_t B = BLEND(backB, frontB, alpha);
-
-    *c++ = {(uint8_t)B, (uint8_t)G, (uint8_t)R, 0xFF};
-    o++;
-  }
+  uint32_t *c = reinterpret_cast<uint32_t*>(data);
+  uint32_t *o = reinterpret_cast<uint32_t*>(other->get_data());
+  SpriteKernels::get_instance().blend(c, o, width * height);
 
   delta_x = other->delta_x;
   delta_y = other->delta_y;
@@ -260,53 +225,39 @@ Sprite::blend(PSprite other) {
 
 void
 Sprite::make_alpha_mask() {
-  Color *c = reinterpret_cast<Color*>(data);
-  uint8_t min = 0xFF;
-  for (unsigned int i = 0; i < width * height; i++) {
-    if (c->alpha != 0x00) {
-      c->alpha = 0xff - static_cast<uint8_t>((0.21 * c->red) +
-                                             (0.72 * c->green) +
-                                             (0.07 * c->blue));
-      c->red = 0;
-      c->green = 0;
-      c->blue = 0;
-      min = std::min(min, c->alpha);
-    }
-    c++;
-  }
-
-  c = reinterpret_cast<Color*>(data);
-  for (unsigned int i = 0; i < width * height; i++) {
-    if (c->alpha != 0x00) {
-      c->alpha = c->alpha - min;
-    }
-    c++;
-  }
+  uint32_t *c = reinterpret_cast<uint32_t*>(data);
+  const SpriteKernels &kernels = SpriteKernels::get_instance();
+  uint8_t min = kernels.alpha_from_luminance(c, width * height);
+  kernels.lower_alpha(c, min, width * height);
 }
 
 void
 Sprite::stick(PSprite sticker, unsigned int dx, unsigned int dy) {
-  Color *base = reinterpret_cast<Color*>(data);
-  Color *stkr = reinterpret_cast<Color*>(sticker->get_data());
+  uint32_t *base = reinterpret_cast<uint32_t*>(data);
+  uint32_t *stkr = reinterpret_cast<uint32_t*>(sticker->get_data());
+  const SpriteKernels &kernels = SpriteKernels::get_instance();
   size_t w = std::min(width, sticker->get_width());
   size_t h = std::min(height, sticker->get_height());
 
   base += dy * width;
   for (size_t y = 0; y < w; y++) {
     base += dx;
-    for (size_t x = 0; x < h; x++) {
-      Color pixel = *stkr++;
-      if ((pixel.alpha & 0xFF) != 0x00) {
-        *base = pixel;
-      }
-      base++;
-    }
+    kernels.stick(base, stkr, h);
+    base += h;
+    stkr += h;
   }
 
   delta_x = sticker->get_delta_x();
   delta_y = sticker->get_delta_y();
 }
 
+PSprite
+Sprite::copy() {
+  PSprite result = std::make_shared<Sprite>(shared_from_this());
+  std::memcpy(result->get_data(), get_data(), width * height * 4);
+  return result;
+}
+
 // Calculate hash of sprite identifier.
 uint64_t
 Sprite::create_id(uint64_t resource, uint64_t index,
@@ -336,20 +287,173 @@ DataSource::get_sprite(Data::Resource res, size_t index,
     return nullptr;
   }
 
-  MaskImage ms = get_sprite_parts(res, index);
+  MaskImage ms = get_decoded_sprite_parts(res, index);
   PSprite mask = std::get<0>(ms);
   PSprite image = std::get<1>(ms);
-
+  /* The parts are shared, so only copies are handed out. */
   if (mask) {
+    mask = mask->copy();
     mask->fill_masked(color);
     if (image) {
       mask->blend(image);
-      return mask;
     }
     return mask;
   }
 
-  return image;
+  return image ? image->copy() : nullptr;
+}
+
+#define UNMULTIPLY(color, a) ((0xFF * (color)) / (a))
+#define BLEND(back, front, a) (((front) * (a)) + ((back) * (0xFF - (a)))) / 0xFF
+
+DataSource::MaskImage
+DataSource::get_sprite_layers(Data::Resource res, size_t index) {
+  if (index >= Data::get_resource_count(res)) {
+    return std::make_tuple(nullptr, nullptr);
+  }
+
+  MaskImage ms = get_decoded_sprite_parts(res, index);
+  PSprite mask = std::get<0>(ms);
+  PSprite image = std::get<1>(ms);
+  /* The parts are shared. */
+  if (mask) {
+    mask = mask->copy();
+  }
+  if (image) {
+    image = image->copy();
+  }
+  if (!mask) {
+    return std::make_tuple(nullptr, image);
+  }
+
+  mask->fill_masked({0xFF, 0xFF, 0xFF, 0xFF});
+  if (!image) {
+    return std::make_tuple(mask, nullptr);
+  }
+
+  /* Same as get_sprite() without the colour: the image is blended onto the
+     mask, except that pixels over the coloured part keep their alpha so the
+     tint shows through. */
+  PSprite overlay = std::make_shared<Sprite>(mask);
+  overlay->fill({0x00, 0x00, 0x00, 0x00});
+  if (image->get_width() == mask->get_width() &&
+      image->get_height() == mask->get_height()) {
+    Sprite::Color *c = reinterpret_cast<Sprite::Color*>(overlay->get_data());
+    Sprite::Color *m = reinterpret_cast<Sprite::Color*>(mask->get_data());
+    Sprite::Color *o = reinterpret_cast<Sprite::Color*>(image->get_data());
+    for (size_t i = 0; i < mask->get_width() * mask->get_height(); i++) {
+      const uint32_t alpha = o->alpha;
+      if (alpha == 0xFF) {
+        *c = *o;
+      } else if (alpha != 0x00) {
+        uint8_t b = static_cast<uint8_t>(UNMULTIPLY(o->blue, alpha));
+        uint8_t g = static_cast<uint8_t>(UNMULTIPLY(o->green, alpha));
+        uint8_t r = static_cast<uint8_t>(UNMULTIPLY(o->red, alpha));
+        if (m->alpha != 0x00) {
+          *c = {b, g, r, static_cast<uint8_t>(alpha)};
+        } else {
+          *c = {static_cast<uint8_t>(BLEND(m->blue, b, alpha)),
+                static_cast<uint8_t>(BLEND(m->green, g, alpha)),
+                static_cast<uint8_t>(BLEND(m->red, r, alpha)), 0xFF};
+        }
+      }
+      c++;
+      m++;
+      o++;
+    }
+    overlay->set_delta(image->get_delta_x(), image->get_delta_y());
+  }
+
+  return std::make_tuple(mask, overlay);
+}
+
+DataSource::MaskImage
+DataSource::get_decoded_sprite_parts(Data::Resource res, size_t index) {
+  uint64_t id = Sprite::create_id(res, index, 0, 0, {0, 0, 0, 0});
+
+  std::unique_lock<std::mutex> lock(decoded_mutex);
+  MaskImage *decoded = decoded_sprites.get(id);
+  if (decoded != nullptr) {
+    return *decoded;
+  }
+
+  auto it = decoding_sprites.find(id);
+  if (it != decoding_sprites.end()) {
+    std::shared_ptr<DecodingSprite> sprite = it->second;
+    decoded_ready.wait(lock, [&sprite]() { return sprite->ready; });
+    return sprite->parts;
+  }
+
+  std::shared_ptr<DecodingSprite> sprite = std::make_shared<DecodingSprite>();
+  sprite->ready = false;
+  decoding_sprites[id] = sprite;
+  lock.unlock();
+
+  /* Threads waiting for the sprite are released however decoding ends. */
+  MaskImage parts = std::make_tuple(nullptr, nullptr);
+  try {
+    parts = decode_sprite_parts(res, index);
+  } catch (ExceptionFreeserf &e) {
+    Log::Warn["data"] << "Failed to decode sprite "
+                      << Data::get_resource_name(res) << " #" << index
+                      << ": " << e.get_description();
+  } catch (...) {
+    publish_decoded_sprite(id, sprite, parts, false);
+    throw;
+  }
+
+  publish_decoded_sprite(id, sprite, parts, true);
+  return parts;
+}
+
+/* Hand the parts to the threads waiting for them, and keep them for later
+   if keep is set. Sprites that failed to decode are kept too, at no cost,
+   so they are only reported once. */
+void
+DataSource::publish_decoded_sprite(uint64_t id,
+                                   std::shared_ptr<DecodingSprite> sprite,
+                                   const MaskImage &parts, bool keep) {
+  size_t size = 0;
+  for (PSprite part : {std::get<0>(parts), std::get<1>(parts)}) {
+    if (part) {
+      size += part->get_width() * part->get_height() * 4;
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(decoded_mutex);
+  sprite->parts = parts;
+  sprite->ready = true;
+  decoding_sprites.erase(id);
+  if (keep) {
+    decoded_sprites.insert(id,
+                           std::unique_ptr<MaskImage>(new MaskImage(parts)),
+                           size);
+  }
+  decoded_ready.notify_all();
+}
+
+/* Parts from the sprite cache if it has them, decoded otherwise. */
+DataSource::MaskImage
+DataSource::decode_sprite_parts(Data::Resource res, size_t index) {
+  if (sprite_cache) {
+    MaskImage parts;
+    if (sprite_cache->get(SpriteCache::get_id(res, index), &parts)) {
+      return parts;
+    }
+  }
+
+  return get_sprite_parts(res, index);
+}
+
+// 64 bit FNV-1a hash, continued from hash.
+uint64_t
+DataSource::hash_data(const void *data, size_t size, uint64_t hash) {
+  const uint8_t *bytes = reinterpret_cast<const uint8_t*>(data);
+  for (size_t i = 0; i < size; i++) {
+    hash ^= bytes[i];
+    hash *= 0x100000001b3;
+  }
+  return hash;
 }
 
 DataSource::MaskImage
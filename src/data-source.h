@@ -22,6 +22,9 @@
 #ifndef SRC_DATA_SOURCE_H_
 #define SRC_DATA_SOURCE_H_
 
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <map>
+#include <mutex>  // NOLINT(build/c++11)
 #include <string>
 #include <memory>
 #include <tuple>
@@ -29,9 +32,11 @@
 
 #include "src/data.h"
 #include "src/debug.h"
+#include "src/lru-cache.h"
 
 class Buffer;
 typedef std::shared_ptr<Buffer> PBuffer;
+class SpriteCache;
 
 // Sprite object.
 // Contains BGRA data.
@@ -68,6 +73,7 @@ class Sprite : public std::enable_shared_from_this<Sprite> {
   virtual int get_delta_y() const { return delta_y; }
   virtual int get_offset_x() const { return offset_x; }
   virtual int get_offset_y() const { return offset_y; }
+  virtual void set_delta(int x, int y) { delta_x = x; delta_y = y; }
 
   virtual PSprite get_masked(PSprite mask);
   virtual PSprite create_mask(PSprite other);
@@ -79,6 +85,8 @@ class Sprite : public std::enable_shared_from_this<Sprite> {
   virtual void make_alpha_mask();
 
   virtual void stick(PSprite sticker, unsigned int x, unsigned int y);
+  /* New sprite with the same pixels. */
+  PSprite copy();
 
   static uint64_t create_id(uint64_t resource, uint64_t index,
                             uint64_t mask_resource, uint64_t mask_index,
@@ -103,6 +111,22 @@ class DataSource {
   std::string path;
   bool loaded;
   std::vector<std::vector<Animation>> animation_table;
+  uint64_t data_hash;
+  std::shared_ptr<SpriteCache> sprite_cache;
+
+  /* Sprites being decoded by some thread, by id. Waiting threads share the
+     entry, so it outlives its removal once the sprite is ready. */
+  typedef struct DecodingSprite {
+    MaskImage parts;
+    bool ready;
+  } DecodingSprite;
+  std::mutex decoded_mutex;
+  std::condition_variable decoded_ready;
+  std::map<uint64_t, std::shared_ptr<DecodingSprite>> decoding_sprites;
+  /* Parts of the sprites decoded last, by id. When they take more memory
+     than the budget the least recently asked for are dropped, and decoded
+     again when asked for. */
+  LruCache<uint64_t, MaskImage> decoded_sprites;
 
  public:
   explicit DataSource(const std::string &path);
@@ -117,10 +141,26 @@ class DataSource {
   virtual bool check() = 0;
   virtual bool load() = 0;
 
+  /* Hash of the data files that the sprites are decoded from, or zero if
+     the decoded sprites can not be kept between runs. */
+  uint64_t get_data_hash() const { return data_hash; }
+  /* Sprites are taken from the cache when it has them. */
+  void set_sprite_cache(std::shared_ptr<SpriteCache> cache) {
+    sprite_cache = cache; }
+
   virtual PSprite get_sprite(Data::Resource res, size_t index,
                              const Sprite::Color &color);
+  /* Split a sprite that takes the player colour into an opaque white layer
+     for the coloured part, to be tinted when drawn, and the rest of the
+     sprite to draw on top of it. The first is null for sprites without a
+     coloured part. */
+  virtual MaskImage get_sprite_layers(Data::Resource res, size_t index);
 
   virtual MaskImage get_sprite_parts(Data::Resource res, size_t index) = 0;
+  /* Parts of a sprite, decoded once while they fit the budget and shared,
+     so they must not be changed. May be called from any thread; waits only
+     if another thread is decoding the same sprite. */
+  MaskImage get_decoded_sprite_parts(Data::Resource res, size_t index);
 
   virtual size_t get_animation_phase_count(size_t animation);
   virtual Animation get_animation(size_t animation, size_t phase);
@@ -132,6 +172,12 @@ class DataSource {
 
  protected:
   MaskImage separate_sprites(PSprite s1, PSprite s2);
+  MaskImage decode_sprite_parts(Data::Resource res, size_t index);
+  void publish_decoded_sprite(uint64_t id,
+                              std::shared_ptr<DecodingSprite> sprite,
+                              const MaskImage &parts, bool keep);
+  static uint64_t hash_data(const void *data, size_t size,
+                            uint64_t hash = 0xcbf29ce484222325);
 };
 
 typedef std::shared_ptr<DataSource> PDataSource;
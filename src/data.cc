@@ -21,20 +21,28 @@
 
 #include "src/data.h"
 
+#include <atomic>  // NOLINT(build/c++11)
 #include <vector>
 #include <memory>
 #include <utility>
 #include <string>
 #include <functional>
+#include <iomanip>
+#include <sstream>
 
 #include "src/log.h"
 #include "src/data-source-dos.h"
 #include "src/data-source-amiga.h"
 #include "src/data-source-custom.h"
+#include "src/sprite-cache.h"
+#include "src/thread-pool.h"
 
 #ifdef _WIN32
 // need for GetModuleFileName
 #include <Windows.h>
+#else
+#include <sys/stat.h>
+#include <cerrno>
 #endif
 
 typedef struct DataResource {
@@ -81,7 +89,10 @@ DataResource data_resources[] = {
   { Data::AssetCursor,       Data::TypeSprite,    1,   "cursor"        },
 };
 
-Data::Data() : data_source(nullptr) {}
+Data::Data()
+  : data_source(nullptr)
+  , sprite_cache_enabled(false) {
+}
 
 Data &
 Data::get_instance() {
@@ -133,7 +144,132 @@ Data::load(const std::string &path) {
     }
   }
 
-  return data_source.get() != nullptr;
+  if (!data_source) {
+    return false;
+  }
+
+  PSpriteCache cache;
+  if (sprite_cache_enabled) {
+    cache = open_sprite_cache();
+  }
+
+  warm_up_sprites();
+
+  /* Queued after the warm-up, so it finds most sprites decoded. */
+  if (cache && (cache->get_count() < SpriteCache::get_total_count())) {
+    PDataSource source = data_source;
+    ThreadPool::get_instance().run([cache, source]() {
+      cache->populate(source);
+    });
+  }
+
+  return true;
+}
+
+// Use the sprite cache file of the data if it exists. Return the cache, or
+// nullptr if the sprites are not cached.
+PSpriteCache
+Data::open_sprite_cache() {
+  uint64_t hash = data_source->get_data_hash();
+  if (hash == 0) {
+    Log::Info["data"] << "Sprites of " << data_source->get_name()
+                      << " data are not cached";
+    return nullptr;
+  }
+
+  std::string folder = get_cache_folder();
+  if (folder.empty()) {
+    Log::Warn["data"] << "No folder for the sprite cache";
+    return nullptr;
+  }
+
+  std::stringstream file_path;
+  file_path << folder << "/sprites-" << std::hex << std::setw(16)
+            << std::setfill('0') << hash << ".cache";
+
+  PSpriteCache cache = std::make_shared<SpriteCache>(file_path.str(), hash);
+  cache->open();
+  data_source->set_sprite_cache(cache);
+
+  return cache;
+}
+
+// Decode the sprites of the game view on the thread pool, so they are
+// ready by the time they are first drawn. Drawing a sprite that is still
+// being decoded waits for just that sprite.
+void
+Data::warm_up_sprites() {
+  /* In the order they are needed: the landscape, then what stands on it. */
+  const Resource resources[] = {
+    AssetMapGround, AssetMapMaskUp, AssetMapMaskDown, AssetPathGround,
+    AssetPathMask, AssetMapBorder, AssetMapWaves, AssetMapObject,
+    AssetMapShadow, AssetGameObject, AssetSerfShadow, AssetSerfTorso,
+    AssetSerfHead,
+  };
+
+  typedef std::pair<Resource, size_t> Item;
+  std::shared_ptr<std::vector<Item>> items =
+    std::make_shared<std::vector<Item>>();
+  for (Resource res : resources) {
+    for (size_t i = 0; i < get_resource_count(res); i++) {
+      items->push_back(std::make_pair(res, i));
+    }
+  }
+
+  /* Each task takes the next sprite in line, so the workers keep to the
+     order. */
+  ThreadPool &pool = ThreadPool::get_instance();
+  PDataSource source = data_source;
+  std::shared_ptr<std::atomic<size_t>> next =
+    std::make_shared<std::atomic<size_t>>(0);
+  for (size_t t = 0; t < pool.get_thread_count(); t++) {
+    pool.run([source, items, next]() {
+      for (size_t i = (*next)++; i < items->size(); i = (*next)++) {
+        const Item &item = (*items)[i];
+        source->get_decoded_sprite_parts(item.first, item.second);
+      }
+    });
+  }
+}
+
+static bool
+create_folder(const std::string &path) {
+#ifdef _WIN32
+  return (CreateDirectoryA(path.c_str(), nullptr) != FALSE) ||
+         (GetLastError() == ERROR_ALREADY_EXISTS);
+#else
+  return (mkdir(path.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH) == 0) ||
+         (errno == EEXIST);
+#endif
+}
+
+// Return folder for files that may be rebuilt, creating it if needed, or an
+// empty string if there is none.
+std::string
+Data::get_cache_folder() const {
+  std::string base;
+#ifdef _WIN32
+  const char *local = std::getenv("LOCALAPPDATA");
+  if (local != nullptr) base = local;
+#elif defined(__APPLE__)
+  const char *home = std::getenv("HOME");
+  if (home != nullptr) base = std::string(home) + "/Library/Caches";
+#else
+  const char *cache_home = std::getenv("XDG_CACHE_HOME");
+  const char *home = std::getenv("HOME");
+  if ((cache_home != nullptr) && (cache_home[0] != '\0')) {
+    base = cache_home;
+  } else if (home != nullptr) {
+    base = std::string(home) + "/.cache";
+  }
+#endif
+
+  if (base.empty() || !create_folder(base) ||
+      !create_folder(base + "/freeserf")) {
+    return std::string();
+  }
+
+  return base + "/freeserf";
 }
 
 // Return standard game data search paths for current platform.
@@ -29,6 +29,9 @@
 class DataSource;
 typedef std::shared_ptr<DataSource> PDataSource;
 
+class SpriteCache;
+typedef std::shared_ptr<SpriteCache> PSpriteCache;
+
 class Data;
 typedef std::unique_ptr<Data> PData;
 
@@ -81,6 +84,7 @@ class Data {
 
  protected:
   PDataSource data_source;
+  bool sprite_cache_enabled;
 
   Data();
 
@@ -93,6 +97,9 @@ class Data {
   static Data &get_instance();
 
   bool load(const std::string &path);
+  /* Keep decoded sprites in a file between runs. Takes effect on load. */
+  void set_sprite_cache_enabled(bool enabled) {
+    sprite_cache_enabled = enabled; }
 
   PDataSource get_data_source() const { return data_source; }
 
@@ -102,6 +109,9 @@ class Data {
 
  protected:
   std::list<std::string> get_standard_search_paths() const;
+  std::string get_cache_folder() const;
+  PSpriteCache open_sprite_cache();
+  void warm_up_sprites();
 };
 
 #endif  // SRC_DATA_H_
@@ -258,6 +258,8 @@ EventLoopSDL::run() {
           gfx.set_resolution(width, height, gfx.is_fullscreen());
           gfx.get_screen_factor(&screen_factor_x, &screen_factor_y);
           notify_resize(width, height);
+        } else if (SDL_WINDOWEVENT_EXPOSED == event.window.event) {
+          gfx.swap_buffers();
         }
         break;
       case SDL_USEREVENT:
@@ -288,10 +290,10 @@ EventLoopSDL::run() {
           if (screen == nullptr) {
             screen = gfx.get_screen_frame();
           }
-          notify_draw(screen);
-
-          // Swap video buffers
-          gfx.swap_buffers();
+          // Swap video buffers if anything was drawn
+          if (notify_draw(screen)) {
+            gfx.swap_buffers();
+          }
 
           SDL_FlushEvent(eventUserTypeStep);
         }
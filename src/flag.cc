@@ -30,8 +30,9 @@
 
 #define SEARCH_MAX_DEPTH  0x10000
 
-FlagSearch::FlagSearch(Game *game_) {
-  game = game_;
+FlagSearch::FlagSearch(Game *game_)
+  : game(game_)
+  , queue(game_->get_frame_allocator()) {
   id = game->next_search_id();
 }
 
@@ -1024,6 +1025,20 @@ Flag::unlink_building() {
   clear_flags();
 }
 
+void
+Flag::relink_endpoints() {
+  for (Direction d : cycle_directions_cw()) {
+    if (d == DirectionUpLeft && has_building()) {
+      Building *building = other_endpoint.b[d];
+      other_endpoint.b[d] = game->get_building(building->get_index());
+    } else if (has_path(d) && other_endpoint.f[d] != nullptr) {
+      other_endpoint.f[d] = game->get_flag(other_endpoint.f[d]->get_index());
+    } else {
+      other_endpoint.f[d] = nullptr;
+    }
+  }
+}
+
 SaveReaderBinary&
 operator >> (SaveReaderBinary &reader, Flag &flag) {
   flag.pos = 0; /* Set correctly later. */
@@ -1134,18 +1149,7 @@ operator >> (SaveReaderText &reader, Flag &flag) {
     int len;
     reader.value("length")[i] >> len;
     flag.length[i] = len;
-    unsigned int obj_index;
-    reader.value("other_endpoint")[i] >> obj_index;
-    if (flag.has_building() && (i == DirectionUpLeft)) {
-      flag.other_endpoint.b[DirectionUpLeft] =
-                                    flag.get_game()->create_building(obj_index);
-    } else {
-      Flag *other_flag = NULL;
-      if (obj_index != 0) {
-        other_flag = flag.get_game()->create_flag(obj_index);
-      }
-      flag.other_endpoint.f[i] = other_flag;
-    }
+    flag.other_endpoint.f[i] = NULL;
     reader.value("other_end_dir")[i] >> flag.other_end_dir[i];
   }
 
@@ -1161,8 +1165,25 @@ operator >> (SaveReaderText &reader, Flag &flag) {
   return reader;
 }
 
+void
+Flag::load_links(SaveReaderText *reader) {
+  for (Direction i : cycle_directions_cw()) {
+    unsigned int obj_index;
+    reader->value("other_endpoint")[i] >> obj_index;
+    if (has_building() && (i == DirectionUpLeft)) {
+      other_endpoint.b[DirectionUpLeft] = game->create_building(obj_index);
+    } else {
+      Flag *other_flag = NULL;
+      if (obj_index != 0) {
+        other_flag = game->create_flag(obj_index);
+      }
+      other_endpoint.f[i] = other_flag;
+    }
+  }
+}
+
 SaveWriterText&
-operator << (SaveWriterText &writer, Flag &flag) {
+operator << (SaveWriterText &writer, const Flag &flag) {
   writer.value("pos") << flag.game->get_map()->pos_col(flag.pos);
   writer.value("pos") << flag.game->get_map()->pos_row(flag.pos);
   writer.value("search_num") << flag.search_num;
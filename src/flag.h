@@ -25,6 +25,7 @@
 #include <vector>
 
 #include "src/building.h"
+#include "src/frame-arena.h"
 #include "src/objects.h"
 
 typedef struct SerfPathInfo {
@@ -169,8 +170,11 @@ class Flag : public GameObject {
     operator >> (SaveReaderBinary &reader, Flag &flag);
   friend SaveReaderText&
     operator >> (SaveReaderText &reader, Flag &flag);
+  /* Resolve the endpoints read by operator >>; the objects they refer to
+     must all have been created. */
+  void load_links(SaveReaderText *reader);
   friend SaveWriterText&
-    operator << (SaveWriterText &writer, Flag &flag);
+    operator << (SaveWriterText &writer, const Flag &flag);
 
   bool schedule_known_dest_cb_(Flag *src, Flag *dest, int slot);
 
@@ -180,6 +184,9 @@ class Flag : public GameObject {
 
   void link_building(Building *building);
   void unlink_building();
+  /* Point endpoints at the objects with the same indices in the game that
+   owns this flag. Used after copying the flag from another game. */
+  void relink_endpoints();
   Building *get_building() { return other_endpoint.b[DirectionUpLeft]; }
 
   void invalidate_resource_path(Direction dir);
@@ -216,6 +223,10 @@ class Flag : public GameObject {
   void schedule_slot_to_known_dest(int slot, unsigned int res_waiting[4]);
   bool call_transporter(Direction dir, bool water);
 
+  // Copies are relinked to the new game by relink_endpoints()
+  Flag(const Flag &that) = default;
+  template<class T, size_t growth> friend class Collection;
+
   friend class FlagSearch;
 };
 
@@ -224,7 +235,7 @@ typedef bool flag_search_func(Flag *flag, void *data);
 class FlagSearch {
  protected:
   Game *game;
-  std::vector<Flag*> queue;
+  FrameVector<Flag*> queue;
   int id;
 
  public:
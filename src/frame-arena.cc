@@ -0,0 +1,65 @@
+/*
+ * frame-arena.cc - Scratch memory released at the end of each game tick
+ *
+ * Copyright (C) 2026  freeserf developers
+ *
+ * This file is part of freeserf.
+ *
+ * freeserf is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * freeserf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with freeserf.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/frame-arena.h"
+
+#include <algorithm>
+
+FrameArena::FrameArena(size_t size)
+  : block(new char[size])
+  , block_size(size)
+  , used(0)
+  , extra_size(0)
+  , allocations(0)
+  , last_allocations(0) {
+}
+
+void *
+FrameArena::allocate(size_t size, size_t align) {
+  allocations++;
+
+  size_t offset = (used + align - 1) & ~(align - 1);
+  if (offset + size <= block_size) {
+    used = offset + size;
+    return block.get() + offset;
+  }
+
+  /* Memory from new[] is suitably aligned for any fundamental type. */
+  char *extra = new char[std::max<size_t>(size, 1)];
+  extra_blocks.push_back(std::unique_ptr<char[]>(extra));
+  extra_size += size;
+  return extra;
+}
+
+void
+FrameArena::reset() {
+  if (!extra_blocks.empty()) {
+    /* Grow so that the next tick fits into a single block. */
+    extra_blocks.clear();
+    block_size += extra_size;
+    block.reset(new char[block_size]);
+    extra_size = 0;
+  }
+
+  used = 0;
+  last_allocations = allocations;
+  allocations = 0;
+}
@@ -0,0 +1,122 @@
+/*
+ * frame-arena.h - Scratch memory released at the end of each game tick
+ *
+ * Copyright (C) 2026  freeserf developers
+ *
+ * This file is part of freeserf.
+ *
+ * freeserf is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * freeserf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with freeserf.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SRC_FRAME_ARENA_H_
+#define SRC_FRAME_ARENA_H_
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <new>
+#include <vector>
+
+// Bump pointer allocator for short lived buffers. Allocations are never freed
+// individually; reset() releases all of them at once. When the current block
+// is exhausted further allocations go to extra blocks, and the next reset()
+// replaces everything by a single block large enough for the whole tick.
+class FrameArena {
+ protected:
+  typedef std::vector<std::unique_ptr<char[]>> Blocks;
+
+  std::unique_ptr<char[]> block;
+  size_t block_size;
+  size_t used;
+  Blocks extra_blocks;
+  size_t extra_size;
+
+  size_t allocations;
+  size_t last_allocations;
+
+ public:
+  explicit FrameArena(size_t size = 64*1024);
+
+  void *allocate(size_t size, size_t align);
+
+  template<class T> T *allocate(size_t count) {
+    return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+  }
+
+  /* Release all allocations. */
+  void reset();
+
+  size_t get_size() const { return block_size; }
+  /* Allocations since the last reset. */
+  size_t get_allocations() const { return allocations; }
+  /* Allocations between the last two resets, each one a heap allocation
+     that was avoided. */
+  size_t get_last_allocations() const { return last_allocations; }
+
+ protected:
+  FrameArena(const FrameArena &that) = delete;
+  FrameArena &operator = (const FrameArena &that) = delete;
+};
+
+// Standard allocator on a FrameArena. Without an arena it falls back to the
+// heap, so containers using it can also be created outside of a tick.
+template<class T>
+class FrameAllocator {
+ public:
+  typedef T value_type;
+
+  FrameArena *arena;
+
+  FrameAllocator() : arena(nullptr) {}
+  explicit FrameAllocator(FrameArena *_arena) : arena(_arena) {}
+  template<class U>
+  FrameAllocator(const FrameAllocator<U> &that)  // NOLINT(runtime/explicit)
+    : arena(that.arena) {}
+
+  T *allocate(size_t count) {
+    if (arena == nullptr) {
+      return static_cast<T*>(::operator new(count * sizeof(T)));
+    }
+    return arena->allocate<T>(count);
+  }
+
+  void deallocate(T *p, size_t /*count*/) {
+    if (arena == nullptr) {
+      ::operator delete(p);
+    }
+  }
+
+  template<class U>
+  bool operator == (const FrameAllocator<U> &that) const {
+    return arena == that.arena;
+  }
+  template<class U>
+  bool operator != (const FrameAllocator<U> &that) const {
+    return arena != that.arena;
+  }
+};
+
+template<class T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
+
+template<class T>
+using FrameList = std::list<T, FrameAllocator<T>>;
+
+template<class K, class V>
+using FrameMap = std::map<K, V, std::less<K>,
+                          FrameAllocator<std::pair<const K, V>>>;
+
+#endif  // SRC_FRAME_ARENA_H_
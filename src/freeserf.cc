@@ -32,6 +32,8 @@
 #include "src/interface.h"
 #include "src/game-manager.h"
 #include "src/command_line.h"
+#include "src/savegame.h"
+#include "src/viewport.h"
 
 #ifdef WIN32
 # include <SDL.h>
@@ -45,8 +47,17 @@ main(int argc, char *argv[]) {
   unsigned int screen_width = 0;
   unsigned int screen_height = 0;
   bool fullscreen = false;
+  bool threaded = false;
 
   CommandLine command_line;
+  command_line.add_option('c', "Memory for cached landscape tiles in MiB")
+                .add_parameter("SIZE", [](std::istream& s) {
+                  unsigned int size = 0;
+                  s >> size;
+                  Viewport::set_tile_cache_budget(static_cast<size_t>(size) *
+                                                  1024*1024);
+                  return true;
+                });
   command_line.add_option('d', "Set Debug output level")
                 .add_parameter("NUM", [](std::istream& s) {
                   int d;
@@ -67,6 +78,14 @@ main(int argc, char *argv[]) {
                   command_line.show_help();
                   exit(EXIT_SUCCESS);
                 });
+  command_line.add_option('i', "Memory for cached images in MiB")
+                .add_parameter("SIZE", [](std::istream& s) {
+                  unsigned int size = 0;
+                  s >> size;
+                  Image::set_cache_budget(static_cast<size_t>(size) *
+                                          1024*1024);
+                  return true;
+                });
   command_line.add_option('l', "Load saved game")
                 .add_parameter("FILE", [&save_file](std::istream& s) {
                   std::getline(s, save_file);
@@ -80,6 +99,14 @@ main(int argc, char *argv[]) {
                   s >> screen_height;
                   return true;
                 });
+  command_line.add_option('s', "Keep decoded sprites in a cache file", [](){
+                  Data::get_instance().set_sprite_cache_enabled(true);
+                });
+  command_line.add_option('t', "Run game simulation on a separate thread",
+                          [&threaded](){ threaded = true; });
+  command_line.add_option('z', "Compress saved games", [](){
+                  GameStore::get_instance().set_compression(true);
+                });
   command_line.set_comment("Please report bugs to <" PACKAGE_BUGREPORT ">");
   if (!command_line.process(argc, argv)) {
     return EXIT_FAILURE;
@@ -125,6 +152,7 @@ main(int argc, char *argv[]) {
   }
   interface.set_size(screen_width, screen_height);
   interface.set_displayed(true);
+  interface.set_threaded(threaded);
 
   if (save_file.empty()) {
     interface.open_game_init();
@@ -22,9 +22,11 @@
 #include "src/game-init.h"
 
 #include <algorithm>
+#include <iomanip>
 #include <sstream>
 #include <string>
 
+#include "src/freeserf.h"
 #include "src/misc.h"
 #include "src/mission.h"
 #include "src/data.h"
@@ -118,6 +120,15 @@ GameInitBox::GameInitBox(Interface *interface)
   file_list->set_size(160, 160);
   file_list->set_displayed(false);
   file_list->set_selection_handler([this](const std::string &item) {
+    /* Indexed saves are previewed without loading them. */
+    if (GameStore::get_instance().get_save_info(item, &save_info)) {
+      this->minimap->set_displayed(false);
+      set_redraw();
+      return;
+    }
+
+    save_info = GameStore::SaveInfo();
+    this->minimap->set_displayed(true);
     Game game;
     if (GameStore::get_instance().load(item, &game)) {
       this->map = game.get_map();
@@ -155,6 +166,57 @@ GameInitBox::draw_background() {
   }
 }
 
+/* Draw the metadata and thumbnail of the selected save in place of the
+   minimap. */
+void
+GameInitBox::draw_save_info() {
+  if (save_info.map_size == 0) {
+    draw_box_string(10, 18, "Unable to load");
+    return;
+  }
+
+  std::stringstream str_map_size;
+  str_map_size << save_info.map_size;
+  draw_box_string(10, 18, "Mapsize:");
+  draw_box_string(18, 18, str_map_size.str());
+
+  unsigned int minutes = save_info.tick / TICKS_PER_SEC / 60;
+  std::stringstream str_time;
+  str_time << (minutes / 60) << ":" << std::setw(2) << std::setfill('0')
+           << (minutes % 60);
+  draw_box_string(21, 18, "Time:");
+  draw_box_string(26, 18, str_time.str());
+
+  /* Colors of the terrain types, Map::Terrain. */
+  static const Color terrain_colors[] = {
+    Color(0x07, 0x07, 0xb3), Color(0x0b, 0x0b, 0xb7),
+    Color(0x13, 0x13, 0xbb), Color(0x13, 0x13, 0xbb),
+    Color(0x73, 0xb3, 0x43), Color(0x63, 0xa3, 0x33),
+    Color(0x53, 0x8b, 0x23), Color(0x3f, 0x73, 0x13),
+    Color(0xef, 0xcf, 0xaf), Color(0xd7, 0xb3, 0x8f),
+    Color(0xbf, 0x97, 0x73), Color(0x9f, 0x6f, 0x4f),
+    Color(0x87, 0x57, 0x3b), Color(0x73, 0x43, 0x2b),
+    Color(0xef, 0xef, 0xef), Color(0xff, 0xff, 0xff)
+  };
+
+  const int scale = 2;
+  int left = 190 + (150 - SAVE_THUMBNAIL_SIZE * scale) / 2;
+  int top = 55 + (160 - SAVE_THUMBNAIL_SIZE * scale) / 2;
+  for (unsigned int y = 0; y < SAVE_THUMBNAIL_SIZE; y++) {
+    for (unsigned int x = 0; x < SAVE_THUMBNAIL_SIZE; x++) {
+      unsigned int sample = save_info.thumbnail[y * SAVE_THUMBNAIL_SIZE + x];
+      unsigned int owner = sample >> 4;
+      Color color = terrain_colors[sample & 0x0f];
+      if (owner != 0 && owner <= save_info.player_colors.size()) {
+        uint32_t c = save_info.player_colors[owner - 1];
+        color = Color((c >> 16) & 0xff, (c >> 8) & 0xff, c & 0xff);
+      }
+      frame->fill_rect(left + x * scale, top + y * scale, scale, scale,
+                       color);
+    }
+  }
+}
+
 /* Get the sprite number for a face. */
 unsigned int
 GameInitBox::get_player_face_sprite(size_t face) {
@@ -215,6 +277,9 @@ GameInitBox::internal_draw() {
       draw_box_icon(5, 0, 316);  // Game type
 
       draw_box_string(10, 2, "Load game");
+      if (save_info.has_metadata) {
+        draw_save_info();
+      }
 
       break;
     }
@@ -323,6 +388,8 @@ GameInitBox::handle_action(int action) {
         }
         case GameCustom: {
           mission = custom_mission;
+          save_info = GameStore::SaveInfo();
+          minimap->set_displayed(true);
           random_input->set_displayed(true);
           random_input->set_random(custom_mission->get_random_base());
           file_list->set_displayed(false);
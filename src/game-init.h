@@ -28,6 +28,7 @@
 #include "src/gui.h"
 #include "src/game.h"
 #include "src/mission.h"
+#include "src/savegame.h"
 
 class Interface;
 class RandomInput;
@@ -66,6 +67,7 @@ class GameInitBox : public GuiObject {
   PMap map;
   std::unique_ptr<Minimap> minimap;
   std::unique_ptr<ListSavedFiles> file_list;
+  GameStore::SaveInfo save_info;
 
  public:
   explicit GameInitBox(Interface *interface);
@@ -76,6 +78,7 @@ class GameInitBox : public GuiObject {
   void draw_box_string(int x, int y, const std::string &str);
   void draw_player_box(unsigned int player, int x, int y);
   void draw_background();
+  void draw_save_info();
   unsigned int get_player_face_sprite(size_t face);
   void handle_action(int action);
   bool handle_player_click(unsigned int player, int x, int y);
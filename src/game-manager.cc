@@ -24,6 +24,7 @@
 #include <string>
 #include <utility>
 
+#include "src/ai.h"
 #include "src/savegame.h"
 
 GameManager &
@@ -79,6 +80,7 @@ GameManager::start_game(PGameInfo game_info) {
   if (!new_game) {
     return false;
   }
+  new_game->start_ai(AI_DEFAULT_BUDGET);
 
   set_current_game(new_game);
 
@@ -91,6 +93,7 @@ GameManager::load_game(const std::string &path) {
   if (!GameStore::get_instance().load(path, new_game.get())) {
     return false;
   }
+  new_game->start_ai(AI_DEFAULT_BUDGET);
 
   set_current_game(new_game);
   new_game->pause();
@@ -0,0 +1,159 @@
+/*
+ * game-thread.cc - Game simulation running on a separate thread
+ *
+ * Copyright (C) 2026  freeserf developers
+ *
+ * This file is part of freeserf.
+ *
+ * freeserf is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * freeserf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with freeserf.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/game-thread.h"
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <utility>
+
+#include "src/log.h"
+
+/* Number of ticks the simulation may fall behind before it gives up
+   catching up. */
+#define MAX_TICK_LAG  10
+
+GameThread::GameThread(PGame _game, unsigned int _tick_length)
+  : game(std::move(_game))
+  , tick_length(_tick_length)
+  , running(false)
+  , height_mark(0)
+  , object_mark(0) {
+  game->get_map()->add_change_handler(this);
+
+  /* Make an initial state available before the first tick. */
+  std::unique_lock<std::mutex> game_lock(game_mutex);
+  publish_state();
+}
+
+GameThread::~GameThread() {
+  stop();
+  game->get_map()->del_change_handler(this);
+}
+
+void
+GameThread::start() {
+  if (running) {
+    return;
+  }
+
+  Log::Debug["game-thread"] << "Starting simulation thread.";
+  running = true;
+  thread = std::thread(&GameThread::run, this);
+}
+
+void
+GameThread::stop() {
+  if (!running) {
+    return;
+  }
+
+  running = false;
+  thread.join();
+  Log::Debug["game-thread"] << "Simulation thread stopped.";
+}
+
+void
+GameThread::post(Command command) {
+  std::lock_guard<std::mutex> commands_lock(commands_mutex);
+  commands.push_back(std::move(command));
+}
+
+void
+GameThread::step() {
+  std::vector<Command> pending;
+  {
+    std::lock_guard<std::mutex> commands_lock(commands_mutex);
+    pending.swap(commands);
+  }
+
+  std::unique_lock<std::mutex> game_lock(game_mutex);
+  for (Command &command : pending) {
+    command(game.get());
+  }
+
+  game->update();
+  publish_state();
+}
+
+GameThread::State *
+GameThread::fetch_state() {
+  if (!states.fetch()) {
+    return nullptr;
+  }
+
+  return &states.get_front();
+}
+
+/* Publish a fork of the game as the new render state. Must be called with
+   the game lock held, as the change lists are also filled by changes made
+   through the lock. Forking is skipped while the consumer has not fetched
+   the last state, the changes are then carried to the next one. */
+void
+GameThread::publish_state() {
+  if (states.is_pending()) {
+    return;
+  }
+
+  State &state = states.get_back();
+  PGame previous = std::move(state.game);
+  state.game = game->fork();
+  state.height_changes = height_changes;
+  state.object_changes = object_changes;
+
+  if (!states.publish()) {
+    /* The previous state was fetched, so were the changes made before it. */
+    height_changes.erase(height_changes.begin(),
+                         height_changes.begin() + height_mark);
+    object_changes.erase(object_changes.begin(),
+                         object_changes.begin() + object_mark);
+  }
+  height_mark = height_changes.size();
+  object_mark = object_changes.size();
+}
+
+void
+GameThread::run() {
+  typedef std::chrono::steady_clock Clock;
+  const Clock::duration tick = std::chrono::milliseconds(tick_length);
+
+  Clock::time_point next = Clock::now();
+  while (running) {
+    step();
+
+    next += tick;
+    Clock::time_point now = Clock::now();
+    if (now > next + MAX_TICK_LAG*tick) {
+      Log::Verbose["game-thread"] << "Simulation is falling behind.";
+      next = now;
+    }
+    std::this_thread::sleep_until(next);
+  }
+}
+
+void
+GameThread::on_height_changed(MapPos pos) {
+  height_changes.push_back(pos);
+}
+
+void
+GameThread::on_object_changed(MapPos pos) {
+  object_changes.push_back(pos);
+}
@@ -0,0 +1,106 @@
+/*
+ * game-thread.h - Game simulation running on a separate thread
+ *
+ * Copyright (C) 2026  freeserf developers
+ *
+ * This file is part of freeserf.
+ *
+ * freeserf is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * freeserf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with freeserf.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SRC_GAME_THREAD_H_
+#define SRC_GAME_THREAD_H_
+
+#include <atomic>  // NOLINT(build/c++11)
+#include <functional>
+#include <mutex>  // NOLINT(build/c++11)
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "src/game.h"
+#include "src/map.h"
+#include "src/triple-buffer.h"
+
+// Runs the game updates on a dedicated thread at a fixed tick rate.
+//
+// After each tick a copy-on-write fork of the game is published as the
+// render state, so drawing never has to wait for the simulation. No fork is
+// taken while the previously published state was not fetched yet. Commands
+// posted from other threads are applied between ticks. Code that needs to
+// access the live game directly must hold the lock returned by lock(); the
+// simulation thread holds it while applying commands and updating the game.
+class GameThread : public Map::Handler {
+ public:
+  typedef std::function<void(Game *game)> Command;
+
+  class State {
+   public:
+    PGame game;
+    // Map positions changed since the previously fetched state.
+    std::vector<MapPos> height_changes;
+    std::vector<MapPos> object_changes;
+  };
+
+ protected:
+  PGame game;
+  unsigned int tick_length;
+
+  std::thread thread;
+  std::atomic<bool> running;
+  std::mutex game_mutex;
+
+  std::mutex commands_mutex;
+  std::vector<Command> commands;
+
+  TripleBuffer<State> states;
+  // Changes not yet known to be seen by the consumer; the ones before the
+  // marks were made before the last published state.
+  std::vector<MapPos> height_changes;
+  std::vector<MapPos> object_changes;
+  size_t height_mark;
+  size_t object_mark;
+
+ public:
+  GameThread(PGame game, unsigned int tick_length);
+  virtual ~GameThread();
+
+  void start();
+  void stop();
+  bool is_running() const { return running; }
+
+  // Queue command to be applied to the game before the next tick.
+  void post(Command command);
+
+  // Run a single tick on the calling thread. Only to be used while the
+  // thread is not running.
+  void step();
+
+  std::unique_lock<std::mutex> lock() {
+    return std::unique_lock<std::mutex>(game_mutex);
+  }
+
+  // Fetch the most recently published render state. Returns nullptr if no
+  // new state was published since the last call.
+  State *fetch_state();
+
+  // Map::Handler implementation
+  virtual void on_height_changed(MapPos pos);
+  virtual void on_object_changed(MapPos pos);
+
+ protected:
+  void run();
+  void publish_state();
+};
+
+#endif  // SRC_GAME_THREAD_H_
@@ -30,7 +30,10 @@
 #include <map>
 #include <memory>
 #include <sstream>
+#include <utility>
+#include <vector>
 
+#include "src/ai.h"
 #include "src/savegame.h"
 #include "src/debug.h"
 #include "src/log.h"
@@ -39,6 +42,7 @@
 #include "src/map.h"
 #include "src/map-generator.h"
 #include "src/map-geometry.h"
+#include "src/thread-pool.h"
 
 #define GROUND_ANALYSIS_RADIUS  25
 
@@ -100,6 +104,7 @@ Game::Game()
 }
 
 Game::~Game() {
+  ai.reset();
   serfs.clear();
   inventories.clear();
   buildings.clear();
@@ -107,6 +112,68 @@ Game::~Game() {
   players.clear();
 }
 
+Game::Game(const Game &that)
+  : map(std::make_shared<Map>(*that.map))
+  , map_gold_morale_factor(that.map_gold_morale_factor)
+  , gold_total(that.gold_total)
+  , players(that.players, this)
+  , flags(that.flags, this)
+  , inventories(that.inventories, this)
+  , buildings(that.buildings, this)
+  , serfs(that.serfs, this)
+  , init_map_rnd(that.init_map_rnd)
+  , game_speed_save(that.game_speed_save)
+  , game_speed(that.game_speed)
+  , tick(that.tick)
+  , last_tick(that.last_tick)
+  , const_tick(that.const_tick)
+  , game_stats_counter(that.game_stats_counter)
+  , history_counter(that.history_counter)
+  , rnd(that.rnd)
+  , next_index(that.next_index)
+  , flag_search_counter(that.flag_search_counter)
+  , update_map_last_tick(that.update_map_last_tick)
+  , update_map_counter(that.update_map_counter)
+  , update_map_initial_pos(that.update_map_initial_pos)
+  , tick_diff(that.tick_diff)
+  , max_next_index(that.max_next_index)
+  , update_map_16_loop(that.update_map_16_loop)
+  , resource_history_index(that.resource_history_index)
+  , field_340(that.field_340)
+  , field_342(that.field_342)
+  , field_344(nullptr)
+  , game_type(that.game_type)
+  , tutorial_level(that.tutorial_level)
+  , mission_level(that.mission_level)
+  , map_preserve_bugs(that.map_preserve_bugs)
+  , player_score_leader(that.player_score_leader)
+  , knight_morale_counter(that.knight_morale_counter)
+  , inventory_schedule_counter(that.inventory_schedule_counter) {
+  std::copy(std::begin(that.player_history_index),
+            std::end(that.player_history_index),
+            std::begin(player_history_index));
+  std::copy(std::begin(that.player_history_counter),
+            std::end(that.player_history_counter),
+            std::begin(player_history_counter));
+
+  /* Copied objects still point into the original game. */
+  for (Flag *flag : flags) {
+    flag->relink_endpoints();
+  }
+
+  for (Building *building : buildings) {
+    if (building->has_inventory()) {
+      unsigned int index = building->get_inventory()->get_index();
+      building->set_inventory(inventories[index]);
+    }
+  }
+}
+
+PGame
+Game::fork() const {
+  return PGame(new Game(*this));
+}
+
 /* Clear the serf request bit of all flags and buildings.
    This allows the flag or building to try and request a
    serf again. */
@@ -473,14 +540,14 @@ Game::update_buildings() {
   }
 }
 
-/* Update serfs as part of the game progression. */
+/* Update serfs as part of the game progression. Serfs are looked up by
+   index as an update may delete other serfs, e.g. the loser of a fight, or
+   create new ones. */
 void
 Game::update_serfs() {
-  Serfs::Iterator i = serfs.begin();
-  while (i != serfs.end()) {
-    Serf *serf = *i;
-    ++i;
-    if (serf->get_index() != 0) {
+  for (unsigned int i = 1; i < serfs.get_index_limit(); i++) {
+    Serf *serf = serfs[i];
+    if (serf != nullptr) {
       serf->update();
     }
   }
@@ -574,7 +641,7 @@ Game::update_game_stats() {
       }
     }
 
-    std::map<unsigned int, unsigned int> values;
+    Values values(get_frame_allocator());
 
     /* Store land area stats in history. */
     for (Player *player : players) {
@@ -656,33 +723,27 @@ Game::update() {
     inventory_schedule_counter += 64;
   }
 
-#if 0
   /* AI related updates */
-  game.next_index = (game.next_index + 1) % game.max_next_index;
-  if (game.next_index > 32) {
-    for (int i = 0; i < game.max_next_index) {
-      int i = 33 - game.next_index;
-      player_t *player = game.player[i & 3];
-      if (PLAYER_IS_ACTIVE(player) && PLAYER_IS_AI(player)) {
-        /* AI */
-        /* TODO */
-      }
-      game.next_index += 1;
-    }
-  } else if (game.game_speed > 0 &&
-       game.max_flag_index < 50) {
-    player_t *player = game.player[game.next_index & 3];
-    if (PLAYER_IS_ACTIVE(player) && PLAYER_IS_AI(player)) {
-      /* AI */
-      /* TODO */
-    }
+  if (ai) {
+    ai->update(this);
   }
-#endif
 
   update_flags();
   update_buildings();
   update_serfs();
   update_game_stats();
+
+  frame_arena.reset();
+}
+
+void
+Game::start_ai(unsigned int budget) {
+  ai.reset(new AIScheduler(budget));
+  for (Player *player : players) {
+    if (player->is_ai()) {
+      ai->add_player(player->get_index());
+    }
+  }
 }
 
 /* Pause or unpause the game. */
@@ -1717,8 +1778,8 @@ Game::update_land_ownership(MapPos init_pos) {
 
   size_t temp_arr_size = calculate_diameter * calculate_diameter *
                          players.size();
-  std::unique_ptr<int[]> temp_arr =
-    std::unique_ptr<int[]>(new int[temp_arr_size]());
+  int *temp_arr = frame_arena.allocate<int>(temp_arr_size);
+  std::fill(temp_arr, temp_arr + temp_arr_size, 0);
 
   const int military_influence[] = {
     0, 1, 2, 4, 7, 12, 18, 29, -1, -1,  /* hut */
@@ -1778,7 +1839,7 @@ Game::update_land_ownership(MapPos init_pos) {
           const int *closeness = map_closeness +
                                  influence_diameter*std::max(-i, 0) +
                                  std::max(-j, 0);
-          int *arr = temp_arr.get() +
+          int *arr = temp_arr +
             (building->get_owner() * calculate_diameter*calculate_diameter) +
             calculate_diameter * std::max(i, 0) + std::max(j, 0);
 
@@ -1808,7 +1869,7 @@ Game::update_land_ownership(MapPos init_pos) {
       int max_val = 0;
       int player_index = -1;
       for (Player *player : players) {
-        const int *arr = temp_arr.get() +
+        const int *arr = temp_arr +
           player->get_index()*calculate_diameter*calculate_diameter +
           calculate_diameter*(i+calculate_radius) + (j+calculate_radius);
         if (*arr > max_val) {
@@ -2110,7 +2171,7 @@ Game::delete_building(Building *building) {
 
 Game::ListSerfs
 Game::get_player_serfs(Player *player) {
-  ListSerfs player_serfs;
+  ListSerfs player_serfs(get_frame_allocator());
 
   for (Serf *serf : serfs) {
     if (serf->get_owner() == player->get_index()) {
@@ -2123,7 +2184,7 @@ Game::get_player_serfs(Player *player) {
 
 Game::ListBuildings
 Game::get_player_buildings(Player *player) {
-  ListBuildings player_buildings;
+  ListBuildings player_buildings(get_frame_allocator());
 
   for (Building *building : buildings) {
     if (building->get_owner() == player->get_index()) {
@@ -2136,7 +2197,7 @@ Game::get_player_buildings(Player *player) {
 
 Game::ListInventories
 Game::get_player_inventories(Player *player) {
-  ListInventories player_inventories;
+  ListInventories player_inventories(get_frame_allocator());
 
   for (Inventory *inventory : inventories) {
     if (inventory->get_owner() == player->get_index()) {
@@ -2149,7 +2210,7 @@ Game::get_player_inventories(Player *player) {
 
 Game::ListSerfs
 Game::get_serfs_at_pos(MapPos pos) {
-  ListSerfs result;
+  ListSerfs result(get_frame_allocator());
 
   for (Serf *serf : serfs) {
     if (serf->get_pos() == pos) {
@@ -2162,7 +2223,7 @@ Game::get_serfs_at_pos(MapPos pos) {
 
 Game::ListSerfs
 Game::get_serfs_in_inventory(Inventory *inventory) {
-  ListSerfs result;
+  ListSerfs result(get_frame_allocator());
 
   for (Serf *serf : serfs) {
     if (serf->get_state() == Serf::StateIdleInStock &&
@@ -2176,7 +2237,7 @@ Game::get_serfs_in_inventory(Inventory *inventory) {
 
 Game::ListSerfs
 Game::get_serfs_related_to(unsigned int dest, Direction dir) {
-  ListSerfs result;
+  ListSerfs result(get_frame_allocator());
 
   for (Serf *serf : serfs) {
     if (serf->is_related_to(dest, dir)) {
@@ -2217,8 +2278,9 @@ Game::get_enemy_score(const Player *player) const {
 void
 Game::building_captured(Building *building) {
   /* Save amount of land and buildings for each player */
-  std::map<int, int> land_before;
-  std::map<int, int> buildings_before;
+  typedef FrameMap<int, int> Counts;
+  Counts land_before(get_frame_allocator());
+  Counts buildings_before(get_frame_allocator());
   for (Player *player : players) {
     land_before[player->get_index()] = player->get_land_area();
     buildings_before[player->get_index()] = player->get_building_score();
@@ -2371,7 +2433,7 @@ bool
 Game::load_serfs(SaveReaderBinary *reader, int max_serf_index) {
   /* Load serf bitmap. */
   int bitmap_size = 4*((max_serf_index + 31)/32);
-  uint8_t *bitmap = reader->read(bitmap_size);
+  const uint8_t *bitmap = reader->read(bitmap_size);
   if (bitmap == NULL) return false;
 
   /* Load serf data. */
@@ -2391,7 +2453,7 @@ bool
 Game::load_flags(SaveReaderBinary *reader, int max_flag_index) {
   /* Load flag bitmap. */
   int bitmap_size = 4*((max_flag_index + 31)/32);
-  uint8_t *bitmap = reader->read(bitmap_size);
+  const uint8_t *bitmap = reader->read(bitmap_size);
   if (bitmap == NULL) return false;
 
   /* Load flag data. */
@@ -2419,7 +2481,7 @@ bool
 Game::load_buildings(SaveReaderBinary *reader, int max_building_index) {
   /* Load building bitmap. */
   int bitmap_size = 4*((max_building_index + 31)/32);
-  uint8_t *bitmap = reader->read(bitmap_size);
+  const uint8_t *bitmap = reader->read(bitmap_size);
   if (bitmap == NULL) return false;
 
   /* Load building data. */
@@ -2449,7 +2511,7 @@ bool
 Game::load_inventories(SaveReaderBinary *reader, int max_inventory_index) {
   /* Load inventory bitmap. */
   int bitmap_size = 4*((max_inventory_index + 31)/32);
-  uint8_t *bitmap = reader->read(bitmap_size);
+  const uint8_t *bitmap = reader->read(bitmap_size);
   if (bitmap == NULL) return false;
 
   /* Load inventory data. */
@@ -2487,6 +2549,25 @@ Game::get_serf_at_pos(MapPos pos) {
   return serfs[map->get_serf_index(pos)];
 }
 
+/* Create the object of each section in objects. A later section for the
+   same object replaces an earlier one. */
+template<class T, size_t growth>
+static void
+stage_objects(const Readers &sections, Collection<T, growth> *objects,
+              std::vector<std::pair<SaveReaderText*, T*>> *staged) {
+  std::map<unsigned int, size_t> positions;
+  for (SaveReaderText *section : sections) {
+    unsigned int index = section->get_number();
+    auto it = positions.find(index);
+    if (it != positions.end()) {
+      (*staged)[it->second].first = section;
+      continue;
+    }
+    positions[index] = staged->size();
+    staged->push_back(std::make_pair(section, objects->get_or_insert(index)));
+  }
+}
+
 SaveReaderText&
 operator >> (SaveReaderText &reader, Game &game) {
   /* Load essential values for calculating map positions
@@ -2508,11 +2589,16 @@ operator >> (SaveReaderText &reader, Game &game) {
     size = (col_size + row_size) - 9;
   }
 
-  /* Initialize remaining map dimensions. */
+  /* Initialize remaining map dimensions. Each map section covers its own
+     block of tiles, so the blocks are loaded in parallel. */
   game.map.reset(new Map(MapGeometry(size)));
-  for (SaveReaderText* subreader : reader.get_sections("map")) {
-    *subreader >> *game.map;
-  }
+  ThreadPool &pool = ThreadPool::get_instance();
+  Readers map_sections = reader.get_sections("map");
+  std::vector<SaveReaderText*> blocks(map_sections.begin(),
+                                      map_sections.end());
+  pool.run_for(blocks.size(), [&blocks, &game](size_t i) {
+    *blocks[i] >> *game.map;
+  });
 
 //  std::string version;
 //  reader.value("version") >> version;
@@ -2568,25 +2654,46 @@ operator >> (SaveReaderText &reader, Game &game) {
     *subreader >> *p;
   }
 
-  for (SaveReaderText* subreader : reader.get_sections("flag")) {
-    Flag *p = game.flags.get_or_insert(subreader->get_number());
-    *subreader >> *p;
-  }
-
-  sections = reader.get_sections("building");
-  for (SaveReaderText* subreader : reader.get_sections("building")) {
-    Building *p = game.buildings.get_or_insert(subreader->get_number());
-    *subreader >> *p;
-  }
-
-  for (SaveReaderText* subreader : reader.get_sections("inventory")) {
-    Inventory *p = game.inventories.get_or_insert(subreader->get_number());
-    *subreader >> *p;
-  }
-
-  for (SaveReaderText* subreader : reader.get_sections("serf")) {
-    Serf *p = game.serfs.get_or_insert(subreader->get_number());
-    *subreader >> *p;
+  /* All objects are created up front. Reading a section then only writes
+     to its own object and can be done in parallel, while references to
+     other objects are resolved afterwards. */
+  std::vector<std::pair<SaveReaderText*, Flag*>> flags;
+  stage_objects(reader.get_sections("flag"), &game.flags, &flags);
+  std::vector<std::pair<SaveReaderText*, Building*>> buildings;
+  stage_objects(reader.get_sections("building"), &game.buildings,
+                &buildings);
+  std::vector<std::pair<SaveReaderText*, Inventory*>> inventories;
+  stage_objects(reader.get_sections("inventory"), &game.inventories,
+                &inventories);
+  std::vector<std::pair<SaveReaderText*, Serf*>> serfs;
+  stage_objects(reader.get_sections("serf"), &game.serfs, &serfs);
+
+  size_t object_count = flags.size() + buildings.size() + inventories.size() +
+                        serfs.size();
+  pool.run_for(object_count, [&](size_t i) {
+    if (i < flags.size()) {
+      *flags[i].first >> *flags[i].second;
+      return;
+    }
+    i -= flags.size();
+    if (i < buildings.size()) {
+      *buildings[i].first >> *buildings[i].second;
+      return;
+    }
+    i -= buildings.size();
+    if (i < inventories.size()) {
+      *inventories[i].first >> *inventories[i].second;
+      return;
+    }
+    i -= inventories.size();
+    *serfs[i].first >> *serfs[i].second;
+  });
+
+  for (auto &flag : flags) {
+    flag.second->load_links(flag.first);
+  }
+  for (auto &building : buildings) {
+    building.second->load_links(building.first);
   }
 
   /* Restore idle serf flag */
@@ -2673,38 +2780,39 @@ operator << (SaveWriterText &writer, Game &game) {
   writer.value("update_state.initial_pos") << game.map->pos_row(
     update_state.initial_pos);
 
-  for (Player *player : game.players) {
-    SaveWriterText &player_writer = writer.add_section("player",
-                                                       player->get_index());
-    player_writer << *player;
+  /* Sections are written in the order the text format stores them in, so
+     the text writer can stream them. */
+  for (unsigned int i : SaveTextOrder(game.buildings.get_index_limit())) {
+    if (i == 0 || !game.buildings.exists(i)) continue;
+    SaveWriterText &building_writer = writer.add_section("building", i);
+    building_writer << *game.buildings[i];
   }
 
-  for (Flag *flag : game.flags) {
-    if (flag->get_index() == 0) continue;
-    SaveWriterText &flag_writer = writer.add_section("flag", flag->get_index());
-    flag_writer << *flag;
+  for (unsigned int i : SaveTextOrder(game.flags.get_index_limit())) {
+    if (i == 0 || !game.flags.exists(i)) continue;
+    SaveWriterText &flag_writer = writer.add_section("flag", i);
+    flag_writer << *game.flags[i];
   }
 
-  for (Building *building : game.buildings) {
-    if (building->get_index() == 0) continue;
-    SaveWriterText &building_writer = writer.add_section("building",
-                                                         building->get_index());
-    building_writer << *building;
+  for (unsigned int i : SaveTextOrder(game.inventories.get_index_limit())) {
+    if (!game.inventories.exists(i)) continue;
+    SaveWriterText &inventory_writer = writer.add_section("inventory", i);
+    inventory_writer << *game.inventories[i];
   }
 
-  for (Inventory *inventory : game.inventories) {
-    SaveWriterText &inventory_writer = writer.add_section("inventory",
-                                                        inventory->get_index());
-    inventory_writer << *inventory;
-  }
+  writer << *game.map;
 
-  for (Serf *serf : game.serfs) {
-    if (serf->get_index() == 0) continue;
-    SaveWriterText &serf_writer = writer.add_section("serf", serf->get_index());
-    serf_writer << *serf;
+  for (unsigned int i : SaveTextOrder(game.players.get_index_limit())) {
+    if (!game.players.exists(i)) continue;
+    SaveWriterText &player_writer = writer.add_section("player", i);
+    player_writer << *game.players[i];
   }
 
-  writer << *game.map;
+  for (unsigned int i : SaveTextOrder(game.serfs.get_index_limit())) {
+    if (i == 0 || !game.serfs.exists(i)) continue;
+    SaveWriterText &serf_writer = writer.add_section("serf", i);
+    serf_writer << *game.serfs[i];
+  }
 
   return writer;
 }
@@ -28,6 +28,7 @@
 #include <list>
 #include <memory>
 
+#include "src/frame-arena.h"
 #include "src/player.h"
 #include "src/flag.h"
 #include "src/serf.h"
@@ -43,12 +44,17 @@
 class SaveReaderBinary;
 class SaveReaderText;
 class SaveWriterText;
+class AIScheduler;
+class Game;
+
+typedef std::shared_ptr<Game> PGame;
 
 class Game {
  public:
-  typedef std::list<Serf*> ListSerfs;
-  typedef std::list<Building*> ListBuildings;
-  typedef std::list<Inventory*> ListInventories;
+  /* Lists returned by queries are only valid until the end of the tick. */
+  typedef FrameList<Serf*> ListSerfs;
+  typedef FrameList<Building*> ListBuildings;
+  typedef FrameList<Inventory*> ListInventories;
 
  protected:
   typedef Collection<Flag, 5000> Flags;
@@ -59,7 +65,7 @@ class Game {
 
   PMap map;
 
-  typedef std::map<unsigned int, unsigned int> Values;
+  typedef FrameMap<unsigned int, unsigned int> Values;
   int map_gold_morale_factor;
   unsigned int gold_total;
 
@@ -102,10 +108,20 @@ class Game {
   int knight_morale_counter;
   int inventory_schedule_counter;
 
+  /* Scratch memory for the current tick, not copied by fork(). */
+  FrameArena frame_arena;
+
+  /* Controllers of the computer players, not copied by fork(). */
+  std::unique_ptr<AIScheduler> ai;
+
  public:
   Game();
   virtual ~Game();
 
+  /* Create an independent copy of the game state. Map tiles are shared
+   copy-on-write with this game, game objects are copied. */
+  PGame fork() const;
+
   PMap get_map() { return map; }
 
   unsigned int get_tick() const { return tick; }
@@ -173,6 +189,16 @@ class Game {
   void lose_resource(Resource::Type type);
 
   uint16_t random_int();
+  void set_random(const Random &random) { rnd = random; }
+
+  /* Let the AI control the computer players. Planning gets budget
+     microseconds per player and tick, zero runs it within the tick. */
+  void start_ai(unsigned int budget);
+  AIScheduler *get_ai() { return ai.get(); }
+
+  FrameArena *get_frame_arena() { return &frame_arena; }
+  FrameAllocator<char> get_frame_allocator() {
+    return FrameAllocator<char>(&frame_arena); }
 
   bool send_serf_to_flag(Flag *dest, Serf::Type type, Resource::Type res1,
                          Resource::Type res2);
@@ -196,6 +222,8 @@ class Game {
   Inventory *get_inventory(unsigned int index) { return inventories[index]; }
   Building *get_building(unsigned int index) { return buildings[index]; }
   Player *get_player(unsigned int index) { return players[index]; }
+  Serfs &get_serfs() { return serfs; }
+  Buildings &get_buildings() { return buildings; }
 
   ListSerfs get_player_serfs(Player *player);
   ListBuildings get_player_buildings(Player *player);
@@ -211,6 +239,8 @@ class Game {
   void clear_search_id();
 
  protected:
+  Game(const Game &that);
+
   void clear_serf_request_failure();
   void update_knight_morale();
   static bool update_inventories_cb(Flag *flag, void *data);
@@ -253,6 +283,4 @@ class Game {
   bool load_inventories(SaveReaderBinary *reader, int max_inventory_index);
 };
 
-typedef std::shared_ptr<Game> PGame;
-
 #endif  // SRC_GAME_H_
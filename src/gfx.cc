@@ -23,6 +23,7 @@
 
 #include <utility>
 #include <algorithm>
+#include <tuple>
 
 #include "src/log.h"
 #include "src/data.h"
@@ -66,7 +67,7 @@ ExceptionGFX::ExceptionGFX(const std::string &description)
 ExceptionGFX::~ExceptionGFX() {
 }
 
-Image::Image(Video *_video, PSprite sprite) {
+Image::Image(Video *_video, PSprite sprite, bool cached) {
   video = _video;
   width = static_cast<unsigned int>(sprite->get_width());
   height = static_cast<unsigned int>(sprite->get_height());
@@ -74,7 +75,9 @@ Image::Image(Video *_video, PSprite sprite) {
   offset_y = sprite->get_offset_y();
   delta_x = sprite->get_delta_x();
   delta_y = sprite->get_delta_y();
-  video_image = video->create_image(sprite->get_data(), width, height);
+  tint = TintNone;
+  video_image = video->create_image(sprite->get_data(), width, height,
+                                    cached);
 }
 
 Image::~Image() {
@@ -86,29 +89,55 @@ Image::~Image() {
 }
 
 /* Sprite cache hash table */
-Image::ImageCache Image::image_cache;
+Image::ImageCache Image::image_cache(64*1024*1024);
 
 void
-Image::cache_image(uint64_t id, Image *image) {
-  image_cache[id] = image;
+Image::cache_image(uint64_t id, Image *image, bool pinned) {
+  image_cache.insert(id, std::unique_ptr<Image>(image), image->get_size(),
+                     pinned);
+}
+
+void
+Image::cache_layers(uint64_t tint_id, Image *tint, uint64_t id, Image *image,
+                    bool pinned) {
+  image_cache.insert(tint_id, std::unique_ptr<Image>(tint), tint->get_size(),
+                     pinned);
+  image_cache.insert(id, std::unique_ptr<Image>(image), image->get_size(),
+                     pinned, 2);
 }
 
 /* Return a pointer to the sprite pointer associated with id. */
 Image *
 Image::get_cached_image(uint64_t id) {
-  ImageCache::iterator result = image_cache.find(id);
-  if (result == image_cache.end()) {
-    return nullptr;
-  }
-  return result->second;
+  return image_cache.get(id);
 }
 
 void
 Image::clear_cache() {
-  while (!image_cache.empty()) {
-    Image *image = image_cache.begin()->second;
-    image_cache.erase(image_cache.begin());
-    delete image;
+  const ImageCache::Stats &stats = image_cache.get_stats();
+  Log::Debug["graphics"] << "image cache: " << stats.hits << " hits, "
+                         << stats.misses << " misses, " << stats.evictions
+                         << " evictions";
+  image_cache.clear();
+}
+
+/* Sprites of the user interface are drawn all the time, so they are kept
+   in the image cache. */
+static bool
+is_interface_sprite(Data::Resource res) {
+  switch (res) {
+    case Data::AssetFrameTop:
+    case Data::AssetFrameBottom:
+    case Data::AssetFrameSplit:
+    case Data::AssetFramePopup:
+    case Data::AssetPanelButton:
+    case Data::AssetIndicator:
+    case Data::AssetFont:
+    case Data::AssetFontShadow:
+    case Data::AssetIcon:
+      return true;
+    default:
+      return false;
   }
 }
 
@@ -152,25 +181,78 @@ Frame::draw_sprite(int x, int y, Data::Resource res, unsigned int index) {
   draw_sprite(x, y, res, index, false, Color::transparent, 1.f);
 }
 
+/* Ids of the cached layers of a sprite. The layer taking the player colour
+   is cached like a sprite in white. */
+static uint64_t
+sprite_id(Data::Resource res, unsigned int index) {
+  return Sprite::create_id(res, index, 0, 0, {0, 0, 0, 0});
+}
+
+static uint64_t
+tint_layer_id(Data::Resource res, unsigned int index) {
+  return Sprite::create_id(res, index, 0, 0, {0xff, 0xff, 0xff, 0xff});
+}
+
+/* Decode a sprite and cache its layers. The image that is drawn last and
+   holds the offsets is returned. */
+Image *
+Frame::cache_sprite_layers(Data::Resource res, unsigned int index) {
+  DataSource::MaskImage layers = data_source->get_sprite_layers(res, index);
+  PSprite tint = std::get<0>(layers);
+  PSprite s = std::get<1>(layers);
+  if (!s && !tint) {
+    Log::Warn["graphics"] << "Failed to decode sprite #"
+                          << Data::get_resource_name(res) << ":" << index;
+    return nullptr;
+  }
+
+  bool pinned = is_interface_sprite(res);
+  Image *image = nullptr;
+  if (!s) {
+    image = new Image(video, tint, true);
+    image->set_tint(Image::TintImage);
+  } else if (tint) {
+    image = new Image(video, s, true);
+    image->set_tint(Image::TintLayer);
+    Image::cache_layers(tint_layer_id(res, index),
+                        new Image(video, tint, true), sprite_id(res, index),
+                        image, pinned);
+    return image;
+  } else {
+    image = new Image(video, s, true);
+  }
+  Image::cache_image(sprite_id(res, index), image, pinned);
+  return image;
+}
+
+/* The player colour is not baked into the sprite; its coloured part is
+   drawn as a separate layer tinted with color, below the rest. */
 void
 Frame::draw_sprite(int x, int y, Data::Resource res, unsigned int index,
                    bool use_off, const Color &color, float progress) {
-  Sprite::Color pc = {color.get_blue(),
-                      color.get_green(),
-                      color.get_red(),
-                      color.get_alpha()};
-  uint64_t id = Sprite::create_id(res, index, 0, 0, pc);
-  Image *image = Image::get_cached_image(id);
+  Image *image = Image::get_cached_image(sprite_id(res, index));
   if (image == nullptr) {
-    PSprite s = data_source->get_sprite(res, index, pc);
-    if (!s) {
-      Log::Warn["graphics"] << "Failed to decode sprite #"
-                            << Data::get_resource_name(res) << ":" << index;
+    image = cache_sprite_layers(res, index);
+    if (image == nullptr) {
       return;
     }
+  }
 
-    image = new Image(video, s);
-    Image::cache_image(id, image);
+  /* Sprites that are all colour are invisible without one. */
+  if (image->get_tint() == Image::TintImage && color.get_alpha() == 0x00) {
+    return;
+  }
+
+  Image *tint = nullptr;
+  if (image->get_tint() == Image::TintLayer && color.get_alpha() != 0x00) {
+    tint = Image::get_cached_image(tint_layer_id(res, index));
+    if (tint == nullptr) {
+      image = cache_sprite_layers(res, index);
+      if (image == nullptr) {
+        return;
+      }
+      tint = Image::get_cached_image(tint_layer_id(res, index));
+    }
   }
 
   if (use_off) {
@@ -179,10 +261,22 @@ Frame::draw_sprite(int x, int y, Data::Resource res, unsigned int index,
   }
   int y_off = image->get_height() - static_cast<int>(image->get_height() *
                                                      progress);
-  video->draw_image(image->get_video_image(), x, y, y_off, video_frame);
+  Video::Color c = {color.get_red(),
+                    color.get_green(),
+                    color.get_blue(),
+                    color.get_alpha()};
+  if (tint != nullptr) {
+    video->draw_tinted_image(tint->get_video_image(), x, y, y_off, c,
+                             video_frame);
+  }
+  if (image->get_tint() == Image::TintImage) {
+    video->draw_tinted_image(image->get_video_image(), x, y, y_off, c,
+                             video_frame);
+  } else {
+    video->draw_image(image->get_video_image(), x, y, y_off, video_frame);
+  }
 }
 
-
 void
 Frame::draw_sprite(int x, int y, Data::Resource res, unsigned int index,
                    bool use_off) {
@@ -257,8 +351,8 @@ Frame::draw_masked_sprite(int x, int y, Data::Resource mask_res,
 
     s = std::move(masked);
 
-    image = new Image(video, s);
-    Image::cache_image(id, image);
+    image = new Image(video, s, true);
+    Image::cache_image(id, image, is_interface_sprite(res));
   }
 
   x += image->get_offset_x();
@@ -266,6 +360,12 @@ Frame::draw_masked_sprite(int x, int y, Data::Resource mask_res,
   video->draw_image(image->get_video_image(), x, y, 0, video_frame);
 }
 
+void
+Frame::draw_sprite(int x, int y, PSprite sprite) {
+  Image image(video, sprite);
+  video->draw_image(image.get_video_image(), x, y, 0, video_frame);
+}
+
 /* Draw the waves sprite with given mask and sprite
    indices at x, y in dest frame. */
 void
@@ -305,8 +405,8 @@ Frame::draw_waves_sprite(int x, int y, Data::Resource mask_res,
       s = std::move(masked);
     }
 
-    image = new Image(video, s);
-    Image::cache_image(id, image);
+    image = new Image(video, s, true);
+    Image::cache_image(id, image, is_interface_sprite(res));
   }
 
   x += image->get_offset_x();
@@ -458,6 +558,17 @@ Frame::draw_frame(int dx, int dy, int sx, int sy, Frame *src, int w, int h) {
   video->draw_frame(dx, dy, video_frame, sx, sy, src->video_frame, w, h);
 }
 
+void
+Frame::set_clip_rect(int x, int y, int width, int height) {
+  video->set_clip_rect(video_frame, x, y, std::max(width, 0),
+                       std::max(height, 0));
+}
+
+void
+Frame::reset_clip_rect() {
+  video->set_clip_rect(video_frame, 0, 0, 0, 0);
+}
+
 void
 Frame::draw_line(int x, int y, int x1, int y1, const Color &color) {
   Video::Color c = {color.get_red(),
@@ -505,6 +616,11 @@ Graphics::swap_buffers() {
   video->swap_buffers();
 }
 
+Video::DrawStats
+Graphics::get_draw_stats() {
+  return video->get_draw_stats();
+}
+
 float
 Graphics::get_zoom_factor() {
   return video->get_zoom_factor();
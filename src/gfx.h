@@ -28,6 +28,7 @@
 
 #include "src/data.h"
 #include "src/debug.h"
+#include "src/lru-cache.h"
 #include "src/video.h"
 
 class ExceptionGFX : public ExceptionFreeserf {
@@ -83,6 +84,15 @@ class Color {
 };
 
 class Image {
+ public:
+  /* How the player colour is applied to the sprite: not at all, to a
+     separate layer drawn below the image, or to the image itself. */
+  typedef enum Tint {
+    TintNone,
+    TintLayer,
+    TintImage,
+  } Tint;
+
  protected:
   int delta_x;
   int delta_y;
@@ -92,12 +102,22 @@ class Image {
   unsigned int height;
   Video *video;
   Video::Image *video_image;
+  Tint tint;
+
+ public:
+  /* Images of sprites by id. When the images take more memory than the
+     budget the least recently drawn are destroyed. Only the pixels of the
+     images count: the video may pack them into atlas pages that are not
+     bounded by the budget, and a page stays until its last image is
+     destroyed. */
+  typedef LruCache<uint64_t, Image> ImageCache;
 
-  typedef std::map<uint64_t, Image*> ImageCache;
+ protected:
   static ImageCache image_cache;
 
  public:
-  Image(Video *video, PSprite sprite);
+  /* Images that are cached for long may be packed with others. */
+  Image(Video *video, PSprite sprite, bool cached = false);
   virtual ~Image();
 
   unsigned int get_width() const { return width; }
@@ -109,10 +129,23 @@ class Image {
 
   void set_offset(int x, int y) { offset_x = x; offset_y = y; }
   void set_delta(int x, int y) { delta_x = x; delta_y = y; }
-
-  static void cache_image(uint64_t id, Image *image);
+  Tint get_tint() const { return tint; }
+  void set_tint(Tint value) { tint = value; }
+
+  /* Memory taken by the image, in bytes. */
+  size_t get_size() const { return width * height * 4; }
+
+  /* The cache takes ownership of image. Pinned images are never evicted. */
+  static void cache_image(uint64_t id, Image *image, bool pinned);
+  /* Cache the image of a sprite with the layer taking the player colour,
+     neither is evicted to make room for the other. */
+  static void cache_layers(uint64_t tint_id, Image *tint, uint64_t id,
+                           Image *image, bool pinned);
   static Image *get_cached_image(uint64_t id);
   static void clear_cache();
+  static void set_cache_budget(size_t bytes) {
+    image_cache.set_budget(bytes); }
+  static const ImageCache &get_cache() { return image_cache; }
 
   Video::Image *get_video_image() const { return video_image; }
 };
@@ -149,6 +182,9 @@ class Frame {
   void draw_waves_sprite(int x, int y, Data::Resource mask_res,
                          unsigned int mask_index, Data::Resource res,
                          unsigned int index);
+  /* Draw a sprite that is not from the data source, e.g. one rendered on
+     the CPU. It is uploaded every time. */
+  void draw_sprite(int x, int y, PSprite sprite);
 
   /* Drawing functions */
   void draw_rect(int x, int y, int width, int height, const Color &color);
@@ -163,12 +199,16 @@ class Frame {
 
   /* Frame functions */
   void draw_frame(int dx, int dy, int sx, int sy, Frame *src, int w, int h);
+  /* Limit drawing to a rectangle of the frame until reset. */
+  void set_clip_rect(int x, int y, int width, int height);
+  void reset_clip_rect();
 
  protected:
   void draw_char_sprite(int x, int y, unsigned char c, const Color &color,
                         const Color &shadow);
   void draw_sprite(int x, int y, Data::Resource res, unsigned int index,
                    bool use_off, const Color &color, float progress);
+  Image *cache_sprite_layers(Data::Resource res, unsigned int index);
 };
 
 class Graphics {
@@ -194,6 +234,7 @@ class Graphics {
   bool is_fullscreen();
 
   void swap_buffers();
+  Video::DrawStats get_draw_stats();
 
   float get_zoom_factor();
   bool set_zoom_factor(float factor);
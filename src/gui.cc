@@ -32,6 +32,27 @@ gui_get_slider_click_value(int x) {
   return 1310 * clamp(0, x - 7, 50);
 }
 
+/* Overlap of two rectangles; the width or height is zero if they are
+   disjoint. */
+static GuiObject::Rect
+intersect_rect(const GuiObject::Rect &a, const GuiObject::Rect &b) {
+  int x0 = std::max(a.x, b.x);
+  int y0 = std::max(a.y, b.y);
+  int x1 = std::min(a.x + a.width, b.x + b.width);
+  int y1 = std::min(a.y + a.height, b.y + b.height);
+  return { x0, y0, std::max(x1 - x0, 0), std::max(y1 - y0, 0) };
+}
+
+/* Smallest rectangle containing both. */
+static GuiObject::Rect
+union_rect(const GuiObject::Rect &a, const GuiObject::Rect &b) {
+  int x0 = std::min(a.x, b.x);
+  int y0 = std::min(a.y, b.y);
+  int x1 = std::max(a.x + a.width, b.x + b.width);
+  int y1 = std::max(a.y + a.height, b.y + b.height);
+  return { x0, y0, x1 - x0, y1 - y0 };
+}
+
 void
 GuiObject::layout() {
 }
@@ -45,7 +66,8 @@ GuiObject::GuiObject() {
   height = 0;
   displayed = false;
   enabled = true;
-  redraw = true;
+  damaged = false;
+  damage = { 0, 0, 0, 0 };
   parent = nullptr;
   frame = nullptr;
   focused = false;
@@ -66,26 +88,73 @@ GuiObject::delete_frame() {
   }
 }
 
+/* Draw the damaged part of the frame again: the object itself, clipped to
+   the damage, and the floats over it. */
+bool
+GuiObject::refresh(Rect *area) {
+  if (frame == nullptr) {
+    frame = Graphics::get_instance().create_frame(width, height);
+    damage = { 0, 0, width, height };
+    damaged = true;
+  }
+
+  if (!damaged) {
+    return false;
+  }
+
+  *area = damage;
+  bool clip = (area->x > 0 || area->y > 0 || area->width < width ||
+               area->height < height);
+  if (clip) {
+    frame->set_clip_rect(area->x, area->y, area->width, area->height);
+  }
+
+  internal_draw();
+
+  for (GuiObject *float_window : floats) {
+    float_window->draw_area(frame, *area);
+  }
+
+  if (clip) {
+    frame->reset_clip_rect();
+  }
+
+  damaged = false;
+  return true;
+}
+
+/* Bring the frame up to date and draw the part of it that lies in area of
+   the parent frame. */
 void
-GuiObject::draw(Frame *_frame) {
+GuiObject::draw_area(Frame *_frame, const Rect &area) {
   if (!displayed) {
     return;
   }
 
-  if (frame == nullptr) {
-    frame = Graphics::get_instance().create_frame(width, height);
-  }
+  Rect changed;
+  refresh(&changed);
 
-  if (redraw) {
-    internal_draw();
+  Rect part = intersect_rect(area, { x, y, width, height });
+  if (part.width > 0 && part.height > 0) {
+    _frame->draw_frame(part.x, part.y, part.x - x, part.y - y, frame,
+                       part.width, part.height);
+  }
+}
 
-    for (GuiObject *float_window : floats) {
-      float_window->draw(frame);
-    }
+bool
+GuiObject::draw(Frame *_frame) {
+  if (!displayed) {
+    return false;
+  }
 
-    redraw = false;
+  Rect area;
+  if (!refresh(&area)) {
+    return false;
   }
-  _frame->draw_frame(x, y, 0, 0, frame, width, height);
+
+  _frame->draw_frame(x + area.x, y + area.y, area.x, area.y, frame,
+                     area.width, area.height);
+  return true;
 }
 
 bool
@@ -171,6 +240,9 @@ GuiObject::set_focused() {
 
 void
 GuiObject::move_to(int px, int py) {
+  if (parent != nullptr && displayed) {
+    parent->set_redraw(x, y, width, height);
+  }
   x = px;
   y = py;
   set_redraw();
@@ -188,6 +260,9 @@ GuiObject::get_position(int *px, int *py) {
 
 void
 GuiObject::set_size(int new_width, int new_height) {
+  if (parent != nullptr && displayed) {
+    parent->set_redraw(x, y, width, height);
+  }
   delete_frame();
   width = new_width;
   height = new_height;
@@ -207,6 +282,9 @@ GuiObject::get_size(int *pwidth, int *pheight) {
 
 void
 GuiObject::set_displayed(bool displayed) {
+  if (parent != nullptr) {
+    parent->set_redraw(x, y, width, height);
+  }
   this->displayed = displayed;
   set_redraw();
 }
@@ -218,9 +296,22 @@ GuiObject::set_enabled(bool enabled) {
 
 void
 GuiObject::set_redraw() {
-  redraw = true;
-  if (parent != nullptr) {
-    parent->set_redraw();
+  set_redraw(0, 0, width, height);
+}
+
+/* Draw a part of the object and what is below it in its parents again. */
+void
+GuiObject::set_redraw(int rx, int ry, int rwidth, int rheight) {
+  Rect area = intersect_rect({ rx, ry, rwidth, rheight },
+                             { 0, 0, width, height });
+  if (area.width == 0 || area.height == 0) {
+    return;
+  }
+
+  damage = damaged ? union_rect(damage, area) : area;
+  damaged = true;
+  if (parent != nullptr && displayed) {
+    parent->set_redraw(x + area.x, y + area.y, area.width, area.height);
   }
 }
 
@@ -240,6 +331,9 @@ GuiObject::add_float(GuiObject *obj, int fx, int fy) {
 
 void
 GuiObject::del_float(GuiObject *obj) {
+  if (obj->displayed) {
+    set_redraw(obj->x, obj->y, obj->width, obj->height);
+  }
   obj->set_parent(nullptr);
   floats.remove(obj);
   set_redraw();
@@ -28,6 +28,14 @@
 #include "src/event_loop.h"
 
 class GuiObject : public EventLoop::Handler {
+ public:
+  typedef struct Rect {
+    int x;
+    int y;
+    int width;
+    int height;
+  } Rect;
+
  private:
   typedef std::list<GuiObject*> FloatList;
   FloatList floats;
@@ -37,7 +45,10 @@ class GuiObject : public EventLoop::Handler {
   int width, height;
   bool displayed;
   bool enabled;
-  bool redraw;
+  /* Part of the frame to draw again, in the object's coordinates. Changes
+     of floats are added to the damage of their parent. */
+  bool damaged;
+  Rect damage;
   GuiObject *parent;
   Frame *frame;
   static GuiObject *focused_object;
@@ -54,12 +65,15 @@ class GuiObject : public EventLoop::Handler {
   virtual bool handle_focus_loose() { return false; }
 
   void delete_frame();
+  bool refresh(Rect *area);
+  void draw_area(Frame *frame, const Rect &area);
 
  public:
   GuiObject();
   virtual ~GuiObject();
 
-  void draw(Frame *frame);
+  /* Draw the damaged part onto frame. Returns whether frame changed. */
+  bool draw(Frame *frame);
   void move_to(int x, int y);
   void get_position(int *x, int *y);
   void set_size(int width, int height);
@@ -67,6 +81,7 @@ class GuiObject : public EventLoop::Handler {
   void set_displayed(bool displayed);
   void set_enabled(bool enabled);
   void set_redraw();
+  void set_redraw(int x, int y, int width, int height);
   bool is_displayed() { return displayed; }
   GuiObject *get_parent() { return parent; }
   void set_parent(GuiObject *parent) { this->parent = parent; }
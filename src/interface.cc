@@ -37,6 +37,7 @@
 #include "src/notification.h"
 #include "src/panel.h"
 #include "src/savegame.h"
+#include "src/savegame-delta.h"
 
 // Interval between automatic save games
 #define AUTOSAVE_INTERVAL  (10*60*TICKS_PER_SEC)
@@ -50,6 +51,8 @@ Interface::Interface()
   displayed = true;
 
   game = nullptr;
+  threaded = false;
+  game_locked = false;
 
   map_cursor_pos = 0;
   map_cursor_type = (CursorType)0;
@@ -74,6 +77,7 @@ Interface::Interface()
   map_cursor_sprites[6].sprite = 33;
 
   last_const_tick = 0;
+  next_autosave = 0;
 
   viewport = nullptr;
   panel = nullptr;
@@ -436,6 +440,8 @@ Interface::update_interface() {
 
 void
 Interface::set_game(PGame new_game) {
+  stop_game_thread();
+
   if (viewport != nullptr) {
     del_float(viewport);
     delete viewport;
@@ -445,9 +451,17 @@ Interface::set_game(PGame new_game) {
   game = std::move(new_game);
 
   if (game) {
-    viewport = new Viewport(this, game->get_map());
+    next_autosave = game->get_const_tick() + AUTOSAVE_INTERVAL;
+    autosave_checkpoint = std::make_shared<SaveCheckpoint>(
+                            GameStore::get_instance().get_autosave_path());
+
+    viewport = new Viewport(this, game);
     viewport->set_displayed(true);
     add_float(viewport, 0, 0);
+
+    if (threaded) {
+      start_game_thread();
+    }
   }
 
   layout();
@@ -455,6 +469,119 @@ Interface::set_game(PGame new_game) {
   set_player(0);
 }
 
+void
+Interface::set_threaded(bool enable) {
+  if (threaded == enable) {
+    return;
+  }
+
+  threaded = enable;
+
+  stop_game_thread();
+  if (threaded && game) {
+    start_game_thread();
+  }
+}
+
+void
+Interface::start_game_thread() {
+  game_thread.reset(new GameThread(game, TICK_LENGTH));
+  update_render_state();
+  game_thread->start();
+
+  if (game_locked) {
+    game_lock = game_thread->lock();
+  }
+}
+
+void
+Interface::stop_game_thread() {
+  if (!game_thread) {
+    return;
+  }
+
+  if (game_lock.owns_lock()) {
+    game_lock.unlock();
+  }
+  game_thread.reset();
+  if (viewport != nullptr) {
+    viewport->set_render_game(game);
+  }
+}
+
+void
+Interface::lock_game() {
+  game_locked = true;
+  if (game_thread && !game_lock.owns_lock()) {
+    game_lock = game_thread->lock();
+  }
+}
+
+void
+Interface::unlock_game() {
+  game_locked = false;
+  if (game_lock.owns_lock()) {
+    game_lock.unlock();
+  }
+}
+
+void
+Interface::post_command(GameThread::Command command) {
+  if (game_thread) {
+    game_thread->post(std::move(command));
+  } else if (game) {
+    command(game.get());
+  }
+}
+
+void
+Interface::save_game(const std::string &prefix) {
+  post_command([prefix](Game *game) {
+    GameStore::get_instance().quick_save_async(prefix, game->fork());
+  });
+}
+
+void
+Interface::autosave() {
+  std::shared_ptr<SaveCheckpoint> checkpoint = autosave_checkpoint;
+  post_command([checkpoint](Game *game) {
+    GameStore::get_instance().checkpoint_async(checkpoint, game->fork());
+  });
+}
+
+/* Report saves finished in the background. */
+void
+Interface::handle_save_results() {
+  for (const GameStore::SaveResult &result :
+         GameStore::get_instance().take_save_results()) {
+    if (result.saved) {
+      Log::Info["interface"] << "Game saved to '" << result.path << "'";
+      play_sound(Audio::TypeSfxAccepted);
+    } else {
+      Log::Error["interface"] << "Failed to save game to '"
+                              << result.path << "'";
+      play_sound(Audio::TypeSfxNotAccepted);
+    }
+  }
+}
+
+/* Hand the latest state published by the game thread to the viewport. */
+void
+Interface::update_render_state() {
+  GameThread::State *state = game_thread->fetch_state();
+  if (state == nullptr) {
+    return;
+  }
+
+  viewport->set_render_game(state->game);
+  for (MapPos pos : state->height_changes) {
+    viewport->redraw_map_pos(pos);
+  }
+  for (MapPos pos : state->object_changes) {
+    viewport->on_object_changed(pos);
+  }
+}
+
 void
 Interface::set_player(unsigned int player_index) {
   if (panel != nullptr) {
@@ -502,6 +629,10 @@ Interface::get_player_color(unsigned int player_index) {
 
 void
 Interface::update_map_cursor_pos(MapPos pos) {
+  if (viewport != nullptr) {
+    viewport->redraw_map_area(map_cursor_pos);
+    viewport->redraw_map_area(pos);
+  }
   map_cursor_pos = pos;
   if (building_road.is_valid()) {
     determine_map_cursor_type_road();
@@ -764,11 +895,23 @@ Interface::update() {
     return;
   }
 
-  game->update();
+  if (game_thread) {
+    update_render_state();
+  } else {
+    game->update();
+  }
 
   int tick_diff = game->get_const_tick() - last_const_tick;
   last_const_tick = game->get_const_tick();
 
+  handle_save_results();
+  if (game->get_const_tick() >= next_autosave) {
+    next_autosave = game->get_const_tick() + AUTOSAVE_INTERVAL;
+    if (!GameStore::get_instance().is_saving()) {
+      autosave();
+    }
+  }
+
   /* Clear return arrow after a timeout */
   if (return_timeout < tick_diff) {
     msg_flags |= BIT(4);
@@ -812,7 +955,6 @@ Interface::update() {
   }
 
   viewport->update();
-  set_redraw();
 }
 
 bool
@@ -840,19 +982,19 @@ Interface::handle_key_pressed(char key, int modifier) {
 
     /* Game speed */
     case '+': {
-      game->speed_increase();
+      post_command([](Game *game) { game->speed_increase(); });
       break;
     }
     case '-': {
-      game->speed_decrease();
+      post_command([](Game *game) { game->speed_decrease(); });
       break;
     }
     case '0': {
-      game->speed_reset();
+      post_command([](Game *game) { game->speed_reset(); });
       break;
     }
     case 'p': {
-      game->pause();
+      post_command([](Game *game) { game->pause(); });
       break;
     }
 
@@ -879,6 +1021,10 @@ Interface::handle_key_pressed(char key, int modifier) {
       viewport->switch_layer(Viewport::LayerGrid);
       break;
     }
+    case 'i': {
+      viewport->switch_layer(Viewport::LayerStats);
+      break;
+    }
 
     /* Game control */
     case 'b': {
@@ -893,7 +1039,7 @@ Interface::handle_key_pressed(char key, int modifier) {
     }
     case 'z':
       if (modifier & 1) {
-        GameStore::get_instance().quick_save("quicksave", game.get());
+        save_game("quicksave");
       }
       break;
     case 'n':
@@ -916,6 +1062,10 @@ Interface::handle_key_pressed(char key, int modifier) {
 
 bool
 Interface::handle_event(const Event *event) {
+  bool handled = true;
+
+  lock_game();
+
   switch (event->type) {
     case Event::TypeResize:
       set_size(event->dx, event->dy);
@@ -924,15 +1074,17 @@ Interface::handle_event(const Event *event) {
       update();
       break;
     case Event::TypeDraw:
-      draw(reinterpret_cast<Frame*>(event->object));
+      handled = draw(reinterpret_cast<Frame*>(event->object));
       break;
 
     default:
-      return GuiObject::handle_event(event);
+      handled = GuiObject::handle_event(event);
       break;
   }
 
-  return true;
+  unlock_game();
+
+  return handled;
 }
 
 void
@@ -22,6 +22,9 @@
 #ifndef SRC_INTERFACE_H_
 #define SRC_INTERFACE_H_
 
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+
 #include "src/misc.h"
 #include "src/random.h"
 #include "src/map.h"
@@ -29,6 +32,7 @@
 #include "src/building.h"
 #include "src/gui.h"
 #include "src/game-manager.h"
+#include "src/game-thread.h"
 
 static const unsigned int map_building_sprite[] = {
   0, 0xa7, 0xa8, 0xae, 0xa9,
@@ -42,6 +46,7 @@ class PanelBar;
 class PopupBox;
 class GameInitBox;
 class NotificationBox;
+class SaveCheckpoint;
 
 class Interface : public GuiObject, public GameManager::Handler {
  public:
@@ -74,6 +79,12 @@ class Interface : public GuiObject, public GameManager::Handler {
  protected:
   PGame game;
 
+  /* Simulation thread, only used in threaded mode. */
+  bool threaded;
+  std::unique_ptr<GameThread> game_thread;
+  std::unique_lock<std::mutex> game_lock;
+  bool game_locked;
+
   Random random;
 
   Viewport *viewport;
@@ -87,6 +98,8 @@ class Interface : public GuiObject, public GameManager::Handler {
   BuildPossibility build_possibility;
 
   unsigned int last_const_tick;
+  unsigned int next_autosave;
+  std::shared_ptr<SaveCheckpoint> autosave_checkpoint;
 
   Road building_road;
   int building_road_valid_dir;
@@ -115,6 +128,23 @@ class Interface : public GuiObject, public GameManager::Handler {
   PGame get_game() { return game; }
   void set_game(PGame game);
 
+  /* In threaded mode the game is updated on a separate thread and the
+     viewport draws from a snapshot of the game. Access to the live game is
+     serialized with lock_game()/unlock_game(); event handling runs with the
+     game locked. */
+  bool is_threaded() const { return threaded; }
+  void set_threaded(bool threaded);
+  void lock_game();
+  void unlock_game();
+  /* Apply command to the game between two game updates. */
+  void post_command(GameThread::Command command);
+  /* Save the game in the background. Only taking the snapshot holds up
+     the game. */
+  void save_game(const std::string &prefix);
+  /* Checkpoint the game in the background to the single autosave file, so
+     autosaves between full saves only write what changed. */
+  void autosave();
+
   Color get_player_color(unsigned int player_index);
 
   Viewport *get_viewport();
@@ -187,6 +217,10 @@ class Interface : public GuiObject, public GameManager::Handler {
   void determine_map_cursor_type_road();
   void update_interface();
   static void update_map_height(MapPos pos, void *data);
+  void start_game_thread();
+  void stop_game_thread();
+  void update_render_state();
+  void handle_save_results();
 
   virtual void internal_draw();
   virtual void layout();
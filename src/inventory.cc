@@ -469,8 +469,16 @@ operator >> (SaveReaderText &reader, Inventory &inventory) {
   return reader;
 }
 
+/* Counts missing from the map are zero. */
+template<typename Key>
+static unsigned int
+get_count(const std::map<Key, unsigned int> &counts, Key key) {
+  auto it = counts.find(key);
+  return (it != counts.end()) ? it->second : 0;
+}
+
 SaveWriterText&
-operator << (SaveWriterText &writer, Inventory &inventory) {
+operator << (SaveWriterText &writer, const Inventory &inventory) {
   writer.value("player") << inventory.owner;
   writer.value("res_dir") << inventory.res_dir;
   writer.value("flag") << inventory.flag;
@@ -484,10 +492,11 @@ operator << (SaveWriterText &writer, Inventory &inventory) {
   writer.value("generic_count") << inventory.generic_count;
 
   for (int i = 0; i < 26; i++) {
-    writer.value("resources") << inventory.resources[(Resource::Type)i];
-    writer.value("serfs") << inventory.serfs[(Serf::Type)i];
+    writer.value("resources") << get_count(inventory.resources,
+                                           (Resource::Type)i);
+    writer.value("serfs") << get_count(inventory.serfs, (Serf::Type)i);
   }
-  writer.value("serfs") << inventory.serfs[(Serf::Type)26];
+  writer.value("serfs") << get_count(inventory.serfs, (Serf::Type)26);
 
   return writer;
 }
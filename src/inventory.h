@@ -131,7 +131,11 @@ class Inventory : public GameObject {
   friend SaveReaderText&
     operator >> (SaveReaderText &reader, Inventory &inventory);
   friend SaveWriterText&
-    operator << (SaveWriterText &writer, Inventory &inventory);
+    operator << (SaveWriterText &writer, const Inventory &inventory);
+
+ protected:
+  Inventory(const Inventory &that) = default;
+  template<class T, size_t growth> friend class Collection;
 };
 
 #endif  // SRC_INVENTORY_H_
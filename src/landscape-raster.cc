@@ -0,0 +1,333 @@
+/*
+ * landscape-raster.cc - Rendering of landscape tiles on the CPU
+ *
+ * Copyright (C) 2026  freeserf developers
+ *
+ * This file is part of freeserf.
+ *
+ * freeserf is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * freeserf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with freeserf.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/landscape-raster.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "src/debug.h"
+#include "src/log.h"
+
+static const uint8_t tri_spr[] = {
+  32, 32, 32, 32, 32, 32, 32, 32,
+  32, 32, 32, 32, 32, 32, 32, 32,
+  32, 32, 32, 32, 32, 32, 32, 32,
+  32, 32, 32, 32, 32, 32, 32, 32,
+  0, 1, 2, 3, 4, 5, 6, 7,
+  0, 1, 2, 3, 4, 5, 6, 7,
+  0, 1, 2, 3, 4, 5, 6, 7,
+  0, 1, 2, 3, 4, 5, 6, 7,
+  24, 25, 26, 27, 28, 29, 30, 31,
+  24, 25, 26, 27, 28, 29, 30, 31,
+  24, 25, 26, 27, 28, 29, 30, 31,
+  8, 9, 10, 11, 12, 13, 14, 15,
+  8, 9, 10, 11, 12, 13, 14, 15,
+  8, 9, 10, 11, 12, 13, 14, 15,
+  16, 17, 18, 19, 20, 21, 22, 23,
+  16, 17, 18, 19, 20, 21, 22, 23
+};
+
+void
+LandscapeRasterizer::draw_triangle_up(const Map &map, int lx, int ly, int m,
+                                      int left, int right, MapPos pos,
+                                      Sprite *tile) const {
+  static const int8_t tri_mask[] = {
+     0,  1,  3,  6,  7, -1, -1, -1, -1,
+     0,  1,  2,  5,  6,  7, -1, -1, -1,
+     0,  1,  2,  3,  5,  6,  7, -1, -1,
+     0,  1,  2,  3,  4,  5,  6,  7, -1,
+     0,  1,  2,  3,  4,  4,  5,  6,  7,
+    -1,  0,  1,  2,  3,  4,  5,  6,  7,
+    -1, -1,  0,  1,  2,  4,  5,  6,  7,
+    -1, -1, -1,  0,  1,  2,  5,  6,  7,
+    -1, -1, -1, -1,  0,  1,  4,  6,  7
+  };
+
+  if (((left - m) < -4) || ((left - m) > 4)) {
+    throw ExceptionFreeserf("Failed to draw triangle up (1).");
+  }
+  if (((right - m) < -4) || ((right - m) > 4)) {
+    throw ExceptionFreeserf("Failed to draw triangle up (2).");
+  }
+
+  int mask = 4 + m - left + 9*(4 + m - right);
+  if (tri_mask[mask] < 0) {
+    throw ExceptionFreeserf("Failed to draw triangle up (3).");
+  }
+
+  Map::Terrain type = map.type_up(map.move_up(pos));
+  int index = (type << 3) | tri_mask[mask];
+  if (index >= 128) {
+    throw ExceptionFreeserf("Failed to draw triangle up (4).");
+  }
+
+  int sprite = tri_spr[index];
+
+  draw_masked(lx, ly, masks_up[mask], textures[sprite], tile);
+}
+
+void
+LandscapeRasterizer::draw_triangle_down(const Map &map, int lx, int ly, int m,
+                                        int left, int right, MapPos pos,
+                                        Sprite *tile) const {
+  static const int8_t tri_mask[] = {
+     0,  0,  0,  0,  0, -1, -1, -1, -1,
+     1,  1,  1,  1,  1,  0, -1, -1, -1,
+     3,  2,  2,  2,  2,  1,  0, -1, -1,
+     6,  5,  3,  3,  3,  2,  1,  0, -1,
+     7,  6,  5,  4,  4,  3,  2,  1,  0,
+    -1,  7,  6,  5,  4,  4,  4,  2,  1,
+    -1, -1,  7,  6,  5,  5,  5,  5,  4,
+    -1, -1, -1,  7,  6,  6,  6,  6,  6,
+    -1, -1, -1, -1,  7,  7,  7,  7,  7
+  };
+
+  if (((left - m) < -4) || ((left - m) > 4)) {
+    throw ExceptionFreeserf("Failed to draw triangle down (1).");
+  }
+  if (((right - m) < -4) || ((right - m) > 4)) {
+    throw ExceptionFreeserf("Failed to draw triangle down (2).");
+  }
+
+  int mask = 4 + left - m + 9*(4 + right - m);
+  if (tri_mask[mask] < 0) {
+    throw ExceptionFreeserf("Failed to draw triangle down (3).");
+  }
+
+  int type = map.type_down(map.move_up_left(pos));
+  int index = (type << 3) | tri_mask[mask];
+  if (index >= 128) {
+    throw ExceptionFreeserf("Failed to draw triangle down (4).");
+  }
+
+  int sprite = tri_spr[index];
+
+  draw_masked(lx, ly + MAP_TILE_HEIGHT, masks_down[mask], textures[sprite],
+              tile);
+}
+
+/* Draw a column (vertical) of tiles, starting at an up pointing tile. */
+void
+LandscapeRasterizer::draw_up_tile_col(const Map &map, MapPos pos, int x_base,
+                                      int y_base, int max_y,
+                                      Sprite *tile) const {
+  int m = map.get_height(pos);
+  int left, right;
+
+  /* Loop until a tile is inside the frame (y >= 0). */
+  while (1) {
+    /* move down */
+    pos = map.move_down(pos);
+
+    left = map.get_height(pos);
+    right = map.get_height(map.move_right(pos));
+
+    int t = std::min(left, right);
+    /*if (left == right) t -= 1;*/ /* TODO ? */
+
+    if (y_base + MAP_TILE_HEIGHT - 4*t >= 0) break;
+
+    y_base += MAP_TILE_HEIGHT;
+
+    /* move down right */
+    pos = map.move_down_right(pos);
+
+    m = map.get_height(pos);
+
+    if (y_base + MAP_TILE_HEIGHT - 4*m >= 0) goto down;
+
+    y_base += MAP_TILE_HEIGHT;
+  }
+
+  /* Loop until a tile is completely outside the frame (y >= max_y). */
+  while (1) {
+    if (y_base - 2*MAP_TILE_HEIGHT - 4*m >= max_y) break;
+
+    draw_triangle_up(map, x_base, y_base - 4*m, m, left, right, pos, tile);
+
+    y_base += MAP_TILE_HEIGHT;
+
+    /* move down right */
+    pos = map.move_down_right(pos);
+    m = map.get_height(pos);
+
+    if (y_base - 2*MAP_TILE_HEIGHT - 4*std::max(left, right) >= max_y) break;
+
+  down:
+    draw_triangle_down(map, x_base, y_base - 4*m, m, left, right, pos, tile);
+
+    y_base += MAP_TILE_HEIGHT;
+
+    /* move down */
+    pos = map.move_down(pos);
+
+    left = map.get_height(pos);
+    right = map.get_height(map.move_right(pos));
+  }
+}
+
+/* Draw a column (vertical) of tiles, starting at a down pointing tile. */
+void
+LandscapeRasterizer::draw_down_tile_col(const Map &map, MapPos pos,
+                                        int x_base, int y_base, int max_y,
+                                        Sprite *tile) const {
+  int left = map.get_height(pos);
+  int right = map.get_height(map.move_right(pos));
+  int m;
+
+  /* Loop until a tile is inside the frame (y >= 0). */
+  while (true) {
+    /* move down right */
+    pos = map.move_down_right(pos);
+
+    m = map.get_height(pos);
+
+    if (y_base + MAP_TILE_HEIGHT - 4*m >= 0) goto down;
+
+    y_base += MAP_TILE_HEIGHT;
+
+    /* move down */
+    pos = map.move_down(pos);
+
+    left = map.get_height(pos);
+    right = map.get_height(map.move_right(pos));
+
+    int t = std::min(left, right);
+    /*if (left == right) t -= 1;*/ /* TODO ? */
+
+    if (y_base + MAP_TILE_HEIGHT - 4*t >= 0) break;
+
+    y_base += MAP_TILE_HEIGHT;
+  }
+
+  /* Loop until a tile is completely outside the frame (y >= max_y). */
+  while (1) {
+    if (y_base - 2*MAP_TILE_HEIGHT - 4*m >= max_y) break;
+
+    draw_triangle_up(map, x_base, y_base - 4*m, m, left, right, pos, tile);
+
+    y_base += MAP_TILE_HEIGHT;
+
+    /* move down right */
+    pos = map.move_down_right(pos);
+    m = map.get_height(pos);
+
+    if (y_base - 2*MAP_TILE_HEIGHT - 4*std::max(left, right) >= max_y) break;
+
+  down:
+    draw_triangle_down(map, x_base, y_base - 4*m, m, left, right, pos, tile);
+
+    y_base += MAP_TILE_HEIGHT;
+
+    /* move down */
+    pos = map.move_down(pos);
+
+    left = map.get_height(pos);
+    right = map.get_height(map.move_right(pos));
+  }
+}
+
+LandscapeRasterizer::LandscapeRasterizer(PDataSource data_source) {
+  for (unsigned int i = 0; i < MAP_TILE_TEXTURES; i++) {
+    textures.push_back(data_source->get_sprite(Data::AssetMapGround, i,
+                                               {0, 0, 0, 0}));
+  }
+  for (unsigned int i = 0; i < MAP_TILE_MASKS; i++) {
+    masks_up.push_back(data_source->get_sprite(Data::AssetMapMaskUp, i,
+                                               {0, 0, 0, 0}));
+    masks_down.push_back(data_source->get_sprite(Data::AssetMapMaskDown, i,
+                                                 {0, 0, 0, 0}));
+  }
+}
+
+PSprite
+LandscapeRasterizer::render(const Map &map, int tc, int tr) const {
+  int tile_width = MAP_TILE_COLS*MAP_TILE_WIDTH;
+  int tile_height = MAP_TILE_ROWS*MAP_TILE_HEIGHT;
+
+  PSprite tile = std::make_shared<Sprite>(tile_width, tile_height);
+  tile->fill({0x00, 0x00, 0x00, 0xff});
+
+  int col = (tc*MAP_TILE_COLS + (tr*MAP_TILE_ROWS)/2) % map.get_cols();
+  int row = tr*MAP_TILE_ROWS;
+  MapPos pos = map.pos(col, row);
+
+  int x_base = -(MAP_TILE_WIDTH/2);
+
+  /* Draw one extra column as half a column will be outside the
+   map tile on both right and left side.. */
+  for (int col = 0; col < MAP_TILE_COLS+1; col++) {
+    draw_up_tile_col(map, pos, x_base, 0, tile_height, tile.get());
+    draw_down_tile_col(map, pos, x_base + MAP_TILE_WIDTH/2, 0, tile_height,
+                       tile.get());
+
+    pos = map.move_right(pos);
+    x_base += MAP_TILE_WIDTH;
+  }
+
+  return tile;
+}
+
+/* Composite texture through mask at x, y of tile. Like
+   Sprite::get_masked(), the texture is repeated downwards to the height of
+   the mask. */
+void
+LandscapeRasterizer::draw_masked(int x, int y, const PSprite &mask,
+                                 const PSprite &texture, Sprite *tile) const {
+  if (!mask || !texture || mask->get_width() > texture->get_width()) {
+    throw ExceptionFreeserf("Failed to apply mask to landscape texture.");
+  }
+
+  x += mask->get_offset_x();
+  y += mask->get_offset_y();
+
+  int tile_width = static_cast<int>(tile->get_width());
+  int tile_height = static_cast<int>(tile->get_height());
+  int width = static_cast<int>(mask->get_width());
+  int height = static_cast<int>(mask->get_height());
+  int left = std::max(0, -x);
+  int right = std::min(width, tile_width - x);
+
+  const uint32_t *m_data = reinterpret_cast<uint32_t*>(mask->get_data());
+  const uint32_t *t_data = reinterpret_cast<uint32_t*>(texture->get_data());
+  Sprite::Color *dest = reinterpret_cast<Sprite::Color*>(tile->get_data());
+  for (int my = std::max(0, -y); my < height && y + my < tile_height; my++) {
+    const uint32_t *m_row = m_data + my * width;
+    const uint32_t *t_row = t_data + (my % texture->get_height()) *
+                                     texture->get_width();
+    Sprite::Color *d_row = dest + (y + my) * tile_width + x;
+    for (int mx = left; mx < right; mx++) {
+      uint32_t value = t_row[mx] & m_row[mx];
+      Sprite::Color pixel;
+      memcpy(&pixel, &value, sizeof(pixel));
+      if (pixel.alpha == 0xff) {
+        d_row[mx] = pixel;
+      } else if (pixel.alpha != 0) {
+        Sprite::Color &d = d_row[mx];
+        unsigned int a = pixel.alpha;
+        d.blue = (pixel.blue * a + d.blue * (0xff - a)) / 0xff;
+        d.green = (pixel.green * a + d.green * (0xff - a)) / 0xff;
+        d.red = (pixel.red * a + d.red * (0xff - a)) / 0xff;
+      }
+    }
+  }
+}
@@ -0,0 +1,70 @@
+/*
+ * landscape-raster.h - Rendering of landscape tiles on the CPU
+ *
+ * Copyright (C) 2026  freeserf developers
+ *
+ * This file is part of freeserf.
+ *
+ * freeserf is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * freeserf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with freeserf.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SRC_LANDSCAPE_RASTER_H_
+#define SRC_LANDSCAPE_RASTER_H_
+
+#include <vector>
+
+#include "src/data-source.h"
+#include "src/map.h"
+
+#define MAP_TILE_WIDTH   32
+#define MAP_TILE_HEIGHT  20
+
+#define MAP_TILE_TEXTURES  33
+#define MAP_TILE_MASKS     81
+
+/* Number of cols,rows in each landscape tile */
+#define MAP_TILE_COLS  16
+#define MAP_TILE_ROWS  16
+
+// Renders tiles of the landscape into sprites by compositing the ground
+// textures through the triangle masks, the same way the viewport used to
+// draw them onto a frame. Textures and masks are decoded when it is
+// created, after which render() may be called from any thread.
+class LandscapeRasterizer {
+ protected:
+  std::vector<PSprite> textures;
+  std::vector<PSprite> masks_up;
+  std::vector<PSprite> masks_down;
+
+ public:
+  explicit LandscapeRasterizer(PDataSource data_source);
+
+  /* Render the landscape tile at column tc and row tr of tiles, each
+     MAP_TILE_COLS by MAP_TILE_ROWS map positions. */
+  PSprite render(const Map &map, int tc, int tr) const;
+
+ protected:
+  void draw_triangle_up(const Map &map, int x, int y, int m, int left,
+                        int right, MapPos pos, Sprite *tile) const;
+  void draw_triangle_down(const Map &map, int x, int y, int m, int left,
+                          int right, MapPos pos, Sprite *tile) const;
+  void draw_up_tile_col(const Map &map, MapPos pos, int x_base, int y_base,
+                        int max_y, Sprite *tile) const;
+  void draw_down_tile_col(const Map &map, MapPos pos, int x_base, int y_base,
+                          int max_y, Sprite *tile) const;
+  void draw_masked(int x, int y, const PSprite &mask, const PSprite &texture,
+                   Sprite *tile) const;
+};
+
+#endif  // SRC_LANDSCAPE_RASTER_H_
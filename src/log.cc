@@ -30,6 +30,7 @@ Log::Level Log::level = Log::LevelInfo;
 #endif
 
 std::ostream *Log::stream = &std::cout;
+std::recursive_mutex Log::mutex;
 
 std::ostream Log::Logger::dummy(0);
 Log::Logger Log::Verbose(Log::LevelVerbose, "Verbose");
@@ -41,6 +42,7 @@ Log::Logger Log::Error(Log::LevelError, "Error");
 void
 Log::set_file(std::ostream *_stream) {
   stream = _stream;
+  set_level(level);
 }
 
 void
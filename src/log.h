@@ -35,8 +35,10 @@
 #ifndef SRC_LOG_H_
 #define SRC_LOG_H_
 
+#include <mutex>  // NOLINT(build/c++11)
 #include <ostream>
 #include <string>
+#include <utility>
 
 class Log {
  public:
@@ -51,15 +53,25 @@ class Log {
     LevelMax
   } Level;
 
+  /* A log line. Other threads are kept from logging until it is done. */
   class Stream {
    protected:
     std::ostream *stream;
+    std::unique_lock<std::recursive_mutex> lock;
 
    public:
-    explicit Stream(std::ostream *_stream) : stream(_stream) {}
+    Stream(std::ostream *_stream,
+           std::unique_lock<std::recursive_mutex> _lock)
+      : stream(_stream), lock(std::move(_lock)) {}
+    Stream(Stream &&that)
+      : stream(that.stream), lock(std::move(that.lock)) {
+      that.stream = nullptr;
+    }
     ~Stream() {
-      *stream << std::endl;
-      stream->flush();
+      if (stream != nullptr) {
+        *stream << std::endl;
+        stream->flush();
+      }
     }
 
     std::ostream *get_stream() { return stream; }
@@ -89,8 +101,9 @@ class Log {
     }
 
     virtual Stream operator[](std::string subsystem) {
+      std::unique_lock<std::recursive_mutex> lock(Log::mutex);
       *stream << prefix << ": [" << subsystem << "] ";
-      return Stream(stream);
+      return Stream(stream, std::move(lock));
     }
 
     void apply_level() {
@@ -114,6 +127,7 @@ class Log {
  protected:
   static std::ostream *stream;
   static Level level;
+  static std::recursive_mutex mutex;
 };
 
 #endif  // SRC_LOG_H_
@@ -0,0 +1,158 @@
+/*
+ * lru-cache.h - Cache evicting the least recently used objects
+ *
+ * Copyright (C) 2026  freeserf developers
+ *
+ * This file is part of freeserf.
+ *
+ * freeserf is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * freeserf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with freeserf.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SRC_LRU_CACHE_H_
+#define SRC_LRU_CACHE_H_
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+
+// Cache owning objects by key. Each object has a cost, e.g. its size in
+// bytes; when the total cost exceeds the budget the least recently used
+// objects are dropped. The object inserted last is always kept, so a
+// budget below the cost of a single object still caches one. Objects used
+// together can be inserted so that none of them is dropped to make room for
+// the others. Pinned objects count towards the budget but are never
+// dropped.
+template <typename Key, typename Value>
+class LruCache {
+ public:
+  typedef struct Stats {
+    size_t hits;
+    size_t misses;
+    size_t evictions;
+  } Stats;
+
+ protected:
+  typedef struct Entry {
+    Key key;
+    std::unique_ptr<Value> value;
+    size_t cost;
+    bool pinned;
+  } Entry;
+  /* Most recently used first. */
+  typedef std::list<Entry> Entries;
+  typedef std::unordered_map<Key, typename Entries::iterator> Lookup;
+
+  Entries entries;
+  Lookup lookup;
+  size_t budget;
+  size_t cost;
+  Stats stats;
+
+ public:
+  explicit LruCache(size_t _budget)
+    : budget(_budget)
+    , cost(0) {
+    reset_stats();
+  }
+
+  /* Object of key, or nullptr on a miss. Marks the object as used. */
+  Value *get(const Key &key) {
+    typename Lookup::iterator it = lookup.find(key);
+    if (it == lookup.end()) {
+      stats.misses++;
+      return nullptr;
+    }
+    stats.hits++;
+    entries.splice(entries.begin(), entries, it->second);
+    return it->second->value.get();
+  }
+
+  /* Whether key is cached, without marking it as used or counting it. */
+  bool contains(const Key &key) const {
+    return (lookup.find(key) != lookup.end());
+  }
+
+  /* Cache value under key, replacing what was cached for it before. The
+     keep most recently inserted objects, including this one, are not
+     dropped to make room for it. */
+  Value *insert(const Key &key, std::unique_ptr<Value> value,
+                size_t value_cost, bool pinned = false, size_t keep = 1) {
+    erase(key);
+    Value *result = value.get();
+    entries.push_front(Entry{key, std::move(value), value_cost, pinned});
+    lookup[key] = entries.begin();
+    cost += value_cost;
+    evict(keep);
+    return result;
+  }
+
+  void erase(const Key &key) {
+    typename Lookup::iterator it = lookup.find(key);
+    if (it == lookup.end()) {
+      return;
+    }
+    cost -= it->second->cost;
+    entries.erase(it->second);
+    lookup.erase(it);
+  }
+
+  void set_pinned(const Key &key, bool pinned) {
+    typename Lookup::iterator it = lookup.find(key);
+    if (it != lookup.end()) {
+      it->second->pinned = pinned;
+      evict();
+    }
+  }
+
+  void clear() {
+    entries.clear();
+    lookup.clear();
+    cost = 0;
+  }
+
+  void set_budget(size_t _budget) {
+    budget = _budget;
+    evict();
+  }
+  size_t get_budget() const { return budget; }
+  /* Total cost of the cached objects. */
+  size_t get_cost() const { return cost; }
+  size_t get_count() const { return entries.size(); }
+
+  const Stats &get_stats() const { return stats; }
+  void reset_stats() { stats = Stats{0, 0, 0}; }
+
+ protected:
+  /* Drop objects until the cost fits the budget, except the first keep
+     objects. */
+  void evict(size_t keep = 1) {
+    size_t left = (entries.size() > keep) ? entries.size() - keep : 0;
+    typename Entries::iterator it = entries.end();
+    while (cost > budget && left > 0) {
+      --it;
+      left--;
+      if (it->pinned) {
+        continue;
+      }
+      cost -= it->cost;
+      lookup.erase(it->key);
+      it = entries.erase(it);
+      stats.evictions++;
+    }
+  }
+};
+
+#endif  // SRC_LRU_CACHE_H_
@@ -67,6 +67,7 @@
 
 #include <algorithm>
 #include <utility>
+#include <mutex>  // NOLINT(build/c++11)
 
 #include "src/debug.h"
 #include "src/savegame.h"
@@ -128,15 +129,10 @@ static int spiral_pattern[] = {
   24, 16, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
 };
 
-static int spiral_pattern_initialized = 0;
+static std::once_flag spiral_pattern_initialized;
 
-/* Initialize the global spiral_pattern. */
 static void
-init_spiral_pattern() {
-  if (spiral_pattern_initialized) {
-    return;
-  }
-
+setup_spiral_pattern() {
   static const int spiral_matrix[] = {
     1,  0,  0,  1,
     1,  1, -1,  0,
@@ -157,8 +153,13 @@ init_spiral_pattern() {
                                      y*spiral_matrix[4*j+3];
     }
   }
+}
 
-  spiral_pattern_initialized = 1;
+/* Initialize the global spiral_pattern. Maps may be created on several
+   threads at once. */
+static void
+init_spiral_pattern() {
+  std::call_once(spiral_pattern_initialized, setup_spiral_pattern);
 }
 
 int *
@@ -336,10 +337,26 @@ Map::Map(const MapGeometry& geom)
 
   regions = (geom.cols() >> 5) * (geom.rows() >> 5);
 
+  change_count = 0;
+  block_changes.resize((geom.cols() / SAVE_MAP_TILE_SIZE) *
+                       (geom.rows() / SAVE_MAP_TILE_SIZE));
+
   init_spiral_pattern();
   init_spiral_pos_pattern();
 }
 
+Map::Map(const Map& that)
+  : geom_(that.geom_)
+  , landscape_tiles(that.landscape_tiles)
+  , game_tiles(that.game_tiles)
+  , regions(that.regions)
+  , update_state(that.update_state)
+  , spiral_pos_pattern(new MapPos[295])
+  , change_count(that.change_count)
+  , block_changes(that.block_changes) {
+  init_spiral_pos_pattern();
+}
+
 /* Return a random map position.
    Returned as map_pos_t and also as col and row if not NULL. */
 MapPos
@@ -381,12 +398,20 @@ Map::init_spiral_pos_pattern() {
 void
 Map::init_tiles(const MapGenerator &generator) {
   landscape_tiles = generator.get_landscape();
+  mark_all_changed();
+}
+
+void
+Map::mark_all_changed() {
+  change_count++;
+  std::fill(block_changes.begin(), block_changes.end(), change_count);
 }
 
 /* Change the height of a map position. */
 void
 Map::set_height(MapPos pos, int height) {
   landscape_tiles[pos].height = height;
+  mark_changed(pos);
 
   /* Mark landscape dirty */
   for (Direction d : cycle_directions_cw()) {
@@ -403,6 +428,7 @@ void
 Map::set_object(MapPos pos, Object obj, int index) {
   landscape_tiles[pos].obj = obj;
   if (index >= 0) game_tiles[pos].obj_index = index;
+  mark_changed(pos);
 
   /* Notify about object change */
   for (Direction d : cycle_directions_cw()) {
@@ -416,6 +442,7 @@ Map::set_object(MapPos pos, Object obj, int index) {
 void
 Map::remove_ground_deposit(MapPos pos, int amount) {
   landscape_tiles[pos].resource_amount -= amount;
+  mark_changed(pos);
 
   if (landscape_tiles[pos].resource_amount <= 0) {
     /* Also sets the ground deposit type to none. */
@@ -427,12 +454,14 @@ Map::remove_ground_deposit(MapPos pos, int amount) {
 void
 Map::remove_fish(MapPos pos, int amount) {
   landscape_tiles[pos].resource_amount -= amount;
+  mark_changed(pos);
 }
 
 /* Set the index of the serf occupying map position. */
 void
 Map::set_serf_index(MapPos pos, int index) {
   game_tiles[pos].serf = index;
+  mark_changed(pos);
 
   /* TODO Mark dirty in viewport. */
 }
@@ -509,6 +538,7 @@ Map::update_hidden(MapPos pos, Random *rnd) {
     if (landscape_tiles[pos].resource_amount < 10 && (r & 0x3f00)) {
       /* Spawn more fish. */
       landscape_tiles[pos].resource_amount += 1;
+      mark_changed(pos);
     }
 
     /* Move in a random direction of: right, down right, left, up left */
@@ -525,6 +555,8 @@ Map::update_hidden(MapPos pos, Random *rnd) {
       /* Migrate a fish to adjacent water space. */
       landscape_tiles[pos].resource_amount -= 1;
       landscape_tiles[adj_pos].resource_amount += 1;
+      mark_changed(pos);
+      mark_changed(adj_pos);
     }
   }
 }
@@ -611,6 +643,8 @@ Map::place_road_segments(const Road &road) {
 
         game_tiles[pos_].paths &= ~BIT(dir);
         game_tiles[move(pos_, dir)].paths &= ~BIT(rev_dir);
+        mark_changed(pos_);
+        mark_changed(move(pos_, dir));
 
         pos_ = move(pos_, dir);
       }
@@ -620,6 +654,8 @@ Map::place_road_segments(const Road &road) {
 
     game_tiles[pos_].paths |= BIT(*it);
     game_tiles[move(pos_, *it)].paths |= BIT(rev_dir);
+    mark_changed(pos_);
+    mark_changed(move(pos_, *it));
 
     pos_ = move(pos_, *it);
   }
@@ -634,6 +670,7 @@ Map::remove_road_backref_until_flag(MapPos pos_, Direction dir) {
 
     /* Clear backreference */
     game_tiles[pos_].paths &= ~BIT(reverse_direction(dir));
+    mark_changed(pos_);
 
     if (get_obj(pos_) == ObjectFlag) break;
 
@@ -688,10 +725,12 @@ Direction
 Map::remove_road_segment(MapPos *pos, Direction dir) {
   /* Clear forward reference. */
   game_tiles[*pos].paths &= ~BIT(dir);
+  mark_changed(*pos);
   *pos = move(*pos, dir);
 
   /* Clear backreference. */
   game_tiles[*pos].paths &= ~BIT(reverse_direction(dir));
+  mark_changed(*pos);
 
   /* Find next direction of path. */
   dir = DirectionNone;
@@ -858,8 +897,6 @@ Map::pos_from_saved_value(uint32_t val) {
   return pos(x, y);
 }
 
-#define SAVE_MAP_TILE_SIZE (16)
-
 SaveReaderText&
 operator >> (SaveReaderText &reader, Map &map) {
   int x = 0;
@@ -868,43 +905,59 @@ operator >> (SaveReaderText &reader, Map &map) {
   reader.value("pos")[1] >> y;
   MapPos pos = map.pos(x, y);
 
+  /* Look up each list once for the whole block. */
+  const SaveReaderTextValue &paths = reader.value("paths");
+  const SaveReaderTextValue &height = reader.value("height");
+  const SaveReaderTextValue &type_up = reader.value("type.up");
+  const SaveReaderTextValue &type_down = reader.value("type.down");
+  const SaveReaderTextValue &object = reader.value("object");
+  const SaveReaderTextValue &serf = reader.value("serf");
+  const SaveReaderTextValue &resource_type = reader.value("resource.type");
+  const SaveReaderTextValue &resource_amount =
+                                             reader.value("resource.amount");
+  const SaveReaderTextValue *idle_serf = nullptr;
+  if (reader.has_value("idle_serf")) {
+    idle_serf = &reader.value("idle_serf");
+  }
+
   for (int y = 0; y < SAVE_MAP_TILE_SIZE; y++) {
     for (int x = 0; x < SAVE_MAP_TILE_SIZE; x++) {
       MapPos p = map.pos_add(pos, map.pos(x, y));
       Map::GameTile &game_tile = map.game_tiles[p];
       Map::LandscapeTile &landscape_tile = map.landscape_tiles[p];
+      size_t i = y*SAVE_MAP_TILE_SIZE+x;
       unsigned int val;
 
-      reader.value("paths")[y*SAVE_MAP_TILE_SIZE+x] >> val;
+      paths[i] >> val;
       game_tile.paths = val & 0x3f;
 
-      reader.value("height")[y*SAVE_MAP_TILE_SIZE+x] >> val;
+      height[i] >> val;
       landscape_tile.height = val & 0x1f;
 
-      reader.value("type.up")[y*SAVE_MAP_TILE_SIZE+x] >> val;
+      type_up[i] >> val;
       landscape_tile.type_up = (Map::Terrain)val;
 
-      reader.value("type.down")[y*SAVE_MAP_TILE_SIZE+x] >> val;
+      type_down[i] >> val;
       landscape_tile.type_down = (Map::Terrain)val;
 
-      try {
-        reader.value("idle_serf")[y*SAVE_MAP_TILE_SIZE+x] >> val;
+      if (idle_serf != nullptr) {
+        (*idle_serf)[i] >> val;
         game_tile.idle_serf = (val != 0);
-        reader.value("object")[y*SAVE_MAP_TILE_SIZE+x] >> val;
+        object[i] >> val;
         landscape_tile.obj = (Map::Object)val;
-      } catch (...) {
-        reader.value("object")[y*SAVE_MAP_TILE_SIZE+x] >> val;
+      } else {
+        object[i] >> val;
         landscape_tile.obj = (Map::Object)(val & 0x7f);
         game_tile.idle_serf = (BIT_TEST(val, 7) != 0);
       }
 
-      reader.value("serf")[y*SAVE_MAP_TILE_SIZE+x] >> val;
+      serf[i] >> val;
       game_tile.serf = val;
 
-      reader.value("resource.type")[y*SAVE_MAP_TILE_SIZE+x] >> val;
+      resource_type[i] >> val;
       landscape_tile.mineral = (Map::Minerals)val;
 
-      reader.value("resource.amount")[y*SAVE_MAP_TILE_SIZE+x] >> val;
+      resource_amount[i] >> val;
       landscape_tile.resource_amount = val;
     }
   }
@@ -914,34 +967,39 @@ operator >> (SaveReaderText &reader, Map &map) {
 
 SaveWriterText&
 operator << (SaveWriterText &writer, Map &map) {
-  int i = 0;
-
-  for (unsigned int ty = 0; ty < map.get_rows(); ty += SAVE_MAP_TILE_SIZE) {
-    for (unsigned int tx = 0; tx < map.get_cols(); tx += SAVE_MAP_TILE_SIZE) {
-      SaveWriterText &map_writer = writer.add_section("map", i++);
-
-      map_writer.value("pos") << tx;
-      map_writer.value("pos") << ty;
-
-      for (int y = 0; y < SAVE_MAP_TILE_SIZE; y++) {
-        for (int x = 0; x < SAVE_MAP_TILE_SIZE; x++) {
-          MapPos pos = map.pos(tx+x, ty+y);
-
-          map_writer.value("height") << map.get_height(pos);
-          map_writer.value("type.up") << map.type_up(pos);
-          map_writer.value("type.down") << map.type_down(pos);
-          map_writer.value("paths") << map.paths(pos);
-          map_writer.value("object") << map.get_obj(pos);
-          map_writer.value("serf") << map.get_serf_index(pos);
-          map_writer.value("idle_serf") << map.get_idle_serf(pos);
-
-          if (map.is_in_water(pos)) {
-            map_writer.value("resource.type") << 0;
-            map_writer.value("resource.amount") << map.get_res_fish(pos);
-          } else {
-            map_writer.value("resource.type") << map.get_res_type(pos);
-            map_writer.value("resource.amount") << map.get_res_amount(pos);
-          }
+  /* Blocks are numbered row by row, but written in the order of the text
+     of their number. */
+  unsigned int block_cols = map.get_cols() / SAVE_MAP_TILE_SIZE;
+  unsigned int block_count = block_cols *
+                             (map.get_rows() / SAVE_MAP_TILE_SIZE);
+
+  for (unsigned int i : SaveTextOrder(block_count)) {
+    unsigned int tx = (i % block_cols) * SAVE_MAP_TILE_SIZE;
+    unsigned int ty = (i / block_cols) * SAVE_MAP_TILE_SIZE;
+    if (!writer.wants_section("map", i)) continue;
+    SaveWriterText &map_writer = writer.add_section("map", i);
+
+    map_writer.value("pos") << tx;
+    map_writer.value("pos") << ty;
+
+    for (int y = 0; y < SAVE_MAP_TILE_SIZE; y++) {
+      for (int x = 0; x < SAVE_MAP_TILE_SIZE; x++) {
+        MapPos pos = map.pos(tx+x, ty+y);
+
+        map_writer.value("height") << map.get_height(pos);
+        map_writer.value("type.up") << map.type_up(pos);
+        map_writer.value("type.down") << map.type_down(pos);
+        map_writer.value("paths") << map.paths(pos);
+        map_writer.value("object") << map.get_obj(pos);
+        map_writer.value("serf") << map.get_serf_index(pos);
+        map_writer.value("idle_serf") << map.get_idle_serf(pos);
+
+        if (map.is_in_water(pos)) {
+          map_writer.value("resource.type") << 0;
+          map_writer.value("resource.amount") << map.get_res_fish(pos);
+        } else {
+          map_writer.value("resource.type") << map.get_res_type(pos);
+          map_writer.value("resource.amount") << map.get_res_amount(pos);
         }
       }
     }
@@ -28,9 +28,13 @@
 #include <vector>
 
 #include "src/map-geometry.h"
+#include "src/cow-vector.h"
 #include "src/misc.h"
 #include "src/random.h"
 
+/* Side of the square blocks the map is saved in. */
+#define SAVE_MAP_TILE_SIZE (16)
+
 class Map;
 
 class Road {
@@ -293,8 +297,8 @@ class Map {
   } GameTile;
 
   MapGeometry geom_;
-  std::vector<LandscapeTile> landscape_tiles;
-  std::vector<GameTile> game_tiles;
+  CowVector<LandscapeTile> landscape_tiles;
+  CowVector<GameTile> game_tiles;
 
   uint16_t regions;
 
@@ -306,8 +310,15 @@ class Map {
 
   std::unique_ptr<MapPos[]> spiral_pos_pattern;
 
+  /* Changes to the saved tile data, counted per save block. */
+  uint64_t change_count;
+  std::vector<uint64_t> block_changes;
+
  public:
   explicit Map(const MapGeometry& geom);
+  // Copy shares tile data with the original until either map modifies it.
+  // Change handlers are not copied.
+  Map(const Map& that);
 
   const MapGeometry& geom() const { return geom_; }
 
@@ -366,9 +377,9 @@ class Map {
   bool has_path(MapPos pos, Direction dir) const {
     return (BIT_TEST(game_tiles[pos].paths, dir) != 0); }
   void add_path(MapPos pos, Direction dir) {
-    game_tiles[pos].paths |= BIT(dir); }
+    game_tiles[pos].paths |= BIT(dir); mark_changed(pos); }
   void del_path(MapPos pos, Direction dir) {
-    game_tiles[pos].paths &= ~BIT(dir); }
+    game_tiles[pos].paths &= ~BIT(dir); mark_changed(pos); }
 
   bool has_owner(MapPos pos) const { return (game_tiles[pos].owner != 0); }
   unsigned int get_owner(MapPos pos) const {
@@ -385,8 +396,10 @@ class Map {
 
   Object get_obj(MapPos pos) const { return landscape_tiles[pos].obj; }
   bool get_idle_serf(MapPos pos) const { return game_tiles[pos].idle_serf; }
-  void set_idle_serf(MapPos pos) { game_tiles[pos].idle_serf = true; }
-  void clear_idle_serf(MapPos pos) { game_tiles[pos].idle_serf = false; }
+  void set_idle_serf(MapPos pos) {
+    game_tiles[pos].idle_serf = true; mark_changed(pos); }
+  void clear_idle_serf(MapPos pos) {
+    game_tiles[pos].idle_serf = false; mark_changed(pos); }
 
   unsigned int get_obj_index(MapPos pos) const {
     return game_tiles[pos].obj_index; }
@@ -441,6 +454,15 @@ class Map {
   void add_change_handler(Handler *handler);
   void del_change_handler(Handler *handler);
 
+  /* Saved tile data is split into blocks of SAVE_MAP_TILE_SIZE squared
+     tiles, numbered row by row. Each block remembers the change count at
+     its last modification, so incremental saves can skip unchanged ones. */
+  unsigned int get_save_block_count() const {
+    return static_cast<unsigned int>(block_changes.size()); }
+  uint64_t get_change_count() const { return change_count; }
+  bool is_block_changed(unsigned int block, uint64_t since) const {
+    return (block_changes[block] > since); }
+
   static int *get_spiral_pattern();
 
   /* Actually place road segments */
@@ -468,6 +490,14 @@ class Map {
 
   void update_public(MapPos pos, Random *rnd);
   void update_hidden(MapPos pos, Random *rnd);
+
+  void mark_changed(MapPos pos) {
+    unsigned int block = (pos_row(pos) / SAVE_MAP_TILE_SIZE) *
+                         (get_cols() / SAVE_MAP_TILE_SIZE) +
+                         (pos_col(pos) / SAVE_MAP_TILE_SIZE);
+    block_changes[block] = ++change_count;
+  }
+  void mark_all_changed();
 };
 
 typedef std::shared_ptr<Map> PMap;
@@ -0,0 +1,164 @@
+/*
+ * mapped-file.cc - Read only view of a file mapped into memory
+ *
+ * Copyright (C) 2026  freeserf developers
+ *
+ * This file is part of freeserf.
+ *
+ * freeserf is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * freeserf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with freeserf.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/mapped-file.h"
+
+#include <fstream>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/* Empty files can not be mapped, they are represented by this instead. */
+static const uint8_t empty_file[1] = { 0 };
+
+MappedFile::MappedFile()
+  : data(nullptr)
+  , size(0)
+  , mapped(false) {
+#ifdef _WIN32
+  file_handle = INVALID_HANDLE_VALUE;
+  mapping_handle = nullptr;
+#endif
+}
+
+MappedFile::~MappedFile() {
+  close();
+}
+
+bool
+MappedFile::open(const std::string &path) {
+  close();
+
+#ifdef _WIN32
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                            nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+
+  LARGE_INTEGER file_size;
+  if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+    CloseHandle(file);
+    return read(path);
+  }
+
+  HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0,
+                                      nullptr);
+  void *view = nullptr;
+  if (mapping != nullptr) {
+    view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  }
+  if (view == nullptr) {
+    if (mapping != nullptr) CloseHandle(mapping);
+    CloseHandle(file);
+    return read(path);
+  }
+
+  file_handle = file;
+  mapping_handle = mapping;
+  data = reinterpret_cast<const uint8_t*>(view);
+  size = static_cast<size_t>(file_size.QuadPart);
+  mapped = true;
+#else
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+
+  struct stat info;
+  if (fstat(fd, &info) != 0 || (info.st_mode & S_IFDIR) == S_IFDIR) {
+    ::close(fd);
+    return false;
+  }
+
+  if (info.st_size == 0) {
+    ::close(fd);
+    data = empty_file;
+    return true;
+  }
+
+  void *view = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (view == MAP_FAILED) {
+    return read(path);
+  }
+
+  data = reinterpret_cast<const uint8_t*>(view);
+  size = static_cast<size_t>(info.st_size);
+  mapped = true;
+#endif
+
+  return true;
+}
+
+void
+MappedFile::close() {
+  if (mapped) {
+#ifdef _WIN32
+    UnmapViewOfFile(data);
+    CloseHandle(mapping_handle);
+    CloseHandle(file_handle);
+    file_handle = INVALID_HANDLE_VALUE;
+    mapping_handle = nullptr;
+#else
+    munmap(const_cast<uint8_t*>(data), size);
+#endif
+  }
+
+  buffer.reset();
+  data = nullptr;
+  size = 0;
+  mapped = false;
+}
+
+/* Fall back to reading the whole file. */
+bool
+MappedFile::read(const std::string &path) {
+  std::ifstream file(path.c_str(), std::ios::binary | std::ios::ate);
+  if (!file.good()) {
+    return false;
+  }
+
+  size = static_cast<size_t>(file.tellg());
+  file.seekg(0, file.beg);
+  if (size == 0) {
+    data = empty_file;
+    return true;
+  }
+
+  buffer.reset(new uint8_t[size]);
+  file.read(reinterpret_cast<char*>(buffer.get()), size);
+  if (!file.good()) {
+    buffer.reset();
+    size = 0;
+    return false;
+  }
+
+  data = buffer.get();
+  return true;
+}
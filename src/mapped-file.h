@@ -0,0 +1,62 @@
+/*
+ * mapped-file.h - Read only view of a file mapped into memory
+ *
+ * Copyright (C) 2026  freeserf developers
+ *
+ * This file is part of freeserf.
+ *
+ * freeserf is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * freeserf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with freeserf.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SRC_MAPPED_FILE_H_
+#define SRC_MAPPED_FILE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Maps a whole file into memory for reading. Where memory mapping is not
+// available the file is read into a buffer instead.
+class MappedFile {
+ protected:
+  const uint8_t *data;
+  size_t size;
+  bool mapped;
+  std::unique_ptr<uint8_t[]> buffer;
+#ifdef _WIN32
+  void *file_handle;
+  void *mapping_handle;
+#endif
+
+ public:
+  MappedFile();
+  virtual ~MappedFile();
+
+  /* Returns false if the file could not be opened. */
+  bool open(const std::string &path);
+  void close();
+
+  bool is_open() const { return (data != nullptr); }
+  const uint8_t *get_data() const { return data; }
+  size_t get_size() const { return size; }
+
+ protected:
+  MappedFile(const MappedFile &that) = delete;
+  MappedFile &operator = (const MappedFile &that) = delete;
+
+  bool read(const std::string &path);
+};
+
+#endif  // SRC_MAPPED_FILE_H_
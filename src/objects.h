@@ -39,7 +39,6 @@ class GameObject {
  public:
   GameObject() = delete;
   GameObject(Game *game, unsigned int index) : index(index), game(game) {}
-  GameObject(const GameObject& that) = delete;  // Copying prohibited
   GameObject(GameObject&& that) = delete;  // Moving prohibited
   virtual ~GameObject() {}
 
@@ -48,6 +47,13 @@ class GameObject {
 
   Game *get_game() const { return game; }
   unsigned int get_index() const { return index; }
+
+ protected:
+  // Copying is only allowed for Collection when forking a game. Subclasses
+  // declare their own copy constructor protected and befriend Collection.
+  GameObject(const GameObject& that) = default;
+
+  void set_game(Game *game_) { game = game_; }
 };
 
 template<class T, size_t growth>
@@ -72,6 +78,24 @@ class Collection {
     last_object_index = 0;
   }
 
+  // Copy all objects of that collection into a collection owned by _game.
+  // Pointers between objects still refer to the objects of the original
+  // collection and have to be relinked by the caller.
+  Collection(const Collection &that, Game *_game)
+    : last_object_index(that.last_object_index)
+    , free_object_indexes(that.free_object_indexes)
+    , game(_game) {
+    objects.reserve(that.objects.capacity());
+    for (const T *obj : that.objects) {
+      T *copy = nullptr;
+      if (obj != nullptr) {
+        copy = new T(*obj);
+        copy->set_game(game);
+      }
+      objects.push_back(copy);
+    }
+  }
+
   virtual ~Collection() {
     clear();
   }
@@ -225,11 +249,22 @@ class Collection {
     }
   };
 
-  Iterator begin() { return Iterator(objects.begin(), &objects); }
+  /* The first object may have been deleted, e.g. a captured castle. */
+  Iterator begin() {
+    Iterator i(objects.begin(), &objects);
+    if (!objects.empty() && objects.front() == nullptr) {
+      ++i;
+    }
+    return i;
+  }
   Iterator end() { return Iterator(objects.end(), &objects); }
 
   ConstIterator begin() const {
-    return ConstIterator(objects.begin(), &objects);
+    ConstIterator i(objects.begin(), &objects);
+    if (!objects.empty() && objects.front() == nullptr) {
+      ++i;
+    }
+    return i;
   }
 
   ConstIterator end() const {
@@ -252,6 +287,10 @@ class Collection {
 
   size_t
   size() const { return objects.size() - free_object_indexes.size(); }
+
+  /* One past the highest index in use. */
+  unsigned int
+  get_index_limit() const { return static_cast<unsigned int>(objects.size()); }
 };
 
 #endif  // SRC_OBJECTS_H_
@@ -23,6 +23,7 @@
 
 #include <algorithm>
 
+#include "src/debug.h"
 #include "src/game.h"
 #include "src/log.h"
 #include "src/inventory.h"
@@ -512,6 +513,47 @@ Player::knights_available_for_attack(MapPos pos) {
   return total_attacking_knights;
 }
 
+/* Whether building is an occupied enemy military building at the border,
+   close enough to the land of the player to be attacked. */
+bool
+Player::can_attack(Building *building) {
+  if (building->get_owner() == index || !building->is_done() ||
+      !building->is_military() || !building->is_active() ||
+      building->get_threat_level() != 3) {
+    return false;
+  }
+
+  PMap map = game->get_map();
+  for (int i = 257; i >= 0; i--) {
+    MapPos pos = map->pos_add_spirally(building->get_position(), 7+257-i);
+    if (map->has_owner(pos) && map->get_owner(pos) == index) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+/* Select building as the target of the next attack with as many knights
+   as are available, up to what the building can hold. Returns the number
+   of knights. */
+int
+Player::prepare_attack(Building *building) {
+  int max_knights = 0;
+  switch (building->get_type()) {
+    case Building::TypeHut: max_knights = 3; break;
+    case Building::TypeTower: max_knights = 6; break;
+    case Building::TypeFortress: max_knights = 12; break;
+    case Building::TypeCastle: max_knights = 20; break;
+    default: NOT_REACHED(); break;
+  }
+
+  building_attacked = building->get_index();
+  int knights = knights_available_for_attack(building->get_position());
+  knights_attacking = std::min(knights, max_knights);
+  return knights_attacking;
+}
+
 void
 Player::start_attack() {
   const int min_level_hut[] = { 1, 1, 2, 2, 3 };
@@ -244,6 +244,8 @@ class Player : public GameObject {
 
   int promote_serfs_to_knights(int number);
   int knights_available_for_attack(MapPos pos);
+  bool can_attack(Building *building);
+  int prepare_attack(Building *building);
   void start_attack();
   void cycle_knights();
 
@@ -348,6 +350,9 @@ class Player : public GameObject {
   void init_ai_values(size_t face);
 
   int available_knights_at_pos(MapPos pos, int index, int dist);
+
+  Player(const Player &that) = default;
+  template<class T, size_t growth> friend class Collection;
 };
 
 #endif  // SRC_PLAYER_H_
@@ -2179,7 +2179,7 @@ PopupBox::draw_transport_info_box() {
 
 #if 1
   /* Draw viewport of flag */
-  Viewport flag_view(interface, interface->get_game()->get_map());
+  Viewport flag_view(interface, interface->get_game());
   flag_view.switch_layer(Viewport::LayerLandscape);
   flag_view.switch_layer(Viewport::LayerSerfs);
   flag_view.switch_layer(Viewport::LayerCursor);
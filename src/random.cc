@@ -22,9 +22,13 @@
 #include "src/random.h"
 
 #include <ctime>
+#include <mutex>  // NOLINT(build/c++11)
 #include <sstream>
 
 Random::Random() {
+  /* The C library generator is shared by all threads. */
+  static std::mutex mutex;
+  std::lock_guard<std::mutex> lock(mutex);
   srand((unsigned int)time(NULL));
   state[0] = std::rand();
   state[1] = std::rand();
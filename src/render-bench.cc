@@ -0,0 +1,310 @@
+/*
+ * render-bench.cc - Benchmark of drawing the game interface
+ *
+ * Copyright (C) 2026  freeserf developers
+ *
+ * This file is part of freeserf.
+ *
+ * freeserf is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * freeserf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with freeserf.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <istream>
+#include <string>
+#include <vector>
+
+#include "src/command_line.h"
+#include "src/data.h"
+#include "src/game-manager.h"
+#include "src/gfx.h"
+#include "src/interface.h"
+#include "src/log.h"
+#include "src/popup.h"
+#include "src/version.h"
+#include "src/video-software.h"
+#include "src/viewport.h"
+
+#ifdef WIN32
+# include <SDL.h>
+#endif  // WIN32
+
+/* Pixels the camera moves each frame. */
+#define CAMERA_STEP  8
+
+/* Move the camera along a square that ends where it started, a side for
+   each quarter of the frames. The frames left over after the four sides
+   are drawn without moving. */
+static void
+move_camera(Viewport *viewport, unsigned int frame, unsigned int count) {
+  unsigned int side = count / 4;
+  if (frame >= side * 4) {
+    return;
+  }
+
+  switch (frame / side) {
+    case 0: viewport->move_by_pixels(CAMERA_STEP, 0); break;
+    case 1: viewport->move_by_pixels(0, CAMERA_STEP); break;
+    case 2: viewport->move_by_pixels(-CAMERA_STEP, 0); break;
+    default: viewport->move_by_pixels(0, -CAMERA_STEP); break;
+  }
+}
+
+/* Screenshots are binary PPM files, the alpha of the screen is left out. */
+static bool
+write_screenshot(const std::string &path, const FrameSoftware *frame) {
+  std::ofstream file(path.c_str(), std::ios::binary | std::ios::trunc);
+  if (!file.good()) {
+    return false;
+  }
+
+  file << "P6\n" << frame->width << " " << frame->height << "\n255\n";
+  std::vector<char> row(frame->width * 3);
+  for (unsigned int y = 0; y < frame->height; y++) {
+    const uint32_t *pixels = frame->pixels.data() + y * frame->width;
+    for (unsigned int x = 0; x < frame->width; x++) {
+      row[x*3 + 0] = static_cast<char>((pixels[x] >> 16) & 0xFF);
+      row[x*3 + 1] = static_cast<char>((pixels[x] >> 8) & 0xFF);
+      row[x*3 + 2] = static_cast<char>(pixels[x] & 0xFF);
+    }
+    file.write(row.data(), row.size());
+  }
+
+  file.close();
+  return !file.fail();
+}
+
+/* Number of pixels of frame that differ from the screenshot at path, or -1
+   if it can not be read or has another size. */
+static int
+compare_screenshot(const std::string &path, const FrameSoftware *frame) {
+  std::ifstream file(path.c_str(), std::ios::binary);
+  std::string magic;
+  unsigned int width = 0;
+  unsigned int height = 0;
+  unsigned int max = 0;
+  file >> magic >> width >> height >> max;
+  file.get();
+  if (!file.good() || magic != "P6" || max != 255 ||
+      width != frame->width || height != frame->height) {
+    return -1;
+  }
+
+  int different = 0;
+  std::vector<char> row(width * 3);
+  for (unsigned int y = 0; y < height; y++) {
+    if (!file.read(row.data(), row.size())) {
+      return -1;
+    }
+    const uint32_t *pixels = frame->pixels.data() + y * width;
+    for (unsigned int x = 0; x < width; x++) {
+      uint32_t rgb = (static_cast<uint8_t>(row[x*3 + 0]) << 16) |
+                     (static_cast<uint8_t>(row[x*3 + 1]) << 8) |
+                     static_cast<uint8_t>(row[x*3 + 2]);
+      if ((pixels[x] & 0x00FFFFFF) != rgb) {
+        different++;
+      }
+    }
+  }
+
+  return different;
+}
+
+int
+main(int argc, char *argv[]) {
+  std::string data_dir;
+  std::string save_file;
+  std::string screenshot_file;
+  std::string reference_file;
+  unsigned int frames = 200;
+  unsigned int screen_width = 800;
+  unsigned int screen_height = 600;
+  bool window = false;
+
+  CommandLine command_line;
+  command_line.add_option('c', "Compare the last frame with a screenshot")
+                .add_parameter("FILE", [&reference_file](std::istream& s) {
+                  std::getline(s, reference_file);
+                  return true;
+                });
+  command_line.add_option('g', "Use specified data directory")
+                .add_parameter("DATA-PATH", [&data_dir](std::istream& s) {
+                  s >> data_dir;
+                  return true;
+                });
+  command_line.add_option('h', "Show this help text", [&command_line](){
+                  command_line.show_help();
+                  exit(EXIT_SUCCESS);
+                });
+  command_line.add_option('l', "Load saved game")
+                .add_parameter("FILE", [&save_file](std::istream& s) {
+                  std::getline(s, save_file);
+                  return true;
+                });
+  command_line.add_option('n', "Number of frames drawn of each view")
+                .add_parameter("COUNT", [&frames](std::istream& s) {
+                  s >> frames;
+                  return true;
+                });
+  command_line.add_option('o', "Write a screenshot of the last frame")
+                .add_parameter("FILE", [&screenshot_file](std::istream& s) {
+                  std::getline(s, screenshot_file);
+                  return true;
+                });
+  command_line.add_option('r', "Set screen resolution (e.g. 800x600)")
+                .add_parameter("RES",
+                              [&screen_width, &screen_height](std::istream& s) {
+                  s >> screen_width;
+                  char c; s >> c;
+                  s >> screen_height;
+                  return true;
+                });
+  command_line.add_option('w', "Draw to a window instead of to memory",
+                          [&window](){ window = true; });
+  command_line.set_comment("Please report bugs to <" PACKAGE_BUGREPORT ">");
+  if (!command_line.process(argc, argv) || frames == 0 ||
+      screen_width * screen_height == 0) {
+    return EXIT_FAILURE;
+  }
+  if (window && (!screenshot_file.empty() || !reference_file.empty())) {
+    Log::Error["render-bench"] << "Screenshots need drawing to memory.";
+    return EXIT_FAILURE;
+  }
+
+  Log::Info["render-bench"] << "starts " << FREESERF_VERSION;
+
+  if (!window) {
+    Video::set_backend(Video::BackendSoftware);
+  }
+
+  Data &data = Data::get_instance();
+  if (!data.load(data_dir)) {
+    Log::Error["render-bench"] << "Could not load game data.";
+    return EXIT_FAILURE;
+  }
+
+  Graphics &gfx = Graphics::get_instance();
+  gfx.set_resolution(screen_width, screen_height, false);
+
+  /* A random game is not the same on each run, so screenshots of it can not
+     be compared. */
+  GameManager &game_manager = GameManager::get_instance();
+  if (!save_file.empty()) {
+    if (!game_manager.load_game(save_file)) {
+      return EXIT_FAILURE;
+    }
+  } else if (!game_manager.start_random_game()) {
+    return EXIT_FAILURE;
+  }
+
+  Interface interface;
+  interface.set_size(screen_width, screen_height);
+  interface.set_displayed(true);
+  Viewport *viewport = interface.get_viewport();
+  Frame *screen = gfx.get_screen_frame();
+
+  typedef struct View {
+    const char *name;
+    int popup;
+  } View;
+  const View views[] = {
+    { "viewport", PopupBox::TypeNone },
+    { "minimap", PopupBox::TypeMap },
+    { "popup", PopupBox::TypeSettSelect },
+  };
+
+  std::cout << std::left << std::setw(12) << "view" << std::right
+            << std::setw(10) << "fps" << std::setw(12) << "ms/frame"
+            << std::setw(12) << "images" << std::setw(12) << "draw calls"
+            << "  (" << frames << " frames, " << screen_width << "x"
+            << screen_height << ")\n";
+
+  for (const View &view : views) {
+    if (view.popup != PopupBox::TypeNone) {
+      interface.open_popup(view.popup);
+    }
+
+    /* The first frame decodes the sprites that are missing. */
+    interface.set_redraw();
+    interface.draw(screen);
+    gfx.swap_buffers();
+
+    uint64_t images = 0;
+    uint64_t draw_calls = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int i = 0; i < frames; i++) {
+      move_camera(viewport, i, frames);
+      interface.draw(screen);
+      gfx.swap_buffers();
+      Video::DrawStats stats = gfx.get_draw_stats();
+      images += stats.images;
+      draw_calls += stats.draw_calls;
+    }
+    auto end = std::chrono::steady_clock::now();
+    std::chrono::duration<double, std::milli> elapsed = end - start;
+
+    std::cout << std::left << std::setw(12) << view.name << std::right
+              << std::fixed << std::setprecision(1)
+              << std::setw(10) << (1000. * frames / elapsed.count())
+              << std::setprecision(3)
+              << std::setw(12) << (elapsed.count() / frames)
+              << std::setw(12) << (images / frames)
+              << std::setw(12) << (draw_calls / frames) << "\n";
+
+    if (view.popup != PopupBox::TypeNone) {
+      interface.close_popup();
+    }
+  }
+
+  /* The camera is back where it started. */
+  interface.set_redraw();
+  interface.draw(screen);
+  gfx.swap_buffers();
+
+  int result = EXIT_SUCCESS;
+  if (!window) {
+    const FrameSoftware *pixels = static_cast<const FrameSoftware*>(
+                                 Video::get_instance().get_screen_frame());
+    if (!screenshot_file.empty()) {
+      if (write_screenshot(screenshot_file, pixels)) {
+        Log::Info["render-bench"] << "Saved screenshot to '"
+                                  << screenshot_file << "'";
+      } else {
+        Log::Error["render-bench"] << "Failed to write screenshot '"
+                                   << screenshot_file << "'";
+        result = EXIT_FAILURE;
+      }
+    }
+    if (!reference_file.empty()) {
+      int different = compare_screenshot(reference_file, pixels);
+      if (different < 0) {
+        Log::Error["render-bench"] << "Screenshot '" << reference_file
+                                   << "' can not be read or has another size";
+        result = EXIT_FAILURE;
+      } else if (different > 0) {
+        Log::Error["render-bench"] << different << " pixels differ from '"
+                                   << reference_file << "'";
+        result = EXIT_FAILURE;
+      } else {
+        Log::Info["render-bench"] << "Same as '" << reference_file << "'";
+      }
+    }
+  }
+
+  delete screen;
+
+  return result;
+}
@@ -0,0 +1,319 @@
+/*
+ * save-convert.cc - Convert and validate save games in bulk
+ *
+ * Copyright (C) 2026  freeserf developers
+ *
+ * This file is part of freeserf.
+ *
+ * freeserf is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * freeserf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with freeserf.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <fstream>
+#include <iostream>
+#include <istream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "src/command_line.h"
+#include "src/log.h"
+#include "src/version.h"
+#include "src/game.h"
+#include "src/mapped-file.h"
+#include "src/savegame.h"
+#include "src/savegame-compress.h"
+#include "src/thread-pool.h"
+
+typedef struct ConvertResult {
+  std::string path;
+  std::string output_path;
+  std::string format;
+  size_t size;
+  double load_time;
+  size_t output_size;
+  double write_time;
+  double reload_time;
+  std::string error;
+} ConvertResult;
+
+static const char *
+format_name(GameStore::Format format) {
+  switch (format) {
+    case GameStore::FormatText: return "text";
+    case GameStore::FormatNative: return "native";
+    case GameStore::FormatLegacy: return "legacy";
+  }
+  return "unknown";
+}
+
+/* Milliseconds since start. */
+static double
+elapsed(std::chrono::steady_clock::time_point start) {
+  std::chrono::duration<double, std::milli> time =
+    std::chrono::steady_clock::now() - start;
+  return time.count();
+}
+
+/* File name of the input without folder and extension. */
+static std::string
+output_name(const std::string &path) {
+  size_t begin = path.find_last_of("\\/");
+  begin = (begin == std::string::npos) ? 0 : begin + 1;
+  size_t end = path.find_last_of('.');
+  if (end == std::string::npos || end < begin) {
+    end = path.length();
+  }
+  return path.substr(begin, end - begin);
+}
+
+/* Load a save, write it in the requested format and check that the result
+   loads to the same game. The output is only written if it is valid. */
+static void
+convert_save(GameStore::Format format, bool compress, ConvertResult *result) {
+  GameStore &store = GameStore::get_instance();
+
+  MappedFile file;
+  if (!file.open(result->path)) {
+    result->error = "unable to open";
+    return;
+  }
+  result->size = file.get_size();
+  if (SaveCompressor::is_compressed(file.get_data(), file.get_size())) {
+    result->format = "compressed";
+  } else {
+    result->format = format_name(GameStore::detect_format(file.get_data(),
+                                                          file.get_size()));
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  std::unique_ptr<Game> game(new Game());
+  if (!store.load(file.get_data(), file.get_size(), game.get())) {
+    result->error = "load failed";
+    return;
+  }
+  result->load_time = elapsed(start);
+
+  std::stringstream reference;
+  if (!store.write(&reference, game.get(), GameStore::FormatText)) {
+    result->error = "unable to write reference";
+    return;
+  }
+
+  start = std::chrono::steady_clock::now();
+  std::stringstream output;
+  if (compress) {
+    SaveCompressor compressor(&output);
+    std::ostream compressed(&compressor);
+    if (!store.write(&compressed, game.get(), format) ||
+        !compressor.finish()) {
+      result->error = "write failed";
+      return;
+    }
+  } else if (!store.write(&output, game.get(), format)) {
+    result->error = "write failed";
+    return;
+  }
+  result->write_time = elapsed(start);
+  std::string data = output.str();
+  result->output_size = data.size();
+  game.reset();
+
+  start = std::chrono::steady_clock::now();
+  std::unique_ptr<Game> copy(new Game());
+  if (!store.load(data.data(), data.size(), copy.get())) {
+    result->error = "reload failed";
+    return;
+  }
+  result->reload_time = elapsed(start);
+
+  std::stringstream round_trip;
+  if (!store.write(&round_trip, copy.get(), GameStore::FormatText) ||
+      round_trip.str() != reference.str()) {
+    result->error = "round trip mismatch";
+    return;
+  }
+
+  if (!result->output_path.empty()) {
+    std::ofstream os(result->output_path.c_str(),
+                     std::ios::binary | std::ios::trunc);
+    if (!os.is_open() || !os.write(data.data(), data.size())) {
+      result->error = "unable to write output";
+      return;
+    }
+  }
+}
+
+static void
+write_results(std::ostream *os, const std::vector<ConvertResult> &results) {
+  *os << "path,format,size,load_ms,output,output_size,write_ms,reload_ms,"
+      << "result\n";
+  for (const ConvertResult &result : results) {
+    *os << result.path << ',' << result.format << ',' << result.size << ','
+        << result.load_time << ',' << result.output_path << ','
+        << result.output_size << ',' << result.write_time << ','
+        << result.reload_time << ','
+        << (result.error.empty() ? "ok" : result.error) << '\n';
+  }
+}
+
+int
+main(int argc, char *argv[]) {
+  std::vector<std::string> paths;
+  std::string output_folder;
+  std::string report_file;
+  GameStore::Format format = GameStore::FormatNative;
+  bool compress = false;
+  unsigned int thread_count = 0;
+
+  CommandLine command_line;
+  command_line.add_option('f', "Format to write: native (default) or text")
+                .add_parameter("FORMAT", [&format](std::istream& s) {
+                  std::string name;
+                  s >> name;
+                  if (name == "native") {
+                    format = GameStore::FormatNative;
+                  } else if (name == "text") {
+                    format = GameStore::FormatText;
+                  } else {
+                    return false;
+                  }
+                  return true;
+                });
+  command_line.add_option('h', "Show this help text", [&command_line](){
+                  command_line.show_help();
+                  exit(EXIT_SUCCESS);
+                });
+  command_line.add_option('i', "Add a save game to convert")
+                .add_parameter("FILE", [&paths](std::istream& s) {
+                  std::string path;
+                  std::getline(s, path);
+                  paths.push_back(path);
+                  return true;
+                });
+  command_line.add_option('j', "Number of saves to convert at once")
+                .add_parameter("THREADS", [&thread_count](std::istream& s) {
+                  s >> thread_count;
+                  return true;
+                });
+  command_line.add_option('l', "Add the save games listed in file, one per "
+                               "line")
+                .add_parameter("FILE", [&paths](std::istream& s) {
+                  std::string list_file;
+                  std::getline(s, list_file);
+                  std::ifstream list(list_file.c_str());
+                  if (!list.is_open()) {
+                    return false;
+                  }
+                  std::string path;
+                  while (std::getline(list, path)) {
+                    if (!path.empty()) {
+                      paths.push_back(path);
+                    }
+                  }
+                  return true;
+                });
+  command_line.add_option('o', "Write converted saves to folder, otherwise "
+                               "they are only validated")
+                .add_parameter("FOLDER", [&output_folder](std::istream& s) {
+                  std::getline(s, output_folder);
+                  return true;
+                });
+  command_line.add_option('r', "Write report to file instead of stdout")
+                .add_parameter("FILE", [&report_file](std::istream& s) {
+                  std::getline(s, report_file);
+                  return true;
+                });
+  command_line.add_option('z', "Compress converted saves",
+                          [&compress](){ compress = true; });
+  command_line.set_comment("Please report bugs to <" PACKAGE_BUGREPORT ">");
+  if (!command_line.process(argc, argv) || paths.empty()) {
+    return EXIT_FAILURE;
+  }
+
+  /* Keep the log out of the report. */
+  Log::set_file(&std::cerr);
+  Log::Info["convert"] << "starts " << FREESERF_VERSION;
+
+  if (!output_folder.empty()) {
+    GameStore &store = GameStore::get_instance();
+    if (!store.is_folder_exists(output_folder) &&
+        !store.create_folder(output_folder)) {
+      Log::Error["convert"] << "Unable to create output folder "
+                            << output_folder;
+      return EXIT_FAILURE;
+    }
+  }
+
+  /* Saves of the same name from different folders get a number. */
+  std::vector<ConvertResult> results(paths.size());
+  std::map<std::string, unsigned int> names;
+  for (size_t i = 0; i < paths.size(); i++) {
+    ConvertResult &result = results[i];
+    result.path = paths[i];
+    result.size = 0;
+    result.load_time = 0;
+    result.output_size = 0;
+    result.write_time = 0;
+    result.reload_time = 0;
+    if (!output_folder.empty()) {
+      std::string name = output_name(paths[i]);
+      unsigned int count = ++names[name];
+      if (count > 1) {
+        name += "-" + std::to_string(count);
+      }
+      result.output_path = output_folder + "/" + name + ".save";
+    }
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  {
+    ThreadPool pool(thread_count);
+    Log::Info["convert"] << "Converting " << paths.size() << " saves on "
+                         << pool.get_thread_count() << " threads";
+    for (ConvertResult &result : results) {
+      ConvertResult *r = &result;
+      pool.run([format, compress, r]() {
+        convert_save(format, compress, r);
+        if (!r->error.empty()) {
+          Log::Warn["convert"] << r->path << ": " << r->error;
+        }
+      });
+    }
+    pool.wait();
+  }
+
+  size_t failures = 0;
+  for (const ConvertResult &result : results) {
+    if (!result.error.empty()) failures++;
+  }
+  Log::Info["convert"] << "Converted " << (results.size() - failures)
+                       << " of " << results.size() << " saves in "
+                       << elapsed(start) << " ms";
+
+  if (report_file.empty()) {
+    write_results(&std::cout, results);
+  } else {
+    std::ofstream file(report_file);
+    if (!file.is_open()) {
+      Log::Error["convert"] << "Unable to open " << report_file;
+      return EXIT_FAILURE;
+    }
+    write_results(&file, results);
+  }
+
+  return (failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,99 @@
+/*
+ * savegame-compress-zlib.cc - Compression of save games using zlib
+ *
+ * Copyright (C) 2026  freeserf developers
+ *
+ * This file is part of freeserf.
+ *
+ * freeserf is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * freeserf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with freeserf.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/savegame-compress-zlib.h"
+
+#include <cstring>
+
+#include "src/debug.h"
+
+SaveCodecZlib::SaveCodecZlib()
+  : started(false)
+  , chunk(0x10000) {
+  memset(&stream, 0, sizeof(stream));
+}
+
+SaveCodecZlib::~SaveCodecZlib() {
+  if (started) {
+    deflateEnd(&stream);
+  }
+}
+
+void
+SaveCodecZlib::deflate_input(int flush, std::ostream *os) {
+  if (!started) {
+    if (deflateInit(&stream, Z_DEFAULT_COMPRESSION) != Z_OK) {
+      throw ExceptionFreeserf("Failed to initialize zlib.");
+    }
+    started = true;
+  }
+
+  int result;
+  do {
+    stream.next_out = reinterpret_cast<Bytef*>(chunk.data());
+    stream.avail_out = static_cast<uInt>(chunk.size());
+    result = deflate(&stream, flush);
+    if (result == Z_STREAM_ERROR) {
+      throw ExceptionFreeserf("Failed to compress save game.");
+    }
+    os->write(chunk.data(), chunk.size() - stream.avail_out);
+  } while (stream.avail_out == 0 ||
+           (flush == Z_FINISH && result != Z_STREAM_END));
+}
+
+void
+SaveCodecZlib::encode(const char *data, size_t size, std::ostream *os) {
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+  stream.avail_in = static_cast<uInt>(size);
+  deflate_input(Z_NO_FLUSH, os);
+}
+
+void
+SaveCodecZlib::finish(std::ostream *os) {
+  stream.next_in = nullptr;
+  stream.avail_in = 0;
+  deflate_input(Z_FINISH, os);
+}
+
+void
+SaveCodecZlib::decode(const char *data, size_t size, std::string *output) {
+  z_stream in;
+  memset(&in, 0, sizeof(in));
+  if (inflateInit(&in) != Z_OK) {
+    throw ExceptionFreeserf("Failed to initialize zlib.");
+  }
+
+  in.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+  in.avail_in = static_cast<uInt>(size);
+  int result;
+  do {
+    in.next_out = reinterpret_cast<Bytef*>(chunk.data());
+    in.avail_out = static_cast<uInt>(chunk.size());
+    result = inflate(&in, Z_NO_FLUSH);
+    if (result != Z_OK && result != Z_STREAM_END) {
+      inflateEnd(&in);
+      throw ExceptionFreeserf("Compressed save game is corrupt.");
+    }
+    output->append(chunk.data(), chunk.size() - in.avail_out);
+  } while (result != Z_STREAM_END);
+
+  inflateEnd(&in);
+}
@@ -0,0 +1,51 @@
+/*
+ * savegame-compress-zlib.h - Compression of save games using zlib
+ *
+ * Copyright (C) 2026  freeserf developers
+ *
+ * This file is part of freeserf.
+ *
+ * freeserf is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * freeserf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with freeserf.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SRC_SAVEGAME_COMPRESS_ZLIB_H_
+#define SRC_SAVEGAME_COMPRESS_ZLIB_H_
+
+#include <zlib.h>
+
+#include <string>
+#include <vector>
+
+#include "src/savegame-compress.h"
+
+// Payload is a single zlib stream.
+class SaveCodecZlib : public SaveCodec {
+ protected:
+  z_stream stream;
+  bool started;
+  std::vector<char> chunk;
+
+ public:
+  SaveCodecZlib();
+  virtual ~SaveCodecZlib();
+
+  virtual void encode(const char *data, size_t size, std::ostream *os);
+  virtual void finish(std::ostream *os);
+  virtual void decode(const char *data, size_t size, std::string *output);
+
+ protected:
+  void deflate_input(int flush, std::ostream *os);
+};
+
+#endif  // SRC_SAVEGAME_COMPRESS_ZLIB_H_
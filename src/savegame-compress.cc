@@ -0,0 +1,371 @@
+/*
+ * savegame-compress.cc - Compression of save games
+ *
+ * Copyright (C) 2026  freeserf developers
+ *
+ * This file is part of freeserf.
+ *
+ * freeserf is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * freeserf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with freeserf.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/savegame-compress.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "src/debug.h"
+#ifdef ENABLE_ZLIB
+#include "src/savegame-compress-zlib.h"
+#endif
+
+static const char compress_magic[8] = {
+  'F', 'S', 'E', 'R', 'F', 'C', 'M', 'P'
+};
+
+#define COMPRESS_HEADER_SIZE  16
+#define COMPRESS_BLOCK_SIZE  0x10000
+
+static void
+write_u32(std::ostream *os, uint32_t val) {
+  char bytes[4] = {
+    static_cast<char>(val & 0xff), static_cast<char>((val >> 8) & 0xff),
+    static_cast<char>((val >> 16) & 0xff), static_cast<char>(val >> 24)
+  };
+  os->write(bytes, sizeof(bytes));
+}
+
+static uint32_t
+read_u32(const uint8_t *data) {
+  return static_cast<uint32_t>(data[0]) |
+         (static_cast<uint32_t>(data[1]) << 8) |
+         (static_cast<uint32_t>(data[2]) << 16) |
+         (static_cast<uint32_t>(data[3]) << 24);
+}
+
+// Byte oriented LZ77 in the style of LZ4. The payload is a series of
+// blocks of at most 64 KiB of input, each starting with its uncompressed
+// size and its compressed size (bit 31 set if the block is stored as is);
+// an uncompressed size of zero ends the stream.
+//
+// A compressed block is a list of sequences: a token byte with the number
+// of literals in the high and the match length minus four in the low four
+// bits (15 meaning more follows in bytes, 255 continuing), the literals, a
+// 16-bit match offset and the rest of the match length. The last sequence
+// of a block has no match.
+class SaveCodecLZ : public SaveCodec {
+ protected:
+  static const unsigned int hash_bits = 14;
+  static const size_t min_match = 4;
+
+  std::vector<int> table;
+  std::string packed;
+
+ public:
+  SaveCodecLZ() : table(1 << hash_bits) {}
+
+  virtual void encode(const char *data, size_t size, std::ostream *os) {
+    while (size > 0) {
+      size_t block = std::min(size, static_cast<size_t>(COMPRESS_BLOCK_SIZE));
+      encode_block(reinterpret_cast<const uint8_t*>(data), block);
+
+      write_u32(os, static_cast<uint32_t>(block));
+      if (packed.size() < block) {
+        write_u32(os, static_cast<uint32_t>(packed.size()));
+        os->write(packed.data(), packed.size());
+      } else {
+        write_u32(os, static_cast<uint32_t>(block) | 0x80000000);
+        os->write(data, block);
+      }
+
+      data += block;
+      size -= block;
+    }
+  }
+
+  virtual void finish(std::ostream *os) {
+    write_u32(os, 0);
+  }
+
+  virtual void decode(const char *data, size_t size, std::string *output) {
+    const uint8_t *in = reinterpret_cast<const uint8_t*>(data);
+    const uint8_t *end = in + size;
+    while (true) {
+      if (end - in < 4) {
+        throw ExceptionFreeserf("Compressed save game is truncated.");
+      }
+      uint32_t raw_size = read_u32(in);
+      in += 4;
+      if (raw_size == 0) {
+        break;
+      }
+      if (end - in < 4) {
+        throw ExceptionFreeserf("Compressed save game is truncated.");
+      }
+      uint32_t packed_size = read_u32(in) & 0x7fffffff;
+      bool stored = (read_u32(in) & 0x80000000) != 0;
+      in += 4;
+      if (raw_size > COMPRESS_BLOCK_SIZE ||
+          packed_size > static_cast<size_t>(end - in)) {
+        throw ExceptionFreeserf("Compressed save game is corrupt.");
+      }
+
+      size_t start = output->size();
+      if (stored) {
+        if (packed_size != raw_size) {
+          throw ExceptionFreeserf("Compressed save game is corrupt.");
+        }
+        output->append(reinterpret_cast<const char*>(in), raw_size);
+      } else {
+        output->resize(start + raw_size);
+        decode_block(in, packed_size,
+                     reinterpret_cast<uint8_t*>(&(*output)[start]), raw_size);
+      }
+      in += packed_size;
+    }
+  }
+
+ protected:
+  static uint32_t read_sequence(const uint8_t *data) {
+    uint32_t val;
+    memcpy(&val, data, sizeof(val));
+    return val;
+  }
+
+  void put_length(size_t length) {
+    while (length >= 255) {
+      packed.push_back(static_cast<char>(255));
+      length -= 255;
+    }
+    packed.push_back(static_cast<char>(length));
+  }
+
+  void put_sequence(const uint8_t *literals, size_t literal_count,
+                    size_t offset, size_t match_length) {
+    size_t match_code = (match_length != 0) ? match_length - min_match : 0;
+    size_t max_code = 15;
+    packed.push_back(static_cast<char>(
+                                   (std::min(literal_count, max_code) << 4) |
+                                   std::min(match_code, max_code)));
+    if (literal_count >= 15) put_length(literal_count - 15);
+    packed.append(reinterpret_cast<const char*>(literals), literal_count);
+    if (match_length == 0) return;
+
+    packed.push_back(static_cast<char>(offset & 0xff));
+    packed.push_back(static_cast<char>(offset >> 8));
+    if (match_code >= 15) put_length(match_code - 15);
+  }
+
+  void encode_block(const uint8_t *data, size_t size) {
+    packed.clear();
+    std::fill(table.begin(), table.end(), -1);
+
+    size_t anchor = 0;
+    size_t pos = 0;
+    while (pos + min_match <= size) {
+      uint32_t sequence = read_sequence(data + pos);
+      uint32_t hash = (sequence * 2654435761u) >> (32 - hash_bits);
+      int candidate = table[hash];
+      table[hash] = static_cast<int>(pos);
+
+      size_t offset = pos - static_cast<size_t>(candidate);
+      if (candidate < 0 || offset > 0xffff ||
+          read_sequence(data + candidate) != sequence) {
+        pos++;
+        continue;
+      }
+
+      const uint8_t *match = data + candidate;
+      size_t length = min_match;
+      while (pos + length < size && match[length] == data[pos + length]) {
+        length++;
+      }
+      put_sequence(data + anchor, pos - anchor, offset, length);
+      pos += length;
+      anchor = pos;
+    }
+
+    put_sequence(data + anchor, size - anchor, 0, 0);
+  }
+
+  static size_t get_length(const uint8_t **in, const uint8_t *end,
+                           size_t length) {
+    if (length != 15) return length;
+    while (true) {
+      if (*in == end) {
+        throw ExceptionFreeserf("Compressed save game is corrupt.");
+      }
+      uint8_t val = *(*in)++;
+      length += val;
+      if (val != 255) return length;
+    }
+  }
+
+  static void decode_block(const uint8_t *in, size_t size, uint8_t *out,
+                           size_t out_size) {
+    const uint8_t *end = in + size;
+    size_t pos = 0;
+    while (true) {
+      if (in == end) {
+        throw ExceptionFreeserf("Compressed save game is corrupt.");
+      }
+      uint8_t token = *in++;
+
+      size_t literals = get_length(&in, end, token >> 4);
+      if (literals > static_cast<size_t>(end - in) ||
+          literals > out_size - pos) {
+        throw ExceptionFreeserf("Compressed save game is corrupt.");
+      }
+      memcpy(out + pos, in, literals);
+      in += literals;
+      pos += literals;
+      if (in == end) break;
+
+      if (end - in < 2) {
+        throw ExceptionFreeserf("Compressed save game is corrupt.");
+      }
+      size_t offset = in[0] | (in[1] << 8);
+      in += 2;
+      size_t length = get_length(&in, end, token & 0x0f) + min_match;
+      if (offset == 0 || offset > pos || length > out_size - pos) {
+        throw ExceptionFreeserf("Compressed save game is corrupt.");
+      }
+
+      /* Matches may overlap the output they produce. */
+      for (size_t i = 0; i < length; i++, pos++) {
+        out[pos] = out[pos - offset];
+      }
+    }
+
+    if (pos != out_size) {
+      throw ExceptionFreeserf("Compressed save game is corrupt.");
+    }
+  }
+};
+
+bool
+SaveCodec::is_available(Type type) {
+  switch (type) {
+    case TypeLZ:
+      return true;
+    case TypeZlib:
+#ifdef ENABLE_ZLIB
+      return true;
+#else
+      return false;
+#endif
+  }
+  return false;
+}
+
+SaveCodec::Type
+SaveCodec::get_default() {
+  return is_available(TypeZlib) ? TypeZlib : TypeLZ;
+}
+
+std::unique_ptr<SaveCodec>
+SaveCodec::create(Type type) {
+  switch (type) {
+    case TypeLZ:
+      return std::unique_ptr<SaveCodec>(new SaveCodecLZ());
+#ifdef ENABLE_ZLIB
+    case TypeZlib:
+      return std::unique_ptr<SaveCodec>(new SaveCodecZlib());
+#endif
+    default:
+      break;
+  }
+  return std::unique_ptr<SaveCodec>();
+}
+
+SaveCompressor::SaveCompressor(std::ostream *_os, SaveCodec::Type type)
+  : os(_os)
+  , codec(SaveCodec::create(type))
+  , buffer(COMPRESS_BLOCK_SIZE)
+  , finished(false) {
+  if (!codec) {
+    throw ExceptionFreeserf("Save game compression is not available.");
+  }
+
+  os->write(compress_magic, sizeof(compress_magic));
+  write_u32(os, type);
+  write_u32(os, 0);
+  setp(buffer.data(), buffer.data() + buffer.size());
+}
+
+SaveCompressor::~SaveCompressor() {
+  finish();
+}
+
+bool
+SaveCompressor::finish() {
+  if (!finished) {
+    finished = true;
+    flush_buffer();
+    codec->finish(os);
+    os->flush();
+  }
+  return os->good();
+}
+
+void
+SaveCompressor::flush_buffer() {
+  if (pptr() != pbase()) {
+    codec->encode(pbase(), pptr() - pbase(), os);
+  }
+  setp(buffer.data(), buffer.data() + buffer.size());
+}
+
+SaveCompressor::int_type
+SaveCompressor::overflow(int_type c) {
+  if (finished) {
+    return traits_type::eof();
+  }
+
+  flush_buffer();
+  if (!traits_type::eq_int_type(c, traits_type::eof())) {
+    *pptr() = traits_type::to_char_type(c);
+    pbump(1);
+  }
+  return os->good() ? traits_type::not_eof(c) : traits_type::eof();
+}
+
+int
+SaveCompressor::sync() {
+  /* Full blocks compress better, data is only passed on when finishing. */
+  return os->good() ? 0 : -1;
+}
+
+bool
+SaveCompressor::is_compressed(const void *data, size_t size) {
+  return (size >= COMPRESS_HEADER_SIZE) &&
+         (memcmp(data, compress_magic, sizeof(compress_magic)) == 0);
+}
+
+void
+SaveCompressor::decompress(const void *data, size_t size,
+                           std::string *output) {
+  if (!is_compressed(data, size)) {
+    throw ExceptionFreeserf("Not a compressed save game.");
+  }
+
+  const uint8_t *bytes = reinterpret_cast<const uint8_t*>(data);
+  SaveCodec::Type type = static_cast<SaveCodec::Type>(read_u32(bytes + 8));
+  std::unique_ptr<SaveCodec> codec = SaveCodec::create(type);
+  if (!codec) {
+    throw ExceptionFreeserf("Unsupported save game compression.");
+  }
+
+  codec->decode(reinterpret_cast<const char*>(bytes) + COMPRESS_HEADER_SIZE,
+                size - COMPRESS_HEADER_SIZE, output);
+}
@@ -0,0 +1,91 @@
+/*
+ * savegame-compress.h - Compression of save games
+ *
+ * Copyright (C) 2026  freeserf developers
+ *
+ * This file is part of freeserf.
+ *
+ * freeserf is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * freeserf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with freeserf.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SRC_SAVEGAME_COMPRESS_H_
+#define SRC_SAVEGAME_COMPRESS_H_
+
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+// A compressed save game is a save of any format wrapped in a container:
+//
+//   header   magic "FSERFCMP", codec and a reserved word (u32 each,
+//            little-endian)
+//   payload  the save compressed by the codec
+//
+// The built-in LZ codec is always available. zlib is used instead when it
+// was found at configure time.
+class SaveCodec {
+ public:
+  typedef enum Type {
+    TypeLZ = 1,
+    TypeZlib = 2
+  } Type;
+
+  virtual ~SaveCodec() = default;
+
+  /* Compress the next part of the stream, writing output to os. */
+  virtual void encode(const char *data, size_t size, std::ostream *os) = 0;
+  /* Write whatever is left of the stream. */
+  virtual void finish(std::ostream *os) = 0;
+  /* Decompress a whole payload, appending to output. Throws
+     ExceptionFreeserf if the data is corrupt. */
+  virtual void decode(const char *data, size_t size, std::string *output) = 0;
+
+  static bool is_available(Type type);
+  static Type get_default();
+  static std::unique_ptr<SaveCodec> create(Type type);
+};
+
+// Stream buffer compressing everything written through it to another
+// stream. Only one block of uncompressed data is buffered at a time.
+class SaveCompressor : public std::streambuf {
+ protected:
+  std::ostream *os;
+  std::unique_ptr<SaveCodec> codec;
+  std::vector<char> buffer;
+  bool finished;
+
+ public:
+  explicit SaveCompressor(std::ostream *os,
+                          SaveCodec::Type type = SaveCodec::get_default());
+  virtual ~SaveCompressor();
+
+  /* Compress the data still buffered and end the stream. */
+  bool finish();
+
+  static bool is_compressed(const void *data, size_t size);
+  /* Decompress a save written through a compressor. Throws
+     ExceptionFreeserf if the data is corrupt or the codec unavailable. */
+  static void decompress(const void *data, size_t size, std::string *output);
+
+ protected:
+  virtual int_type overflow(int_type c);
+  virtual int sync();
+
+  void flush_buffer();
+};
+
+#endif  // SRC_SAVEGAME_COMPRESS_H_
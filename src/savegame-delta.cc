@@ -0,0 +1,262 @@
+/*
+ * savegame-delta.cc - Incremental save games
+ *
+ * Copyright (C) 2026  freeserf developers
+ *
+ * This file is part of freeserf.
+ *
+ * freeserf is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * freeserf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with freeserf.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/savegame-delta.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "src/game.h"
+#include "src/log.h"
+#include "src/savegame-compress.h"
+
+// Native writer skipping the map blocks unchanged since a full save.
+class SaveWriterDelta : public SaveWriterNative {
+ protected:
+  const Map *map;
+  uint64_t since;
+
+ public:
+  SaveWriterDelta(const Map *_map, uint64_t _since)
+    : map(_map)
+    , since(_since) {
+  }
+
+  virtual bool wants_section(const std::string &name, unsigned int number) {
+    return (name != "map") || map->is_block_changed(number, since);
+  }
+};
+
+/* Write data to a new file that is then renamed over path, so path is
+   never left half written. */
+static bool
+replace_file(const std::string &path, const std::string &data) {
+  std::string temp_path = path + ".tmp";
+  {
+    std::ofstream os(temp_path.c_str(), std::ios::binary | std::ios::trunc);
+    if (!os.is_open()) {
+      Log::Error["savegame"] << "Unable to open save game file: '"
+                             << temp_path << "'";
+      return false;
+    }
+    os.write(data.data(), data.size());
+    os.close();
+    if (os.fail()) {
+      Log::Error["savegame"] << "Unable to write save game file: '"
+                             << temp_path << "'";
+      std::remove(temp_path.c_str());
+      return false;
+    }
+  }
+
+#ifdef _WIN32
+  /* Renaming does not replace files there. */
+  std::remove(path.c_str());
+#endif  // _WIN32
+  if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+    Log::Error["savegame"] << "Unable to replace save game file: '"
+                           << path << "'";
+    std::remove(temp_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+SaveCheckpoint::SaveCheckpoint(const std::string &_path,
+                               unsigned int _compact_interval)
+  : path(_path)
+  , compact_interval(_compact_interval)
+  , delta_count(0)
+  , has_base(false)
+  , base_change_count(0)
+  , base_size(0)
+  , base_checksum(0)
+  , last_delta_size(0) {
+}
+
+std::string
+SaveCheckpoint::get_latest_path() const {
+  return (delta_count > 0) ? get_delta_path() : path;
+}
+
+bool
+SaveCheckpoint::save(Game *game, bool compress) {
+  bool full = !has_base || (delta_count >= compact_interval) ||
+              (last_delta_size > base_size / 2);
+
+  const Map *map = game->get_map().get();
+  SaveWriterDelta writer(map, full ? 0 : base_change_count);
+  writer << *game;
+  SaveWriterNative::Fingerprints fingerprints = writer.get_fingerprints();
+
+  if (!full) {
+    writer.drop_unchanged(base_fingerprints);
+
+    unsigned int index = 0;
+    for (const auto &base : base_fingerprints) {
+      if (fingerprints.find(base.first) != fingerprints.end()) continue;
+
+      /* Unchanged map blocks were not written at all. */
+      size_t pos = base.first.find(' ');
+      std::string name = base.first.substr(0, pos);
+      if (name == "map") continue;
+
+      SaveWriterText &removed = writer.add_section("removed", index++);
+      removed.value("section") << name;
+      removed.value("number") << atoi(base.first.c_str() + pos + 1);
+    }
+    writer.value("delta.base") << path;
+    writer.value("delta.base_size") << base_size;
+    writer.value("delta.base_checksum") << base_checksum;
+  }
+
+  std::ostringstream os;
+  if (!writer.write(&os)) {
+    return false;
+  }
+  std::string data = os.str();
+  if (compress) {
+    try {
+      std::ostringstream compressed_os;
+      SaveCompressor compressor(&compressed_os);
+      std::ostream compressed(&compressor);
+      compressed.write(data.data(), data.size());
+      if (!compressor.finish()) {
+        return false;
+      }
+      data = compressed_os.str();
+    } catch (ExceptionFreeserf& e) {
+      Log::Error["savegame"] << "Failed to compress save game: "
+                             << e.get_description();
+      return false;
+    }
+  }
+  size_t size = data.size();
+
+  if (full) {
+    /* The delta of the old full save must be gone before it is replaced. */
+    std::remove(get_delta_path().c_str());
+    delta_count = 0;
+    last_delta_size = 0;
+    if (!replace_file(path, data)) {
+      has_base = false;
+      return false;
+    }
+    has_base = true;
+    base_fingerprints.swap(fingerprints);
+    base_change_count = map->get_change_count();
+    base_size = size;
+    base_checksum = SaveWriterNative::checksum(data.data(), data.size());
+  } else {
+    if (!replace_file(get_delta_path(), data)) {
+      return false;
+    }
+    last_delta_size = size;
+    delta_count++;
+  }
+
+  Log::Debug["savegame"] << "Saved " << (full ? "full" : "delta")
+                         << " checkpoint of " << size << " bytes";
+  return true;
+}
+
+SaveReaderDelta::SaveReaderDelta(SaveReaderText *_base,
+                                 SaveReaderText *_delta)
+  : base(_base)
+  , delta(_delta) {
+  for (SaveReaderText *reader : delta->get_sections("removed")) {
+    std::string name;
+    unsigned int number = 0;
+    reader->value("section") >> name;
+    reader->value("number") >> number;
+    removed[name].insert(number);
+  }
+}
+
+bool
+SaveReaderDelta::is_delta(SaveReaderText *reader) {
+  Readers root = reader->get_sections("game");
+  return !root.empty() && root.front()->has_value("delta.base");
+}
+
+std::string
+SaveReaderDelta::get_base_path(SaveReaderText *reader) {
+  std::string path;
+  reader->get_sections("game").front()->value("delta.base") >> path;
+  return path;
+}
+
+void
+SaveReaderDelta::check_base(SaveReaderText *reader, const void *data,
+                            size_t size) {
+  SaveReaderText *root = reader->get_sections("game").front();
+  if (!root->has_value("delta.base_size") ||
+      !root->has_value("delta.base_checksum")) {
+    throw ExceptionFreeserf("Delta save does not identify its base");
+  }
+
+  size_t base_size = 0;
+  unsigned int base_checksum = 0;
+  root->value("delta.base_size") >> base_size;
+  root->value("delta.base_checksum") >> base_checksum;
+  if (size != base_size ||
+      SaveWriterNative::checksum(data, size) != base_checksum) {
+    throw ExceptionFreeserf("Delta save was written for another base save");
+  }
+}
+
+const SaveReaderTextValue &
+SaveReaderDelta::value(const std::string &name) const {
+  throw ExceptionFreeserf("Failed to load value: " + name);
+}
+
+Readers
+SaveReaderDelta::get_sections(const std::string &name) {
+  Readers changed = delta->get_sections(name);
+  if (name == "game") {
+    return changed;
+  }
+
+  std::set<unsigned int> replaced;
+  for (SaveReaderText *reader : changed) {
+    replaced.insert(reader->get_number());
+  }
+
+  const std::set<unsigned int> &gone = removed[name];
+  Readers result;
+  for (SaveReaderText *reader : base->get_sections(name)) {
+    unsigned int number = reader->get_number();
+    if (replaced.find(number) == replaced.end() &&
+        gone.find(number) == gone.end()) {
+      result.push_back(reader);
+    }
+  }
+  result.splice(result.end(), changed);
+
+  /* Sections are loaded in the order a full save stores them in. */
+  result.sort([](SaveReaderText *a, SaveReaderText *b) {
+    return std::to_string(a->get_number()) < std::to_string(b->get_number());
+  });
+  return result;
+}
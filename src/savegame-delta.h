@@ -0,0 +1,106 @@
+/*
+ * savegame-delta.h - Incremental save games
+ *
+ * Copyright (C) 2026  freeserf developers
+ *
+ * This file is part of freeserf.
+ *
+ * freeserf is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * freeserf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with freeserf.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SRC_SAVEGAME_DELTA_H_
+#define SRC_SAVEGAME_DELTA_H_
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+
+#include "src/savegame.h"
+#include "src/savegame-native.h"
+
+class Game;
+
+// Checkpoints of a running game, written as a full save followed by delta
+// saves holding only the sections that changed since that full save.
+//
+// A delta is a native save whose root section names the full save it
+// applies to ("delta.base") with the size and checksum of that file, and
+// that has one "removed" section for each section of the full save that no
+// longer exists. Map blocks are only serialized when the map reports
+// changes since the full save; all other sections are compared to the full
+// save by fingerprint, as objects change through too many paths to track.
+// Every delta is relative to the full save, so loading never needs more
+// than two files.
+//
+// Files are replaced by renaming a new file over them, and the delta is
+// removed before a new full save replaces the old one, so a crash leaves
+// a delta that applies to the full save, or none.
+//
+// After compact_interval deltas, or when the last delta grew to half the
+// size of the full save, the next checkpoint is a new full save.
+class SaveCheckpoint {
+ protected:
+  std::string path;
+  unsigned int compact_interval;
+  unsigned int delta_count;
+  bool has_base;
+  uint64_t base_change_count;
+  size_t base_size;
+  uint32_t base_checksum;
+  size_t last_delta_size;
+  SaveWriterNative::Fingerprints base_fingerprints;
+
+ public:
+  explicit SaveCheckpoint(const std::string &path,
+                          unsigned int compact_interval = 16);
+
+  /* Write a checkpoint of game, compressed if compress is set (see
+     SaveCompressor). All checkpoints must be of the same game, or of forks
+     of it taken in order. */
+  bool save(Game *game, bool compress = false);
+
+  /* The full save, and the delta applying to it. */
+  const std::string &get_path() const { return path; }
+  std::string get_delta_path() const { return path + ".delta"; }
+  /* File to load the latest checkpoint from. */
+  std::string get_latest_path() const;
+  unsigned int get_delta_count() const { return delta_count; }
+};
+
+// Presents a delta save applied to its full save as a single save.
+class SaveReaderDelta : public SaveReaderText {
+ protected:
+  SaveReaderText *base;
+  SaveReaderText *delta;
+  std::map<std::string, std::set<unsigned int>> removed;
+
+ public:
+  SaveReaderDelta(SaveReaderText *base, SaveReaderText *delta);
+
+  static bool is_delta(SaveReaderText *reader);
+  static std::string get_base_path(SaveReaderText *reader);
+  /* Throws ExceptionFreeserf unless data is the full save the delta was
+     written for. */
+  static void check_base(SaveReaderText *reader, const void *data,
+                         size_t size);
+
+  virtual std::string get_name() const { return std::string(); }
+  virtual unsigned int get_number() const { return 0; }
+  virtual const SaveReaderTextValue &value(const std::string &name) const;
+  virtual Readers get_sections(const std::string &name);
+  virtual bool has_value(const std::string & /*name*/) { return false; }
+};
+
+#endif  // SRC_SAVEGAME_DELTA_H_
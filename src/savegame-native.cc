@@ -0,0 +1,642 @@
+/*
+ * savegame-native.cc - Binary save game format
+ *
+ * Copyright (C) 2026  freeserf developers
+ *
+ * This file is part of freeserf.
+ *
+ * freeserf is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * freeserf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with freeserf.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/savegame-native.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <set>
+#include <utility>
+
+#include "src/debug.h"
+#include "src/thread-pool.h"
+
+static const char native_magic[8] = { 'F', 'S', 'E', 'R', 'F', 'S', 'A', 'V' };
+
+#define NATIVE_HEADER_SIZE  24
+#define NATIVE_ENTRY_SIZE  32
+#define NATIVE_NAME_SIZE  16
+
+/* Column type flags, combined with the element width. */
+#define NATIVE_COLUMN_SIGNED  0x100
+#define NATIVE_COLUMN_TEXT  0x200
+/* Every present record has exactly one element, ranges are omitted. */
+#define NATIVE_COLUMN_SCALAR  0x400
+
+/* CRC-32 as used by zlib and PNG. */
+static uint32_t
+crc32(const uint8_t *data, size_t size) {
+  static const struct Table {
+    uint32_t entries[256];
+    Table() {
+      for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++) {
+          c = (c & 1) ? (0xedb88320 ^ (c >> 1)) : (c >> 1);
+        }
+        entries[i] = c;
+      }
+    }
+  } table;
+
+  uint32_t crc = 0xffffffff;
+  for (size_t i = 0; i < size; i++) {
+    crc = table.entries[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+  }
+  return crc ^ 0xffffffff;
+}
+
+static std::string
+lowercase(const std::string &str) {
+  std::string result = str;
+  std::transform(result.begin(), result.end(), result.begin(), ::tolower);
+  return result;
+}
+
+// Little-endian output buffer.
+class NativeOutput {
+ public:
+  std::string data;
+
+  void u32(uint32_t val) {
+    uint8_t bytes[4] = { static_cast<uint8_t>(val),
+                         static_cast<uint8_t>(val >> 8),
+                         static_cast<uint8_t>(val >> 16),
+                         static_cast<uint8_t>(val >> 24) };
+    data.append(reinterpret_cast<char*>(bytes), 4);
+  }
+
+  void element(int64_t val, unsigned int width) {
+    for (unsigned int i = 0; i < width; i++) {
+      data += static_cast<char>((val >> (8 * i)) & 0xff);
+    }
+  }
+
+  void bytes(const void *buf, size_t size) {
+    data.append(reinterpret_cast<const char*>(buf), size);
+  }
+
+  void align() {
+    while ((data.size() % 4) != 0) {
+      data += '\0';
+    }
+  }
+};
+
+// Bounds checked little-endian input.
+class NativeInput {
+ protected:
+  const uint8_t *data;
+  size_t size;
+  size_t pos;
+
+ public:
+  NativeInput(const uint8_t *_data, size_t _size)
+    : data(_data), size(_size), pos(0) {}
+
+  const uint8_t *bytes(size_t count) {
+    if (count > size - pos) {
+      throw ExceptionFreeserf("Invalid read past end of native save.");
+    }
+    const uint8_t *result = data + pos;
+    pos += count;
+    return result;
+  }
+
+  uint32_t u32() {
+    const uint8_t *b = bytes(4);
+    return b[0] | (b[1] << 8) | (b[2] << 16) |
+           (static_cast<uint32_t>(b[3]) << 24);
+  }
+
+  void align() {
+    bytes((4 - (pos % 4)) % 4);
+  }
+};
+
+static int64_t
+read_element(const uint8_t *data, unsigned int type) {
+  unsigned int width = type & 0xff;
+  uint32_t val = 0;
+  for (unsigned int i = 0; i < width; i++) {
+    val |= static_cast<uint32_t>(data[i]) << (8 * i);
+  }
+
+  if ((type & NATIVE_COLUMN_SIGNED) == 0) {
+    return val;
+  }
+
+  switch (width) {
+    case 1: return static_cast<int8_t>(val);
+    case 2: return static_cast<int16_t>(val);
+    default: return static_cast<int32_t>(val);
+  }
+}
+
+// Values of one section of the text format.
+class SaveWriterNative::Record : public SaveWriterText {
+ public:
+  /* Sorted by name. A vector, as a map would allocate a node for each
+     value of each section. */
+  typedef std::vector<std::pair<std::string, SaveWriterTextValue>> Values;
+
+  SaveWriterNative *writer;
+  std::string name;
+  unsigned int number;
+  Values values;
+
+  Record(SaveWriterNative *_writer, const std::string &_name,
+         unsigned int _number)
+    : writer(_writer)
+    , name(_name)
+    , number(_number) {
+  }
+
+  virtual SaveWriterTextValue &value(const std::string &val_name) {
+    std::string key = lowercase(val_name);
+    Values::iterator it = std::lower_bound(values.begin(), values.end(), key,
+                                           is_before);
+    if (it == values.end() || it->first != key) {
+      it = values.insert(it, std::make_pair(key, SaveWriterTextValue()));
+    }
+    return it->second;
+  }
+
+  /* The value of the column, or nullptr if the section has none. */
+  const SaveWriterTextValue *find(const std::string &column) const {
+    Values::const_iterator it = std::lower_bound(values.begin(), values.end(),
+                                                 column, is_before);
+    return (it != values.end() && it->first == column) ? &it->second
+                                                       : nullptr;
+  }
+
+  virtual SaveWriterText &add_section(const std::string &sub_name,
+                                      unsigned int sub_number) {
+    return writer->add_section(sub_name, sub_number);
+  }
+
+  virtual bool wants_section(const std::string &sub_name,
+                             unsigned int sub_number) {
+    return writer->wants_section(sub_name, sub_number);
+  }
+
+  static bool is_before(const Values::value_type &value,
+                        const std::string &key) {
+    return value.first < key;
+  }
+
+  std::string get_key() const {
+    return name + " " + std::to_string(number);
+  }
+
+  /* FNV-1a hash of all names and values. */
+  uint64_t get_fingerprint() const {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    auto add = [&hash](const void *data, size_t size) {
+      const uint8_t *bytes = reinterpret_cast<const uint8_t*>(data);
+      for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+      }
+    };
+
+    for (const auto &value : values) {
+      add(value.first.c_str(), value.first.size() + 1);
+      if (value.second.has_text()) {
+        std::string text = value.second.get_value();
+        add("t", 1);
+        add(text.c_str(), text.size() + 1);
+      } else {
+        const std::vector<int64_t> &numbers = value.second.get_numbers();
+        uint64_t count = numbers.size();
+        add(&count, sizeof(count));
+        add(numbers.data(), numbers.size() * sizeof(int64_t));
+      }
+    }
+    return hash;
+  }
+};
+
+SaveWriterNative::SaveWriterNative() {
+  records.push_back(std::unique_ptr<Record>(new Record(this, "game", 0)));
+  root = records.back().get();
+}
+
+SaveWriterNative::~SaveWriterNative() {
+}
+
+SaveWriterTextValue &
+SaveWriterNative::value(const std::string &name) {
+  return root->value(name);
+}
+
+SaveWriterText &
+SaveWriterNative::add_section(const std::string &name, unsigned int number) {
+  records.push_back(std::unique_ptr<Record>(new Record(this, name, number)));
+  return *records.back();
+}
+
+uint32_t
+SaveWriterNative::checksum(const void *data, size_t size) {
+  return crc32(reinterpret_cast<const uint8_t*>(data), size);
+}
+
+SaveWriterNative::Fingerprints
+SaveWriterNative::get_fingerprints() const {
+  Fingerprints fingerprints;
+  for (const std::unique_ptr<Record> &record : records) {
+    if (record.get() == root) continue;
+    fingerprints[record->get_key()] = record->get_fingerprint();
+  }
+  return fingerprints;
+}
+
+void
+SaveWriterNative::drop_unchanged(const Fingerprints &base) {
+  Records changed;
+  for (std::unique_ptr<Record> &record : records) {
+    if (record.get() != root) {
+      auto it = base.find(record->get_key());
+      if (it != base.end() && it->second == record->get_fingerprint()) {
+        continue;
+      }
+    }
+    changed.push_back(std::move(record));
+  }
+  records.swap(changed);
+}
+
+bool
+SaveWriterNative::write(std::ostream *os) {
+  /* Group the records by name, in order of first appearance. There are
+     only a few names, so they are searched. */
+  std::vector<std::string> names;
+  std::vector<std::vector<Record*>> tables;
+  for (const std::unique_ptr<Record> &record : records) {
+    size_t t = std::find(names.begin(), names.end(), record->name) -
+               names.begin();
+    if (t == names.size()) {
+      names.push_back(record->name);
+      tables.push_back(std::vector<Record*>());
+    }
+    tables[t].push_back(record.get());
+  }
+
+  NativeOutput directory;
+  NativeOutput body;
+  size_t offset = NATIVE_HEADER_SIZE + names.size() * NATIVE_ENTRY_SIZE;
+  for (size_t t = 0; t < names.size(); t++) {
+    const std::string &name = names[t];
+    if (name.size() >= NATIVE_NAME_SIZE) {
+      throw ExceptionFreeserf("Section name too long: " + name);
+    }
+
+    NativeOutput table;
+    table.data = write_table(tables[t]);
+
+    char entry_name[NATIVE_NAME_SIZE] = {0};
+    std::copy(name.begin(), name.end(), entry_name);
+    directory.bytes(entry_name, NATIVE_NAME_SIZE);
+    directory.u32(static_cast<uint32_t>(offset + body.data.size()));
+    directory.u32(static_cast<uint32_t>(table.data.size()));
+    directory.u32(static_cast<uint32_t>(tables[t].size()));
+    directory.u32(crc32(reinterpret_cast<const uint8_t*>(table.data.data()),
+                        table.data.size()));
+    body.bytes(table.data.data(), table.data.size());
+  }
+
+  NativeOutput header;
+  header.bytes(native_magic, sizeof(native_magic));
+  header.u32(SAVE_NATIVE_VERSION);
+  header.u32(static_cast<uint32_t>(names.size()));
+  header.u32(crc32(reinterpret_cast<const uint8_t*>(directory.data.data()),
+                   directory.data.size()));
+  header.u32(0);
+
+  os->write(header.data.data(), header.data.size());
+  os->write(directory.data.data(), directory.data.size());
+  os->write(body.data.data(), body.data.size());
+  return os->good();
+}
+
+std::string
+SaveWriterNative::write_table(const std::vector<Record*> &records) const {
+  NativeOutput out;
+  std::set<std::string> columns;
+  for (Record *record : records) {
+    for (const auto &value : record->values) {
+      columns.insert(value.first);
+    }
+  }
+
+  out.u32(static_cast<uint32_t>(records.size()));
+  out.u32(static_cast<uint32_t>(columns.size()));
+  for (Record *record : records) {
+    out.u32(record->number);
+  }
+
+  std::vector<const SaveWriterTextValue*> values(records.size());
+  for (const std::string &column : columns) {
+    /* Find the narrowest type that fits all values. */
+    bool text = false;
+    bool scalar = true;
+    int64_t min = 0;
+    int64_t max = 0;
+    for (size_t i = 0; i < records.size(); i++) {
+      values[i] = records[i]->find(column);
+      if (values[i] == nullptr) continue;
+      if (values[i]->has_text()) {
+        text = true;
+        continue;
+      }
+      scalar = scalar && (values[i]->get_numbers().size() == 1);
+      for (int64_t n : values[i]->get_numbers()) {
+        min = std::min(min, n);
+        max = std::max(max, n);
+      }
+    }
+
+    unsigned int type = 1;
+    if (text || min < std::numeric_limits<int32_t>::min() ||
+        max > std::numeric_limits<uint32_t>::max() ||
+        (min < 0 && max > std::numeric_limits<int32_t>::max())) {
+      type = 1 | NATIVE_COLUMN_TEXT;
+      text = true;
+    } else if (min < 0) {
+      type = NATIVE_COLUMN_SIGNED;
+      if (min >= -0x80 && max <= 0x7f) {
+        type |= 1;
+      } else if (min >= -0x8000 && max <= 0x7fff) {
+        type |= 2;
+      } else {
+        type |= 4;
+      }
+    } else if (max <= 0xff) {
+      type = 1;
+    } else if (max <= 0xffff) {
+      type = 2;
+    } else {
+      type = 4;
+    }
+    if (!text && scalar) {
+      type |= NATIVE_COLUMN_SCALAR;
+    }
+
+    out.u32(static_cast<uint32_t>(column.size()));
+    out.bytes(column.data(), column.size());
+    out.align();
+    out.u32(type);
+
+    for (const SaveWriterTextValue *value : values) {
+      out.element((value != nullptr) ? 1 : 0, 1);
+    }
+    out.align();
+
+    std::vector<std::string> texts;
+    if ((type & NATIVE_COLUMN_SCALAR) == 0) {
+      uint32_t first = 0;
+      out.u32(first);
+      for (const SaveWriterTextValue *value : values) {
+        if (value != nullptr) {
+          if (text) {
+            texts.push_back(value->get_value());
+            first += static_cast<uint32_t>(texts.back().size());
+          } else {
+            first += static_cast<uint32_t>(value->get_numbers().size());
+          }
+        }
+        out.u32(first);
+      }
+    }
+
+    if (text) {
+      for (const std::string &str : texts) {
+        out.bytes(str.data(), str.size());
+      }
+    } else {
+      for (const SaveWriterTextValue *value : values) {
+        if (value == nullptr) continue;
+        for (int64_t n : value->get_numbers()) {
+          out.element(n, type & 0xff);
+        }
+      }
+    }
+    out.align();
+  }
+
+  return out.data;
+}
+
+// One record of a table.
+class SaveReaderNative::Section : public SaveReaderText {
+ public:
+  typedef std::map<std::string, SaveReaderTextValue> Values;
+
+  std::string name;
+  unsigned int number;
+  Values values;
+
+  Section(const std::string &_name, unsigned int _number)
+    : name(_name)
+    , number(_number) {
+  }
+
+  virtual std::string get_name() const { return name; }
+  virtual unsigned int get_number() const { return number; }
+
+  virtual const SaveReaderTextValue &
+  value(const std::string &val_name) const {
+    Values::const_iterator it = values.find(lowercase(val_name));
+    if (it == values.end()) {
+      throw ExceptionFreeserf("Failed to load value: " + val_name);
+    }
+    return it->second;
+  }
+
+  virtual Readers get_sections(const std::string & /*name*/) {
+    throw ExceptionFreeserf("Recursive sections are not allowed");
+  }
+
+  virtual bool has_value(const std::string &val_name) {
+    return (values.find(lowercase(val_name)) != values.end());
+  }
+};
+
+bool
+SaveReaderNative::is_native(const void *data, size_t size) {
+  return (size >= NATIVE_HEADER_SIZE) &&
+         (memcmp(data, native_magic, sizeof(native_magic)) == 0);
+}
+
+SaveReaderNative::SaveReaderNative(const void *data, size_t size) {
+  if (!is_native(data, size)) {
+    throw ExceptionFreeserf("Not a native save game.");
+  }
+
+  const uint8_t *bytes = reinterpret_cast<const uint8_t*>(data);
+  NativeInput header(bytes, size);
+  header.bytes(sizeof(native_magic));
+  uint32_t version = header.u32();
+  if (version > SAVE_NATIVE_VERSION) {
+    throw ExceptionFreeserf("Unsupported native save version.");
+  }
+  uint32_t section_count = header.u32();
+  uint32_t directory_checksum = header.u32();
+  header.u32();
+
+  /* Checked before multiplying, the count comes from the file. */
+  if (section_count > (size - NATIVE_HEADER_SIZE) / NATIVE_ENTRY_SIZE) {
+    throw ExceptionFreeserf("Native save directory out of bounds.");
+  }
+  size_t directory_size = static_cast<size_t>(section_count) *
+                          NATIVE_ENTRY_SIZE;
+  const uint8_t *directory = header.bytes(directory_size);
+  if (crc32(directory, directory_size) != directory_checksum) {
+    throw ExceptionFreeserf("Native save directory is corrupt.");
+  }
+
+  NativeInput entries(directory, directory_size);
+  for (uint32_t i = 0; i < section_count; i++) {
+    const char *name = reinterpret_cast<const char*>(
+                                             entries.bytes(NATIVE_NAME_SIZE));
+    std::string table_name(name, strnlen(name, NATIVE_NAME_SIZE));
+    uint32_t offset = entries.u32();
+    uint32_t table_size = entries.u32();
+    uint32_t record_count = entries.u32();
+    uint32_t checksum = entries.u32();
+
+    if (offset > size || table_size > size - offset) {
+      throw ExceptionFreeserf("Native save section out of bounds.");
+    }
+    if (crc32(bytes + offset, table_size) != checksum) {
+      throw ExceptionFreeserf("Native save section \"" + table_name +
+                              "\" is corrupt.");
+    }
+
+    tables.push_back(Table());
+    tables.back().name = table_name;
+    tables.back().data = bytes + offset;
+    tables.back().size = table_size;
+    tables.back().record_count = record_count;
+  }
+
+  /* Tables are independent of each other, decode them in parallel. */
+  ThreadPool::get_instance().run_for(tables.size(), [this](size_t i) {
+    read_table(&tables[i]);
+  });
+}
+
+SaveReaderNative::~SaveReaderNative() {
+}
+
+void
+SaveReaderNative::read_table(Table *table) {
+  const std::string &name = table->name;
+  size_t size = table->size;
+  unsigned int record_count = table->record_count;
+  NativeInput in(table->data, size);
+  if (in.u32() != record_count) {
+    throw ExceptionFreeserf("Native save section \"" + name +
+                            "\" is inconsistent.");
+  }
+  uint32_t column_count = in.u32();
+
+  /* Each record is at least its number in size. */
+  if (record_count > size / 4) {
+    throw ExceptionFreeserf("Native save section out of bounds.");
+  }
+
+  Sections &sections = table->sections;
+  for (uint32_t i = 0; i < record_count; i++) {
+    sections.push_back(std::unique_ptr<Section>(new Section(name, in.u32())));
+    table->readers.push_back(sections.back().get());
+  }
+
+  std::vector<int64_t> numbers;
+  for (uint32_t c = 0; c < column_count; c++) {
+    uint32_t name_size = in.u32();
+    const char *column_name = reinterpret_cast<const char*>(
+                                                         in.bytes(name_size));
+    std::string column(column_name, name_size);
+    in.align();
+    uint32_t type = in.u32();
+    unsigned int width = type & 0xff;
+    if (width != 1 && width != 2 && width != 4) {
+      throw ExceptionFreeserf("Invalid native save column type.");
+    }
+
+    const uint8_t *present = in.bytes(record_count);
+    in.align();
+    std::vector<uint32_t> first(record_count + 1);
+    if ((type & NATIVE_COLUMN_SCALAR) != 0) {
+      for (uint32_t i = 0; i < record_count; i++) {
+        first[i + 1] = first[i] + (present[i] != 0 ? 1 : 0);
+      }
+    } else {
+      for (uint32_t &f : first) {
+        f = in.u32();
+      }
+    }
+    if (first.back() > size / width) {
+      throw ExceptionFreeserf("Native save section out of bounds.");
+    }
+    const uint8_t *elements = in.bytes(static_cast<size_t>(first.back()) *
+                                       width);
+    in.align();
+
+    for (uint32_t i = 0; i < record_count; i++) {
+      if (present[i] == 0) continue;
+      if (first[i] > first[i + 1] || first[i + 1] > first.back()) {
+        throw ExceptionFreeserf("Native save section is inconsistent.");
+      }
+
+      Section *section = sections[i].get();
+      if ((type & NATIVE_COLUMN_TEXT) != 0) {
+        std::string text(reinterpret_cast<const char*>(elements + first[i]),
+                         first[i + 1] - first[i]);
+        section->values.emplace(column, SaveReaderTextValue(text));
+      } else {
+        numbers.clear();
+        for (uint32_t e = first[i]; e < first[i + 1]; e++) {
+          numbers.push_back(read_element(elements + e * width, type));
+        }
+        section->values.emplace(column, SaveReaderTextValue(numbers));
+      }
+    }
+  }
+}
+
+const SaveReaderTextValue &
+SaveReaderNative::value(const std::string &name) const {
+  throw ExceptionFreeserf("Failed to load value: " + name);
+}
+
+Readers
+SaveReaderNative::get_sections(const std::string &name) {
+  Readers readers;
+  for (Table &table : tables) {
+    if (table.name == name) {
+      readers.insert(readers.end(), table.readers.begin(),
+                     table.readers.end());
+    }
+  }
+  return readers;
+}
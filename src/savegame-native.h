@@ -0,0 +1,125 @@
+/*
+ * savegame-native.h - Binary save game format
+ *
+ * Copyright (C) 2026  freeserf developers
+ *
+ * This file is part of freeserf.
+ *
+ * freeserf is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * freeserf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with freeserf.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SRC_SAVEGAME_NATIVE_H_
+#define SRC_SAVEGAME_NATIVE_H_
+
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "src/savegame.h"
+
+/* Current version of the native save format. */
+#define SAVE_NATIVE_VERSION  1
+
+// The native save format stores the same sections and values as the text
+// format, but in binary form:
+//
+//   header     magic "FSERFSAV", version, section count and the checksum
+//              of the section directory (all integers little-endian u32)
+//   directory  one entry per section: name (16 bytes, zero padded),
+//              offset, size, record count and CRC-32 of the section data
+//   sections   one table per section name ("game", "map", "player", "flag",
+//              "building", "inventory", "serf"), with one record for each
+//              section of that name in the text format
+//
+// A table holds the record numbers followed by one column per value name.
+// Each column has a presence flag and an element range per record, and
+// stores the elements with a fixed width of 1, 2 or 4 bytes chosen to fit
+// the values of the column. Columns that contain text store bytes.
+// Everything is aligned to 4 bytes, so tables are decoded straight from a
+// memory mapped file, without reading the file into memory first. Decoding
+// still copies the values of each record into a SaveReaderTextValue, as
+// that is what the readers of the sections hand out.
+class SaveWriterNative : public SaveWriterText {
+ protected:
+  class Record;
+  typedef std::vector<std::unique_ptr<Record>> Records;
+
+  Record *root;
+  Records records;
+
+ public:
+  SaveWriterNative();
+  virtual ~SaveWriterNative();
+
+  virtual SaveWriterTextValue &value(const std::string &name);
+  virtual SaveWriterText &add_section(const std::string &name,
+                                      unsigned int number);
+
+  bool write(std::ostream *os);
+
+  typedef std::map<std::string, uint64_t> Fingerprints;
+
+  /* Hash of the values of each section added so far, by "name number". */
+  Fingerprints get_fingerprints() const;
+  /* Drop the sections that have the same fingerprint in base. */
+  void drop_unchanged(const Fingerprints &base);
+
+  /* CRC-32 of data, the checksum the sections are stored with. */
+  static uint32_t checksum(const void *data, size_t size);
+
+ protected:
+  std::string write_table(const std::vector<Record*> &table) const;
+
+  friend class Record;
+};
+
+class SaveReaderNative : public SaveReaderText {
+ protected:
+  class Section;
+  typedef std::vector<std::unique_ptr<Section>> Sections;
+
+  class Table {
+   public:
+    std::string name;
+    const uint8_t *data;
+    size_t size;
+    unsigned int record_count;
+    Sections sections;
+    Readers readers;
+  };
+
+  std::vector<Table> tables;
+
+ public:
+  /* Parse the save game in data; throws ExceptionFreeserf if the data is
+     not a valid native save. The data must stay valid while loading. */
+  SaveReaderNative(const void *data, size_t size);
+  virtual ~SaveReaderNative();
+
+  static bool is_native(const void *data, size_t size);
+
+  virtual std::string get_name() const { return std::string(); }
+  virtual unsigned int get_number() const { return 0; }
+  virtual const SaveReaderTextValue &value(const std::string &name) const;
+  virtual Readers get_sections(const std::string &name);
+  virtual bool has_value(const std::string & /*name*/) { return false; }
+
+ protected:
+  void read_table(Table *table);
+};
+
+#endif  // SRC_SAVEGAME_NATIVE_H_
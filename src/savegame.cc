@@ -21,6 +21,10 @@
 
 #include "src/savegame.h"
 
+#include <cctype>
+#include <climits>
+#include <cstdio>
+#include <cstring>
 #include <sstream>
 #include <vector>
 #include <map>
@@ -34,7 +38,11 @@
 #include "src/game.h"
 #include "src/log.h"
 #include "src/debug.h"
-#include "src/configfile.h"
+#include "src/mapped-file.h"
+#include "src/savegame-compress.h"
+#include "src/savegame-delta.h"
+#include "src/savegame-native.h"
+#include "src/thread-pool.h"
 
 #ifdef _WIN32
 #include <Windows.h>
@@ -49,104 +57,163 @@
 #include <sys/stat.h>
 #endif
 
-class SaveWriterTextSection : public SaveWriterText {
+// Writes the text format straight to a stream. Sections must be added in
+// the order they appear in the file, sorted by name and then by the text of
+// their number (see SaveTextOrder). Only the values of the current section
+// and of the root section are held in memory.
+class SaveWriterTextStream : public SaveWriterText {
  protected:
-  typedef std::map<std::string, SaveWriterTextValue> Values;
-  typedef std::vector<SaveWriterTextSection*> Sections;
-
- protected:
-  std::string name;
-  unsigned int number;
-  Values values;
-  Sections sections;
-
- public:
-  SaveWriterTextSection(std::string name_, unsigned int number_)
-    : name(name_)
-    , number(number_) {
-  }
+  class Section : public SaveWriterText {
+   protected:
+    typedef std::pair<bool, SaveWriterTextValue> Entry;
+    typedef std::map<std::string, Entry> Values;
+
+    SaveWriterTextStream *writer;
+    std::string key;
+    Values values;
+
+   public:
+    explicit Section(SaveWriterTextStream *_writer) : writer(_writer) {}
+
+    const std::string &get_key() const { return key; }
+
+    /* Start over as another section, keeping the value storage. */
+    void reset(const std::string &_key) {
+      key = _key;
+      for (auto &value : values) {
+        value.second.first = false;
+        value.second.second.clear();
+      }
+    }
 
-  virtual ~SaveWriterTextSection() {
-    for (auto section : sections) {
-      delete section;
+    virtual SaveWriterTextValue &value(const std::string &val_name) {
+      Entry &entry = values[val_name];
+      entry.first = true;
+      return entry.second;
     }
-  }
 
-  virtual SaveWriterTextValue &value(const std::string &val_name) {
-    Values::iterator i = values.find(val_name);
-    if (i != values.end()) {
-      return i->second;
+    virtual SaveWriterText &add_section(const std::string &sub_name,
+                                        unsigned int sub_number) {
+      return writer->add_section(sub_name, sub_number);
     }
 
-    values[val_name] = SaveWriterTextValue();
-    return values[val_name];
-  }
+    void format(std::string *str) const {
+      bool empty = true;
+      for (const auto &value : values) {
+        if (!value.second.first) continue;
+        if (empty) {
+          *str += "[" + key + "]\n";
+          empty = false;
+        }
+        *str += "  ";
+        *str += value.first;
+        *str += " = ";
+        value.second.second.append_value(str);
+        *str += "\n";
+      }
+    }
+  };
 
-  bool save(const std::string &path) {
-    ConfigFile file;
-    save(&file);
-    return file.save(path);
-  }
+  std::ostream *os;
+  Section root;
+  Section current;
+  bool root_written;
+  std::string scratch;
 
-  bool write(std::ostream *os) {
-    ConfigFile file;
-    save(&file);
-    return file.write(os);
+ public:
+  explicit SaveWriterTextStream(std::ostream *_os)
+    : os(_os)
+    , root(this)
+    , current(this)
+    , root_written(false) {
+    root.reset("game 0");
   }
 
-
-  SaveWriterText &add_section(const std::string &sub_name,
-                              unsigned int sub_number) {
-    SaveWriterTextSection *section = new SaveWriterTextSection(sub_name,
-                                                               sub_number);
-    sections.push_back(section);
-    return *section;
+  virtual SaveWriterTextValue &value(const std::string &name) {
+    return root.value(name);
   }
 
- protected:
-  bool save(ConfigFile *file) {
-    std::stringstream str;
-    str << name << " " << number;
+  virtual SaveWriterText &add_section(const std::string &name,
+                                      unsigned int number) {
+    std::string key = name + " " + std::to_string(number);
+    if (!current.get_key().empty() && !(current.get_key() < key)) {
+      throw ExceptionFreeserf("Save sections out of order: " + key);
+    }
 
-    for (auto value : values) {
-      file->set_value(str.str(), value.first, value.second.get_value());
+    write_section(current);
+    if (!root_written && root.get_key() < key) {
+      write_section(root);
+      root_written = true;
     }
 
-    for (SaveWriterTextSection *writer : sections) {
-      writer->save(file);
+    current.reset(key);
+    return current;
+  }
+
+  /* Write the sections still pending. */
+  bool finish() {
+    write_section(current);
+    current.reset(std::string());
+    if (!root_written) {
+      write_section(root);
+      root_written = true;
     }
+    os->flush();
+    return os->good();
+  }
 
-    return true;
+ protected:
+  void write_section(const Section &section) {
+    scratch.clear();
+    section.format(&scratch);
+    os->write(scratch.data(), scratch.size());
   }
 };
 
 typedef std::map<std::string, SaveReaderTextValue> Values;
 
+/* Value names are looked up in lower case. Most names in the code already
+   are, so only copy the ones that need changing. */
+static Values::const_iterator
+find_value(const Values &values, const std::string &name) {
+  for (char c : name) {
+    if (isupper(static_cast<unsigned char>(c))) {
+      std::string v_name = name;
+      std::transform(v_name.begin(), v_name.end(), v_name.begin(), ::tolower);
+      return values.find(v_name);
+    }
+  }
+  return values.find(name);
+}
+
 class SaveReaderTextSection : public SaveReaderText {
  protected:
+  std::string key;
   std::string name;
   int number;
   Values values;
   Readers readers_stub;
 
  public:
-  SaveReaderTextSection(ConfigFile *file, const std::string &_name)
-    : name(_name)
+  explicit SaveReaderTextSection(const std::string &_key)
+    : key(_key)
+    , name(_key)
     , number(0) {
     size_t pos = name.find(' ');
     if (pos != std::string::npos) {
-      std::string value = name.substr(pos + 1, name.length() - pos - 1);
+      number = atoi(name.c_str() + pos + 1);
       name = name.substr(0, pos);
-      std::stringstream ss;
-      ss << value;
-      ss >> number;
     }
+  }
+
+  const std::string &get_key() const { return key; }
 
-    auto vals = file->get_values(_name);
-    for (std::string vname : vals) {
-      values.emplace(std::make_pair(vname,
-                           SaveReaderTextValue(file->value(_name, vname, ""))));
+  void set_value(const std::string &val_name, SaveReaderTextValue &&val) {
+    Values::iterator it = values.find(val_name);
+    if (it != values.end()) {
+      values.erase(it);
     }
+    values.emplace(val_name, std::move(val));
   }
 
   virtual std::string get_name() const {
@@ -159,9 +226,7 @@ class SaveReaderTextSection : public SaveReaderText {
 
   virtual const SaveReaderTextValue &
   value(const std::string &val_name) const {
-    std::string v_name = val_name;
-    std::transform(v_name.begin(), v_name.end(), v_name.begin(), ::tolower);
-    Values::const_iterator it = values.find(v_name);
+    Values::const_iterator it = find_value(values, val_name);
     if (it == values.end()) {
       std::ostringstream str;
       str << "Failed to load value: " << val_name;
@@ -171,53 +236,50 @@ class SaveReaderTextSection : public SaveReaderText {
     return it->second;
   }
 
-  virtual Readers get_sections(const std::string &name) {
+  virtual Readers get_sections(const std::string & /*name*/) {
     throw ExceptionFreeserf("Recursive sections are not allowed");
     return readers_stub;
   }
 
   virtual bool has_value(const std::string &name) {
-    std::string v_name = name;
-    std::transform(v_name.begin(), v_name.end(), v_name.begin(), ::tolower);
-    Values::const_iterator it = values.find(v_name);
-    return (it != values.end());
+    return (find_value(values, name) != values.end());
   }
 };
 
-typedef std::list<SaveReaderTextSection*> ReaderSections;
+typedef std::unique_ptr<SaveReaderTextSection> PReaderSection;
+typedef std::vector<PReaderSection> ReaderSections;
+
+static void
+trim(const char **begin, const char **end) {
+  while (*begin < *end && isspace(static_cast<unsigned char>(**begin))) {
+    (*begin)++;
+  }
+  while (*end > *begin && isspace(static_cast<unsigned char>((*end)[-1]))) {
+    (*end)--;
+  }
+}
 
+static std::string
+lowercase(const char *begin, const char *end) {
+  std::string result(begin, end);
+  std::transform(result.begin(), result.end(), result.begin(), ::tolower);
+  return result;
+}
+
+// Parses the text format in place, without building a ConfigFile first.
+// Names are matched case insensitively and sections are ordered like
+// ConfigFile orders them, so loading behaves exactly as before.
 class SaveReaderTextFile : public SaveReaderText {
  protected:
   ReaderSections sections;
-  Values values;
+  std::map<std::string, Readers> tables;
+  SaveReaderTextSection *main;
 
  public:
-  explicit SaveReaderTextFile(std::istream *is) {
-    ConfigFile file;
-
-    try {
-      file.read(is);
-    } catch (...) {
-      throw ExceptionFreeserf("Wrong config file format.");
-    }
-
-    auto sects = file.get_sections();
-    for (std::string name : sects) {
-      SaveReaderTextSection *section = new SaveReaderTextSection(&file, name);
-      sections.push_back(section);
-    }
-
-    auto vals = file.get_values("main");
-    for (std::string vname : vals) {
-      values.emplace(std::make_pair(vname,
-                           SaveReaderTextValue(file.value("main", vname, ""))));
-    }
-  }
-
-  virtual ~SaveReaderTextFile() {
-    for (auto section : sections) {
-      delete section;
-    }
+  /* The data is only used while constructing. */
+  SaveReaderTextFile(const char *data, size_t size)
+    : main(nullptr) {
+    parse(data, size);
   }
 
   virtual std::string get_name() const {
@@ -230,35 +292,128 @@ class SaveReaderTextFile : public SaveReaderText {
 
   virtual const SaveReaderTextValue &
   value(const std::string &name) const {
-    std::string v_name = name;
-    std::transform(v_name.begin(), v_name.end(), v_name.begin(), ::tolower);
-    Values::const_iterator it = values.find(v_name);
-    if (it == values.end()) {
+    if (main == nullptr) {
       std::ostringstream str;
       str << "Failed to load value: " << name;
       throw ExceptionFreeserf(str.str());
     }
+    return main->value(name);
+  }
 
+  virtual Readers get_sections(const std::string &name) {
+    auto it = tables.find(name);
+    if (it == tables.end()) {
+      return Readers();
+    }
     return it->second;
   }
 
-  virtual Readers get_sections(const std::string &name) {
-    Readers result;
+  virtual bool has_value(const std::string &name) {
+    return (main != nullptr) && main->has_value(name);
+  }
+
+ protected:
+  void parse(const char *data, size_t size) {
+    const char *end = data + size;
+    const char *line = data;
+    size_t line_number = 0;
+    bool sorted = true;
+
+    /* Find the sections first; each one spans the lines up to the next
+       section header. Their values are parsed on the thread pool. */
+    std::vector<std::pair<const char*, const char*>> bodies;
+    while (line < end) {
+      const char *eol = reinterpret_cast<const char*>(
+                                            memchr(line, '\n', end - line));
+      if (eol == nullptr) {
+        eol = end;
+      }
+      const char *begin = line;
+      const char *finish = eol;
+      line = eol + 1;
+      line_number++;
+
+      trim(&begin, &finish);
+      if (begin == finish || *begin != '[') {
+        continue;
+      }
+
+      if (!bodies.empty()) {
+        bodies.back().second = begin;
+      }
+      const char *close = finish;
+      while (close > begin && close[-1] != ']') close--;
+      if (close - begin < 3) {
+        Log::Error["savegame"] << "Failed to parse save game ("
+                               << line_number << ")";
+        end = begin;
+        break;
+      }
+      std::string key = lowercase(begin + 1, close - 1);
+      sorted = sorted && (sections.empty() ||
+                          sections.back()->get_key() < key);
+      sections.push_back(PReaderSection(new SaveReaderTextSection(key)));
+      bodies.push_back(std::make_pair(std::min(line, end), end));
+    }
 
-    for (SaveReaderTextSection *reader : sections) {
-      if (reader->get_name() == name) {
-        result.push_back(reader);
+    ThreadPool::get_instance().run_for(sections.size(),
+                                       [this, &bodies](size_t i) {
+      parse_values(sections[i].get(), bodies[i].first, bodies[i].second);
+    });
+
+    if (!sorted) {
+      /* A later section of the same name replaces an earlier one. */
+      std::stable_sort(sections.begin(), sections.end(),
+                       [](const PReaderSection &a, const PReaderSection &b) {
+        return a->get_key() < b->get_key();
+      });
+      ReaderSections unique;
+      for (size_t i = 0; i < sections.size(); i++) {
+        if (i + 1 == sections.size() ||
+            sections[i]->get_key() != sections[i + 1]->get_key()) {
+          unique.push_back(std::move(sections[i]));
+        }
       }
+      sections.swap(unique);
     }
 
-    return result;
+    for (PReaderSection &reader : sections) {
+      tables[reader->get_name()].push_back(reader.get());
+      if (reader->get_key() == "main") {
+        main = reader.get();
+      }
+    }
   }
 
-  virtual bool has_value(const std::string &name) {
-    std::string v_name = name;
-    std::transform(v_name.begin(), v_name.end(), v_name.begin(), ::tolower);
-    Values::const_iterator it = values.find(v_name);
-    return (it != values.end());
+  static void
+  parse_values(SaveReaderTextSection *section, const char *line,
+               const char *end) {
+    while (line < end) {
+      const char *eol = reinterpret_cast<const char*>(
+                                            memchr(line, '\n', end - line));
+      if (eol == nullptr) {
+        eol = end;
+      }
+      const char *begin = line;
+      const char *finish = eol;
+      line = eol + 1;
+
+      trim(&begin, &finish);
+      if (begin == finish || *begin == ';' || *begin == '#') {
+        continue;
+      }
+
+      const char *eq = reinterpret_cast<const char*>(
+                                           memchr(begin, '=', finish - begin));
+      const char *name_end = (eq != nullptr) ? eq : finish;
+      const char *val_begin = (eq != nullptr) ? eq + 1 : begin;
+      const char *val_end = finish;
+      trim(&begin, &name_end);
+      trim(&val_begin, &val_end);
+
+      section->set_value(lowercase(begin, name_end),
+                         SaveReaderTextValue(val_begin, val_end - val_begin));
+    }
   }
 };
 
@@ -268,8 +423,8 @@ SaveReaderBinary::SaveReaderBinary(const SaveReaderBinary &reader) {
   end = reader.end;
 }
 
-SaveReaderBinary::SaveReaderBinary(void *data, size_t size) {
-  start = current = reinterpret_cast<uint8_t*>(data);
+SaveReaderBinary::SaveReaderBinary(const void *data, size_t size) {
+  start = current = reinterpret_cast<const uint8_t*>(data);
   end = start + size;
 }
 
@@ -284,7 +439,7 @@ SaveReaderBinary::operator >> (uint8_t &val) {
 SaveReaderBinary&
 SaveReaderBinary::operator >> (uint16_t &val) {
   if (!has_data_left(2)) throw ExceptionFreeserf("Invalid read past end.");
-  val = *reinterpret_cast<uint16_t*>(current);
+  val = *reinterpret_cast<const uint16_t*>(current);
   current += 2;
   return *this;
 }
@@ -292,7 +447,7 @@ SaveReaderBinary::operator >> (uint16_t &val) {
 SaveReaderBinary&
 SaveReaderBinary::operator >> (uint32_t &val) {
   if (!has_data_left(4)) throw ExceptionFreeserf("Invalid read past end.");
-  val = *reinterpret_cast<uint32_t*>(current);
+  val = *reinterpret_cast<const uint32_t*>(current);
   current += 4;
   return *this;
 }
@@ -316,89 +471,208 @@ SaveReaderBinary::extract(size_t size) {
   return new_reader;
 }
 
-uint8_t *
+const uint8_t *
 SaveReaderBinary::read(size_t size) {
   if (!has_data_left(size)) throw ExceptionFreeserf("Invalid read past end.");
-  uint8_t *data = current;
+  const uint8_t *data = current;
   current += size;
   return data;
 }
 
+/* Parse an integer that atoi() would read the same way. */
+static bool
+parse_int(const char *begin, const char *end, int64_t *result) {
+  bool negative = false;
+  if (begin != end && (*begin == '-' || *begin == '+')) {
+    negative = (*begin == '-');
+    begin++;
+  }
+  if (begin == end) {
+    return false;
+  }
+
+  int64_t val = 0;
+  for (; begin != end; begin++) {
+    if (*begin < '0' || *begin > '9') {
+      return false;
+    }
+    val = val * 10 + (*begin - '0');
+    if (val > static_cast<int64_t>(INT_MAX) + 1) {
+      return false;
+    }
+  }
+
+  val = negative ? -val : val;
+  if (val > INT_MAX) {
+    return false;
+  }
+  *result = val;
+  return true;
+}
+
 SaveReaderTextValue::SaveReaderTextValue(const std::string &_value)
-  : value(_value) {
-  if (value.find(',') != std::string::npos) {
-    std::istringstream iss(value);
-    std::string item;
-    while (std::getline(iss, item, ',')) {
-      parts.emplace_back(item);
+  : value(_value)
+  , is_number(false)
+  , number(0) {
+  parse();
+}
+
+SaveReaderTextValue::SaveReaderTextValue(const char *data, size_t size)
+  : is_number(false)
+  , number(0) {
+  if (parse_numbers(data, data + size)) {
+    return;
+  }
+
+  value.assign(data, size);
+  std::transform(value.begin(), value.end(), value.begin(), ::tolower);
+  parse();
+}
+
+SaveReaderTextValue::SaveReaderTextValue(int64_t _number)
+  : is_number(true)
+  , number(_number) {
+}
+
+SaveReaderTextValue::SaveReaderTextValue(const std::vector<int64_t> &_numbers)
+  : is_number(true)
+  , number(_numbers.empty() ? 0 : _numbers.front()) {
+  /* Like text values, only lists of more than one value have elements. */
+  if (_numbers.size() > 1) {
+    numbers = _numbers;
+  }
+}
+
+/* Parse a value that is an integer or a list of integers, in place. Other
+   values are left alone. */
+bool
+SaveReaderTextValue::parse_numbers(const char *begin, const char *end) {
+  const char *comma = std::find(begin, end, ',');
+  if (comma == end) {
+    is_number = parse_int(begin, end, &number);
+    return is_number;
+  }
+
+  /* Split like getline() would, dropping an empty last element. */
+  while (begin < end) {
+    comma = std::find(begin, end, ',');
+    int64_t val = 0;
+    if (!parse_int(begin, comma, &val)) {
+      numbers.clear();
+      return false;
+    }
+    numbers.push_back(val);
+    begin = comma + 1;
+  }
+  number = numbers.front();
+  is_number = true;
+  return true;
+}
+
+void
+SaveReaderTextValue::parse() {
+  number = atoi(value.c_str());
+
+  if (value.find(',') == std::string::npos) {
+    return;
+  }
+
+  /* Split like getline() would, dropping an empty last element. */
+  const char *begin = value.data();
+  const char *end = begin + value.size();
+  bool numeric = true;
+  while (begin < end) {
+    const char *comma = std::find(begin, end, ',');
+    int64_t val = 0;
+    if (numeric && parse_int(begin, comma, &val)) {
+      numbers.push_back(val);
+    } else {
+      numeric = false;
+    }
+    begin = comma + 1;
+  }
+
+  if (!numeric) {
+    /* Keep elements that are not plain integers as text. */
+    numbers.clear();
+    begin = value.data();
+    while (begin < end) {
+      const char *comma = std::find(begin, end, ',');
+      parts.emplace_back(std::string(begin, comma));
+      begin = comma + 1;
     }
   }
 }
 
 const SaveReaderTextValue&
 SaveReaderTextValue::operator >> (int &val) const {
-  int result = atoi(value.c_str());
-  val = result;
+  val = static_cast<int>(get_number());
 
   return *this;
 }
 
 const SaveReaderTextValue&
 SaveReaderTextValue::operator >> (unsigned int &val) const {
-  int result = atoi(value.c_str());
-  val = result;
+  val = static_cast<unsigned int>(get_number());
 
   return *this;
 }
 
 const SaveReaderTextValue&
 SaveReaderTextValue::operator >> (Direction &val) const {
-  int result = atoi(value.c_str());
-  val = (Direction)result;
+  val = (Direction)get_number();
 
   return *this;
 }
 
 const SaveReaderTextValue&
 SaveReaderTextValue::operator >> (Resource::Type &val) const {
-  int result = atoi(value.c_str());
-  val = (Resource::Type)result;
+  val = (Resource::Type)get_number();
 
   return *this;
 }
 
 const SaveReaderTextValue&
 SaveReaderTextValue::operator >> (Building::Type &val) const {
-  int result = atoi(value.c_str());
-  val = (Building::Type)result;
+  val = (Building::Type)get_number();
 
   return *this;
 }
 
 const SaveReaderTextValue&
 SaveReaderTextValue::operator >> (Serf::State &val) const {
-  int result = atoi(value.c_str());
-  val = (Serf::State)result;
+  val = (Serf::State)get_number();
 
   return *this;
 }
 
 const SaveReaderTextValue&
 SaveReaderTextValue::operator >> (uint16_t &val) const {
-  int result = atoi(value.c_str());
-  val = (uint16_t)result;
+  val = (uint16_t)get_number();
 
   return *this;
 }
 
 const SaveReaderTextValue&
 SaveReaderTextValue::operator >> (std::string &val) const {
-  val = value;
+  if (is_number) {
+    std::ostringstream ss;
+    ss << number;
+    for (size_t i = 1; i < numbers.size(); i++) {
+      ss << "," << numbers[i];
+    }
+    val = ss.str();
+  } else {
+    val = value;
+  }
   return *this;
 }
 
-const SaveReaderTextValue&
+SaveReaderTextValue
 SaveReaderTextValue::operator[] (size_t pos) const {
+  if (pos < numbers.size()) {
+    return SaveReaderTextValue(numbers[pos]);
+  }
   if (pos >= parts.size()) {
     throw ExceptionFreeserf("Failed to read value");
   }
@@ -407,71 +681,137 @@ SaveReaderTextValue::operator[] (size_t pos) const {
 }
 
 SaveWriterTextValue&
-SaveWriterTextValue::operator << (int val) {
-  if (!value.empty()) {
-    value += ",";
+SaveWriterTextValue::add_number(int64_t val) {
+  if (!is_text) {
+    numbers.push_back(val);
+    return *this;
+  }
+
+  if (!text.empty()) {
+    text += ",";
   }
 
   std::ostringstream ss;
   ss << val;
-  value += ss.str();
+  text += ss.str();
 
   return *this;
 }
 
+SaveWriterTextValue&
+SaveWriterTextValue::operator << (int val) {
+  return add_number(val);
+}
+
 SaveWriterTextValue&
 SaveWriterTextValue::operator << (unsigned int val) {
-  if (!value.empty()) {
-    value += ",";
-  }
+  return add_number(val);
+}
 
-  std::ostringstream ss;
-  ss << val;
-  value += ss.str();
+SaveWriterTextValue&
+SaveWriterTextValue::operator << (Direction val) {
+  return add_number(static_cast<int>(val));
+}
 
-  return *this;
+SaveWriterTextValue&
+SaveWriterTextValue::operator << (Resource::Type val) {
+  return add_number(static_cast<int>(val));
 }
 
 SaveWriterTextValue&
-SaveWriterTextValue::operator << (Direction val) {
-  if (!value.empty()) {
-    value += ",";
+SaveWriterTextValue::operator << (const std::string &val) {
+  if (!is_text) {
+    text = get_value();
+    numbers.clear();
+    is_text = true;
   }
 
-  std::ostringstream ss;
-  ss << static_cast<int>(val);
-  value += ss.str();
+  if (!text.empty()) {
+    text += ",";
+  }
+
+  text += val;
 
   return *this;
 }
 
-SaveWriterTextValue&
-SaveWriterTextValue::operator << (Resource::Type val) {
-  if (!value.empty()) {
-    value += ",";
+std::string
+SaveWriterTextValue::get_value() const {
+  std::string str;
+  append_value(&str);
+  return str;
+}
+
+void
+SaveWriterTextValue::append_value(std::string *str) const {
+  if (is_text) {
+    *str += text;
+    return;
   }
 
-  std::ostringstream ss;
-  ss << static_cast<int>(val);
-  value += ss.str();
+  char buffer[24];
+  for (size_t i = 0; i < numbers.size(); i++) {
+    if (i != 0) {
+      *str += ',';
+    }
 
-  return *this;
+    int64_t val = numbers[i];
+    uint64_t digits = (val < 0) ? 0 - static_cast<uint64_t>(val) : val;
+    char *p = buffer + sizeof(buffer);
+    do {
+      *--p = static_cast<char>('0' + (digits % 10));
+      digits /= 10;
+    } while (digits != 0);
+    if (val < 0) {
+      *--p = '-';
+    }
+    str->append(p, buffer + sizeof(buffer) - p);
+  }
 }
 
-SaveWriterTextValue&
-SaveWriterTextValue::operator << (const std::string &val) {
-  if (!value.empty()) {
-    value += ",";
+void
+SaveWriterTextValue::clear() {
+  numbers.clear();
+  text.clear();
+  is_text = false;
+}
+
+SaveTextOrder::Iterator &
+SaveTextOrder::Iterator::operator ++ () {
+  if (done) {
+    return *this;
   }
 
-  value += val;
+  if (number == 0) {
+    /* "0" is followed by "1". */
+    done = (last == 0);
+    number = 1;
+  } else if (number <= last / 10) {
+    number *= 10;
+  } else {
+    while (number % 10 == 9 || number >= last) {
+      number /= 10;
+      if (number == 0) {
+        done = true;
+        return *this;
+      }
+    }
+    number++;
+  }
 
   return *this;
 }
 
 // SaveGame
 
-GameStore::GameStore() {
+GameStore::GameStore()
+  : pending_saves(0)
+  , compress(false)
+  , index_loaded(false)
+  , index_scanned(false)
+  , folder_time(0)
+  , scan_time(0)
+  , pending_refreshes(0) {
   folder_path = ".";
 
 #ifdef _WIN32
@@ -512,7 +852,25 @@ GameStore::GameStore() {
 #endif
 }
 
+GameStore::GameStore(const std::string &folder)
+  : folder_path(folder)
+  , pending_saves(0)
+  , compress(false)
+  , index_loaded(false)
+  , index_scanned(false)
+  , folder_time(0)
+  , scan_time(0)
+  , pending_refreshes(0) {
+  if (!is_folder_exists(folder_path)) {
+    if (!create_folder(folder_path)) {
+      throw ExceptionFreeserf("Failed to create folder");
+    }
+  }
+}
+
 GameStore::~GameStore() {
+  wait_for_saves();
+  wait_for_index();
 }
 
 GameStore &
@@ -526,7 +884,7 @@ GameStore::create_folder(const std::string &path) {
 #ifdef _WIN32
   return (CreateDirectoryA(path.c_str(), nullptr) != FALSE);
 #else
-  return (mkdir(folder_path.c_str(),
+  return (mkdir(path.c_str(),
                 S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH) == 0);
 #endif  // _WIN32
 }
@@ -544,11 +902,300 @@ GameStore::is_folder_exists(const std::string &path) {
 
 const std::vector<GameStore::SaveInfo> &
 GameStore::get_saved_games() {
-  saved_games.clear();
-  update();
+  std::lock_guard<std::mutex> lock(index_mutex);
+  if (!index_loaded) {
+    read_index();
+    index_loaded = true;
+  }
+
+  /* Adding, removing or renaming files changes the time of the folder.
+     Times are in seconds, so a folder changed in the second it was last
+     scanned might have changed again since. */
+  size_t time = 0;
+  get_file_time(folder_path, nullptr, &time);
+  if (!index_scanned || time != folder_time || time >= scan_time) {
+    saved_games.clear();
+    update();
+    folder_time = time;
+    scan_time = static_cast<size_t>(std::time(nullptr));
+    index_scanned = true;
+    refresh_index();
+  }
+
+  for (SaveInfo &info : saved_games) {
+    auto it = index.find(info.path);
+    if (it != index.end()) {
+      SaveInfo indexed = it->second;
+      indexed.name = info.name;
+      indexed.type = info.type;
+      info = indexed;
+    }
+  }
+
   return saved_games;
 }
 
+bool
+GameStore::get_save_info(const std::string &path, SaveInfo *info) {
+  std::lock_guard<std::mutex> lock(index_mutex);
+  auto it = index.find(path);
+  if (it == index.end()) {
+    return false;
+  }
+  *info = it->second;
+  return true;
+}
+
+void
+GameStore::wait_for_index() {
+  std::unique_lock<std::mutex> lock(index_mutex);
+  index_done.wait(lock, [this]() { return (pending_refreshes == 0); });
+}
+
+void
+GameStore::describe(Game *game, SaveInfo *info) {
+  info->has_metadata = true;
+  info->tick = game->get_tick();
+  info->player_colors.clear();
+  for (unsigned int i = 0; i < GAME_MAX_PLAYER_COUNT; i++) {
+    Player *player = game->get_player(i);
+    if (player == nullptr) continue;
+    Player::Color color = player->get_color();
+    info->player_colors.push_back((color.red << 16) | (color.green << 8) |
+                                  color.blue);
+  }
+
+  info->thumbnail.clear();
+  PMap map = game->get_map();
+  if (!map) {
+    info->map_size = 0;
+    return;
+  }
+  info->map_size = map->get_size();
+  for (unsigned int y = 0; y < SAVE_THUMBNAIL_SIZE; y++) {
+    for (unsigned int x = 0; x < SAVE_THUMBNAIL_SIZE; x++) {
+      MapPos pos = map->pos(x * map->get_cols() / SAVE_THUMBNAIL_SIZE,
+                            y * map->get_rows() / SAVE_THUMBNAIL_SIZE);
+      uint8_t sample = map->type_up(pos) & 0x0f;
+      if (map->has_owner(pos)) {
+        sample |= (map->get_owner(pos) + 1) << 4;
+      }
+      info->thumbnail.push_back(sample);
+    }
+  }
+}
+
+std::string
+GameStore::get_index_path() const {
+#ifdef _WIN32
+  return folder_path + "\\saves.index";
+#else
+  return folder_path + "/saves.index";
+#endif  // _WIN32
+}
+
+bool
+GameStore::get_file_time(const std::string &path, size_t *size,
+                         size_t *time) {
+  struct stat info;
+  if (stat(path.c_str(), &info) != 0) {
+    return false;
+  }
+  if (size != nullptr) *size = static_cast<size_t>(info.st_size);
+  if (time != nullptr) *time = static_cast<size_t>(info.st_mtime);
+  return true;
+}
+
+/* The index is a native save with one "save" section per file. */
+void
+GameStore::read_index() {
+  index.clear();
+
+  MappedFile file;
+  if (!file.open(get_index_path())) {
+    return;
+  }
+
+  try {
+    SaveReaderNative reader(file.get_data(), file.get_size());
+    for (SaveReaderText *section : reader.get_sections("save")) {
+      SaveInfo info;
+      int type = 0;
+      unsigned int player_count = 0;
+      section->value("path") >> info.path;
+      section->value("name") >> info.name;
+      section->value("type") >> type;
+      info.type = static_cast<SaveInfo::Type>(type);
+      section->value("file_size") >> info.file_size;
+      section->value("file_time") >> info.file_time;
+      section->value("map_size") >> info.map_size;
+      section->value("tick") >> info.tick;
+      section->value("player_count") >> player_count;
+      for (unsigned int i = 0; i < player_count; i++) {
+        unsigned int color = 0;
+        if (player_count == 1) {
+          section->value("player_colors") >> color;
+        } else {
+          section->value("player_colors")[i] >> color;
+        }
+        info.player_colors.push_back(color);
+      }
+      if (info.map_size != 0) {
+        const SaveReaderTextValue &thumbnail = section->value("thumbnail");
+        for (size_t i = 0; i < SAVE_THUMBNAIL_SIZE * SAVE_THUMBNAIL_SIZE;
+             i++) {
+          unsigned int sample = 0;
+          thumbnail[i] >> sample;
+          info.thumbnail.push_back(sample);
+        }
+      }
+      info.has_metadata = true;
+      index[info.path] = info;
+    }
+  } catch (ExceptionFreeserf& e) {
+    Log::Warn["savegame"] << "Ignoring save game index: " << e.what();
+    index.clear();
+  }
+}
+
+void
+GameStore::write_index() {
+  SaveWriterNative writer;
+  unsigned int number = 0;
+  for (const auto &entry : index) {
+    const SaveInfo &info = entry.second;
+    SaveWriterText &section = writer.add_section("save", number++);
+    section.value("path") << info.path;
+    section.value("name") << info.name;
+    section.value("type") << static_cast<int>(info.type);
+    section.value("file_size") << info.file_size;
+    section.value("file_time") << info.file_time;
+    section.value("map_size") << info.map_size;
+    section.value("tick") << info.tick;
+    unsigned int player_count =
+      static_cast<unsigned int>(info.player_colors.size());
+    section.value("player_count") << player_count;
+    for (uint32_t color : info.player_colors) {
+      section.value("player_colors") << color;
+    }
+    for (uint8_t sample : info.thumbnail) {
+      section.value("thumbnail") << static_cast<unsigned int>(sample);
+    }
+  }
+
+  /* Write to a new file first, so a crash never leaves a broken index. */
+  std::string path = get_index_path();
+  std::string new_path = path + ".new";
+  {
+    std::ofstream os(new_path.c_str(), std::ios::binary | std::ios::trunc);
+    if (!os.is_open() || !writer.write(&os)) {
+      Log::Warn["savegame"] << "Unable to write save game index";
+      return;
+    }
+  }
+  std::remove(path.c_str());
+  std::rename(new_path.c_str(), path.c_str());
+}
+
+/* Drop index entries of saves that are gone and index the ones that are
+   new or were changed since they were indexed. */
+void
+GameStore::refresh_index() {
+  bool changed = false;
+  std::set<std::string> paths;
+  std::vector<SaveInfo> saves;
+  for (const SaveInfo &info : saved_games) {
+    paths.insert(info.path);
+    SaveInfo save = info;
+    if (!get_file_time(save.path, &save.file_size, &save.file_time)) {
+      continue;
+    }
+
+    auto it = index.find(save.path);
+    if (it != index.end() && it->second.file_size == save.file_size &&
+        it->second.file_time == save.file_time) {
+      continue;
+    }
+    if (it != index.end()) {
+      index.erase(it);
+      changed = true;
+    }
+    if (index_pending.insert(save.path).second) {
+      saves.push_back(save);
+    }
+  }
+
+  for (auto it = index.begin(); it != index.end(); ) {
+    if (paths.find(it->first) == paths.end()) {
+      it = index.erase(it);
+      changed = true;
+    } else {
+      ++it;
+    }
+  }
+
+  if (!saves.empty()) {
+    pending_refreshes++;
+    ThreadPool::get_instance().run([this, saves]() { index_saves(saves); });
+  } else if (changed) {
+    write_index();
+  }
+}
+
+/* Read the metadata of saves, on a worker thread. */
+void
+GameStore::index_saves(std::vector<SaveInfo> saves) {
+  for (SaveInfo &save : saves) {
+    Game game;
+    if (load(save.path, &game)) {
+      describe(&game, &save);
+    } else {
+      /* Remember failed saves as well, so they are not read every time. */
+      save.has_metadata = true;
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(index_mutex);
+  for (SaveInfo &save : saves) {
+    index_pending.erase(save.path);
+    /* The save may have changed again while it was read. */
+    size_t size = 0;
+    size_t time = 0;
+    if (get_file_time(save.path, &size, &time) && size == save.file_size &&
+        time == save.file_time) {
+      index[save.path] = save;
+    }
+  }
+  write_index();
+  pending_refreshes--;
+  index_done.notify_all();
+}
+
+/* Index a save game written by this program. */
+void
+GameStore::update_index(const std::string &path, Game *game) {
+  if (path.compare(0, folder_path.size(), folder_path) != 0) {
+    return;
+  }
+
+  SaveInfo info;
+  if (!get_file_time(path, &info.file_size, &info.file_time)) {
+    return;
+  }
+  info.path = path;
+  info.name = name_from_file(path.substr(folder_path.size() + 1));
+  info.type = SaveInfo::Regular;
+  describe(game, &info);
+
+  std::lock_guard<std::mutex> lock(index_mutex);
+  if (!index_loaded) {
+    read_index();
+    index_loaded = true;
+  }
+  index[path] = info;
+  write_index();
+}
+
 std::string
 GameStore::name_from_file(const std::string &file_name) {
   size_t pos = file_name.find_last_of('.');
@@ -721,49 +1368,141 @@ GameStore::find_regular() {
 
 bool
 GameStore::load(const std::string &path, Game *game) {
-  std::ifstream file;
-  file.open(path.c_str());
+  std::string delta_path = SaveCheckpoint(path).get_delta_path();
+  if (is_file_exists(delta_path)) {
+    /* A delta that can not be used is checked before the game is loaded,
+       so the full save can still be loaded on its own. */
+    if (load(delta_path, game)) {
+      return true;
+    }
+    Log::Warn["savegame"] << "Ignoring delta save '" << delta_path << "'";
+  }
 
-  if (!file.is_open()) {
+  MappedFile file;
+  if (!file.open(path)) {
     Log::Error["savegame"] << "Unable to open save game file: '" << path << "'";
     return false;
   }
 
+  return load(file.get_data(), file.get_size(), game);
+}
+
+GameStore::Format
+GameStore::detect_format(const void *data, size_t size) {
+  if (SaveReaderNative::is_native(data, size)) {
+    return FormatNative;
+  }
+
+  /* Text saves start with a section, possibly after comments. Legacy saves
+     are binary and contain zero bytes early on. */
+  const char *text = reinterpret_cast<const char*>(data);
+  size_t start = 0;
+  while (start < size && isspace(static_cast<unsigned char>(text[start]))) {
+    start++;
+  }
+  if (start == size || (text[start] != '[' && text[start] != ';' &&
+                        text[start] != '#')) {
+    return FormatLegacy;
+  }
+  if (memchr(text, 0, std::min(size, static_cast<size_t>(1024))) != nullptr) {
+    return FormatLegacy;
+  }
+
+  return FormatText;
+}
+
+bool
+GameStore::load(const void *data, size_t size, Game *game) {
   try {
-    SaveReaderTextFile reader_text(&file);
-    reader_text >> *game;
-  } catch (ExceptionFreeserf& e) {
-    file.close();
-    Log::Warn["savegame"] << "Unable to load save game: " << e.what();
-    Log::Warn["savegame"] << "Trying compatability mode...";
-    std::ifstream input(path.c_str(), std::ios::binary);
-    std::vector<char> buffer((std::istreambuf_iterator<char>(input)),
-                             (std::istreambuf_iterator<char>()));
-    SaveReaderBinary reader(&buffer[0], buffer.size());
-    try {
-      reader >> *game;
-    } catch (ExceptionFreeserf& e) {
-      Log::Error["savegame"] << "Failed to load save game: " << e.what();
-      return false;
+    if (SaveCompressor::is_compressed(data, size)) {
+      std::string save;
+      SaveCompressor::decompress(data, size, &save);
+      if (SaveCompressor::is_compressed(save.data(), save.size())) {
+        throw ExceptionFreeserf("Save game is compressed twice.");
+      }
+      return load(save.data(), save.size(), game);
+    }
+
+    switch (detect_format(data, size)) {
+      case FormatNative: {
+        SaveReaderNative reader(data, size);
+        if (SaveReaderDelta::is_delta(&reader)) {
+          load_delta(&reader, game);
+        } else {
+          reader >> *game;
+        }
+        break;
+      }
+      case FormatText: {
+        SaveReaderTextFile reader(reinterpret_cast<const char*>(data), size);
+        reader >> *game;
+        break;
+      }
+      case FormatLegacy: {
+        SaveReaderBinary reader(data, size);
+        reader >> *game;
+        break;
+      }
     }
+  } catch (ExceptionFreeserf& e) {
+    Log::Error["savegame"] << "Failed to load save game: " << e.what();
+    return false;
   }
 
   return true;
 }
 
-bool
-GameStore::quick_save(const std::string &prefix, Game *game) {
+void
+GameStore::load_delta(SaveReaderText *delta, Game *game) {
+  std::string path = SaveReaderDelta::get_base_path(delta);
+  MappedFile file;
+  if (!file.open(path)) {
+    throw ExceptionFreeserf("Unable to open base save game: " + path);
+  }
+  const void *data = file.get_data();
+  size_t size = file.get_size();
+  SaveReaderDelta::check_base(delta, data, size);
+
+  std::string decompressed;
+  if (SaveCompressor::is_compressed(data, size)) {
+    SaveCompressor::decompress(data, size, &decompressed);
+    data = decompressed.data();
+    size = decompressed.size();
+  }
+
+  std::unique_ptr<SaveReaderText> base;
+  switch (detect_format(data, size)) {
+    case FormatNative:
+      base.reset(new SaveReaderNative(data, size));
+      break;
+    case FormatText:
+      base.reset(new SaveReaderTextFile(reinterpret_cast<const char*>(data),
+                                        size));
+      break;
+    default:
+      throw ExceptionFreeserf("Unsupported base save game: " + path);
+  }
+  if (SaveReaderDelta::is_delta(base.get())) {
+    throw ExceptionFreeserf("Base save game is a delta: " + path);
+  }
+
+  SaveReaderDelta reader(base.get(), delta);
+  reader >> *game;
+}
+
+std::string
+GameStore::get_quick_save_path(const std::string &prefix) {
   /* Build filename including time stamp. */
   std::time_t t = time(NULL);
   struct tm *tm = std::localtime(&t);
   if (tm == nullptr) {
-    return false;
+    return std::string();
   }
 
   char name[128];
   size_t r = strftime(name, sizeof(name), "%Y-%m-%d_%H-%M-%S", tm);
   if (r == 0) {
-    return false;
+    return std::string();
   }
 
   GameStore save_game;
@@ -771,9 +1510,102 @@ GameStore::quick_save(const std::string &prefix, Game *game) {
   std::string path = save_game.get_folder_path();
   path += "/" + prefix + "-" + name + ".save";
 
+  return path;
+}
+
+bool
+GameStore::quick_save(const std::string &prefix, Game *game) {
+  std::string path = get_quick_save_path(prefix);
+  if (path.empty()) {
+    return false;
+  }
+
   return save(path, game);
 }
 
+void
+GameStore::run_save(const std::string &path, std::function<bool()> save) {
+  {
+    std::lock_guard<std::mutex> lock(saves_mutex);
+    pending_saves++;
+  }
+
+  ThreadPool::get_instance().run([this, path, save]() {
+    SaveResult result;
+    result.path = path;
+    result.saved = false;
+    try {
+      result.saved = save();
+    } catch (ExceptionFreeserf &e) {
+      Log::Error["savegame"] << "Failed to save game: "
+                             << e.get_description();
+    } catch (std::exception &e) {
+      Log::Error["savegame"] << "Failed to save game: " << e.what();
+    } catch (...) {
+      Log::Error["savegame"] << "Failed to save game";
+    }
+
+    std::lock_guard<std::mutex> lock(saves_mutex);
+    save_results.push_back(result);
+    pending_saves--;
+    saves_done.notify_all();
+  });
+}
+
+void
+GameStore::save_async(const std::string &path, std::shared_ptr<Game> snapshot,
+                      Format format) {
+  run_save(path, [this, path, snapshot, format]() {
+    return save(path, snapshot.get(), format);
+  });
+}
+
+void
+GameStore::checkpoint_async(std::shared_ptr<SaveCheckpoint> checkpoint,
+                            std::shared_ptr<Game> snapshot) {
+  bool compressed = compress;
+  run_save(checkpoint->get_path(), [this, checkpoint, snapshot, compressed]() {
+    if (!checkpoint->save(snapshot.get(), compressed)) {
+      return false;
+    }
+    update_index(checkpoint->get_path(), snapshot.get());
+    return true;
+  });
+}
+
+void
+GameStore::quick_save_async(const std::string &prefix,
+                            std::shared_ptr<Game> snapshot) {
+  std::string path = get_quick_save_path(prefix);
+  if (path.empty()) {
+    std::lock_guard<std::mutex> lock(saves_mutex);
+    save_results.push_back(SaveResult{path, false});
+    return;
+  }
+
+  save_async(path, snapshot);
+}
+
+bool
+GameStore::is_saving() {
+  std::lock_guard<std::mutex> lock(saves_mutex);
+  return (pending_saves != 0);
+}
+
+void
+GameStore::wait_for_saves() {
+  std::unique_lock<std::mutex> lock(saves_mutex);
+  saves_done.wait(lock, [this]() { return (pending_saves == 0); });
+}
+
+std::vector<GameStore::SaveResult>
+GameStore::take_save_results() {
+  std::lock_guard<std::mutex> lock(saves_mutex);
+  std::vector<SaveResult> results;
+  results.swap(save_results);
+  return results;
+}
+
 // In target, replace any character from needle with replacement character.
 static std::string
 strreplace(const std::string &src, const std::string &needle, char replace) {
@@ -793,33 +1625,62 @@ strreplace(const std::string &src, const std::string &needle, char replace) {
 }
 
 bool
-GameStore::save(const std::string &path, Game *game) {
+GameStore::save(const std::string &path, Game *game, Format format) {
   /* Substitute problematic characters. These are problematic
    particularly on windows platforms, but also in general on FAT
    filesystems through any platform. */
   /* TODO Possibly use PathCleanupSpec() when building for windows platform. */
   std::string file_path = strreplace(path, "*?\"<>|", '_');
 
-  SaveWriterTextSection writer("game", 0);
-  writer << *game;
-  return writer.save(file_path);
+  std::ofstream os;
+  if (format == FormatNative || compress) {
+    os.open(file_path.c_str(), std::ios::binary);
+  } else {
+    os.open(file_path.c_str(), std::ios_base::trunc);
+  }
+  if (!os.is_open()) {
+    Log::Error["savegame"] << "Unable to open save game file: '"
+                           << file_path << "'";
+    return false;
+  }
+
+  bool saved = false;
+  if (!compress) {
+    saved = write(&os, game, format);
+  } else {
+    try {
+      SaveCompressor compressor(&os);
+      std::ostream compressed(&compressor);
+      saved = write(&compressed, game, format) && compressor.finish();
+    } catch (ExceptionFreeserf& e) {
+      Log::Error["savegame"] << "Failed to compress save game: " << e.what();
+    }
+  }
+  os.close();
+
+  if (saved) {
+    update_index(file_path, game);
+  }
+  return saved;
 }
 
 bool
 GameStore::read(std::istream *is, Game *game) {
-  try {
-    SaveReaderTextFile reader_text(is);
-    reader_text >> *game;
-  } catch (...) {
-    return false;
-  }
-  return true;
+  std::string data((std::istreambuf_iterator<char>(*is)),
+                   (std::istreambuf_iterator<char>()));
+  return load(data.data(), data.size(), game);
 }
 
 bool
-GameStore::write(std::ostream *os, Game *game) {
-  SaveWriterTextSection writer("game", 0);
+GameStore::write(std::ostream *os, Game *game, Format format) {
+  if (format == FormatNative) {
+    SaveWriterNative writer;
+    writer << *game;
+    return writer.write(os);
+  }
+
+  SaveWriterTextStream writer(os);
   writer << *game;
-  return writer.write(os);
+  return writer.finish();
 }
 
@@ -25,9 +25,16 @@
 #include <iostream>
 #include <string>
 #include <list>
+#include <map>
+#include <set>
 #include <vector>
 #include <memory>
 #include <sstream>
+#include <cstdint>
+#include <atomic>  // NOLINT(build/c++11)
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <functional>
+#include <mutex>  // NOLINT(build/c++11)
 
 #include "src/map.h"
 #include "src/resource.h"
@@ -37,13 +44,13 @@
 
 class SaveReaderBinary {
  protected:
-  uint8_t *start;
-  uint8_t *current;
-  uint8_t *end;
+  const uint8_t *start;
+  const uint8_t *current;
+  const uint8_t *end;
 
  public:
   SaveReaderBinary(const SaveReaderBinary &reader);
-  SaveReaderBinary(void *data, size_t size);
+  SaveReaderBinary(const void *data, size_t size);
 
   SaveReaderBinary& operator >> (uint8_t &val);
   SaveReaderBinary& operator >> (uint16_t &val);
@@ -53,25 +60,36 @@ class SaveReaderBinary {
   void reset() { current = start; }
   void skip(size_t count) { current += count; }
   SaveReaderBinary extract(size_t size);
-  uint8_t *read(size_t size);
+  const uint8_t *read(size_t size);
   bool has_data_left(size_t size) const { return current + size <= end; }
 };
 
+// Value being loaded. Lists of integers are parsed once into a column of
+// numbers, so elements can be read without splitting the text again.
 class SaveReaderTextValue {
  protected:
   std::string value;
+  std::vector<int64_t> numbers;
   std::vector<SaveReaderTextValue> parts;
+  bool is_number;
+  int64_t number;
 
  public:
   explicit SaveReaderTextValue(const std::string &value);
+  /* Value from a view into a text save file. Integers and lists of them
+     are parsed from the view; other values are copied and converted to
+     lower case, like all names and values of that format. */
+  SaveReaderTextValue(const char *data, size_t size);
+  /* Value that was stored as numbers rather than text. */
+  explicit SaveReaderTextValue(int64_t number);
+  explicit SaveReaderTextValue(const std::vector<int64_t> &numbers);
 
   const SaveReaderTextValue& operator >> (int &val) const;
   const SaveReaderTextValue& operator >> (unsigned int &val) const;
   template <typename = std::enable_if<
                                     !std::is_same<size_t, unsigned int>::value>>
     const SaveReaderTextValue& operator >> (size_t &val) const {
-      int result = atoi(value.c_str());
-      val = result;
+      val = static_cast<size_t>(get_number());
       return *this;
     }
   const SaveReaderTextValue& operator >> (Direction &val) const;
@@ -80,29 +98,36 @@ class SaveReaderTextValue {
   const SaveReaderTextValue& operator >> (Serf::State &val) const;
   const SaveReaderTextValue& operator >> (uint16_t &val) const;
   const SaveReaderTextValue& operator >> (std::string &val) const;
-  const SaveReaderTextValue& operator[] (size_t pos) const;
+  SaveReaderTextValue operator[] (size_t pos) const;
+
+ protected:
+  int64_t get_number() const { return number; }
+  bool parse_numbers(const char *begin, const char *end);
+  void parse();
 };
 
+// Value being saved. Numbers are kept as such until the value is formatted
+// as text, so binary formats can store them directly.
 class SaveWriterTextValue {
  protected:
-  std::string value;
+  std::vector<int64_t> numbers;
+  std::string text;
+  bool is_text;
 
  public:
-  SaveWriterTextValue() {}
+  SaveWriterTextValue() : is_text(false) {}
 
   SaveWriterTextValue& operator << (int val);
   SaveWriterTextValue& operator << (unsigned int val);
   template <typename = std::enable_if<
                                     !std::is_same<size_t, unsigned int>::value>>
     SaveWriterTextValue& operator << (size_t val) {
-      if (!value.empty()) {
-        value += ",";
+      if (val > static_cast<size_t>(INT64_MAX)) {
+        std::ostringstream ss;
+        ss << val;
+        return *this << ss.str();
       }
-      std::ostringstream ss;
-      ss << val;
-      value += ss.str();
-
-      return *this;
+      return add_number(static_cast<int64_t>(val));
     }
 
 
@@ -110,7 +135,18 @@ class SaveWriterTextValue {
   SaveWriterTextValue& operator << (Resource::Type val);
   SaveWriterTextValue& operator << (const std::string &val);
 
-  std::string &get_value() { return value; }
+  /* Comma separated text form of the value. */
+  std::string get_value() const;
+  void append_value(std::string *str) const;
+
+  /* Remove all elements, keeping the allocated storage. */
+  void clear();
+
+  bool has_text() const { return is_text; }
+  const std::vector<int64_t> &get_numbers() const { return numbers; }
+
+ protected:
+  SaveWriterTextValue& add_number(int64_t val);
 };
 
 class SaveReaderText;
@@ -133,8 +169,48 @@ class SaveWriterText {
   virtual SaveWriterTextValue &value(const std::string &name) = 0;
   virtual SaveWriterText &add_section(const std::string &name,
                                       unsigned int number) = 0;
+  /* Writers that only store part of the game may skip sections. */
+  virtual bool wants_section(const std::string & /*name*/,
+                             unsigned int /*number*/) {
+    return true;
+  }
 };
 
+// Numbers below count in the order of their decimal text ("0", "1", "10",
+// "11", "2"), which is the order the text format stores sections in.
+class SaveTextOrder {
+ protected:
+  unsigned int count;
+
+ public:
+  class Iterator {
+   protected:
+    unsigned int number;
+    unsigned int last;
+    bool done;
+
+   public:
+    Iterator(unsigned int _number, unsigned int _last, bool _done)
+      : number(_number), last(_last), done(_done) {}
+
+    Iterator &operator ++ ();
+    bool operator != (const Iterator &right) const {
+      return (done != right.done) || (!done && number != right.number);
+    }
+    unsigned int operator * () const { return number; }
+  };
+
+  explicit SaveTextOrder(unsigned int _count) : count(_count) {}
+
+  Iterator begin() const { return Iterator(0, count - 1, count == 0); }
+  Iterator end() const { return Iterator(0, count - 1, true); }
+};
+
+/* Width and height of the map thumbnail of saved games. */
+#define SAVE_THUMBNAIL_SIZE  64
+
+class SaveCheckpoint;
+
 class GameStore {
  public:
   class SaveInfo {
@@ -147,6 +223,29 @@ class GameStore {
     std::string name;
     std::string path;
     Type type;
+
+    /* Metadata from the save game index, valid if has_metadata is set.
+       Saves that failed to load have a map size of zero. */
+    bool has_metadata;
+    size_t file_size;
+    size_t file_time;
+    unsigned int map_size;
+    unsigned int tick;
+    /* Color of each player as 0xRRGGBB. */
+    std::vector<uint32_t> player_colors;
+    /* SAVE_THUMBNAIL_SIZE rows of samples of the map, each holding the
+       terrain (bits 0-3) and the owner plus one (bits 4-6, zero if none). */
+    std::vector<uint8_t> thumbnail;
+
+    SaveInfo()
+      : type(Regular), has_metadata(false), file_size(0), file_time(0)
+      , map_size(0), tick(0) {}
+  };
+
+  class SaveResult {
+   public:
+    std::string path;
+    bool saved;
   };
 
  protected:
@@ -155,7 +254,30 @@ class GameStore {
   std::string folder_path;
   std::vector<SaveInfo> saved_games;
 
+  /* Saves running in the background. */
+  std::mutex saves_mutex;
+  std::condition_variable saves_done;
+  unsigned int pending_saves;
+  std::vector<SaveResult> save_results;
+
+  std::atomic<bool> compress;
+
+  /* Metadata of the saves in the folder by path, kept in an index file so
+     the saves don't have to be read to list them. */
+  std::mutex index_mutex;
+  std::condition_variable index_done;
+  std::map<std::string, SaveInfo> index;
+  bool index_loaded;
+  bool index_scanned;
+  size_t folder_time;
+  size_t scan_time;
+  std::set<std::string> index_pending;
+  unsigned int pending_refreshes;
+
  public:
+  /* Store of the saves in folder instead of the save folder of the user,
+     e.g. for tests. The folder is created if it does not exist. */
+  explicit GameStore(const std::string &folder);
   virtual ~GameStore();
 
   static GameStore &get_instance();
@@ -163,16 +285,64 @@ class GameStore {
   std::string get_folder_path() const { return folder_path; }
   bool create_folder(const std::string &path);
   bool is_folder_exists(const std::string &path);
+  /* Saves in the folder, with metadata as far as it is indexed yet. The
+     folder is only scanned again after files were added or removed. Saves
+     missing from the index are indexed on the thread pool. */
   const std::vector<SaveInfo> &get_saved_games();
+  /* Metadata of a save game from the index; false if not indexed yet. */
+  bool get_save_info(const std::string &path, SaveInfo *info);
+  /* Wait until saves missing from the index have been indexed. */
+  void wait_for_index();
+  /* Fill in the metadata of info from game. */
+  static void describe(Game *game, SaveInfo *info);
+
+  typedef enum Format {
+    FormatText,
+    FormatNative,
+    FormatLegacy
+  } Format;
+
+  /* Compress saves of any format written by save(), and checkpoints.
+   Compressed saves are recognized on load whether or not this is
+   enabled. */
+  void set_compression(bool enable) { compress = enable; }
+  bool get_compression() const { return compress; }
 
   /* Generic save/load function that will try to detect the right
    format on load and save to the best format on write. */
-  bool save(const std::string &path, Game *game);
+  bool save(const std::string &path, Game *game,
+            Format format = FormatNative);
+  /* The full save of a checkpoint (see SaveCheckpoint) is loaded with its
+     latest delta, or on its own if the delta does not apply to it. */
   bool load(const std::string &path, Game *game);
   bool quick_save(const std::string &prefix, Game *game);
 
   bool read(std::istream *is, Game *game);
-  bool write(std::ostream *os, Game *game);
+  bool write(std::ostream *os, Game *game, Format format = FormatText);
+
+  /* Save a snapshot of the game (see Game::fork()) on a worker thread.
+   Returns without waiting for the save; the outcome is collected with
+   take_save_results(). */
+  void save_async(const std::string &path, std::shared_ptr<Game> snapshot,
+                  Format format = FormatNative);
+  void quick_save_async(const std::string &prefix,
+                        std::shared_ptr<Game> snapshot);
+  /* Write the next checkpoint of a snapshot on a worker thread, the same
+   way as save_async(). */
+  void checkpoint_async(std::shared_ptr<SaveCheckpoint> checkpoint,
+                        std::shared_ptr<Game> snapshot);
+  /* Autosaves are checkpoints of the same file, so they do not pile up. */
+  std::string get_autosave_path() const {
+    return folder_path + "/autosave.save";
+  }
+  bool is_saving();
+  void wait_for_saves();
+  /* Outcome of background saves finished since the last call. */
+  std::vector<SaveResult> take_save_results();
+
+  /* Load a save game of any format from memory, e.g. a mapped file. */
+  bool load(const void *data, size_t size, Game *game);
+  static Format detect_format(const void *data, size_t size);
 
  protected:
   void update();
@@ -181,6 +351,21 @@ class GameStore {
   void find_regular();
   std::string name_from_file(const std::string &file_name);
   bool is_file_exists(const std::string &path);
+  std::string get_quick_save_path(const std::string &prefix);
+  /* Run save on the thread pool and record its outcome as the save of
+     path. A save that throws is recorded as failed. */
+  void run_save(const std::string &path, std::function<bool()> save);
+  /* Load a delta save (see SaveCheckpoint) on top of its full save. */
+  void load_delta(SaveReaderText *delta, Game *game);
+
+  std::string get_index_path() const;
+  static bool get_file_time(const std::string &path, size_t *size,
+                            size_t *time);
+  void read_index();
+  void write_index();
+  void refresh_index();
+  void index_saves(std::vector<SaveInfo> saves);
+  void update_index(const std::string &path, Game *game);
 };
 
 #endif  // SRC_SAVEGAME_H_
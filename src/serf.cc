@@ -382,7 +382,7 @@ Serf::reset_transport(Flag *flag) {
              s.leaving_building.field_B < 0) {
     s.leaving_building.field_B = -2;
     s.leaving_building.dest = 0;
-  } else if (state == StateTransporting &&
+  } else if ((state == StateTransporting || state == StateDelivering) &&
              s.walking.dest == flag->get_index()) {
     s.walking.dest = 0;
   } else if (state == StateMoveResourceOut &&
@@ -1033,10 +1033,14 @@ Serf::transporter_move_to_flag(Flag *flag) {
       Resource::Type temp_res = s.transporting.res;
       int temp_dest = s.transporting.dest;
 
-      flag->pick_up_resource(res_index, &s.transporting.res,
-                             &s.transporting.dest);
-
-      flag->drop_resource(temp_res, temp_dest);
+      if (flag->pick_up_resource(res_index, &s.transporting.res,
+                                 &s.transporting.dest)) {
+        flag->drop_resource(temp_res, temp_dest);
+      } else if (flag->drop_resource(temp_res, temp_dest)) {
+        /* The scheduled slot was empty, dropping the resource without
+           picking one up must not leave a copy with the serf. */
+        s.transporting.res = Resource::TypeNone;
+      }
     }
 
     /* Find next resource to be picked up */
@@ -1127,6 +1131,13 @@ Serf::handle_serf_walking_state_dest_reached() {
   if (s.walking.dir1 < 0) {
     PMap map = game->get_map();
     Building *building = game->get_building_at_pos(map->move_up_left(pos));
+    if (building == nullptr) {
+      /* The building is gone, e.g. burnt down by an enemy. */
+      set_state(StateLost);
+      s.lost.field_B = 0;
+      counter = 0;
+      return;
+    }
     building->requested_serf_reached(this);
 
     if (map->has_serf(map->move_up_left(pos))) {
@@ -2258,9 +2269,14 @@ Serf::handle_serf_delivering_state() {
     if (s.transporting.res != Resource::TypeNone) {
       Resource::Type res = s.transporting.res;
       s.transporting.res = Resource::TypeNone;
-      Building *building =
+      if (s.transporting.dest != 0) {
+        Building *building =
                   game->get_building_at_pos(game->get_map()->move_up_left(pos));
-      building->requested_resource_delivered(res);
+        building->requested_resource_delivered(res);
+      } else {
+        /* The building was demolished or taken by an enemy on the way. */
+        game->lose_resource(res);
+      }
     }
 
     animation = 4 + 9 - (animation - (3 + 10*9));
@@ -4550,10 +4566,13 @@ Serf::handle_knight_occupy_enemy_building() {
     return;
   }
 
+  /* The building may have been replaced by a new one under construction
+     while the knight was on its way. */
   Building *building =
                   game->get_building_at_pos(game->get_map()->move_up_left(pos));
   if (building != NULL) {
-    if (!building->is_burning() && building->is_military()) {
+    if (!building->is_burning() && building->is_done() &&
+        building->is_military()) {
       if (building->get_owner() == owner) {
         /* Enter building if there is space. */
         if (building->get_type() == Building::TypeCastle) {
@@ -4610,7 +4629,7 @@ Serf::handle_state_knight_free_walking() {
         Serf *other = game->get_serf_at_pos(pos_);
         if (get_owner() != other->get_owner()) {
           if (other->state == StateKnightFreeWalking) {
-            pos = map->move_left(pos_);
+            pos_ = map->move_left(pos_);
             if (can_pass_map_pos(pos_)) {
               int dist_col = s.free_walking.dist_col;
               int dist_row = s.free_walking.dist_row;
@@ -4645,10 +4664,13 @@ Serf::handle_state_knight_free_walking() {
               animation = 99;
               counter = 255;
 
+              /* The building the knight walks to may be gone. */
               Flag *dest = game->get_flag(other->s.walking.dest);
-              Building *building = dest->get_building();
-              if (!building->has_inventory()) {
-                building->requested_knight_attacking_on_walk();
+              if (dest != nullptr && dest->has_building()) {
+                Building *building = dest->get_building();
+                if (!building->has_inventory()) {
+                  building->requested_knight_attacking_on_walk();
+                }
               }
 
               set_other_state(other, StateKnightEngageAttackingFree);
@@ -5853,7 +5875,7 @@ operator >> (SaveReaderText &reader, Serf &serf) {
 }
 
 SaveWriterText&
-operator << (SaveWriterText &writer, Serf &serf) {
+operator << (SaveWriterText &writer, const Serf &serf) {
   writer.value("type") << serf.type;
   writer.value("owner") << serf.owner;
   writer.value("animation") << serf.animation;
@@ -6008,13 +6030,20 @@ operator << (SaveWriterText &writer, Serf &serf) {
     case Serf::StateKnightAttackingVictory:
     case Serf::StateKnightEngageAttackingFree:
     case Serf::StateKnightEngageAttackingFreeJoin:
-    case Serf::StateKnightAttackingVictoryFree:
       writer.value("state.move") << serf.s.attacking.move;
       writer.value("state.attacker_won") << serf.s.attacking.attacker_won;
       writer.value("state.field_D") << serf.s.attacking.field_D;
       writer.value("state.def_index") << serf.s.attacking.def_index;
       break;
 
+    case Serf::StateKnightAttackingVictoryFree:
+      writer.value("state.move") << serf.s.attacking_victory_free.move;
+      writer.value("state.dist_col") << serf.s.attacking_victory_free.dist_col;
+      writer.value("state.dist_row") << serf.s.attacking_victory_free.dist_row;
+      writer.value("state.def_index") <<
+        serf.s.attacking_victory_free.def_index;
+      break;
+
     case Serf::StateKnightDefendingFree:
     case Serf::StateKnightEngageDefendingFree:
       writer.value("state.dist_col") << serf.s.defending_free.dist_col;
@@ -458,7 +458,7 @@ class Serf : public GameObject {
   friend SaveReaderText&
     operator >> (SaveReaderText &reader, Serf &serf);
   friend SaveWriterText&
-    operator << (SaveWriterText &writer, Serf &serf);
+    operator << (SaveWriterText &writer, const Serf &serf);
 
   std::string print_state();
 
@@ -559,6 +559,9 @@ class Serf : public GameObject {
   void handle_serf_defending_tower_state();
   void handle_serf_defending_fortress_state();
   void handle_serf_defending_castle_state();
+
+  Serf(const Serf &that) = default;
+  template<class T, size_t growth> friend class Collection;
 };
 
 #endif  // SRC_SERF_H_
@@ -0,0 +1,164 @@
+/*
+ * sprite-bench.cc - Benchmark of the sprite kernels
+ *
+ * Copyright (C) 2026  freeserf developers
+ *
+ * This file is part of freeserf.
+ *
+ * freeserf is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * freeserf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with freeserf.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <istream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "src/command_line.h"
+#include "src/log.h"
+#include "src/version.h"
+#include "src/sprite-kernels.h"
+
+typedef std::vector<uint32_t> Pixels;
+
+/* Pixels with a mix of transparent, opaque and translucent ones, like the
+   sprites of the data files. */
+static Pixels
+make_pixels(std::mt19937 *rnd, size_t count) {
+  Pixels pixels(count);
+  for (uint32_t &pixel : pixels) {
+    pixel = static_cast<uint32_t>((*rnd)());
+    switch ((*rnd)() % 4) {
+      case 0: pixel &= 0x00FFFFFF; break;
+      case 1: pixel |= 0xFF000000; break;
+      default: break;
+    }
+  }
+  return pixels;
+}
+
+/* Time of one run of kernel over the pixels, in nanoseconds per pixel. */
+static double
+measure(const std::function<void()> &kernel, unsigned int iterations,
+        size_t count) {
+  kernel();
+  auto start = std::chrono::steady_clock::now();
+  for (unsigned int i = 0; i < iterations; i++) {
+    kernel();
+  }
+  auto end = std::chrono::steady_clock::now();
+  std::chrono::duration<double, std::nano> elapsed = end - start;
+  return elapsed.count() / (static_cast<double>(iterations) * count);
+}
+
+int
+main(int argc, char *argv[]) {
+  unsigned int iterations = 1000;
+  unsigned int width = 32;
+  unsigned int height = 20;
+
+  CommandLine command_line;
+  command_line.add_option('h', "Show this help text", [&command_line](){
+                  command_line.show_help();
+                  exit(EXIT_SUCCESS);
+                });
+  command_line.add_option('n', "Number of runs of each kernel")
+                .add_parameter("COUNT", [&iterations](std::istream& s) {
+                  s >> iterations;
+                  return true;
+                });
+  command_line.add_option('s', "Size of the sprites")
+                .add_parameter("WIDTHxHEIGHT", [&width, &height]
+                               (std::istream& s) {
+                  char x;
+                  s >> width >> x >> height;
+                  return true;
+                });
+  command_line.set_comment("Please report bugs to <" PACKAGE_BUGREPORT ">");
+  if (!command_line.process(argc, argv) || iterations == 0 ||
+      width * height == 0) {
+    return EXIT_FAILURE;
+  }
+
+  Log::Info["sprite-bench"] << "starts " << FREESERF_VERSION;
+  Log::Info["sprite-bench"] << "best level is "
+                            << SpriteKernels::get_level_name(
+                                 SpriteKernels::get_best_level());
+
+  const size_t count = width * height;
+  std::mt19937 rnd;
+  const Pixels a = make_pixels(&rnd, count);
+  const Pixels b = make_pixels(&rnd, count);
+  Pixels dest(count);
+
+  /* Each run starts from the same pixels so the work does not change. */
+  typedef std::function<void(const SpriteKernels&)> Run;
+  std::vector<std::pair<std::string, Run>> runs = {
+    { "mask", [&](const SpriteKernels &k) {
+        k.mask(dest.data(), a.data(), b.data(), count); } },
+    { "compare", [&](const SpriteKernels &k) {
+        k.compare(dest.data(), a.data(), b.data(), count); } },
+    { "fill_masked", [&](const SpriteKernels &k) {
+        dest = a;
+        k.fill_masked(dest.data(), 0xFF2040C0, count); } },
+    { "add", [&](const SpriteKernels &k) {
+        dest = a;
+        k.add(dest.data(), b.data(), count); } },
+    { "del", [&](const SpriteKernels &k) {
+        dest = a;
+        k.del(dest.data(), b.data(), count); } },
+    { "blend", [&](const SpriteKernels &k) {
+        dest = a;
+        k.blend(dest.data(), b.data(), count); } },
+    { "stick", [&](const SpriteKernels &k) {
+        dest = a;
+        k.stick(dest.data(), b.data(), count); } },
+    { "make_alpha_mask", [&](const SpriteKernels &k) {
+        dest = a;
+        uint8_t min = k.alpha_from_luminance(dest.data(), count);
+        k.lower_alpha(dest.data(), min, count); } },
+  };
+
+  std::vector<SpriteKernels> levels;
+  for (SpriteKernels::Level level : { SpriteKernels::LevelScalar,
+                                      SpriteKernels::LevelSSE2,
+                                      SpriteKernels::LevelAVX2 }) {
+    if (SpriteKernels::is_supported(level)) {
+      levels.push_back(SpriteKernels::get_kernels(level));
+    }
+  }
+
+  std::cout << std::left << std::setw(16) << "kernel";
+  for (const SpriteKernels &kernels : levels) {
+    std::cout << std::right << std::setw(12)
+              << SpriteKernels::get_level_name(kernels.get_level());
+  }
+  std::cout << "  (ns per pixel, " << width << "x" << height << ")\n";
+
+  for (const auto &run : runs) {
+    std::cout << std::left << std::setw(16) << run.first;
+    for (const SpriteKernels &kernels : levels) {
+      double ns = measure([&run, &kernels]() { run.second(kernels); },
+                          iterations, count);
+      std::cout << std::right << std::setw(12) << std::fixed
+                << std::setprecision(3) << ns;
+    }
+    std::cout << "\n";
+  }
+
+  return EXIT_SUCCESS;
+}
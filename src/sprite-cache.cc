@@ -0,0 +1,382 @@
+/*
+ * sprite-cache.cc - File of decoded sprites kept between runs
+ *
+ * Copyright (C) 2026  freeserf developers
+ *
+ * This file is part of freeserf.
+ *
+ * freeserf is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * freeserf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with freeserf.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/sprite-cache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <utility>
+#include <vector>
+
+#include "src/log.h"
+
+/* "FSSC" in the byte order of the machine that wrote the file. Files of
+   other machines are rebuilt. */
+#define SPRITE_CACHE_MAGIC    0x43535346
+/* Increase when the decoding of sprites changes. */
+#define SPRITE_CACHE_VERSION  1
+
+// Sprite copied from the cache.
+class SpriteCached : public Sprite {
+ public:
+  SpriteCached(size_t w, size_t h, int dx, int dy, int ox, int oy,
+               const uint8_t *pixels) {
+    create(w, h);
+    delta_x = dx;
+    delta_y = dy;
+    offset_x = ox;
+    offset_y = oy;
+    std::memcpy(data, pixels, w * h * 4);
+  }
+  virtual ~SpriteCached() {}
+};
+
+SpriteCache::SpriteCache(const std::string &_path, uint64_t _data_hash)
+  : path(_path)
+  , data_hash(_data_hash)
+  , entries(nullptr)
+  , entry_count(0) {
+}
+
+SpriteCache::~SpriteCache() {
+}
+
+bool
+SpriteCache::open() {
+  std::unique_ptr<MappedFile> mapped(new MappedFile());
+  if (!mapped->open(path)) {
+    return false;
+  }
+
+  const uint8_t *data = mapped->get_data();
+  size_t size = mapped->get_size();
+  if (size < sizeof(Header)) {
+    Log::Warn["data"] << "Sprite cache '" << path << "' is truncated";
+    return false;
+  }
+
+  const Header *header = reinterpret_cast<const Header*>(data);
+  if ((header->magic != SPRITE_CACHE_MAGIC) ||
+      (header->version != SPRITE_CACHE_VERSION) ||
+      (header->data_hash != data_hash)) {
+    Log::Info["data"] << "Sprite cache '" << path << "' is out of date";
+    return false;
+  }
+  if (header->entry_count > (size - sizeof(Header)) / sizeof(Entry)) {
+    Log::Warn["data"] << "Sprite cache '" << path << "' is truncated";
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex);
+  file = std::move(mapped);
+  entries = reinterpret_cast<const Entry*>(data + sizeof(Header));
+  entry_count = static_cast<size_t>(header->entry_count);
+
+  Log::Info["data"] << "Sprite cache '" << path << "' has " << entry_count
+                    << " sprites";
+  return true;
+}
+
+bool
+SpriteCache::save() {
+  /* Only this thread replaces the file, so it may be read without the lock
+     until then. */
+  std::map<uint64_t, DataSource::MaskImage> sprites;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    sprites = added;
+  }
+
+  std::string temp_path = path + ".tmp";
+  if (!write(temp_path, sprites)) {
+    Log::Warn["data"] << "Failed to write sprite cache '" << temp_path << "'";
+    std::remove(temp_path.c_str());
+    return false;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    /* The mapped file can not be replaced on all platforms. */
+    file.reset();
+    entries = nullptr;
+    entry_count = 0;
+    std::remove(path.c_str());
+    if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+      Log::Warn["data"] << "Failed to replace sprite cache '" << path << "'";
+      std::remove(temp_path.c_str());
+      return false;
+    }
+    for (const auto &sprite : sprites) {
+      added.erase(sprite.first);
+    }
+  }
+
+  if (!open()) {
+    /* Keep the sprites in memory then. */
+    std::lock_guard<std::mutex> lock(mutex);
+    added.insert(sprites.begin(), sprites.end());
+    return false;
+  }
+
+  return true;
+}
+
+bool
+SpriteCache::write(const std::string &file_path,
+                   const std::map<uint64_t,
+                                  DataSource::MaskImage> &sprites) const {
+  /* Entries of the mapped file and the added sprites, ordered by id. */
+  typedef struct Source {
+    const Entry *entry;
+    PSprite mask;
+    PSprite image;
+  } Source;
+  std::map<uint64_t, Source> sources;
+  for (size_t i = 0; i < entry_count; i++) {
+    sources[entries[i].id] = { &entries[i], nullptr, nullptr };
+  }
+  for (const auto &sprite : sprites) {
+    sources[sprite.first] = { nullptr, std::get<0>(sprite.second),
+                              std::get<1>(sprite.second) };
+  }
+
+  /* Pixels of each part, in the order they are written after the index. */
+  std::vector<std::pair<const uint8_t*, size_t>> pixels;
+  std::vector<Entry> index;
+  uint64_t offset = sizeof(Header);
+  for (const auto &source : sources) {
+    const Entry *entry = source.second.entry;
+    if ((entry == nullptr) || (is_valid(entry->mask) &&
+                               is_valid(entry->image))) {
+      offset += sizeof(Entry);
+    }
+  }
+  auto add_part = [&](Part *part, const uint8_t *data) {
+    size_t size = static_cast<size_t>(part->width) * part->height * 4;
+    part->offset = offset;
+    pixels.push_back(std::make_pair(data, size));
+    offset += size;
+  };
+  auto add_sprite = [&](Part *part, const PSprite &sprite) {
+    *part = Part();
+    if (!sprite) {
+      return;
+    }
+    part->width = static_cast<uint32_t>(sprite->get_width());
+    part->height = static_cast<uint32_t>(sprite->get_height());
+    part->delta_x = sprite->get_delta_x();
+    part->delta_y = sprite->get_delta_y();
+    part->offset_x = sprite->get_offset_x();
+    part->offset_y = sprite->get_offset_y();
+    add_part(part, sprite->get_data());
+  };
+  auto add_mapped = [&](Part *part, const Part &source) {
+    *part = source;
+    if (source.offset != 0) {
+      add_part(part, file->get_data() + source.offset);
+    }
+  };
+
+  for (const auto &source : sources) {
+    Entry entry;
+    entry.id = source.first;
+    if (source.second.entry != nullptr) {
+      if (!is_valid(source.second.entry->mask) ||
+          !is_valid(source.second.entry->image)) {
+        continue;
+      }
+      add_mapped(&entry.mask, source.second.entry->mask);
+      add_mapped(&entry.image, source.second.entry->image);
+    } else {
+      add_sprite(&entry.mask, source.second.mask);
+      add_sprite(&entry.image, source.second.image);
+    }
+    index.push_back(entry);
+  }
+
+  std::ofstream out(file_path.c_str(), std::ios::binary | std::ios::trunc);
+  if (!out.good()) {
+    return false;
+  }
+
+  Header header;
+  header.magic = SPRITE_CACHE_MAGIC;
+  header.version = SPRITE_CACHE_VERSION;
+  header.data_hash = data_hash;
+  header.entry_count = index.size();
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  if (!index.empty()) {
+    out.write(reinterpret_cast<const char*>(index.data()),
+              index.size() * sizeof(Entry));
+  }
+  for (const auto &part : pixels) {
+    out.write(reinterpret_cast<const char*>(part.first), part.second);
+  }
+
+  out.close();
+  return !out.fail();
+}
+
+const SpriteCache::Entry *
+SpriteCache::find(uint64_t id) const {
+  const Entry *end = entries + entry_count;
+  const Entry *entry = std::lower_bound(entries, end, id,
+                                        [](const Entry &e, uint64_t id) {
+                                          return e.id < id;
+                                        });
+  if ((entry == end) || (entry->id != id)) {
+    return nullptr;
+  }
+  return entry;
+}
+
+bool
+SpriteCache::is_valid(const Part &part) const {
+  if (part.offset == 0) {
+    return true;
+  }
+
+  uint64_t size = static_cast<uint64_t>(part.width) * part.height * 4;
+  return (part.offset <= file->get_size()) &&
+         (size <= file->get_size() - part.offset);
+}
+
+PSprite
+SpriteCache::load_part(const Part &part) const {
+  if (part.offset == 0) {
+    return nullptr;
+  }
+
+  if (!is_valid(part)) {
+    throw ExceptionFreeserf("Sprite cache is corrupt");
+  }
+
+  return std::make_shared<SpriteCached>(part.width, part.height,
+                                        part.delta_x, part.delta_y,
+                                        part.offset_x, part.offset_y,
+                                        file->get_data() + part.offset);
+}
+
+bool
+SpriteCache::get(uint64_t id, DataSource::MaskImage *parts) {
+  std::lock_guard<std::mutex> lock(mutex);
+
+  const Entry *entry = find(id);
+  if (entry != nullptr) {
+    try {
+      *parts = std::make_tuple(load_part(entry->mask),
+                               load_part(entry->image));
+      return true;
+    } catch (ExceptionFreeserf &e) {
+      Log::Warn["data"] << e.get_description() << " at sprite " << id;
+      return false;
+    }
+  }
+
+  auto it = added.find(id);
+  if (it != added.end()) {
+    PSprite mask = std::get<0>(it->second);
+    PSprite image = std::get<1>(it->second);
+    *parts = std::make_tuple(mask ? mask->copy() : nullptr,
+                             image ? image->copy() : nullptr);
+    return true;
+  }
+
+  return false;
+}
+
+void
+SpriteCache::add(uint64_t id, const DataSource::MaskImage &parts) {
+  std::lock_guard<std::mutex> lock(mutex);
+  added[id] = parts;
+}
+
+bool
+SpriteCache::contains(uint64_t id) {
+  std::lock_guard<std::mutex> lock(mutex);
+  return (find(id) != nullptr) || (added.find(id) != added.end());
+}
+
+size_t
+SpriteCache::get_count() {
+  std::lock_guard<std::mutex> lock(mutex);
+  size_t count = entry_count;
+  for (const auto &sprite : added) {
+    if (find(sprite.first) == nullptr) {
+      count++;
+    }
+  }
+  return count;
+}
+
+void
+SpriteCache::populate(PDataSource source) {
+  size_t decoded = 0;
+  for (int r = Data::AssetNone; r <= Data::AssetCursor; r++) {
+    Data::Resource res = static_cast<Data::Resource>(r);
+    if (Data::get_resource_type(res) != Data::TypeSprite) {
+      continue;
+    }
+    for (size_t i = 0; i < Data::get_resource_count(res); i++) {
+      uint64_t id = get_id(res, i);
+      if (contains(id)) {
+        continue;
+      }
+      try {
+        add(id, source->get_decoded_sprite_parts(res, i));
+        decoded++;
+      } catch (ExceptionFreeserf &e) {
+        /* Left to fail when it is drawn. */
+        Log::Debug["data"] << "Sprite " << Data::get_resource_name(res)
+                           << " #" << i << " not cached: "
+                           << e.get_description();
+      }
+    }
+  }
+
+  if (decoded == 0) {
+    return;
+  }
+
+  if (save()) {
+    Log::Info["data"] << "Saved " << decoded << " sprites to sprite cache '"
+                      << path << "'";
+  }
+}
+
+uint64_t
+SpriteCache::get_id(Data::Resource res, size_t index) {
+  return Sprite::create_id(res, index, 0, 0, {0, 0, 0, 0});
+}
+
+size_t
+SpriteCache::get_total_count() {
+  size_t count = 0;
+  for (int r = Data::AssetNone; r <= Data::AssetCursor; r++) {
+    Data::Resource res = static_cast<Data::Resource>(r);
+    if (Data::get_resource_type(res) == Data::TypeSprite) {
+      count += Data::get_resource_count(res);
+    }
+  }
+  return count;
+}
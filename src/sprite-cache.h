@@ -0,0 +1,110 @@
+/*
+ * sprite-cache.h - File of decoded sprites kept between runs
+ *
+ * Copyright (C) 2026  freeserf developers
+ *
+ * This file is part of freeserf.
+ *
+ * freeserf is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * freeserf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with freeserf.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SRC_SPRITE_CACHE_H_
+#define SRC_SPRITE_CACHE_H_
+
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <string>
+
+#include "src/data-source.h"
+#include "src/mapped-file.h"
+
+// Decoded parts of the sprites of a data source, stored in a file that is
+// mapped into memory. The file is keyed by the hash of the data files so
+// it is rebuilt when they change. Sprites that are decoded while it is
+// open are added in memory until the file is saved again.
+class SpriteCache {
+ protected:
+  typedef struct Part {
+    uint32_t width;
+    uint32_t height;
+    int32_t delta_x;
+    int32_t delta_y;
+    int32_t offset_x;
+    int32_t offset_y;
+    /* Offset of the BGRA pixels in the file, zero for no part. */
+    uint64_t offset;
+  } Part;
+
+  typedef struct Entry {
+    uint64_t id;
+    Part mask;
+    Part image;
+  } Entry;
+
+  typedef struct Header {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t data_hash;
+    uint64_t entry_count;
+  } Header;
+
+  std::string path;
+  uint64_t data_hash;
+
+  std::mutex mutex;
+  std::unique_ptr<MappedFile> file;
+  const Entry *entries;
+  size_t entry_count;
+  std::map<uint64_t, DataSource::MaskImage> added;
+
+ public:
+  SpriteCache(const std::string &path, uint64_t data_hash);
+  virtual ~SpriteCache();
+
+  /* Map the file if it exists and belongs to the data. Returns false if
+     there is no usable file; the cache is empty then. */
+  bool open();
+  /* Write the file with all sprites, replacing the old one. */
+  bool save();
+
+  /* Copy of the parts of a sprite. Returns false if they are not cached;
+     parts that the sprite does not have are cached as null. */
+  bool get(uint64_t id, DataSource::MaskImage *parts);
+  void add(uint64_t id, const DataSource::MaskImage &parts);
+  bool contains(uint64_t id);
+  size_t get_count();
+
+  /* Decode the sprites of source that are missing and save the file.
+     Meant to be run in the background. */
+  void populate(PDataSource source);
+
+  static uint64_t get_id(Data::Resource res, size_t index);
+  /* Number of sprites of all resources. */
+  static size_t get_total_count();
+
+ protected:
+  SpriteCache(const SpriteCache &that) = delete;
+  SpriteCache &operator = (const SpriteCache &that) = delete;
+
+  const Entry *find(uint64_t id) const;
+  bool is_valid(const Part &part) const;
+  PSprite load_part(const Part &part) const;
+  bool write(const std::string &path,
+             const std::map<uint64_t, DataSource::MaskImage> &sprites) const;
+};
+
+typedef std::shared_ptr<SpriteCache> PSpriteCache;
+
+#endif  // SRC_SPRITE_CACHE_H_
@@ -0,0 +1,646 @@
+/*
+ * sprite-kernels.cc - Per pixel operations on sprite data
+ *
+ * Copyright (C) 2026  freeserf developers
+ *
+ * This file is part of freeserf.
+ *
+ * freeserf is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * freeserf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with freeserf.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/sprite-kernels.h"
+
+#include <algorithm>
+#include <string>
+
+#include "src/debug.h"
+
+/* The vector kernels are compiled for the instruction set of each function
+   so the rest of the program does not depend on it. They are only used on
+   x86-64, where the scalar code does its double arithmetic in SSE2 too and
+   the luminance is rounded the same way. */
+#if defined(__GNUC__) && defined(__x86_64__)
+# define SPRITE_KERNELS_X86
+# include <immintrin.h>
+# define TARGET_SSE2 __attribute__((target("sse2")))
+# define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+/* Same layout as Sprite::Color. */
+typedef struct Pixel {
+  uint8_t blue;
+  uint8_t green;
+  uint8_t red;
+  uint8_t alpha;
+} Pixel;
+
+#define UNMULTIPLY(color, a) ((0xFF * (color)) / (a))
+#define BLEND(back, front, a) (((front) * (a)) + ((back) * (0xFF - (a)))) / 0xFF
+
+// Scalar kernels. These are the reference for the others.
+
+static void
+mask_scalar(uint32_t *dest, const uint32_t *a, const uint32_t *b,
+            size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    dest[i] = a[i] & b[i];
+  }
+}
+
+static void
+compare_scalar(uint32_t *dest, const uint32_t *a, const uint32_t *b,
+               size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    dest[i] = (a[i] == b[i]) ? 0x00000000 : 0xFFFFFFFF;
+  }
+}
+
+static void
+fill_masked_scalar(uint32_t *dest, uint32_t color, size_t count) {
+  const Pixel *p = reinterpret_cast<const Pixel*>(dest);
+  for (size_t i = 0; i < count; i++) {
+    if (p[i].alpha != 0x00) {
+      dest[i] = color;
+    }
+  }
+}
+
+static void
+add_scalar(uint32_t *dest, const uint32_t *src, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    dest[i] += src[i];
+  }
+}
+
+static void
+del_scalar(uint32_t *dest, const uint32_t *src, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    if (src[i] == 0xFFFFFFFF) {
+      dest[i] = 0x00000000;
+    }
+  }
+}
+
+static void
+blend_scalar(uint32_t *dest, const uint32_t *src, size_t count) {
+  Pixel *c = reinterpret_cast<Pixel*>(dest);
+  const Pixel *o = reinterpret_cast<const Pixel*>(src);
+  for (size_t i = 0; i < count; i++, c++, o++) {
+    const uint32_t alpha = o->alpha;
+
+    if (alpha == 0x00) {
+      continue;
+    }
+
+    if (alpha == 0xFF) {
+      *c = *o;
+      continue;
+    }
+
+    const uint8_t frontR = UNMULTIPLY(o->red, alpha);
+    const uint8_t frontG = UNMULTIPLY(o->green, alpha);
+    const uint8_t frontB = UNMULTIPLY(o->blue, alpha);
+
+    const uint32_t R = BLEND(c->red, frontR, alpha);
+    const uint32_t G = BLEND(c->green, frontG, alpha);
+    const uint32_t B = BLEND(c->blue, frontB, alpha);
+
+    *c = {(uint8_t)B, (uint8_t)G, (uint8_t)R, 0xFF};
+  }
+}
+
+static void
+stick_scalar(uint32_t *dest, const uint32_t *src, size_t count) {
+  const Pixel *p = reinterpret_cast<const Pixel*>(src);
+  for (size_t i = 0; i < count; i++) {
+    if (p[i].alpha != 0x00) {
+      dest[i] = src[i];
+    }
+  }
+}
+
+static uint8_t
+alpha_from_luminance_scalar(uint32_t *dest, size_t count) {
+  Pixel *c = reinterpret_cast<Pixel*>(dest);
+  uint8_t min = 0xFF;
+  for (size_t i = 0; i < count; i++, c++) {
+    if (c->alpha != 0x00) {
+      c->alpha = 0xff - static_cast<uint8_t>((0.21 * c->red) +
+                                             (0.72 * c->green) +
+                                             (0.07 * c->blue));
+      c->red = 0;
+      c->green = 0;
+      c->blue = 0;
+      min = std::min(min, c->alpha);
+    }
+  }
+  return min;
+}
+
+static void
+lower_alpha_scalar(uint32_t *dest, uint8_t amount, size_t count) {
+  Pixel *c = reinterpret_cast<Pixel*>(dest);
+  for (size_t i = 0; i < count; i++, c++) {
+    if (c->alpha != 0x00) {
+      c->alpha = c->alpha - amount;
+    }
+  }
+}
+
+#ifdef SPRITE_KERNELS_X86
+
+// SSE2 kernels, four pixels at a time. The remainder is left to the scalar
+// kernels.
+
+TARGET_SSE2 static inline __m128i
+load_sse2(const uint32_t *p) {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+
+TARGET_SSE2 static inline void
+store_sse2(uint32_t *p, __m128i v) {
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v);
+}
+
+/* Bits of a where mask is set, of b elsewhere. */
+TARGET_SSE2 static inline __m128i
+select_sse2(__m128i mask, __m128i a, __m128i b) {
+  return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+TARGET_SSE2 static inline __m128i
+visible_sse2(__m128i v) {
+  __m128i transparent = _mm_cmpeq_epi32(_mm_srli_epi32(v, 24),
+                                        _mm_setzero_si128());
+  return _mm_xor_si128(transparent, _mm_set1_epi32(-1));
+}
+
+TARGET_SSE2 static void
+mask_sse2(uint32_t *dest, const uint32_t *a, const uint32_t *b,
+          size_t count) {
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    store_sse2(dest + i, _mm_and_si128(load_sse2(a + i), load_sse2(b + i)));
+  }
+  mask_scalar(dest + i, a + i, b + i, count - i);
+}
+
+TARGET_SSE2 static void
+compare_sse2(uint32_t *dest, const uint32_t *a, const uint32_t *b,
+             size_t count) {
+  const __m128i ones = _mm_set1_epi32(-1);
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128i equal = _mm_cmpeq_epi32(load_sse2(a + i), load_sse2(b + i));
+    store_sse2(dest + i, _mm_xor_si128(equal, ones));
+  }
+  compare_scalar(dest + i, a + i, b + i, count - i);
+}
+
+TARGET_SSE2 static void
+fill_masked_sse2(uint32_t *dest, uint32_t color, size_t count) {
+  const __m128i c = _mm_set1_epi32(static_cast<int>(color));
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128i v = load_sse2(dest + i);
+    store_sse2(dest + i, select_sse2(visible_sse2(v), c, v));
+  }
+  fill_masked_scalar(dest + i, color, count - i);
+}
+
+TARGET_SSE2 static void
+add_sse2(uint32_t *dest, const uint32_t *src, size_t count) {
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    store_sse2(dest + i, _mm_add_epi32(load_sse2(dest + i),
+                                       load_sse2(src + i)));
+  }
+  add_scalar(dest + i, src + i, count - i);
+}
+
+TARGET_SSE2 static void
+del_sse2(uint32_t *dest, const uint32_t *src, size_t count) {
+  const __m128i ones = _mm_set1_epi32(-1);
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128i full = _mm_cmpeq_epi32(load_sse2(src + i), ones);
+    store_sse2(dest + i, _mm_andnot_si128(full, load_sse2(dest + i)));
+  }
+  del_scalar(dest + i, src + i, count - i);
+}
+
+/* The channel of each pixel at shift, unmultiplied by alpha the way the
+   scalar code does in integers. The quotient of integers below 2^16 is
+   exact in single precision after truncation. */
+TARGET_SSE2 static inline __m128i
+unmultiply_sse2(__m128i v, int shift, __m128 alpha) {
+  const __m128i ff = _mm_set1_epi32(0xFF);
+  __m128i color = _mm_and_si128(_mm_srli_epi32(v, shift), ff);
+  /* Both factors are below 2^16 so the 16 bit product is exact. */
+  __m128 scaled = _mm_cvtepi32_ps(_mm_mullo_epi16(color, ff));
+  __m128i front = _mm_cvttps_epi32(_mm_div_ps(scaled, alpha));
+  return _mm_and_si128(front, ff);
+}
+
+/* (front * alpha + back * (0xFF - alpha)) / 0xFF for the channel at shift.
+   The sum is at most 0xFF * 0xFF, where x / 0xFF is
+   (x + 1 + (x >> 8)) >> 8. */
+TARGET_SSE2 static inline __m128i
+blend_channel_sse2(__m128i back, __m128i front, int shift, __m128i alpha,
+                   __m128i inverse, __m128 alpha_ps) {
+  const __m128i ff = _mm_set1_epi32(0xFF);
+  __m128i f = unmultiply_sse2(front, shift, alpha_ps);
+  __m128i b = _mm_and_si128(_mm_srli_epi32(back, shift), ff);
+  __m128i x = _mm_add_epi32(_mm_mullo_epi16(f, alpha),
+                            _mm_mullo_epi16(b, inverse));
+  x = _mm_add_epi32(x, _mm_add_epi32(_mm_set1_epi32(1),
+                                     _mm_srli_epi32(x, 8)));
+  return _mm_slli_epi32(_mm_srli_epi32(x, 8), shift);
+}
+
+TARGET_SSE2 static void
+blend_sse2(uint32_t *dest, const uint32_t *src, size_t count) {
+  const __m128i ff = _mm_set1_epi32(0xFF);
+  const __m128i opaque = _mm_set1_epi32(static_cast<int>(0xFF000000));
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128i c = load_sse2(dest + i);
+    __m128i o = load_sse2(src + i);
+    __m128i alpha = _mm_srli_epi32(o, 24);
+    __m128i inverse = _mm_sub_epi32(ff, alpha);
+    __m128 alpha_ps = _mm_cvtepi32_ps(alpha);
+
+    __m128i result = opaque;
+    for (int shift = 0; shift <= 16; shift += 8) {
+      result = _mm_or_si128(result, blend_channel_sse2(c, o, shift, alpha,
+                                                       inverse, alpha_ps));
+    }
+
+    __m128i transparent = _mm_cmpeq_epi32(alpha, _mm_setzero_si128());
+    __m128i solid = _mm_cmpeq_epi32(alpha, ff);
+    result = select_sse2(solid, o, result);
+    store_sse2(dest + i, select_sse2(transparent, c, result));
+  }
+  blend_scalar(dest + i, src + i, count - i);
+}
+
+TARGET_SSE2 static void
+stick_sse2(uint32_t *dest, const uint32_t *src, size_t count) {
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128i s = load_sse2(src + i);
+    store_sse2(dest + i, select_sse2(visible_sse2(s), s, load_sse2(dest + i)));
+  }
+  stick_scalar(dest + i, src + i, count - i);
+}
+
+/* Luminance of two pixels, in double precision and in the same order of
+   operations as the scalar code. */
+TARGET_SSE2 static inline __m128i
+luminance_sse2(__m128i r, __m128i g, __m128i b) {
+  __m128d l = _mm_add_pd(_mm_mul_pd(_mm_set1_pd(0.21), _mm_cvtepi32_pd(r)),
+                         _mm_mul_pd(_mm_set1_pd(0.72), _mm_cvtepi32_pd(g)));
+  l = _mm_add_pd(l, _mm_mul_pd(_mm_set1_pd(0.07), _mm_cvtepi32_pd(b)));
+  return _mm_cvttpd_epi32(l);
+}
+
+TARGET_SSE2 static uint8_t
+alpha_from_luminance_sse2(uint32_t *dest, size_t count) {
+  const __m128i ff = _mm_set1_epi32(0xFF);
+  __m128i min = ff;
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128i v = load_sse2(dest + i);
+    __m128i r = _mm_and_si128(_mm_srli_epi32(v, 16), ff);
+    __m128i g = _mm_and_si128(_mm_srli_epi32(v, 8), ff);
+    __m128i b = _mm_and_si128(v, ff);
+    __m128i low = luminance_sse2(r, g, b);
+    __m128i high = luminance_sse2(_mm_unpackhi_epi64(r, r),
+                                  _mm_unpackhi_epi64(g, g),
+                                  _mm_unpackhi_epi64(b, b));
+    __m128i alpha = _mm_sub_epi32(ff, _mm_unpacklo_epi64(low, high));
+
+    __m128i visible = visible_sse2(v);
+    store_sse2(dest + i, select_sse2(visible, _mm_slli_epi32(alpha, 24), v));
+    min = _mm_min_epi16(min, select_sse2(visible, alpha, ff));
+  }
+
+  uint32_t lanes[4];
+  store_sse2(lanes, min);
+  uint8_t result = alpha_from_luminance_scalar(dest + i, count - i);
+  for (int j = 0; j < 4; j++) {
+    result = std::min(result, static_cast<uint8_t>(lanes[j]));
+  }
+  return result;
+}
+
+TARGET_SSE2 static void
+lower_alpha_sse2(uint32_t *dest, uint8_t amount, size_t count) {
+  const __m128i a = _mm_set1_epi32(static_cast<int>(amount) << 24);
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128i v = load_sse2(dest + i);
+    /* Only the top byte changes; a borrow wraps like the scalar byte. */
+    store_sse2(dest + i,
+               _mm_sub_epi32(v, _mm_and_si128(visible_sse2(v), a)));
+  }
+  lower_alpha_scalar(dest + i, amount, count - i);
+}
+
+// AVX2 kernels, eight pixels at a time, the same way as the SSE2 ones.
+
+TARGET_AVX2 static inline __m256i
+load_avx2(const uint32_t *p) {
+  return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+}
+
+TARGET_AVX2 static inline void
+store_avx2(uint32_t *p, __m256i v) {
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v);
+}
+
+TARGET_AVX2 static inline __m256i
+select_avx2(__m256i mask, __m256i a, __m256i b) {
+  return _mm256_blendv_epi8(b, a, mask);
+}
+
+TARGET_AVX2 static inline __m256i
+visible_avx2(__m256i v) {
+  __m256i transparent = _mm256_cmpeq_epi32(_mm256_srli_epi32(v, 24),
+                                           _mm256_setzero_si256());
+  return _mm256_xor_si256(transparent, _mm256_set1_epi32(-1));
+}
+
+TARGET_AVX2 static void
+mask_avx2(uint32_t *dest, const uint32_t *a, const uint32_t *b,
+          size_t count) {
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    store_avx2(dest + i, _mm256_and_si256(load_avx2(a + i),
+                                          load_avx2(b + i)));
+  }
+  mask_scalar(dest + i, a + i, b + i, count - i);
+}
+
+TARGET_AVX2 static void
+compare_avx2(uint32_t *dest, const uint32_t *a, const uint32_t *b,
+             size_t count) {
+  const __m256i ones = _mm256_set1_epi32(-1);
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256i equal = _mm256_cmpeq_epi32(load_avx2(a + i), load_avx2(b + i));
+    store_avx2(dest + i, _mm256_xor_si256(equal, ones));
+  }
+  compare_scalar(dest + i, a + i, b + i, count - i);
+}
+
+TARGET_AVX2 static void
+fill_masked_avx2(uint32_t *dest, uint32_t color, size_t count) {
+  const __m256i c = _mm256_set1_epi32(static_cast<int>(color));
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256i v = load_avx2(dest + i);
+    store_avx2(dest + i, select_avx2(visible_avx2(v), c, v));
+  }
+  fill_masked_scalar(dest + i, color, count - i);
+}
+
+TARGET_AVX2 static void
+add_avx2(uint32_t *dest, const uint32_t *src, size_t count) {
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    store_avx2(dest + i, _mm256_add_epi32(load_avx2(dest + i),
+                                          load_avx2(src + i)));
+  }
+  add_scalar(dest + i, src + i, count - i);
+}
+
+TARGET_AVX2 static void
+del_avx2(uint32_t *dest, const uint32_t *src, size_t count) {
+  const __m256i ones = _mm256_set1_epi32(-1);
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256i full = _mm256_cmpeq_epi32(load_avx2(src + i), ones);
+    store_avx2(dest + i, _mm256_andnot_si256(full, load_avx2(dest + i)));
+  }
+  del_scalar(dest + i, src + i, count - i);
+}
+
+TARGET_AVX2 static inline __m256i
+blend_channel_avx2(__m256i back, __m256i front, int shift, __m256i alpha,
+                   __m256i inverse, __m256 alpha_ps) {
+  const __m256i ff = _mm256_set1_epi32(0xFF);
+  __m256i f = _mm256_and_si256(_mm256_srli_epi32(front, shift), ff);
+  __m256 scaled = _mm256_cvtepi32_ps(_mm256_mullo_epi16(f, ff));
+  f = _mm256_and_si256(_mm256_cvttps_epi32(_mm256_div_ps(scaled, alpha_ps)),
+                       ff);
+  __m256i b = _mm256_and_si256(_mm256_srli_epi32(back, shift), ff);
+  __m256i x = _mm256_add_epi32(_mm256_mullo_epi16(f, alpha),
+                               _mm256_mullo_epi16(b, inverse));
+  x = _mm256_add_epi32(x, _mm256_add_epi32(_mm256_set1_epi32(1),
+                                           _mm256_srli_epi32(x, 8)));
+  return _mm256_slli_epi32(_mm256_srli_epi32(x, 8), shift);
+}
+
+TARGET_AVX2 static void
+blend_avx2(uint32_t *dest, const uint32_t *src, size_t count) {
+  const __m256i ff = _mm256_set1_epi32(0xFF);
+  const __m256i opaque = _mm256_set1_epi32(static_cast<int>(0xFF000000));
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256i c = load_avx2(dest + i);
+    __m256i o = load_avx2(src + i);
+    __m256i alpha = _mm256_srli_epi32(o, 24);
+    __m256i inverse = _mm256_sub_epi32(ff, alpha);
+    __m256 alpha_ps = _mm256_cvtepi32_ps(alpha);
+
+    __m256i result = opaque;
+    for (int shift = 0; shift <= 16; shift += 8) {
+      result = _mm256_or_si256(result,
+                               blend_channel_avx2(c, o, shift, alpha,
+                                                  inverse, alpha_ps));
+    }
+
+    __m256i transparent = _mm256_cmpeq_epi32(alpha, _mm256_setzero_si256());
+    __m256i solid = _mm256_cmpeq_epi32(alpha, ff);
+    result = select_avx2(solid, o, result);
+    store_avx2(dest + i, select_avx2(transparent, c, result));
+  }
+  blend_scalar(dest + i, src + i, count - i);
+}
+
+TARGET_AVX2 static void
+stick_avx2(uint32_t *dest, const uint32_t *src, size_t count) {
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256i s = load_avx2(src + i);
+    store_avx2(dest + i,
+               select_avx2(visible_avx2(s), s, load_avx2(dest + i)));
+  }
+  stick_scalar(dest + i, src + i, count - i);
+}
+
+TARGET_AVX2 static inline __m128i
+luminance_avx2(__m128i r, __m128i g, __m128i b) {
+  __m256d l = _mm256_add_pd(
+                _mm256_mul_pd(_mm256_set1_pd(0.21), _mm256_cvtepi32_pd(r)),
+                _mm256_mul_pd(_mm256_set1_pd(0.72), _mm256_cvtepi32_pd(g)));
+  l = _mm256_add_pd(l, _mm256_mul_pd(_mm256_set1_pd(0.07),
+                                     _mm256_cvtepi32_pd(b)));
+  return _mm256_cvttpd_epi32(l);
+}
+
+TARGET_AVX2 static uint8_t
+alpha_from_luminance_avx2(uint32_t *dest, size_t count) {
+  const __m256i ff = _mm256_set1_epi32(0xFF);
+  __m256i min = ff;
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256i v = load_avx2(dest + i);
+    __m256i r = _mm256_and_si256(_mm256_srli_epi32(v, 16), ff);
+    __m256i g = _mm256_and_si256(_mm256_srli_epi32(v, 8), ff);
+    __m256i b = _mm256_and_si256(v, ff);
+    __m128i low = luminance_avx2(_mm256_castsi256_si128(r),
+                                 _mm256_castsi256_si128(g),
+                                 _mm256_castsi256_si128(b));
+    __m128i high = luminance_avx2(_mm256_extracti128_si256(r, 1),
+                                  _mm256_extracti128_si256(g, 1),
+                                  _mm256_extracti128_si256(b, 1));
+    __m256i l = _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+    __m256i alpha = _mm256_sub_epi32(ff, l);
+
+    __m256i visible = visible_avx2(v);
+    store_avx2(dest + i,
+               select_avx2(visible, _mm256_slli_epi32(alpha, 24), v));
+    min = _mm256_min_epu32(min, select_avx2(visible, alpha, ff));
+  }
+
+  uint32_t lanes[8];
+  store_avx2(lanes, min);
+  uint8_t result = alpha_from_luminance_scalar(dest + i, count - i);
+  for (int j = 0; j < 8; j++) {
+    result = std::min(result, static_cast<uint8_t>(lanes[j]));
+  }
+  return result;
+}
+
+TARGET_AVX2 static void
+lower_alpha_avx2(uint32_t *dest, uint8_t amount, size_t count) {
+  const __m256i a = _mm256_set1_epi32(static_cast<int>(amount) << 24);
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256i v = load_avx2(dest + i);
+    store_avx2(dest + i,
+               _mm256_sub_epi32(v, _mm256_and_si256(visible_avx2(v), a)));
+  }
+  lower_alpha_scalar(dest + i, amount, count - i);
+}
+
+#endif  // SPRITE_KERNELS_X86
+
+SpriteKernels::SpriteKernels(Level level)
+  : level(level)
+  , mask_(mask_scalar)
+  , compare_(compare_scalar)
+  , fill_masked_(fill_masked_scalar)
+  , add_(add_scalar)
+  , del_(del_scalar)
+  , blend_(blend_scalar)
+  , stick_(stick_scalar)
+  , alpha_from_luminance_(alpha_from_luminance_scalar)
+  , lower_alpha_(lower_alpha_scalar) {
+#ifdef SPRITE_KERNELS_X86
+  switch (level) {
+    case LevelSSE2:
+      mask_ = mask_sse2;
+      compare_ = compare_sse2;
+      fill_masked_ = fill_masked_sse2;
+      add_ = add_sse2;
+      del_ = del_sse2;
+      blend_ = blend_sse2;
+      stick_ = stick_sse2;
+      alpha_from_luminance_ = alpha_from_luminance_sse2;
+      lower_alpha_ = lower_alpha_sse2;
+      break;
+    case LevelAVX2:
+      mask_ = mask_avx2;
+      compare_ = compare_avx2;
+      fill_masked_ = fill_masked_avx2;
+      add_ = add_avx2;
+      del_ = del_avx2;
+      blend_ = blend_avx2;
+      stick_ = stick_avx2;
+      alpha_from_luminance_ = alpha_from_luminance_avx2;
+      lower_alpha_ = lower_alpha_avx2;
+      break;
+    default:
+      break;
+  }
+#endif
+}
+
+SpriteKernels &
+SpriteKernels::get_instance() {
+  /* Sprites are composed on the thread pool too. */
+  static SpriteKernels kernels(get_best_level());
+  return kernels;
+}
+
+bool
+SpriteKernels::is_supported(Level level) {
+  switch (level) {
+    case LevelScalar:
+      return true;
+#ifdef SPRITE_KERNELS_X86
+    case LevelSSE2:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("sse2");
+    case LevelAVX2:
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("avx2");
+#endif
+    default:
+      return false;
+  }
+}
+
+SpriteKernels::Level
+SpriteKernels::get_best_level() {
+  if (is_supported(LevelAVX2)) {
+    return LevelAVX2;
+  }
+  if (is_supported(LevelSSE2)) {
+    return LevelSSE2;
+  }
+  return LevelScalar;
+}
+
+const char *
+SpriteKernels::get_level_name(Level level) {
+  switch (level) {
+    case LevelScalar: return "scalar";
+    case LevelSSE2: return "SSE2";
+    case LevelAVX2: return "AVX2";
+    default: return "unknown";
+  }
+}
+
+SpriteKernels
+SpriteKernels::get_kernels(Level level) {
+  if (!is_supported(level)) {
+    throw ExceptionFreeserf(std::string("Sprite kernels not supported: ") +
+                            get_level_name(level));
+  }
+  return SpriteKernels(level);
+}
@@ -0,0 +1,103 @@
+/*
+ * sprite-kernels.h - Per pixel operations on sprite data
+ *
+ * Copyright (C) 2026  freeserf developers
+ *
+ * This file is part of freeserf.
+ *
+ * freeserf is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * freeserf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with freeserf.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SRC_SPRITE_KERNELS_H_
+#define SRC_SPRITE_KERNELS_H_
+
+#include <cstddef>
+#include <cstdint>
+
+// Loops over runs of BGRA pixels, as stored in sprites, that the sprite
+// compositing is built from. There is an implementation for each level of
+// vector instructions; all of them give exactly the same pixels. The best
+// one that the CPU supports is picked when first used.
+class SpriteKernels {
+ public:
+  typedef enum Level {
+    LevelScalar,
+    LevelSSE2,
+    LevelAVX2,
+  } Level;
+
+  typedef void (*Combine)(uint32_t *dest, const uint32_t *a,
+                          const uint32_t *b, size_t count);
+  typedef void (*Apply)(uint32_t *dest, const uint32_t *src, size_t count);
+  typedef void (*Fill)(uint32_t *dest, uint32_t color, size_t count);
+  typedef uint8_t (*Luminance)(uint32_t *dest, size_t count);
+  typedef void (*Lower)(uint32_t *dest, uint8_t amount, size_t count);
+
+ protected:
+  Level level;
+  Combine mask_;
+  Combine compare_;
+  Fill fill_masked_;
+  Apply add_;
+  Apply del_;
+  Apply blend_;
+  Apply stick_;
+  Luminance alpha_from_luminance_;
+  Lower lower_alpha_;
+
+  explicit SpriteKernels(Level level);
+
+ public:
+  /* Kernels of the best level supported. */
+  static SpriteKernels &get_instance();
+  /* Whether the build and the CPU support the level. */
+  static bool is_supported(Level level);
+  static Level get_best_level();
+  static const char *get_level_name(Level level);
+  /* Kernels of a level that is supported, for testing and benchmarks. */
+  static SpriteKernels get_kernels(Level level);
+
+  Level get_level() const { return level; }
+
+  /* dest = a & b */
+  void mask(uint32_t *dest, const uint32_t *a, const uint32_t *b,
+            size_t count) const { mask_(dest, a, b, count); }
+  /* dest = 0 where a and b are equal, all ones elsewhere. */
+  void compare(uint32_t *dest, const uint32_t *a, const uint32_t *b,
+               size_t count) const { compare_(dest, a, b, count); }
+  /* Replace pixels that are not fully transparent by color. */
+  void fill_masked(uint32_t *dest, uint32_t color, size_t count) const {
+    fill_masked_(dest, color, count); }
+  /* dest += src, per 32 bit pixel. */
+  void add(uint32_t *dest, const uint32_t *src, size_t count) const {
+    add_(dest, src, count); }
+  /* Clear pixels where src is all ones. */
+  void del(uint32_t *dest, const uint32_t *src, size_t count) const {
+    del_(dest, src, count); }
+  /* Blend src with premultiplied alpha onto opaque dest. */
+  void blend(uint32_t *dest, const uint32_t *src, size_t count) const {
+    blend_(dest, src, count); }
+  /* Copy the pixels of src that are not fully transparent. */
+  void stick(uint32_t *dest, const uint32_t *src, size_t count) const {
+    stick_(dest, src, count); }
+  /* Turn visible pixels black with an alpha of the inverted luminance.
+     Returns the lowest alpha of them, or 0xFF if there are none. */
+  uint8_t alpha_from_luminance(uint32_t *dest, size_t count) const {
+    return alpha_from_luminance_(dest, count); }
+  /* Subtract amount from the alpha of visible pixels. */
+  void lower_alpha(uint32_t *dest, uint8_t amount, size_t count) const {
+    lower_alpha_(dest, amount, count); }
+};
+
+#endif  // SRC_SPRITE_KERNELS_H_
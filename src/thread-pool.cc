@@ -0,0 +1,155 @@
+/*
+ * thread-pool.cc - Fixed set of worker threads running queued tasks
+ *
+ * Copyright (C) 2026  freeserf developers
+ *
+ * This file is part of freeserf.
+ *
+ * freeserf is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * freeserf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with freeserf.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/thread-pool.h"
+
+#include <algorithm>
+#include <atomic>  // NOLINT(build/c++11)
+#include <exception>
+#include <memory>
+#include <utility>
+
+ThreadPool::ThreadPool(unsigned int thread_count)
+  : busy(0)
+  , stopping(false) {
+  if (thread_count == 0) {
+    thread_count = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  for (unsigned int i = 0; i < thread_count; i++) {
+    workers.push_back(std::thread(&ThreadPool::worker, this));
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  task_added.notify_all();
+
+  for (std::thread &thread : workers) {
+    thread.join();
+  }
+}
+
+ThreadPool &
+ThreadPool::get_instance() {
+  static ThreadPool pool;
+  return pool;
+}
+
+void
+ThreadPool::run(Task task) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    tasks.push_back(std::move(task));
+  }
+  task_added.notify_one();
+}
+
+void
+ThreadPool::wait() {
+  std::unique_lock<std::mutex> lock(mutex);
+  task_done.wait(lock, [this]() { return tasks.empty() && (busy == 0); });
+}
+
+void
+ThreadPool::run_for(size_t count, const IndexTask &task) {
+  if (count == 0) {
+    return;
+  }
+
+  class Batch {
+   public:
+    const IndexTask &task;
+    size_t count;
+    std::atomic<size_t> next;
+    size_t done;
+    std::exception_ptr error;
+    std::mutex mutex;
+    std::condition_variable finished;
+
+    Batch(const IndexTask &_task, size_t _count)
+      : task(_task), count(_count), next(0), done(0) {}
+
+    /* Run calls until none are left unclaimed. */
+    void work() {
+      size_t completed = 0;
+      std::exception_ptr failure;
+      for (size_t i = next++; i < count; i = next++) {
+        try {
+          task(i);
+        } catch (...) {
+          if (!failure) failure = std::current_exception();
+        }
+        completed++;
+      }
+      if (completed == 0) return;
+
+      std::lock_guard<std::mutex> lock(mutex);
+      if (failure && !error) error = failure;
+      done += completed;
+      if (done == count) finished.notify_all();
+    }
+  };
+
+  /* Workers that start after the batch is done find nothing to claim, but
+     still hold on to it. */
+  std::shared_ptr<Batch> batch = std::make_shared<Batch>(task, count);
+  size_t helpers = std::min(count - 1, workers.size());
+  for (size_t i = 0; i < helpers; i++) {
+    run([batch]() { batch->work(); });
+  }
+  batch->work();
+
+  std::unique_lock<std::mutex> lock(batch->mutex);
+  batch->finished.wait(lock, [&batch]() {
+    return batch->done == batch->count; });
+  if (batch->error) {
+    std::rethrow_exception(batch->error);
+  }
+}
+
+void
+ThreadPool::worker() {
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true) {
+    task_added.wait(lock, [this]() { return stopping || !tasks.empty(); });
+    if (tasks.empty()) {
+      /* Stopping, and nothing left to do. */
+      return;
+    }
+
+    Task task = std::move(tasks.front());
+    tasks.pop_front();
+    busy++;
+
+    lock.unlock();
+    task();
+    lock.lock();
+
+    busy--;
+    if (tasks.empty() && (busy == 0)) {
+      task_done.notify_all();
+    }
+  }
+}
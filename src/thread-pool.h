@@ -0,0 +1,73 @@
+/*
+ * thread-pool.h - Fixed set of worker threads running queued tasks
+ *
+ * Copyright (C) 2026  freeserf developers
+ *
+ * This file is part of freeserf.
+ *
+ * freeserf is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * freeserf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with freeserf.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SRC_THREAD_POOL_H_
+#define SRC_THREAD_POOL_H_
+
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <deque>
+#include <functional>
+#include <mutex>  // NOLINT(build/c++11)
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+class ThreadPool {
+ public:
+  typedef std::function<void()> Task;
+  typedef std::function<void(size_t)> IndexTask;
+
+ protected:
+  typedef std::vector<std::thread> Workers;
+  typedef std::deque<Task> Tasks;
+
+  Workers workers;
+  Tasks tasks;
+  unsigned int busy;
+  bool stopping;
+
+  std::mutex mutex;
+  std::condition_variable task_added;
+  std::condition_variable task_done;
+
+ public:
+  /* Start thread_count workers, or one per hardware thread if zero. */
+  explicit ThreadPool(unsigned int thread_count = 0);
+  virtual ~ThreadPool();
+
+  /* Shared pool for background work of the game. */
+  static ThreadPool &get_instance();
+
+  size_t get_thread_count() const { return workers.size(); }
+
+  /* Queue task to be run on one of the workers. */
+  void run(Task task);
+  /* Wait until all queued tasks have completed. */
+  void wait();
+  /* Run task for each index below count and wait for just those calls.
+     The calling thread takes part, so this may be used from a task of the
+     pool itself. The first exception thrown by a call is rethrown. */
+  void run_for(size_t count, const IndexTask &task);
+
+ protected:
+  void worker();
+};
+
+#endif  // SRC_THREAD_POOL_H_
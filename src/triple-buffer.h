@@ -0,0 +1,78 @@
+/*
+ * triple-buffer.h - Lock-free single producer, single consumer buffer
+ *
+ * Copyright (C) 2026  freeserf developers
+ *
+ * This file is part of freeserf.
+ *
+ * freeserf is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * freeserf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with freeserf.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SRC_TRIPLE_BUFFER_H_
+#define SRC_TRIPLE_BUFFER_H_
+
+#include <atomic>  // NOLINT(build/c++11)
+
+// Passes values from one producer thread to one consumer thread without
+// locking. The producer fills the back buffer and publishes it, the consumer
+// fetches the most recently published value into the front buffer. Neither
+// side ever waits for the other; values published faster than they are
+// fetched are dropped.
+template<class T>
+class TripleBuffer {
+ protected:
+  static const unsigned int index_mask = 3;
+  static const unsigned int fresh_bit = 4;
+
+  T buffers[3];
+  unsigned int back;
+  std::atomic<unsigned int> middle;
+  unsigned int front;
+
+ public:
+  TripleBuffer() : back(0), middle(1), front(2) {}
+
+  // Producer side.
+  T &get_back() { return buffers[back]; }
+
+  // Make the back buffer available to the consumer. Returns true if the
+  // previously published value was never fetched; that value is now in the
+  // back buffer so the producer can carry over whatever it must not lose.
+  bool publish() {
+    unsigned int prev = middle.exchange(back | fresh_bit);
+    back = prev & index_mask;
+    return (prev & fresh_bit) != 0;
+  }
+
+  // Whether the last published value is still waiting to be fetched.
+  bool is_pending() const {
+    return (middle.load() & fresh_bit) != 0;
+  }
+
+  // Consumer side.
+  T &get_front() { return buffers[front]; }
+
+  // Move the most recently published value to the front buffer. Returns false
+  // if nothing was published since the last fetch.
+  bool fetch() {
+    if ((middle.load() & fresh_bit) == 0) {
+      return false;
+    }
+    unsigned int prev = middle.exchange(front);
+    front = prev & index_mask;
+    return true;
+  }
+};
+
+#endif  // SRC_TRIPLE_BUFFER_H_
@@ -21,10 +21,18 @@
 
 #include "src/video-sdl.h"
 
+#include <algorithm>
 #include <sstream>
 
 #include <SDL.h>
 
+/* Size of atlas pages, limited by the renderer, and of the largest image
+   that is packed into them. */
+#define ATLAS_PAGE_SIZE    1024
+#define ATLAS_IMAGE_LIMIT  256
+/* Images are kept apart so filtering never picks up their neighbours. */
+#define ATLAS_PADDING      1
+
 ExceptionSDL::ExceptionSDL(const std::string &description) throw()
   : ExceptionVideo(description) {
   sdl_error = SDL_GetError();
@@ -43,6 +51,18 @@ VideoSDL::VideoSDL() {
   cursor = nullptr;
   fullscreen = false;
   zoom_factor = 1.f;
+  atlas_size = ATLAS_PAGE_SIZE;
+  batch_texture = nullptr;
+  render_target = nullptr;
+  render_target_valid = false;
+  render_clip = { 0, 0, 0, 0 };
+  render_clipped = false;
+  blend_mode = SDL_BLENDMODE_NONE;
+  blend_mode_valid = false;
+  stats = DrawStats{0, 0, 0, 0, 0};
+  last_stats = stats;
+  total_stats = stats;
+  frames = 0;
 
   Log::Info["video"] << "Initializing \"sdl\".";
   Log::Info["video"] << "Available drivers:";
@@ -94,6 +114,12 @@ VideoSDL::VideoSDL() {
   }
   SDL_PixelFormatEnumToMasks(pixel_format, &bpp,
                              &Rmask, &Gmask, &Bmask, &Amask);
+  if (render_info.max_texture_width > 0) {
+    atlas_size = std::min(atlas_size, render_info.max_texture_width);
+  }
+  if (render_info.max_texture_height > 0) {
+    atlas_size = std::min(atlas_size, render_info.max_texture_height);
+  }
 
   /* Set scaling mode */
   SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "linear");
@@ -105,6 +131,17 @@ VideoSDL::VideoSDL() {
 }
 
 VideoSDL::~VideoSDL() {
+  if (frames > 0) {
+    Log::Debug["video"] << "Drew " << frames << " frames with "
+                        << total_stats.images / frames << " images, "
+                        << total_stats.draw_calls / frames << " draw calls and "
+                        << total_stats.state_changes / frames
+                        << " state changes per frame";
+  }
+  for (AtlasPage &page : atlas_pages) {
+    SDL_DestroyTexture(page.texture);
+  }
+  atlas_pages.clear();
   if (screen != nullptr) {
     delete screen;
     screen = nullptr;
@@ -114,7 +151,7 @@ VideoSDL::~VideoSDL() {
 }
 
 Video &
-Video::get_instance() {
+Video::get_platform_instance() {
   static VideoSDL instance;
   return instance;
 }
@@ -140,11 +177,15 @@ VideoSDL::set_resolution(unsigned int width, unsigned int height, bool fs) {
   }
 
   if (screen == nullptr) {
-    screen = new Video::Frame();
+    screen = new FrameSDL();
   }
 
   /* Allocate new screen surface and texture */
+  flush_batch();
   if (screen->texture != nullptr) {
+    if (render_target == screen->texture) {
+      render_target_valid = false;
+    }
     SDL_DestroyTexture(screen->texture);
   }
   screen->texture = create_texture(width, height);
@@ -191,32 +232,141 @@ VideoSDL::get_screen_frame() {
 
 Video::Frame *
 VideoSDL::create_frame(unsigned int width, unsigned int height) {
-  Video::Frame *frame = new Video::Frame;
+  FrameSDL *frame = new FrameSDL();
   frame->texture = create_texture(width, height);
   return frame;
 }
 
 void
-VideoSDL::destroy_frame(Video::Frame *frame) {
+VideoSDL::destroy_frame(Video::Frame *video_frame) {
+  FrameSDL *frame = static_cast<FrameSDL*>(video_frame);
+  flush_batch();
+  if (render_target == frame->texture) {
+    render_target_valid = false;
+  }
   SDL_DestroyTexture(frame->texture);
   delete frame;
 }
 
 Video::Image *
-VideoSDL::create_image(void *data, unsigned int width, unsigned int height) {
-  Video::Image *image = new Video::Image();
+VideoSDL::create_image(void *data, unsigned int width, unsigned int height,
+                       bool pack) {
+  ImageSDL *image = new ImageSDL();
   image->w = width;
   image->h = height;
+  image->rect = { 0, 0, static_cast<int>(width), static_cast<int>(height) };
+
+  if (pack && width <= ATLAS_IMAGE_LIMIT && height <= ATLAS_IMAGE_LIMIT) {
+    SDL_Surface *surf = create_surface_from_data(data, width, height);
+    bool packed = pack_image(image, surf);
+    SDL_FreeSurface(surf);
+    if (packed) {
+      return image;
+    }
+  }
+
   image->texture = create_texture_from_data(data, width, height);
   return image;
 }
 
 void
-VideoSDL::destroy_image(Video::Image *image) {
-  SDL_DestroyTexture(image->texture);
+VideoSDL::destroy_image(Video::Image *video_image) {
+  ImageSDL *image = static_cast<ImageSDL*>(video_image);
+  if (image->texture == batch_texture) {
+    flush_batch();
+  }
+  if (image->packed) {
+    release_packed_image(image);
+  } else {
+    SDL_DestroyTexture(image->texture);
+  }
   delete image;
 }
 
+/* Copy the image into the area of a destroyed image it fits in, or else
+   into the free space of the last atlas page, starting a new shelf or page
+   when it does not fit. */
+bool
+VideoSDL::pack_image(ImageSDL *image, SDL_Surface *surface) {
+  int width = static_cast<int>(image->w) + ATLAS_PADDING;
+  int height = static_cast<int>(image->h) + ATLAS_PADDING;
+  if (width > atlas_size || height > atlas_size) {
+    return false;
+  }
+
+  AtlasPage *page = nullptr;
+  SDL_Rect rect = { 0, 0, static_cast<int>(image->w),
+                    static_cast<int>(image->h) };
+  for (AtlasPage &p : atlas_pages) {
+    for (auto it = p.free_areas.begin(); it != p.free_areas.end(); ++it) {
+      if (it->w >= rect.w && it->h >= rect.h) {
+        page = &p;
+        rect.x = it->x;
+        rect.y = it->y;
+        p.free_areas.erase(it);
+        break;
+      }
+    }
+    if (page != nullptr) {
+      break;
+    }
+  }
+
+  if (page == nullptr && !atlas_pages.empty()) {
+    page = &atlas_pages.back();
+    if (page->shelf_x + width > atlas_size) {
+      page->shelf_x = 0;
+      page->shelf_y += page->shelf_height;
+      page->shelf_height = 0;
+    }
+    if (page->shelf_y + height > atlas_size) {
+      page = nullptr;
+    } else {
+      rect.x = page->shelf_x;
+      rect.y = page->shelf_y;
+      page->shelf_x += width;
+      page->shelf_height = std::max(page->shelf_height, height);
+    }
+  }
+
+  if (page == nullptr) {
+    flush_batch();
+    AtlasPage new_page = { create_texture(atlas_size, atlas_size), 0, width,
+                           0, height, {} };
+    atlas_pages.push_back(new_page);
+    page = &atlas_pages.back();
+  }
+
+  if (SDL_UpdateTexture(page->texture, &rect, surface->pixels,
+                        surface->pitch) < 0) {
+    throw ExceptionSDL("Unable to update atlas page");
+  }
+  page->images++;
+
+  image->texture = page->texture;
+  image->rect = rect;
+  image->packed = true;
+  return true;
+}
+
+void
+VideoSDL::release_packed_image(ImageSDL *image) {
+  for (auto it = atlas_pages.begin(); it != atlas_pages.end(); ++it) {
+    if (it->texture == image->texture) {
+      if (--it->images == 0) {
+        if (render_target == it->texture) {
+          render_target_valid = false;
+        }
+        SDL_DestroyTexture(it->texture);
+        atlas_pages.erase(it);
+      } else {
+        it->free_areas.push_back(image->rect);
+      }
+      break;
+    }
+  }
+}
+
 void
 VideoSDL::warp_mouse(int x, int y) {
   SDL_WarpMouseInWindow(nullptr, x, y);
@@ -254,7 +404,8 @@ VideoSDL::create_texture(int width, int height) {
     throw ExceptionSDL("Unable to create SDL texture");
   }
 
-  SDL_SetRenderTarget(renderer, texture);
+  flush_batch();
+  set_render_target(texture, nullptr);
   SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
   SDL_SetRenderDrawColor(renderer, 0x00, 0x00, 0x00, 0x00);
   SDL_RenderClear(renderer);
@@ -275,23 +426,179 @@ VideoSDL::create_texture_from_data(void *data, int width, int height) {
   return texture;
 }
 
+void
+VideoSDL::set_render_target(SDL_Texture *texture, const SDL_Rect *clip) {
+  bool same_target = (render_target_valid && render_target == texture);
+  if (same_target && is_render_target_clip(clip)) {
+    stats.state_skipped++;
+    return;
+  }
+
+  if (!same_target) {
+    /* Changing the target resets the clip rectangle. */
+    SDL_SetRenderTarget(renderer, texture);
+    render_target = texture;
+    render_target_valid = true;
+    render_clipped = false;
+    stats.state_changes++;
+  }
+  if (!is_render_target_clip(clip)) {
+    SDL_RenderSetClipRect(renderer, clip);
+    render_clipped = (clip != nullptr);
+    if (clip != nullptr) {
+      render_clip = *clip;
+    }
+    stats.state_changes++;
+  }
+}
+
+void
+VideoSDL::set_render_target(const FrameSDL *frame) {
+  set_render_target(frame->texture, frame->clipped ? &frame->clip : nullptr);
+}
+
+bool
+VideoSDL::is_render_target(const FrameSDL *frame) const {
+  return (render_target_valid && render_target == frame->texture &&
+          is_render_target_clip(frame->clipped ? &frame->clip : nullptr));
+}
+
+bool
+VideoSDL::is_render_target_clip(const SDL_Rect *clip) const {
+  if (clip == nullptr || !render_clipped) {
+    return (clip == nullptr && !render_clipped);
+  }
+  return (clip->x == render_clip.x && clip->y == render_clip.y &&
+          clip->w == render_clip.w && clip->h == render_clip.h);
+}
+
+void
+VideoSDL::set_clip_rect(Video::Frame *video_frame, int x, int y,
+                        unsigned int width, unsigned int height) {
+  FrameSDL *frame = static_cast<FrameSDL*>(video_frame);
+  /* Images batched for the frame are drawn with the old clip. */
+  if (render_target_valid && render_target == frame->texture) {
+    flush_batch();
+  }
+  frame->clip = { x, y, static_cast<int>(width), static_cast<int>(height) };
+  frame->clipped = (width != 0 && height != 0);
+}
+
+void
+VideoSDL::set_blend_mode(SDL_BlendMode mode) {
+  if (blend_mode_valid && blend_mode == mode) {
+    stats.state_skipped++;
+    return;
+  }
+  SDL_SetRenderDrawBlendMode(renderer, mode);
+  blend_mode = mode;
+  blend_mode_valid = true;
+  stats.state_changes++;
+}
+
+/* Draw the batched images. The render target is already set. */
+void
+VideoSDL::flush_batch() {
+  if (batch.empty()) {
+    return;
+  }
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+  if (batch.size() > 1) {
+    int tw = 0;
+    int th = 0;
+    SDL_QueryTexture(batch_texture, nullptr, nullptr, &tw, &th);
+    float sx = 1.f / static_cast<float>(tw);
+    float sy = 1.f / static_cast<float>(th);
+
+    batch_vertices.clear();
+    batch_indices.clear();
+    for (const BatchedImage &item : batch) {
+      int base = static_cast<int>(batch_vertices.size());
+      float x0 = static_cast<float>(item.dest.x);
+      float y0 = static_cast<float>(item.dest.y);
+      float x1 = static_cast<float>(item.dest.x + item.dest.w);
+      float y1 = static_cast<float>(item.dest.y + item.dest.h);
+      float u0 = static_cast<float>(item.src.x) * sx;
+      float v0 = static_cast<float>(item.src.y) * sy;
+      float u1 = static_cast<float>(item.src.x + item.src.w) * sx;
+      float v1 = static_cast<float>(item.src.y + item.src.h) * sy;
+      const SDL_Color &c = item.color;
+      batch_vertices.push_back(SDL_Vertex{{x0, y0}, c, {u0, v0}});
+      batch_vertices.push_back(SDL_Vertex{{x1, y0}, c, {u1, v0}});
+      batch_vertices.push_back(SDL_Vertex{{x1, y1}, c, {u1, v1}});
+      batch_vertices.push_back(SDL_Vertex{{x0, y1}, c, {u0, v1}});
+      int quad[] = { 0, 1, 2, 0, 2, 3 };
+      for (int index : quad) {
+        batch_indices.push_back(base + index);
+      }
+    }
+
+    int r = SDL_RenderGeometry(renderer, batch_texture,
+                               batch_vertices.data(),
+                               static_cast<int>(batch_vertices.size()),
+                               batch_indices.data(),
+                               static_cast<int>(batch_indices.size()));
+    stats.draw_calls++;
+    batch.clear();
+    if (r < 0) {
+      throw ExceptionSDL("RenderGeometry error");
+    }
+    return;
+  }
+#endif
+
+  for (const BatchedImage &item : batch) {
+    const SDL_Color &c = item.color;
+    bool tinted = (c.r != 0xff || c.g != 0xff || c.b != 0xff || c.a != 0xff);
+    if (tinted) {
+      SDL_SetTextureColorMod(batch_texture, c.r, c.g, c.b);
+      SDL_SetTextureAlphaMod(batch_texture, c.a);
+    }
+    int r = SDL_RenderCopy(renderer, batch_texture, &item.src, &item.dest);
+    stats.draw_calls++;
+    if (tinted) {
+      SDL_SetTextureColorMod(batch_texture, 0xff, 0xff, 0xff);
+      SDL_SetTextureAlphaMod(batch_texture, 0xff);
+    }
+    if (r < 0) {
+      batch.clear();
+      throw ExceptionSDL("RenderCopy error");
+    }
+  }
+  batch.clear();
+}
+
 void
 VideoSDL::draw_image(const Video::Image *image, int x, int y, int y_offset,
                         Video::Frame *dest) {
-  SDL_Rect dest_rect = { x, y + y_offset,
-                         static_cast<int>(image->w),
-                         static_cast<int>(image->h - y_offset) };
-  SDL_Rect src_rect = { 0, y_offset,
-                        static_cast<int>(image->w),
-                        static_cast<int>(image->h - y_offset) };
-
-  /* Blit sprite */
-  SDL_SetRenderTarget(renderer, dest->texture);
-  SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
-  int r = SDL_RenderCopy(renderer, image->texture, &src_rect, &dest_rect);
-  if (r < 0) {
-    throw ExceptionSDL("RenderCopy error");
+  draw_tinted_image(image, x, y, y_offset, {0xff, 0xff, 0xff, 0xff}, dest);
+}
+
+void
+VideoSDL::draw_tinted_image(const Video::Image *video_image, int x, int y,
+                            int y_offset, const Video::Color color,
+                            Video::Frame *video_dest) {
+  const ImageSDL *image = static_cast<const ImageSDL*>(video_image);
+  FrameSDL *dest = static_cast<FrameSDL*>(video_dest);
+  BatchedImage item;
+  item.color = { color.r, color.g, color.b, color.a };
+  item.dest = { x, y + y_offset,
+                static_cast<int>(image->w),
+                static_cast<int>(image->h - y_offset) };
+  item.src = { image->rect.x, image->rect.y + y_offset,
+               static_cast<int>(image->w),
+               static_cast<int>(image->h - y_offset) };
+
+  /* Blit sprite, after the images of other textures or targets */
+  if (image->texture != batch_texture || !is_render_target(dest)) {
+    flush_batch();
+    batch_texture = image->texture;
   }
+  set_render_target(dest);
+  set_blend_mode(SDL_BLENDMODE_BLEND);
+  batch.push_back(item);
+  stats.images++;
 }
 
 void
@@ -300,9 +607,12 @@ VideoSDL::draw_frame(int dx, int dy, Video::Frame *dest, int sx, int sy,
   SDL_Rect dest_rect = { dx, dy, w, h };
   SDL_Rect src_rect = { sx, sy, w, h };
 
-  SDL_SetRenderTarget(renderer, dest->texture);
-  SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
-  int r = SDL_RenderCopy(renderer, src->texture, &src_rect, &dest_rect);
+  flush_batch();
+  set_render_target(static_cast<FrameSDL*>(dest));
+  set_blend_mode(SDL_BLENDMODE_BLEND);
+  int r = SDL_RenderCopy(renderer, static_cast<FrameSDL*>(src)->texture,
+                         &src_rect, &dest_rect);
+  stats.draw_calls++;
   if (r < 0) {
     throw ExceptionSDL("RenderCopy error");
   }
@@ -324,9 +634,11 @@ VideoSDL::fill_rect(int x, int y, unsigned int width, unsigned int height,
   SDL_Rect rect = { x, y, static_cast<int>(width), static_cast<int>(height) };
 
   /* Fill rectangle */
-  SDL_SetRenderTarget(renderer, dest->texture);
+  flush_batch();
+  set_render_target(static_cast<FrameSDL*>(dest));
   SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, 0xff);
   int r = SDL_RenderFillRect(renderer, &rect);
+  stats.draw_calls++;
   if (r < 0) {
     throw ExceptionSDL("RenderFillRect error");
   }
@@ -335,16 +647,29 @@ VideoSDL::fill_rect(int x, int y, unsigned int width, unsigned int height,
 void
 VideoSDL::draw_line(int x, int y, int x1, int y1, const Video::Color color,
                     Video::Frame *dest) {
-  SDL_SetRenderTarget(renderer, dest->texture);
+  flush_batch();
+  set_render_target(static_cast<FrameSDL*>(dest));
   SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, 0xff);
   SDL_RenderDrawLine(renderer, x, y, x1, y1);
+  stats.draw_calls++;
 }
 
 void
 VideoSDL::swap_buffers() {
-  SDL_SetRenderTarget(renderer, nullptr);
+  flush_batch();
+  set_render_target(nullptr, nullptr);
   SDL_RenderCopy(renderer, screen->texture, nullptr, nullptr);
+  stats.draw_calls++;
   SDL_RenderPresent(renderer);
+
+  stats.atlas_pages = static_cast<unsigned int>(atlas_pages.size());
+  last_stats = stats;
+  total_stats.images += stats.images;
+  total_stats.draw_calls += stats.draw_calls;
+  total_stats.state_changes += stats.state_changes;
+  total_stats.state_skipped += stats.state_skipped;
+  frames++;
+  stats = DrawStats{0, 0, 0, 0, 0};
 }
 
 void
@@ -24,25 +24,31 @@
 
 #include <exception>
 #include <string>
+#include <vector>
 
 #include <SDL.h>
 
 #include "src/video.h"
 
-class Video::Frame {
+class FrameSDL : public Video::Frame {
  public:
   SDL_Texture *texture;
+  /* Drawing is limited to clip when clipped is set. */
+  SDL_Rect clip;
+  bool clipped;
 
-  Frame() : texture(NULL) {}
+  FrameSDL() : texture(NULL), clip{0, 0, 0, 0}, clipped(false) {}
 };
 
-class Video::Image {
+class ImageSDL : public Video::Image {
  public:
-  unsigned int w;
-  unsigned int h;
   SDL_Texture *texture;
+  /* Area of the texture holding the image. Packed images share the
+     texture of an atlas page. */
+  SDL_Rect rect;
+  bool packed;
 
-  Image() : w(0), h(0), texture(NULL) {}
+  ImageSDL() : texture(NULL), rect{0, 0, 0, 0}, packed(false) {}
 };
 
 class ExceptionSDL : public ExceptionVideo {
@@ -67,11 +73,52 @@ class VideoSDL : public Video {
 
   SDL_Window *window;
   SDL_Renderer *renderer;
-  Video::Frame *screen;
+  FrameSDL *screen;
   bool fullscreen;
   SDL_Cursor *cursor;
   float zoom_factor;
 
+  /* Textures that small images are packed into, filled shelf by shelf. The
+     areas of destroyed images are reused for images that fit, and a page is
+     freed when its last image is destroyed. */
+  typedef struct AtlasPage {
+    SDL_Texture *texture;
+    unsigned int images;
+    int shelf_x;
+    int shelf_y;
+    int shelf_height;
+    std::vector<SDL_Rect> free_areas;
+  } AtlasPage;
+  std::vector<AtlasPage> atlas_pages;
+  int atlas_size;
+
+  /* Images drawn from the same texture to the same target are collected
+     and drawn at once, when anything else is drawn or the frame ends. */
+  typedef struct BatchedImage {
+    SDL_Rect src;
+    SDL_Rect dest;
+    SDL_Color color;
+  } BatchedImage;
+  std::vector<BatchedImage> batch;
+  SDL_Texture *batch_texture;
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+  std::vector<SDL_Vertex> batch_vertices;
+  std::vector<int> batch_indices;
+#endif
+
+  /* Renderer state, to skip setting it again. */
+  SDL_Texture *render_target;
+  bool render_target_valid;
+  SDL_Rect render_clip;
+  bool render_clipped;
+  SDL_BlendMode blend_mode;
+  bool blend_mode_valid;
+
+  DrawStats stats;
+  DrawStats last_stats;
+  DrawStats total_stats;
+  unsigned int frames;
+
  public:
   VideoSDL();
   virtual ~VideoSDL();
@@ -85,15 +132,20 @@ class VideoSDL : public Video {
   virtual Video::Frame *get_screen_frame();
   virtual Video::Frame *create_frame(unsigned int width, unsigned int height);
   virtual void destroy_frame(Video::Frame *frame);
+  virtual void set_clip_rect(Video::Frame *frame, int x, int y,
+                             unsigned int width, unsigned int height);
 
   virtual Video::Image *create_image(void *data, unsigned int width,
-                                     unsigned int height);
+                                     unsigned int height, bool pack);
   virtual void destroy_image(Video::Image *image);
 
   virtual void warp_mouse(int x, int y);
 
   virtual void draw_image(const Video::Image *image, int x, int y,
                            int y_offset, Video::Frame *dest);
+  virtual void draw_tinted_image(const Video::Image *image, int x, int y,
+                                 int y_offset, const Video::Color color,
+                                 Video::Frame *dest);
   virtual void draw_frame(int dx, int dy, Video::Frame *dest, int sx, int sy,
                           Video::Frame *src, int w, int h);
   virtual void draw_rect(int x, int y, unsigned int width, unsigned int height,
@@ -104,6 +156,7 @@ class VideoSDL : public Video {
                          const Video::Color color, Video::Frame *dest);
 
   virtual void swap_buffers();
+  virtual DrawStats get_draw_stats() { return last_stats; }
 
   virtual void set_cursor(void *data, unsigned int width, unsigned int height);
 
@@ -116,6 +169,15 @@ class VideoSDL : public Video {
   SDL_Surface *create_surface_from_data(void *data, int width, int height);
   SDL_Texture *create_texture(int width, int height);
   SDL_Texture *create_texture_from_data(void *data, int width, int height);
+  bool pack_image(ImageSDL *image, SDL_Surface *surface);
+  void release_packed_image(ImageSDL *image);
+
+  void set_render_target(SDL_Texture *texture, const SDL_Rect *clip);
+  void set_render_target(const FrameSDL *frame);
+  bool is_render_target(const FrameSDL *frame) const;
+  bool is_render_target_clip(const SDL_Rect *clip) const;
+  void set_blend_mode(SDL_BlendMode mode);
+  void flush_batch();
 };
 
 #endif  // SRC_VIDEO_SDL_H_
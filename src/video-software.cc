@@ -0,0 +1,369 @@
+/*
+ * video-software.cc - Video backend drawing into memory
+ *
+ * Copyright (C) 2026  freeserf developers
+ *
+ * This file is part of freeserf.
+ *
+ * freeserf is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * freeserf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with freeserf.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "src/video-software.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include "src/log.h"
+
+/* Size of the screen until the resolution is set, as the SDL window. */
+#define SCREEN_WIDTH   800
+#define SCREEN_HEIGHT  600
+
+/* x / 255, rounded. */
+static inline uint32_t
+div_255(uint32_t x) {
+  x += 0x80;
+  return (x + (x >> 8)) >> 8;
+}
+
+static inline uint32_t
+get_channel(uint32_t pixel, int shift) {
+  return (pixel >> shift) & 0xFF;
+}
+
+uint32_t
+VideoSoftware::blend_pixel(uint32_t back, uint32_t front) {
+  uint32_t alpha = front >> 24;
+  if (alpha == 0xFF) {
+    return front;
+  }
+  if (alpha == 0x00) {
+    return back;
+  }
+
+  uint32_t inverse = 0xFF - alpha;
+  uint32_t result = (alpha + div_255(get_channel(back, 24) * inverse)) << 24;
+  for (int shift = 0; shift < 24; shift += 8) {
+    uint32_t c = div_255(get_channel(front, shift) * alpha +
+                         get_channel(back, shift) * inverse);
+    result |= c << shift;
+  }
+  return result;
+}
+
+uint32_t
+VideoSoftware::tint_pixel(uint32_t pixel, const Video::Color &color) {
+  return (div_255(get_channel(pixel, 24) * color.a) << 24) |
+         (div_255(get_channel(pixel, 16) * color.r) << 16) |
+         (div_255(get_channel(pixel, 8) * color.g) << 8) |
+         div_255(get_channel(pixel, 0) * color.b);
+}
+
+VideoSoftware::VideoSoftware() {
+  screen = nullptr;
+  width = 0;
+  height = 0;
+  fullscreen = false;
+  zoom_factor = 1.f;
+  stats = DrawStats{0, 0, 0, 0, 0};
+  last_stats = stats;
+  total_stats = stats;
+  frames = 0;
+
+  Log::Info["video"] << "Initializing \"software\".";
+
+  set_resolution(SCREEN_WIDTH, SCREEN_HEIGHT, fullscreen);
+}
+
+VideoSoftware::~VideoSoftware() {
+  if (frames > 0) {
+    Log::Debug["video"] << "Drew " << frames << " frames with "
+                        << total_stats.images / frames << " images and "
+                        << total_stats.draw_calls / frames
+                        << " draw calls per frame";
+  }
+  if (screen != nullptr) {
+    delete screen;
+    screen = nullptr;
+  }
+}
+
+void
+VideoSoftware::set_resolution(unsigned int _width, unsigned int _height,
+                              bool fs) {
+  width = _width;
+  height = _height;
+  fullscreen = fs;
+  resize_screen(width, height);
+}
+
+void
+VideoSoftware::get_resolution(unsigned int *_width, unsigned int *_height) {
+  if (_width != nullptr) {
+    *_width = width;
+  }
+  if (_height != nullptr) {
+    *_height = height;
+  }
+}
+
+/* The screen frame is kept, so the frames of the interface that refer to
+   it stay valid. */
+void
+VideoSoftware::resize_screen(unsigned int _width, unsigned int _height) {
+  if (screen == nullptr) {
+    screen = new FrameSoftware(_width, _height);
+    return;
+  }
+
+  screen->width = _width;
+  screen->height = _height;
+  screen->pixels.assign(_width * _height, 0);
+}
+
+Video::Frame *
+VideoSoftware::create_frame(unsigned int _width, unsigned int _height) {
+  return new FrameSoftware(_width, _height);
+}
+
+void
+VideoSoftware::destroy_frame(Video::Frame *frame) {
+  delete frame;
+}
+
+void
+VideoSoftware::set_clip_rect(Video::Frame *video_frame, int x, int y,
+                             unsigned int _width, unsigned int _height) {
+  FrameSoftware *frame = static_cast<FrameSoftware*>(video_frame);
+  frame->clip_x = x;
+  frame->clip_y = y;
+  frame->clip_width = _width;
+  frame->clip_height = _height;
+  frame->clipped = (_width != 0 && _height != 0);
+}
+
+VideoSoftware::Bounds
+VideoSoftware::get_bounds(const FrameSoftware *frame) {
+  Bounds bounds = { 0, 0, static_cast<int>(frame->width),
+                    static_cast<int>(frame->height) };
+  if (frame->clipped) {
+    bounds.left = std::max(bounds.left, frame->clip_x);
+    bounds.top = std::max(bounds.top, frame->clip_y);
+    bounds.right = std::min(bounds.right, frame->clip_x +
+                            static_cast<int>(frame->clip_width));
+    bounds.bottom = std::min(bounds.bottom, frame->clip_y +
+                             static_cast<int>(frame->clip_height));
+  }
+  return bounds;
+}
+
+Video::Image *
+VideoSoftware::create_image(void *data, unsigned int _width,
+                            unsigned int _height, bool /*pack*/) {
+  ImageSoftware *image = new ImageSoftware();
+  image->w = _width;
+  image->h = _height;
+  image->pixels.resize(_width * _height);
+  if (!image->pixels.empty()) {
+    std::memcpy(image->pixels.data(), data, image->pixels.size() * 4);
+  }
+  return image;
+}
+
+void
+VideoSoftware::destroy_image(Video::Image *image) {
+  delete image;
+}
+
+/* Blend w x h pixels of src, tinted by color, onto dest at x, y. */
+void
+VideoSoftware::draw_pixels(const uint32_t *src, unsigned int src_pitch,
+                           int x, int y, int w, int h,
+                           const Video::Color color, FrameSoftware *dest) {
+  Bounds bounds = get_bounds(dest);
+  int left = std::max(x, bounds.left);
+  int top = std::max(y, bounds.top);
+  int right = std::min(x + w, bounds.right);
+  int bottom = std::min(y + h, bounds.bottom);
+  if (left >= right || top >= bottom) {
+    return;
+  }
+
+  bool tinted = (color.r != 0xff || color.g != 0xff || color.b != 0xff ||
+                 color.a != 0xff);
+  for (int row = top; row < bottom; row++) {
+    const uint32_t *s = src + (row - y) * src_pitch + (left - x);
+    uint32_t *d = dest->pixels.data() + row * dest->width + left;
+    for (int i = 0; i < right - left; i++) {
+      uint32_t pixel = tinted ? tint_pixel(s[i], color) : s[i];
+      d[i] = blend_pixel(d[i], pixel);
+    }
+  }
+}
+
+void
+VideoSoftware::draw_image(const Video::Image *image, int x, int y,
+                          int y_offset, Video::Frame *dest) {
+  draw_tinted_image(image, x, y, y_offset, {0xff, 0xff, 0xff, 0xff}, dest);
+}
+
+void
+VideoSoftware::draw_tinted_image(const Video::Image *video_image, int x,
+                                 int y, int y_offset,
+                                 const Video::Color color,
+                                 Video::Frame *dest) {
+  const ImageSoftware *image = static_cast<const ImageSoftware*>(video_image);
+  if (y_offset < 0 || y_offset >= static_cast<int>(image->h)) {
+    return;
+  }
+
+  draw_pixels(image->pixels.data() + y_offset * image->w, image->w,
+              x, y + y_offset, image->w, image->h - y_offset, color,
+              static_cast<FrameSoftware*>(dest));
+  stats.images++;
+  stats.draw_calls++;
+}
+
+void
+VideoSoftware::draw_frame(int dx, int dy, Video::Frame *dest, int sx, int sy,
+                          Video::Frame *video_src, int w, int h) {
+  const FrameSoftware *src = static_cast<const FrameSoftware*>(video_src);
+
+  /* Leave out the part outside of the source. */
+  if (sx < 0) {
+    dx -= sx;
+    w += sx;
+    sx = 0;
+  }
+  if (sy < 0) {
+    dy -= sy;
+    h += sy;
+    sy = 0;
+  }
+  w = std::min(w, static_cast<int>(src->width) - sx);
+  h = std::min(h, static_cast<int>(src->height) - sy);
+  stats.draw_calls++;
+  if (w <= 0 || h <= 0) {
+    return;
+  }
+
+  draw_pixels(src->pixels.data() + sy * src->width + sx, src->width,
+              dx, dy, w, h, {0xff, 0xff, 0xff, 0xff},
+              static_cast<FrameSoftware*>(dest));
+}
+
+void
+VideoSoftware::draw_rect(int x, int y, unsigned int _width,
+                         unsigned int _height, const Video::Color color,
+                         Video::Frame *dest) {
+  /* Draw rectangle. */
+  fill_rect(x, y, _width, 1, color, dest);
+  fill_rect(x, y+_height-1, _width, 1, color, dest);
+  fill_rect(x, y, 1, _height, color, dest);
+  fill_rect(x+_width-1, y, 1, _height, color, dest);
+}
+
+void
+VideoSoftware::fill_rect(int x, int y, unsigned int _width,
+                         unsigned int _height, const Video::Color color,
+                         Video::Frame *video_dest) {
+  FrameSoftware *dest = static_cast<FrameSoftware*>(video_dest);
+  stats.draw_calls++;
+
+  Bounds bounds = get_bounds(dest);
+  int left = std::max(x, bounds.left);
+  int top = std::max(y, bounds.top);
+  int right = std::min(x + static_cast<int>(_width), bounds.right);
+  int bottom = std::min(y + static_cast<int>(_height), bounds.bottom);
+  if (left >= right || top >= bottom) {
+    return;
+  }
+
+  /* Opaque, as the SDL renderer draws it. */
+  uint32_t pixel = 0xFF000000 | (color.r << 16) | (color.g << 8) | color.b;
+  for (int row = top; row < bottom; row++) {
+    uint32_t *d = dest->pixels.data() + row * dest->width;
+    std::fill(d + left, d + right, pixel);
+  }
+}
+
+void
+VideoSoftware::draw_line(int x, int y, int x1, int y1,
+                         const Video::Color color, Video::Frame *video_dest) {
+  FrameSoftware *dest = static_cast<FrameSoftware*>(video_dest);
+  stats.draw_calls++;
+
+  Bounds bounds = get_bounds(dest);
+  uint32_t pixel = 0xFF000000 | (color.r << 16) | (color.g << 8) | color.b;
+
+  /* Bresenham, both ends included. */
+  int dx = std::abs(x1 - x);
+  int dy = -std::abs(y1 - y);
+  int step_x = (x < x1) ? 1 : -1;
+  int step_y = (y < y1) ? 1 : -1;
+  int error = dx + dy;
+  while (true) {
+    if (x >= bounds.left && x < bounds.right &&
+        y >= bounds.top && y < bounds.bottom) {
+      dest->pixels[y * dest->width + x] = pixel;
+    }
+    if (x == x1 && y == y1) {
+      break;
+    }
+    int error2 = 2 * error;
+    if (error2 >= dy) {
+      error += dy;
+      x += step_x;
+    }
+    if (error2 <= dx) {
+      error += dx;
+      y += step_y;
+    }
+  }
+}
+
+void
+VideoSoftware::swap_buffers() {
+  last_stats = stats;
+  total_stats.images += stats.images;
+  total_stats.draw_calls += stats.draw_calls;
+  frames++;
+  stats = DrawStats{0, 0, 0, 0, 0};
+}
+
+bool
+VideoSoftware::set_zoom_factor(float factor) {
+  if ((factor < 0.2f) || (factor > 1.f)) {
+    return false;
+  }
+
+  zoom_factor = factor;
+  resize_screen(static_cast<unsigned int>(static_cast<float>(width) *
+                                          zoom_factor),
+                static_cast<unsigned int>(static_cast<float>(height) *
+                                          zoom_factor));
+
+  return true;
+}
+
+void
+VideoSoftware::get_screen_factor(float *fx, float *fy) {
+  if (fx != nullptr) {
+    *fx = 1.f;
+  }
+  if (fy != nullptr) {
+    *fy = 1.f;
+  }
+}
@@ -0,0 +1,138 @@
+/*
+ * video-software.h - Video backend drawing into memory
+ *
+ * Copyright (C) 2026  freeserf developers
+ *
+ * This file is part of freeserf.
+ *
+ * freeserf is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * freeserf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with freeserf.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SRC_VIDEO_SOFTWARE_H_
+#define SRC_VIDEO_SOFTWARE_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "src/video.h"
+
+/* Pixels are 32 bit BGRA, the same as the pixels of sprites. */
+class FrameSoftware : public Video::Frame {
+ public:
+  unsigned int width;
+  unsigned int height;
+  std::vector<uint32_t> pixels;
+  /* Drawing is limited to clip when clipped is set. */
+  int clip_x;
+  int clip_y;
+  unsigned int clip_width;
+  unsigned int clip_height;
+  bool clipped;
+
+  FrameSoftware(unsigned int w, unsigned int h)
+    : width(w), height(h), pixels(w * h, 0)
+    , clip_x(0), clip_y(0), clip_width(0), clip_height(0), clipped(false) {}
+};
+
+class ImageSoftware : public Video::Image {
+ public:
+  std::vector<uint32_t> pixels;
+};
+
+// Draws frames into buffers in memory, blending the way the SDL renderer
+// does, so it needs no display. Used to benchmark the interface and to
+// compare screenshots.
+class VideoSoftware : public Video {
+ protected:
+  /* Part of a frame that may be drawn to, the right and bottom edges are
+     excluded. */
+  typedef struct Bounds {
+    int left;
+    int top;
+    int right;
+    int bottom;
+  } Bounds;
+
+  FrameSoftware *screen;
+  unsigned int width;
+  unsigned int height;
+  bool fullscreen;
+  float zoom_factor;
+
+  DrawStats stats;
+  DrawStats last_stats;
+  DrawStats total_stats;
+  unsigned int frames;
+
+ public:
+  VideoSoftware();
+  virtual ~VideoSoftware();
+
+  virtual void set_resolution(unsigned int width, unsigned int height,
+                              bool fullscreen);
+  virtual void get_resolution(unsigned int *width, unsigned int *height);
+  virtual void set_fullscreen(bool enable) { fullscreen = enable; }
+  virtual bool is_fullscreen() { return fullscreen; }
+
+  virtual Video::Frame *get_screen_frame() { return screen; }
+  virtual Video::Frame *create_frame(unsigned int width, unsigned int height);
+  virtual void destroy_frame(Video::Frame *frame);
+  virtual void set_clip_rect(Video::Frame *frame, int x, int y,
+                             unsigned int width, unsigned int height);
+
+  virtual Video::Image *create_image(void *data, unsigned int width,
+                                     unsigned int height, bool pack);
+  virtual void destroy_image(Video::Image *image);
+
+  virtual void warp_mouse(int /*x*/, int /*y*/) {}
+
+  virtual void draw_image(const Video::Image *image, int x, int y,
+                          int y_offset, Video::Frame *dest);
+  virtual void draw_tinted_image(const Video::Image *image, int x, int y,
+                                 int y_offset, const Video::Color color,
+                                 Video::Frame *dest);
+  virtual void draw_frame(int dx, int dy, Video::Frame *dest, int sx, int sy,
+                          Video::Frame *src, int w, int h);
+  virtual void draw_rect(int x, int y, unsigned int width, unsigned int height,
+                         const Video::Color color, Video::Frame *dest);
+  virtual void fill_rect(int x, int y, unsigned int width, unsigned int height,
+                         const Video::Color color, Video::Frame *dest);
+  virtual void draw_line(int x, int y, int x1, int y1,
+                         const Video::Color color, Video::Frame *dest);
+
+  virtual void swap_buffers();
+  virtual DrawStats get_draw_stats() { return last_stats; }
+
+  virtual void set_cursor(void * /*data*/, unsigned int /*width*/,
+                          unsigned int /*height*/) {}
+
+  virtual float get_zoom_factor() { return zoom_factor; }
+  virtual bool set_zoom_factor(float factor);
+  virtual void get_screen_factor(float *fx, float *fy);
+
+  /* Source over destination without premultiplied alpha, the same as the
+     blend mode of the SDL renderer. */
+  static uint32_t blend_pixel(uint32_t back, uint32_t front);
+  /* Multiply each channel of pixel by the one of color. */
+  static uint32_t tint_pixel(uint32_t pixel, const Video::Color &color);
+
+ protected:
+  void resize_screen(unsigned int width, unsigned int height);
+  static Bounds get_bounds(const FrameSoftware *frame);
+  void draw_pixels(const uint32_t *src, unsigned int src_pitch, int x, int y,
+                   int w, int h, const Video::Color color,
+                   FrameSoftware *dest);
+};
+
+#endif  // SRC_VIDEO_SOFTWARE_H_
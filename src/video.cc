@@ -23,6 +23,8 @@
 
 #include <sstream>
 
+#include "src/video-software.h"
+
 ExceptionVideo::ExceptionVideo(const std::string &description) :
   ExceptionFreeserf(description) {
 }
@@ -34,3 +36,15 @@ std::string
 ExceptionVideo::get_description() const {
   return "[" + get_system() + ":" + get_platform() + "] " + description.c_str();
 }
+
+Video::Backend Video::backend = Video::BackendPlatform;
+
+Video &
+Video::get_instance() {
+  if (backend == BackendSoftware) {
+    static VideoSoftware instance;
+    return instance;
+  }
+
+  return get_platform_instance();
+}
@@ -49,13 +49,33 @@ class Video {
   class Frame;
   class Image;
 
+  typedef enum Backend {
+    BackendPlatform,  /* Window of the platform */
+    BackendSoftware,  /* Frames in memory, needs no display */
+  } Backend;
+
+  /* Work done by the renderer for one frame, for profiling. */
+  typedef struct DrawStats {
+    unsigned int images;         /* Images drawn */
+    unsigned int draw_calls;     /* Draw calls issued to the renderer */
+    unsigned int state_changes;  /* Render target or blend mode changes */
+    unsigned int state_skipped;  /* Redundant state changes left out */
+    unsigned int atlas_pages;    /* Textures holding packed images */
+  } DrawStats;
+
  protected:
+  static Backend backend;
+
   Video() {}
 
  public:
   virtual ~Video() {}
 
   static Video &get_instance();
+  /* Backend that get_instance() creates. Must be set before it is first
+     called. */
+  static void set_backend(Backend value) { backend = value; }
+  static Backend get_backend() { return backend; }
 
   virtual void set_resolution(unsigned int width, unsigned int height,
                               bool fullscreen) = 0;
@@ -67,15 +87,25 @@ class Video {
   virtual Frame *create_frame(unsigned int width,
                                       unsigned int height) = 0;
   virtual void destroy_frame(Frame *frame) = 0;
+  /* Limit drawing to frame to a rectangle. A width or height of zero
+     removes the limit. */
+  virtual void set_clip_rect(Frame *frame, int x, int y, unsigned int width,
+                             unsigned int height) = 0;
 
+  /* Images that are kept around, e.g. cached sprites, may be packed
+     together into shared textures. */
   virtual Image *create_image(void *data, unsigned int width,
-                                      unsigned int height) = 0;
+                              unsigned int height, bool pack) = 0;
   virtual void destroy_image(Image *image) = 0;
 
   virtual void warp_mouse(int x, int y) = 0;
 
   virtual void draw_image(const Image *image, int x, int y,
                           int y_offset, Frame *dest) = 0;
+  /* Draw image with its colours multiplied by color. */
+  virtual void draw_tinted_image(const Image *image, int x, int y,
+                                 int y_offset, const Video::Color color,
+                                 Frame *dest) = 0;
   virtual void draw_frame(int dx, int dy, Frame *dest, int sx, int sy,
                           Frame *src, int w, int h) = 0;
   virtual void draw_rect(int x, int y, unsigned int width, unsigned int height,
@@ -86,6 +116,8 @@ class Video {
                          const Video::Color color, Frame *dest) = 0;
 
   virtual void swap_buffers() = 0;
+  /* Stats of the last frame that was swapped. */
+  virtual DrawStats get_draw_stats() = 0;
 
   virtual void set_cursor(void *data, unsigned int width,
                           unsigned int height) = 0;
@@ -93,6 +125,25 @@ class Video {
   virtual float get_zoom_factor() = 0;
   virtual bool set_zoom_factor(float factor) = 0;
   virtual void get_screen_factor(float *fx, float *fy) = 0;
+
+ protected:
+  static Video &get_platform_instance();
+};
+
+/* Render target, extended by each backend. */
+class Video::Frame {
+ public:
+  virtual ~Frame() {}
+};
+
+/* Image that can be drawn, extended by each backend. */
+class Video::Image {
+ public:
+  unsigned int w;
+  unsigned int h;
+
+  Image() : w(0), h(0) {}
+  virtual ~Image() {}
 };
 
 #endif  // SRC_VIDEO_H_
@@ -25,6 +25,7 @@
 #include <memory>
 #include <utility>
 #include <sstream>
+#include <vector>
 
 #include "src/misc.h"
 #include "src/game.h"
@@ -36,310 +37,253 @@
 #include "src/interface.h"
 #include "src/popup.h"
 #include "src/pathfinder.h"
+#include "src/thread-pool.h"
 #include "src/data-source.h"
+#include "src/landscape-raster.h"
 
-#define MAP_TILE_WIDTH   32
-#define MAP_TILE_HEIGHT  20
-
-#define MAP_TILE_TEXTURES  33
-#define MAP_TILE_MASKS     81
-
-/* Number of cols,rows in each landscape tile */
-#define MAP_TILE_COLS  16
-#define MAP_TILE_ROWS  16
-
-static const uint8_t tri_spr[] = {
-  32, 32, 32, 32, 32, 32, 32, 32,
-  32, 32, 32, 32, 32, 32, 32, 32,
-  32, 32, 32, 32, 32, 32, 32, 32,
-  32, 32, 32, 32, 32, 32, 32, 32,
-  0, 1, 2, 3, 4, 5, 6, 7,
-  0, 1, 2, 3, 4, 5, 6, 7,
-  0, 1, 2, 3, 4, 5, 6, 7,
-  0, 1, 2, 3, 4, 5, 6, 7,
-  24, 25, 26, 27, 28, 29, 30, 31,
-  24, 25, 26, 27, 28, 29, 30, 31,
-  24, 25, 26, 27, 28, 29, 30, 31,
-  8, 9, 10, 11, 12, 13, 14, 15,
-  8, 9, 10, 11, 12, 13, 14, 15,
-  8, 9, 10, 11, 12, 13, 14, 15,
-  16, 17, 18, 19, 20, 21, 22, 23,
-  16, 17, 18, 19, 20, 21, 22, 23
-};
+/* Estimated memory of a prerendered landscape tile. */
+#define MAP_TILE_FRAME_SIZE \
+  (MAP_TILE_COLS*MAP_TILE_WIDTH * MAP_TILE_ROWS*MAP_TILE_HEIGHT * 4)
 
-void
-Viewport::draw_triangle_up(int lx, int ly, int m, int left, int right,
-                           MapPos pos, Frame *tile) {
-  static const int8_t tri_mask[] = {
-     0,  1,  3,  6,  7, -1, -1, -1, -1,
-     0,  1,  2,  5,  6,  7, -1, -1, -1,
-     0,  1,  2,  3,  5,  6,  7, -1, -1,
-     0,  1,  2,  3,  4,  5,  6,  7, -1,
-     0,  1,  2,  3,  4,  4,  5,  6,  7,
-    -1,  0,  1,  2,  3,  4,  5,  6,  7,
-    -1, -1,  0,  1,  2,  4,  5,  6,  7,
-    -1, -1, -1,  0,  1,  2,  5,  6,  7,
-    -1, -1, -1, -1,  0,  1,  4,  6,  7
-  };
+size_t Viewport::tile_cache_budget = 64*1024*1024;
 
-  if (((left - m) < -4) || ((left - m) > 4)) {
-    throw ExceptionFreeserf("Failed to draw triangle up (1).");
-  }
-  if (((right - m) < -4) || ((right - m) > 4)) {
-    throw ExceptionFreeserf("Failed to draw triangle up (2).");
-  }
-
-  int mask = 4 + m - left + 9*(4 + m - right);
-  if (tri_mask[mask] < 0) {
-    throw ExceptionFreeserf("Failed to draw triangle up (3).");
-  }
-
-  Map::Terrain type = map->type_up(map->move_up(pos));
-  int index = (type << 3) | tri_mask[mask];
-  if (index >= 128) {
-    throw ExceptionFreeserf("Failed to draw triangle up (4).");
-  }
-
-  int sprite = tri_spr[index];
+void
+Viewport::layout() {
+  landscape_tiles.clear();
 
-  tile->draw_masked_sprite(lx, ly, Data::AssetMapMaskUp, mask,
-                            Data::AssetMapGround, sprite);
+  /* Keep the tiles in view and the ring around them. */
+  size_t cols = width/(MAP_TILE_COLS*MAP_TILE_WIDTH) + 3;
+  size_t rows = height/(MAP_TILE_ROWS*MAP_TILE_HEIGHT) + 3;
+  landscape_tiles.set_budget(std::max(tile_cache_budget,
+                                      cols*rows*MAP_TILE_FRAME_SIZE));
 }
 
 void
-Viewport::draw_triangle_down(int lx, int ly, int m, int left, int right,
-                             MapPos pos, Frame *tile) {
-  static const int8_t tri_mask[] = {
-     0,  0,  0,  0,  0, -1, -1, -1, -1,
-     1,  1,  1,  1,  1,  0, -1, -1, -1,
-     3,  2,  2,  2,  2,  1,  0, -1, -1,
-     6,  5,  3,  3,  3,  2,  1,  0, -1,
-     7,  6,  5,  4,  4,  3,  2,  1,  0,
-    -1,  7,  6,  5,  4,  4,  4,  2,  1,
-    -1, -1,  7,  6,  5,  5,  5,  5,  4,
-    -1, -1, -1,  7,  6,  6,  6,  6,  6,
-    -1, -1, -1, -1,  7,  7,  7,  7,  7
-  };
-
-  if (((left - m) < -4) || ((left - m) > 4)) {
-    throw ExceptionFreeserf("Failed to draw triangle down (1).");
-  }
-  if (((right - m) < -4) || ((right - m) > 4)) {
-    throw ExceptionFreeserf("Failed to draw triangle down (2).");
-  }
+Viewport::redraw_map_pos(MapPos pos) {
+  int mx, my;
+  map_pix_from_map_coord(pos, map->get_height(pos), &mx, &my);
 
-  int mask = 4 + left - m + 9*(4 + right - m);
-  if (tri_mask[mask] < 0) {
-    throw ExceptionFreeserf("Failed to draw triangle down (3).");
-  }
+  int horiz_tiles = map->get_cols()/MAP_TILE_COLS;
+  int vert_tiles = map->get_rows()/MAP_TILE_ROWS;
 
-  int type = map->type_down(map->move_up_left(pos));
-  int index = (type << 3) | tri_mask[mask];
-  if (index >= 128) {
-    throw ExceptionFreeserf("Failed to draw triangle down (4).");
-  }
+  int tile_width = MAP_TILE_COLS*MAP_TILE_WIDTH;
+  int tile_height = MAP_TILE_ROWS*MAP_TILE_HEIGHT;
 
-  int sprite = tri_spr[index];
+  int tc = (mx / tile_width) % horiz_tiles;
+  int tr = (my / tile_height) % vert_tiles;
+  int tid = tc + horiz_tiles*tr;
 
-  tile->draw_masked_sprite(lx, ly + MAP_TILE_HEIGHT,
-                            Data::AssetMapMaskDown, mask,
-                            Data::AssetMapGround, sprite);
+  /* Keep showing the tile until it is rendered again. */
+  if (landscape_tiles.contains(tid) ||
+      pending_tiles.find(tid) != pending_tiles.end()) {
+    request_tile(tid, tc, tr);
+  }
 }
 
-/* Draw a column (vertical) of tiles, starting at an up pointing tile. */
+/* Draw the surroundings of pos again, large enough for the objects on it
+   and the map cursor. */
 void
-Viewport::draw_up_tile_col(MapPos pos, int x_base, int y_base, int max_y,
-                           Frame *tile) {
-  int m = map->get_height(pos);
-  int left, right;
-
-  /* Loop until a tile is inside the frame (y >= 0). */
-  while (1) {
-    /* move down */
-    pos = map->move_down(pos);
-
-    left = map->get_height(pos);
-    right = map->get_height(map->move_right(pos));
-
-    int t = std::min(left, right);
-    /*if (left == right) t -= 1;*/ /* TODO ? */
-
-    if (y_base + MAP_TILE_HEIGHT - 4*t >= 0) break;
-
-    y_base += MAP_TILE_HEIGHT;
-
-    /* move down right */
-    pos = map->move_down_right(pos);
-
-    m = map->get_height(pos);
-
-    if (y_base + MAP_TILE_HEIGHT - 4*m >= 0) goto down;
-
-    y_base += MAP_TILE_HEIGHT;
+Viewport::redraw_map_area(MapPos pos) {
+  /* The position may be left from the map of a previous game. */
+  if (pos >= map->geom().tile_count()) {
+    return;
   }
 
-  /* Loop until a tile is completely outside the frame (y >= max_y). */
-  while (1) {
-    if (y_base - 2*MAP_TILE_HEIGHT - 4*m >= max_y) break;
-
-    draw_triangle_up(x_base, y_base - 4*m, m, left, right, pos, tile);
+  int sx = 0;
+  int sy = 0;
+  screen_pix_from_map_coord(pos, &sx, &sy);
 
-    y_base += MAP_TILE_HEIGHT;
+  /* The map wraps around, so pos may also be in view one map further left
+     or up. */
+  int map_width = map->get_cols()*MAP_TILE_WIDTH;
+  int map_height = map->get_rows()*MAP_TILE_HEIGHT;
+  for (int wy = 0; wy < 2; wy++) {
+    for (int wx = 0; wx < 2; wx++) {
+      int x = sx - wx*map_width - wy*(map->get_rows()*MAP_TILE_WIDTH)/2;
+      int y = sy - wy*map_height;
+      set_redraw(x - 2*MAP_TILE_WIDTH, y - 5*MAP_TILE_HEIGHT,
+                 4*MAP_TILE_WIDTH, 7*MAP_TILE_HEIGHT);
+    }
+  }
+}
 
-    /* move down right */
-    pos = map->move_down_right(pos);
-    m = map->get_height(pos);
+Frame *
+Viewport::get_tile_frame(unsigned int tid, int tc, int tr) {
+  Frame *tile_frame = landscape_tiles.get(tid);
+  if (tile_frame != nullptr) {
+    return tile_frame;
+  }
 
-    if (y_base - 2*MAP_TILE_HEIGHT - 4*std::max(left, right) >= max_y) break;
+  /* Needed right away, so render it here. A result of the thread pool
+     that is still pending is outdated by this. */
+  pending_tiles.erase(tid);
+  Log::Verbose["viewport"] << "map: " << map->get_cols()*MAP_TILE_WIDTH << ","
+                           << map->get_rows()*MAP_TILE_HEIGHT << ", cols,rows: "
+                           << map->get_cols() << "," << map->get_rows()
+                           << ", tc,tr: " << tc << "," << tr;
+  return landscape_tiles.insert(tid, upload_tile(rasterizer->render(*map, tc,
+                                                                    tr)),
+                                MAP_TILE_FRAME_SIZE);
+}
 
-  down:
-    draw_triangle_down(x_base, y_base - 4*m, m, left, right, pos, tile);
+/* Copy a tile rendered by the rasterizer to a new frame. */
+std::unique_ptr<Frame>
+Viewport::upload_tile(PSprite sprite) {
+  unsigned int tile_width = static_cast<unsigned int>(sprite->get_width());
+  unsigned int tile_height = static_cast<unsigned int>(sprite->get_height());
+  std::unique_ptr<Frame> tile_frame(
+    Graphics::get_instance().create_frame(tile_width, tile_height));
+  tile_frame->draw_sprite(0, 0, sprite);
 
-    y_base += MAP_TILE_HEIGHT;
+#if 0
+  /* Draw a border around the tile for debug. */
+  tile_frame->draw_rect(0, 0, tile_width, tile_height, Color(0xff, 0x00, 0x00));
+#endif
 
-    /* move down */
-    pos = map->move_down(pos);
+  return tile_frame;
+}
 
-    left = map->get_height(pos);
-    right = map->get_height(map->move_right(pos));
+/* Queue tile to be rendered on the thread pool. */
+void
+Viewport::request_tile(unsigned int tid, int tc, int tr) {
+  if (pending_tiles.find(tid) == pending_tiles.end()) {
+    tile_requests.push_back(TileRequest{tid, tc, tr});
   }
+  pending_tiles[tid] = ++tile_serial;
 }
 
-/* Draw a column (vertical) of tiles, starting at a down pointing tile. */
+/* Start rendering the requested tiles from a copy of the map, which is
+   cheap as the copy shares the tile data with the original until the game
+   changes it. */
 void
-Viewport::draw_down_tile_col(MapPos pos, int x_base, int y_base,
-                             int max_y, Frame *tile) {
-  int left = map->get_height(pos);
-  int right = map->get_height(map->move_right(pos));
-  int m;
-
-  /* Loop until a tile is inside the frame (y >= 0). */
-  while (true) {
-    /* move down right */
-    pos = map->move_down_right(pos);
-
-    m = map->get_height(pos);
-
-    if (y_base + MAP_TILE_HEIGHT - 4*m >= 0) goto down;
-
-    y_base += MAP_TILE_HEIGHT;
-
-    /* move down */
-    pos = map->move_down(pos);
-
-    left = map->get_height(pos);
-    right = map->get_height(map->move_right(pos));
-
-    int t = std::min(left, right);
-    /*if (left == right) t -= 1;*/ /* TODO ? */
-
-    if (y_base + MAP_TILE_HEIGHT - 4*t >= 0) break;
-
-    y_base += MAP_TILE_HEIGHT;
+Viewport::dispatch_tile_requests() {
+  if (tile_requests.empty()) {
+    return;
   }
 
-  /* Loop until a tile is completely outside the frame (y >= max_y). */
-  while (1) {
-    if (y_base - 2*MAP_TILE_HEIGHT - 4*m >= max_y) break;
-
-    draw_triangle_up(x_base, y_base - 4*m, m, left, right, pos, tile);
-
-    y_base += MAP_TILE_HEIGHT;
-
-    /* move down right */
-    pos = map->move_down_right(pos);
-    m = map->get_height(pos);
-
-    if (y_base - 2*MAP_TILE_HEIGHT - 4*std::max(left, right) >= max_y) break;
-
-  down:
-    draw_triangle_down(x_base, y_base - 4*m, m, left, right, pos, tile);
-
-    y_base += MAP_TILE_HEIGHT;
-
-    /* move down */
-    pos = map->move_down(pos);
+  std::shared_ptr<const Map> map_copy = std::make_shared<Map>(*map);
+  std::shared_ptr<LandscapeRasterizer> tile_rasterizer = rasterizer;
+  std::shared_ptr<TileQueue> queue = rendered_tiles;
+  for (const TileRequest &request : tile_requests) {
+    RenderedTile tile = { request.tid, pending_tiles[request.tid], nullptr };
+    int tc = request.tc;
+    int tr = request.tr;
+    ThreadPool::get_instance().run([map_copy, tile_rasterizer, queue, tile,
+                                    tc, tr]() {
+      RenderedTile result = tile;
+      try {
+        result.sprite = tile_rasterizer->render(*map_copy, tc, tr);
+      } catch (ExceptionFreeserf& e) {
+        Log::Warn["viewport"] << "Failed to render landscape: " << e.what();
+      }
+      std::lock_guard<std::mutex> lock(queue->mutex);
+      queue->tiles.push_back(result);
+    });
+  }
+  tile_requests.clear();
+}
 
-    left = map->get_height(pos);
-    right = map->get_height(map->move_right(pos));
+/* Upload the tiles finished by the thread pool that are still current. */
+/* Returns whether a tile that was shown before has been replaced. */
+bool
+Viewport::collect_rendered_tiles() {
+  std::vector<RenderedTile> tiles;
+  {
+    std::lock_guard<std::mutex> lock(rendered_tiles->mutex);
+    tiles.swap(rendered_tiles->tiles);
+  }
+
+  bool replaced = false;
+  for (const RenderedTile &tile : tiles) {
+    auto it = pending_tiles.find(tile.tid);
+    if (it == pending_tiles.end() || it->second != tile.serial) {
+      continue;
+    }
+    pending_tiles.erase(it);
+    replaced |= landscape_tiles.contains(tile.tid);
+    if (tile.sprite) {
+      landscape_tiles.insert(tile.tid, upload_tile(tile.sprite),
+                             MAP_TILE_FRAME_SIZE);
+    } else {
+      landscape_tiles.erase(tile.tid);
+    }
   }
-}
 
-void
-Viewport::layout() {
-  landscape_tiles.clear();
+  return replaced;
 }
 
-void
-Viewport::redraw_map_pos(MapPos pos) {
-  int mx, my;
-  map_pix_from_map_coord(pos, map->get_height(pos), &mx, &my);
-
+/* Tile at the pixel x, y of the viewport, which may be outside of it. */
+unsigned int
+Viewport::get_tile_at(int x, int y, int *tc, int *tr) {
   int horiz_tiles = map->get_cols()/MAP_TILE_COLS;
   int vert_tiles = map->get_rows()/MAP_TILE_ROWS;
 
-  int tile_width = MAP_TILE_COLS*MAP_TILE_WIDTH;
-  int tile_height = MAP_TILE_ROWS*MAP_TILE_HEIGHT;
-
-  int tc = (mx / tile_width) % horiz_tiles;
-  int tr = (my / tile_height) % vert_tiles;
-  int tid = tc + horiz_tiles*tr;
+  int map_width = map->get_cols()*MAP_TILE_WIDTH;
+  int map_height = map->get_rows()*MAP_TILE_HEIGHT;
 
-  TilesMap::iterator it = landscape_tiles.find(tid);
-  if (it != landscape_tiles.end()) {
-    landscape_tiles.erase(tid);
+  /* Like in draw_landscape(), wrapping around vertically shifts the map. */
+  int my = offset_y + y;
+  int mx = offset_x + x;
+  while (my < 0) {
+    my += map_height;
+    mx -= (map->get_rows()*MAP_TILE_WIDTH)/2;
   }
+  while (my >= map_height) {
+    my -= map_height;
+    mx += (map->get_rows()*MAP_TILE_WIDTH)/2;
+  }
+  mx %= map_width;
+  if (mx < 0) mx += map_width;
+
+  *tc = (mx / (MAP_TILE_COLS*MAP_TILE_WIDTH)) % horiz_tiles;
+  *tr = (my / (MAP_TILE_ROWS*MAP_TILE_HEIGHT)) % vert_tiles;
+  return *tc + horiz_tiles * *tr;
 }
 
-Frame *
-Viewport::get_tile_frame(unsigned int tid, int tc, int tr) {
-  TilesMap::iterator it = landscape_tiles.find(tid);
-  if (it != landscape_tiles.end()) {
-    return it->second.get();
+/* Request the tiles just beyond the edges the view is scrolling towards. */
+void
+Viewport::prefetch_tiles() {
+  if (scroll_x == 0 && scroll_y == 0) {
+    return;
   }
 
   int tile_width = MAP_TILE_COLS*MAP_TILE_WIDTH;
   int tile_height = MAP_TILE_ROWS*MAP_TILE_HEIGHT;
 
-  std::unique_ptr<Frame> tile_frame(
-    Graphics::get_instance().create_frame(tile_width, tile_height));
-  tile_frame->fill_rect(0, 0, tile_width, tile_height, Color::black);
-
-  int col = (tc*MAP_TILE_COLS + (tr*MAP_TILE_ROWS)/2) % map->get_cols();
-  int row = tr*MAP_TILE_ROWS;
-  MapPos pos = map->pos(col, row);
-
-  int x_base = -(MAP_TILE_WIDTH/2);
-
-  /* Draw one extra column as half a column will be outside the
-   map tile on both right and left side.. */
-  for (int col = 0; col < MAP_TILE_COLS+1; col++) {
-    draw_up_tile_col(pos, x_base, 0, tile_height, tile_frame.get());
-    draw_down_tile_col(pos, x_base + MAP_TILE_WIDTH/2, 0, tile_height,
-                       tile_frame.get());
-
-    pos = map->move_right(pos);
-    x_base += MAP_TILE_WIDTH;
+  /* A tile overlapping the ring contains one of the points sampled at tile
+     size distances. */
+  std::vector<std::pair<int, int>> points;
+  if (scroll_x != 0) {
+    int x = (scroll_x > 0) ? width : -1;
+    for (int y = 0; y < height + tile_height; y += tile_height) {
+      int py = std::min(y, height - 1);
+      points.push_back(std::make_pair(x, py));
+      points.push_back(std::make_pair(x + scroll_x * (tile_width - 1), py));
+    }
+  }
+  if (scroll_y != 0) {
+    int y = (scroll_y > 0) ? height : -1;
+    for (int x = 0; x < width + tile_width; x += tile_width) {
+      int px = std::min(x, width - 1);
+      points.push_back(std::make_pair(px, y));
+      points.push_back(std::make_pair(px, y + scroll_y * (tile_height - 1)));
+    }
   }
 
-#if 0
-  /* Draw a border around the tile for debug. */
-  tile_frame->draw_rect(0, 0, tile_width, tile_height, Color(0xff, 0x00, 0x00));
-#endif
-
-  Log::Verbose["viewport"] << "map: " << map->get_cols()*MAP_TILE_WIDTH << ","
-                           << map->get_rows()*MAP_TILE_HEIGHT << ", cols,rows: "
-                           << map->get_cols() << "," << map->get_rows()
-                           << ", tc,tr: " << tc << "," << tr << ", tw,th: "
-                           << tile_width << "," << tile_height;
-
-  landscape_tiles[tid] = std::move(tile_frame);
-
-  return landscape_tiles[tid].get();
+  for (const auto &point : points) {
+    int tc, tr;
+    unsigned int tid = get_tile_at(point.first, point.second, &tc, &tr);
+    if (!landscape_tiles.contains(tid) &&
+        pending_tiles.find(tid) == pending_tiles.end()) {
+      request_tile(tid, tc, tr);
+    }
+  }
 }
 
 void
 Viewport::draw_landscape() {
+  collect_rendered_tiles();
+
   int horiz_tiles = map->get_cols()/MAP_TILE_COLS;
   int vert_tiles = map->get_rows()/MAP_TILE_ROWS;
 
@@ -700,7 +644,7 @@ Viewport::draw_ocupation_flag(Building *building, int lx, int ly, float mul) {
   if (building->has_knight()) {
     draw_game_sprite(lx, ly -
                      static_cast<int>(mul * building->get_knight_count()),
-                     182 + ((interface->get_game()->get_tick() >> 3) & 3) +
+                     182 + ((game->get_tick() >> 3) & 3) +
                      4 * static_cast<int>(building->get_threat_level()));
   }
 }
@@ -767,7 +711,7 @@ Viewport::draw_unharmed_building(Building *building, int lx, int ly) {
       if (building->is_playing_sfx()) { /* Draw elevator down */
         draw_game_sprite(lx-6, ly-39, 153);
         MapPos pos = building->get_position();
-        if ((((interface->get_game()->get_tick() +
+        if ((((game->get_tick() +
                reinterpret_cast<uint8_t*>(&pos)[1]) >> 3) & 7) == 0
             && random.random() < 40000) {
           play_sound(Audio::TypeSfxElevator);
@@ -804,7 +748,7 @@ Viewport::draw_unharmed_building(Building *building, int lx, int ly) {
         for (int p = 1; p <= pigs_count; p++) {
           if (pigs_count >= pigs_layout[p * 4]) {
             int i = (pigs_layout[p * 4 + 1]
-                     + (interface->get_game()->get_tick() >> 3)) & 0xfe;
+                     + (game->get_tick() >> 3)) & 0xfe;
             draw_game_sprite(lx + pigfarm_anim[i + 1] + pigs_layout[p * 4 + 2],
                              ly + pigs_layout[p * 4 + 3], pigfarm_anim[i]);
           }
@@ -813,14 +757,14 @@ Viewport::draw_unharmed_building(Building *building, int lx, int ly) {
       break;
     case Building::TypeMill:
       if (building->is_active()) {
-        if ((interface->get_game()->get_tick() >> 4) & 3) {
+        if ((game->get_tick() >> 4) & 3) {
           building->stop_playing_sfx();
         } else if (!building->is_playing_sfx()) {
           building->start_playing_sfx();
           play_sound(Audio::TypeSfxMillGrinding);
         }
         draw_shadow_and_building_sprite(lx, ly, map_building_sprite[type] +
-                                ((interface->get_game()->get_tick() >> 4) & 3));
+                                ((game->get_tick() >> 4) & 3));
       } else {
         draw_shadow_and_building_sprite(lx, ly, map_building_sprite[type]);
       }
@@ -829,13 +773,13 @@ Viewport::draw_unharmed_building(Building *building, int lx, int ly) {
       draw_shadow_and_building_sprite(lx, ly, map_building_sprite[type]);
       if (building->is_active()) {
         draw_game_sprite(lx + 5, ly-21,
-                         154 + ((interface->get_game()->get_tick() >> 3) & 7));
+                         154 + ((game->get_tick() >> 3) & 7));
       }
       break;
     case Building::TypeSteelSmelter:
       draw_shadow_and_building_sprite(lx, ly, map_building_sprite[type]);
       if (building->is_active()) {
-        int i = (interface->get_game()->get_tick() >> 3) & 7;
+        int i = (game->get_tick() >> 3) & 7;
         if (i == 0 || (i == 7 && !building->is_playing_sfx())) {
           building->start_playing_sfx();
           play_sound(Audio::TypeSfxGoldBoils);
@@ -850,7 +794,7 @@ Viewport::draw_unharmed_building(Building *building, int lx, int ly) {
       draw_shadow_and_building_sprite(lx, ly, map_building_sprite[type]);
       if (building->is_active()) {
         draw_game_sprite(lx-16, ly-21,
-                         128 + ((interface->get_game()->get_tick() >> 3) & 7));
+                         128 + ((game->get_tick() >> 3) & 7));
       }
       break;
     case Building::TypeTower:
@@ -862,14 +806,14 @@ Viewport::draw_unharmed_building(Building *building, int lx, int ly) {
       draw_ocupation_flag(building, lx - 12, ly - 21, 0.5f);
       if (building->has_knight()) {
         draw_game_sprite(lx+22, ly - 34 - (building->get_knight_count()+1)/2,
-                    182 + (((interface->get_game()->get_tick() >> 3) + 2) & 3) +
+                    182 + (((game->get_tick() >> 3) + 2) & 3) +
                          4 * static_cast<int>(building->get_threat_level()));
       }
       break;
     case Building::TypeGoldSmelter:
       draw_shadow_and_building_sprite(lx, ly, map_building_sprite[type]);
       if (building->is_active()) {
-        int i = (interface->get_game()->get_tick() >> 3) & 7;
+        int i = (game->get_tick() >> 3) & 7;
         if (i == 0 || (i == 7 && !building->is_playing_sfx())) {
           building->start_playing_sfx();
           play_sound(Audio::TypeSfxGoldBoils);
@@ -1114,8 +1058,14 @@ Viewport::draw_burning_building(Building *building, int lx, int ly) {
     building->stop_playing_sfx();
   }
 
-  uint16_t delta = interface->get_game()->get_tick() - building->get_tick();
-  building->set_tick(interface->get_game()->get_tick());
+  /* A snapshot of the game is refreshed every tick, including the burning
+     counter, so it only needs to be advanced here when drawing the game
+     itself. */
+  uint16_t delta = 0;
+  if (!interface->is_threaded()) {
+    delta = game->get_tick() - building->get_tick();
+    building->set_tick(game->get_tick());
+  }
 
   if (building->get_burning_counter() >= delta) {
     building->decrease_burning_counter(delta);  // TODO(jonls): this is also
@@ -1143,7 +1093,7 @@ Viewport::draw_burning_building(Building *building, int lx, int ly) {
 
 void
 Viewport::draw_building(MapPos pos, int lx, int ly) {
-  Building *building = interface->get_game()->get_building_at_pos(pos);
+  Building *building = game->get_building_at_pos(pos);
 
   if (building->is_burning()) {
     draw_burning_building(building, lx, ly);
@@ -1154,7 +1104,7 @@ Viewport::draw_building(MapPos pos, int lx, int ly) {
 
 void
 Viewport::draw_water_waves(MapPos pos, int lx, int ly) {
-  int sprite = (((pos ^ 5) + (interface->get_game()->get_tick() >> 3)) & 0xf);
+  int sprite = (((pos ^ 5) + (game->get_tick() >> 3)) & 0xf);
 
   if (map->type_down(pos) <= Map::TerrainWater3 &&
       map->type_up(pos) <= Map::TerrainWater3) {
@@ -1184,7 +1134,7 @@ Viewport::draw_water_waves_row(MapPos pos, int y_base, int cols,
 
 void
 Viewport::draw_flag_and_res(MapPos pos, int lx, int ly) {
-  Flag *flag = interface->get_game()->get_flag_at_pos(pos);
+  Flag *flag = game->get_flag_at_pos(pos);
 
   int res_pos[] = {  6, -4,
                     10, -2,
@@ -1203,8 +1153,8 @@ Viewport::draw_flag_and_res(MapPos pos, int lx, int ly) {
   }
 
   int pl_num = flag->get_owner();
-  Color player_color = interface->get_player_color(pl_num);
-  int spr = 0x80 + ((interface->get_game()->get_tick() >> 3) & 3);
+  Color player_color = get_player_color(pl_num);
+  int spr = 0x80 + ((game->get_tick() >> 3) & 3);
 
   draw_shadow_and_building_sprite(lx, ly, spr, player_color);
 
@@ -1238,7 +1188,7 @@ Viewport::draw_map_objects_row(MapPos pos, int y_base, int cols, int x_base) {
         /* Adding sprite number to animation ensures
            that the tree animation won't be synchronized
            for all trees on the map. */
-        int tree_anim = (interface->get_game()->get_tick() + sprite) >> 4;
+        int tree_anim = (game->get_tick() + sprite) >> 4;
         if (sprite < 16) {
           sprite = (sprite & ~7) + (tree_anim & 7);
         } else {
@@ -1885,7 +1835,7 @@ Viewport::draw_active_serf(Serf *serf, MapPos pos, int x_base, int y_base) {
   int body = serf_get_body(serf);
 
   if (body > -1) {
-    Color color = interface->get_player_color(serf->get_owner());
+    Color color = get_player_color(serf->get_owner());
     draw_row_serf(lx, ly, true, color, body);
     if (layers & Layer::LayerGrid) {
       frame->draw_number(lx, ly, serf->get_index(), Color(0, 0, 128));
@@ -1903,7 +1853,7 @@ Viewport::draw_active_serf(Serf *serf, MapPos pos, int x_base, int y_base) {
       serf->get_state() == Serf::StateKnightAttackingDefeatFree) {
     int index = serf->get_attacking_def_index();
     if (index != 0) {
-      Serf *def_serf = interface->get_game()->get_serf(index);
+      Serf *def_serf = game->get_serf(index);
 
       Animation animation =
                            data_source->get_animation(def_serf->get_animation(),
@@ -1914,7 +1864,7 @@ Viewport::draw_active_serf(Serf *serf, MapPos pos, int x_base, int y_base) {
       int body = serf_get_body(def_serf);
 
       if (body > -1) {
-        Color color = interface->get_player_color(def_serf->get_owner());
+        Color color = get_player_color(def_serf->get_owner());
         draw_row_serf(lx, ly, true, color, body);
       }
     }
@@ -1926,7 +1876,7 @@ Viewport::draw_active_serf(Serf *serf, MapPos pos, int x_base, int y_base) {
       animation.sprite >= 0x80 && animation.sprite < 0xc0) {
     int index = serf->get_attacking_def_index();
     if (index != 0) {
-      Serf *def_serf = interface->get_game()->get_serf(index);
+      Serf *def_serf = game->get_serf(index);
 
       if (serf->get_animation() >= 146 && serf->get_animation() < 156) {
         if ((serf->get_attacking_field_D() == 0 ||
@@ -2001,7 +1951,7 @@ Viewport::draw_serf_row(MapPos pos, int y_base, int cols, int x_base) {
 
     /* Active serf */
     if (map->has_serf(pos)) {
-      Serf *serf = interface->get_game()->get_serf_at_pos(pos);
+      Serf *serf = game->get_serf_at_pos(pos);
 
       if (serf->get_state() != Serf::StateMining ||
           (serf->get_mining_substate() != 3 &&
@@ -2023,11 +1973,11 @@ Viewport::draw_serf_row(MapPos pos, int y_base, int cols, int x_base) {
         lx = x_base + arr_3[2* map->paths(pos)];
         ly = y_base - 4 * map->get_height(pos) +
             arr_3[2 * map->paths(pos) + 1];
-        body = arr_2[((interface->get_game()->get_tick() +
+        body = arr_2[((game->get_tick() +
                        arr_1[pos & 0xf]) >> 3) & 0x7f];
       }
 
-      Color color = interface->get_player_color(map->get_owner(pos));
+      Color color = get_player_color(map->get_owner(pos));
       draw_row_serf(lx, ly, true, color, body);
     }
   }
@@ -2041,7 +1991,7 @@ Viewport::draw_serf_row_behind(MapPos pos, int y_base, int cols, int x_base) {
        i++, x_base += MAP_TILE_WIDTH, pos = map->move_right(pos)) {
     /* Active serf */
     if (map->has_serf(pos)) {
-      Serf *serf = interface->get_game()->get_serf_at_pos(pos);
+      Serf *serf = game->get_serf_at_pos(pos);
 
       if (serf->get_state() == Serf::StateMining &&
           (serf->get_mining_substate() == 3 ||
@@ -2129,7 +2079,7 @@ Viewport::draw_map_cursor_possible_build() {
   int y_off = 0;
   MapPos base_pos = get_offset(&x_off, &y_off);
 
-  PGame game = interface->get_game();
+  Player *player = game->get_player(interface->get_player()->get_index());
 
   for (int x_base = x_off; x_base < width + MAP_TILE_WIDTH;
        x_base += MAP_TILE_WIDTH) {
@@ -2150,12 +2100,12 @@ Viewport::draw_map_cursor_possible_build() {
 
       /* Draw possible building */
       int sprite = -1;
-      if (game->can_build_castle(pos, interface->get_player())) {
+      if (game->can_build_castle(pos, player)) {
         sprite = 50;
-      } else if (game->can_player_build(pos, interface->get_player()) &&
+      } else if (game->can_player_build(pos, player) &&
                  Map::map_space_from_obj[map->get_obj(pos)] == Map::SpaceOpen &&
                  (game->can_build_flag(map->move_down_right(pos),
-                                       interface->get_player()) ||
+                                       player) ||
                  map->has_flag(map->move_down_right(pos)))) {
         if (game->can_build_mine(pos)) {
           sprite = 48;
@@ -2270,12 +2220,64 @@ Viewport::draw_height_grid_overlay(const Color &color) {
   }
 }
 
+/* Hit rate of a cache in percent. */
+template <typename Stats>
+static unsigned int
+hit_rate(const Stats &stats) {
+  size_t lookups = stats.hits + stats.misses;
+  if (lookups == 0) {
+    return 100;
+  }
+  return static_cast<unsigned int>(stats.hits * 100 / lookups);
+}
+
+/* Draw the use of the caches and the renderer in the top left corner. */
+void
+Viewport::draw_stats_overlay() {
+  std::vector<std::string> lines;
+
+  const Image::ImageCache &images = Image::get_cache();
+  std::stringstream str;
+  str << "images " << images.get_count() << " "
+      << images.get_cost() / 1024 << "/" << images.get_budget() / 1024
+      << "k hit " << hit_rate(images.get_stats()) << "% evict "
+      << images.get_stats().evictions;
+  lines.push_back(str.str());
+
+  str.str("");
+  str << "tiles " << landscape_tiles.get_count() << " "
+      << landscape_tiles.get_cost() / 1024 << "/"
+      << landscape_tiles.get_budget() / 1024 << "k hit "
+      << hit_rate(landscape_tiles.get_stats()) << "% evict "
+      << landscape_tiles.get_stats().evictions;
+  lines.push_back(str.str());
+
+  Video::DrawStats draw = Graphics::get_instance().get_draw_stats();
+  str.str("");
+  str << "draws " << draw.draw_calls << " images " << draw.images
+      << " state " << draw.state_changes << " pages " << draw.atlas_pages;
+  lines.push_back(str.str());
+
+  int y = 4;
+  for (const std::string &line : lines) {
+    frame->draw_string(4, y, line, Color::white, Color::black);
+    y += 10;
+  }
+}
+
 void
 Viewport::internal_draw() {
   if (map == NULL) {
     return;
   }
 
+  /* Only the render game is accessed while drawing the map, so the game can
+     keep running in the meantime. Views of the live game keep the lock. */
+  bool live = (game == interface->get_game());
+  if (!live) {
+    interface->unlock_game();
+  }
+
   if (layers & LayerLandscape) {
     draw_landscape();
   }
@@ -2290,6 +2292,17 @@ Viewport::internal_draw() {
   if (layers & LayerCursor) {
     draw_map_cursor();
   }
+  if (layers & LayerLandscape) {
+    prefetch_tiles();
+    dispatch_tile_requests();
+  }
+  if (layers & LayerStats) {
+    draw_stats_overlay();
+  }
+
+  if (!live) {
+    interface->lock_game();
+  }
 }
 
 bool
@@ -2371,6 +2384,9 @@ Viewport::handle_dbl_click(int lx, int ly, Event::Button button) {
 
   MapPos clk_pos = map_pos_from_screen_pix(lx, ly);
 
+  /* Act on the live game rather than the one being drawn. */
+  PMap map = interface->get_game()->get_map();
+
   if (interface->is_building_road()) {
     if (clk_pos != interface->get_map_cursor_pos()) {
       MapPos pos = interface->get_building_road().get_end(map.get());
@@ -2443,27 +2459,9 @@ Viewport::handle_dbl_click(int lx, int ly, Event::Button button) {
 
         if (building->is_done() &&
             building->is_military()) {
-          if (!building->is_active() ||
-              building->get_threat_level() != 3) {
-            /* It is not allowed to attack
-               if currently not occupied or
-               is too far from the border. */
-            play_sound(Audio::TypeSfxNotAccepted);
-            return false;
-          }
-
-          int found = 0;
-          for (int i = 257; i >= 0; i--) {
-            MapPos pos = map->pos_add_spirally(building->get_position(),
-                                                       7+257-i);
-            if (map->has_owner(pos)
-                && map->get_owner(pos) == player->get_index()) {
-              found = 1;
-              break;
-            }
-          }
-
-          if (!found) {
+          /* It is not allowed to attack if currently not occupied or
+             is too far from the border. */
+          if (!player->can_attack(building)) {
             play_sound(Audio::TypeSfxNotAccepted);
             return false;
           }
@@ -2471,18 +2469,7 @@ Viewport::handle_dbl_click(int lx, int ly, Event::Button button) {
           /* Action accepted */
           play_sound(Audio::TypeSfxClick);
 
-          int max_knights = 0;
-          switch (building->get_type()) {
-            case Building::TypeHut: max_knights = 3; break;
-            case Building::TypeTower: max_knights = 6; break;
-            case Building::TypeFortress: max_knights = 12; break;
-            case Building::TypeCastle: max_knights = 20; break;
-            default: NOT_REACHED(); break;
-          }
-
-          int knights =
-                 player->knights_available_for_attack(building->get_position());
-          player->knights_attacking = std::min(knights, max_knights);
+          player->prepare_attack(building);
           interface->open_popup(PopupBox::TypeStartAttack);
         }
       }
@@ -2501,22 +2488,90 @@ Viewport::handle_drag(int lx, int ly) {
   return true;
 }
 
-Viewport::Viewport(Interface *_interface, PMap _map)
-  : interface(_interface)
-  , map(_map) {
+Viewport::Viewport(Interface *_interface, PGame _game)
+  : landscape_tiles(tile_cache_budget)
+  , interface(_interface)
+  , game(_game)
+  , map(_game->get_map()) {
   map->add_change_handler(this);
   layers = LayerAll;
 
   offset_x = 0;
   offset_y = 0;
+  scroll_x = 0;
+  scroll_y = 0;
+  tile_serial = 0;
 
   last_tick = 0;
 
   data_source = Data::get_instance().get_data_source();
+  rasterizer = std::make_shared<LandscapeRasterizer>(data_source);
+  rendered_tiles = std::make_shared<TileQueue>();
 }
 
 Viewport::~Viewport() {
   map->del_change_handler(this);
+
+  const TileCache::Stats &stats = landscape_tiles.get_stats();
+  Log::Debug["viewport"] << "tile cache: " << stats.hits << " hits, "
+                         << stats.misses << " misses, " << stats.evictions
+                         << " evictions";
+}
+
+void
+Viewport::set_render_game(PGame new_game) {
+  if (new_game == game) {
+    return;
+  }
+
+  if (interface->is_threaded()) {
+    inherit_sfx_state(game.get());
+  }
+
+  map->del_change_handler(this);
+  game = std::move(new_game);
+  map = game->get_map();
+  map->add_change_handler(this);
+
+  set_redraw();
+}
+
+/* Sound effect state is stored in the game objects and updated while drawing
+   them. A new snapshot has to take it over from the previous one, or sounds
+   would be restarted every tick. */
+void
+Viewport::inherit_sfx_state(Game *previous) {
+  for (Serf *serf : game->get_serfs()) {
+    Serf *prev = previous->get_serf(serf->get_index());
+    if ((prev != nullptr) && prev->playing_sfx()) {
+      serf->start_playing_sfx();
+    } else {
+      serf->stop_playing_sfx();
+    }
+  }
+
+  /* Only buildings where the sound effect state is owned by the drawing code;
+     for mines it is set by the game. */
+  for (Building *building : game->get_buildings()) {
+    if (!building->is_burning() &&
+        building->get_type() != Building::TypeMill &&
+        building->get_type() != Building::TypeSteelSmelter &&
+        building->get_type() != Building::TypeGoldSmelter) {
+      continue;
+    }
+    Building *prev = previous->get_building(building->get_index());
+    if ((prev != nullptr) && prev->is_playing_sfx()) {
+      building->start_playing_sfx();
+    } else {
+      building->stop_playing_sfx();
+    }
+  }
+}
+
+Color
+Viewport::get_player_color(unsigned int player_index) {
+  Player::Color player_color = game->get_player(player_index)->get_color();
+  return Color(player_color.red, player_color.green, player_color.blue);
 }
 
 void
@@ -2526,6 +2581,7 @@ Viewport::on_height_changed(MapPos pos) {
 
 void
 Viewport::on_object_changed(MapPos pos) {
+  redraw_map_area(pos);
   if (interface->get_map_cursor_pos() == pos) {
     interface->update_map_cursor_pos(pos);
   }
@@ -2698,6 +2754,10 @@ Viewport::move_by_pixels(int lx, int ly) {
 
   offset_x += lx;
   offset_y += ly;
+  if (lx != 0 || ly != 0) {
+    scroll_x = (lx > 0) - (lx < 0);
+    scroll_y = (ly > 0) - (ly < 0);
+  }
 
   if (offset_y < 0) {
     offset_y += lheight;
@@ -2717,11 +2777,16 @@ Viewport::move_by_pixels(int lx, int ly) {
 /* Called periodically when the game progresses. */
 void
 Viewport::update() {
-  int tick_xor = interface->get_game()->get_tick() ^ last_tick;
-  last_tick = interface->get_game()->get_tick();
+  int tick_xor = game->get_tick() ^ last_tick;
+  last_tick = game->get_tick();
 
   /* Viewport animation does not care about low bits in anim */
   if (tick_xor >= 1 << 3) {
     set_redraw();
   }
+
+  /* Show tiles rendered again after the height of the map changed. */
+  if (collect_rendered_tiles()) {
+    set_redraw();
+  }
 }
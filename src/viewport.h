@@ -24,13 +24,18 @@
 
 #include <map>
 #include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <vector>
 
 #include "src/gui.h"
+#include "src/game.h"
 #include "src/map.h"
 #include "src/building.h"
+#include "src/lru-cache.h"
 
 class Interface;
 class DataSource;
+class LandscapeRasterizer;
 
 class Viewport : public GuiObject, public Map::Handler {
  public:
@@ -42,6 +47,7 @@ class Viewport : public GuiObject, public Map::Handler {
     LayerCursor = 1<<4,
     LayerGrid = 1<<5,
     LayerBuilds = 1<<6,
+    LayerStats = 1<<7,
     LayerAll = (LayerLandscape |
                 LayerPaths |
                 LayerObjects |
@@ -51,22 +57,59 @@ class Viewport : public GuiObject, public Map::Handler {
 
  protected:
   /* Cache prerendered tiles of the landscape. */
-  typedef std::map<unsigned int, std::unique_ptr<Frame>> TilesMap;
-  TilesMap landscape_tiles;
+  typedef LruCache<unsigned int, Frame> TileCache;
+  TileCache landscape_tiles;
+  /* Memory for cached tiles of new viewports, in bytes. */
+  static size_t tile_cache_budget;
+
+  /* Landscape tiles are rendered on the thread pool. Finished tiles are
+     queued until the interface thread uploads them; the queue is shared
+     with the tasks so it outlives the viewport. */
+  typedef struct RenderedTile {
+    unsigned int tid;
+    unsigned int serial;
+    PSprite sprite;
+  } RenderedTile;
+  typedef struct TileQueue {
+    std::mutex mutex;
+    std::vector<RenderedTile> tiles;
+  } TileQueue;
+  std::shared_ptr<LandscapeRasterizer> rasterizer;
+  std::shared_ptr<TileQueue> rendered_tiles;
+  /* Tiles being rendered, with the serial of the latest request. Results
+     of older requests are dropped. */
+  std::map<unsigned int, unsigned int> pending_tiles;
+  typedef struct TileRequest {
+    unsigned int tid;
+    int tc;
+    int tr;
+  } TileRequest;
+  std::vector<TileRequest> tile_requests;
+  unsigned int tile_serial;
 
   int offset_x, offset_y;
+  /* Direction of the last scroll (-1, 0 or 1), to prefetch tiles. */
+  int scroll_x, scroll_y;
   unsigned int layers;
   Interface *interface;
   unsigned int last_tick;
   PDataSource data_source;
 
+  /* Game and map that are drawn. In threaded mode this is a snapshot that is
+     only accessed from the interface thread. */
+  PGame game;
   PMap map;
 
  public:
-  Viewport(Interface *interface, PMap map);
+  Viewport(Interface *interface, PGame game);
   virtual ~Viewport();
 
-  void switch_layer(Layer layer) { layers ^= layer; }
+  void switch_layer(Layer layer) { layers ^= layer; set_redraw(); }
+
+  /* The budget is raised as needed to hold the visible tiles. */
+  static void set_tile_cache_budget(size_t bytes) {
+    tile_cache_budget = bytes; }
+  const TileCache &get_tile_cache() const { return landscape_tiles; }
 
   void move_to_map_pos(MapPos pos);
   void move_by_pixels(int x, int y);
@@ -78,18 +121,13 @@ class Viewport : public GuiObject, public Map::Handler {
   MapPos map_pos_from_screen_pix(int x, int y);
 
   void redraw_map_pos(MapPos pos);
+  void redraw_map_area(MapPos pos);
+
+  void set_render_game(PGame game);
 
   void update();
 
  protected:
-  void draw_triangle_up(int x, int y, int m, int left, int right, MapPos pos,
-                        Frame *frame);
-  void draw_triangle_down(int x, int y, int m, int left, int right,
-                          MapPos pos, Frame *frame);
-  void draw_up_tile_col(MapPos pos, int x_base, int y_base, int max_y,
-                        Frame *frame);
-  void draw_down_tile_col(MapPos pos, int x_base, int y_base, int max_y,
-                          Frame *frame);
   void draw_landscape();
   void draw_path_segment(int x, int y, MapPos pos, Direction dir);
   void draw_border_segment(int x, int y, MapPos pos, Direction dir);
@@ -121,8 +159,11 @@ class Viewport : public GuiObject, public Map::Handler {
   void draw_map_cursor();
   void draw_base_grid_overlay(const Color &color);
   void draw_height_grid_overlay(const Color &color);
+  void draw_stats_overlay();
   MapPos get_offset(int *x_off, int *y_off,
                     int *col = nullptr, int *row = nullptr);
+  Color get_player_color(unsigned int player_index);
+  void inherit_sfx_state(Game *previous);
 
   virtual void internal_draw();
   virtual void layout();
@@ -131,6 +172,12 @@ class Viewport : public GuiObject, public Map::Handler {
   virtual bool handle_drag(int x, int y);
 
   Frame *get_tile_frame(unsigned int tid, int tc, int tr);
+  std::unique_ptr<Frame> upload_tile(PSprite sprite);
+  void request_tile(unsigned int tid, int tc, int tr);
+  void dispatch_tile_requests();
+  bool collect_rendered_tiles();
+  unsigned int get_tile_at(int x, int y, int *tc, int *tr);
+  void prefetch_tiles();
 
  public:
   virtual void on_height_changed(MapPos pos);
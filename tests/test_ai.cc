@@ -0,0 +1,238 @@
+/*
+ * test_ai.cc - AI player tests
+ *
+ * Copyright (C) 2026  freeserf developers
+ *
+ * This file is part of freeserf.
+ *
+ * freeserf is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * freeserf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with freeserf.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <sstream>
+#include <string>
+#include <thread>  // NOLINT(build/c++11)
+
+#include "src/ai.h"
+#include "src/game.h"
+#include "src/mission.h"
+#include "src/random.h"
+#include "src/savegame.h"
+
+static const char *seed = "8667715887436237";
+
+static void
+init_game(Game *game, bool castle) {
+  game->init(3, Random(seed));
+  game->set_random(Random(seed));
+  game->add_player(35, 30, 40);
+  if (castle) {
+    game->build_castle(game->get_map()->pos(6, 6), game->get_player(0));
+  }
+}
+
+TEST(AI, PlacesCastle) {
+  Game game;
+  init_game(&game, false);
+  game.start_ai(0);
+  game.get_ai()->add_player(0);
+
+  Player *player = game.get_player(0);
+  for (int i = 0; i < 10 && !player->has_castle(); i++) {
+    game.update();
+  }
+  EXPECT_TRUE(player->has_castle());
+}
+
+TEST(AI, BuildsEconomy) {
+  Game game;
+  init_game(&game, true);
+  game.start_ai(0);
+  game.get_ai()->add_player(0);
+
+  Player *player = game.get_player(0);
+  for (int i = 0; i < 5000; i++) {
+    game.update();
+  }
+
+  EXPECT_LT(0, player->get_completed_building_count(Building::TypeLumberjack) +
+               player->get_incomplete_building_count(Building::TypeLumberjack));
+
+  AIScheduler::Stats stats = game.get_ai()->get_stats(0);
+  EXPECT_LT(0u, stats.plans);
+  EXPECT_LT(0u, stats.actions);
+  EXPECT_EQ(stats.plans, stats.slices);
+  EXPECT_EQ(0u, stats.overruns);
+}
+
+static std::string
+run_ai_game() {
+  Game game;
+  init_game(&game, true);
+  game.start_ai(0);
+  game.get_ai()->add_player(0);
+  for (int i = 0; i < 3000; i++) game.update();
+
+  std::stringstream str;
+  GameStore::get_instance().write(&str, &game);
+  return str.str();
+}
+
+TEST(AI, UnlimitedBudgetIsDeterministic) {
+  EXPECT_EQ(run_ai_game(), run_ai_game());
+}
+
+// Planning that does not complete until released by the test.
+class AIBlocking : public AI {
+ public:
+  std::mutex mutex;
+  std::condition_variable changed;
+  bool started;
+  bool released;
+
+  AIBlocking() : started(false), released(false) {}
+
+  virtual bool plan(Game * /*game*/, Player * /*player*/,
+                    const Budget & /*budget*/, Actions *actions) {
+    std::unique_lock<std::mutex> lock(mutex);
+    started = true;
+    changed.notify_all();
+    changed.wait(lock, [this]() { return released; });
+    actions->push_back([](Game *game, Player *player) {
+      game->build_castle(game->get_map()->pos(6, 6), player);
+    });
+    return true;
+  }
+};
+
+TEST(AI, TicksDoNotWaitForPlanning) {
+  Game game;
+  init_game(&game, false);
+  game.start_ai(1000);
+  std::shared_ptr<AIBlocking> ai = std::make_shared<AIBlocking>();
+  game.get_ai()->add_player(0, ai);
+
+  game.update();
+  {
+    std::unique_lock<std::mutex> lock(ai->mutex);
+    ai->changed.wait(lock, [&ai]() { return ai->started; });
+  }
+
+  // The game keeps running while the plan is in progress
+  for (int i = 0; i < 10; i++) {
+    game.update();
+  }
+  EXPECT_EQ(10u, game.get_ai()->get_stats(0).missed_ticks);
+  EXPECT_FALSE(game.get_player(0)->has_castle());
+
+  {
+    std::lock_guard<std::mutex> lock(ai->mutex);
+    ai->released = true;
+  }
+  ai->changed.notify_all();
+
+  // The completed plan is applied on the next tick
+  while (game.get_ai()->get_stats(0).plans == 0) {
+    std::this_thread::yield();
+  }
+  game.update();
+  EXPECT_TRUE(game.get_player(0)->has_castle());
+
+  AIScheduler::Stats stats = game.get_ai()->get_stats(0);
+  EXPECT_EQ(1u, stats.slices);
+  EXPECT_EQ(1u, stats.actions);
+}
+
+// Runs a game like batch-sim, all players computer controlled, and returns
+// the number of fights. Fails on an exception or a serf left on the map
+// after it was deleted.
+static unsigned int
+run_batch_game(uint16_t number, unsigned int ticks) {
+  Random seed(number);
+  PGameInfo game_info = std::make_shared<GameInfo>(seed);
+  game_info->set_map_size(3);
+  PGame game = game_info->instantiate();
+  game->set_random(seed);
+
+  Random rnd = seed;
+  PMap map = game->get_map();
+  for (unsigned int i = 0; game->get_player(i) != nullptr; i++) {
+    Player *player = game->get_player(i);
+    for (int t = 0; t < 100 && !player->has_castle(); t++) {
+      int col, row;
+      MapPos pos = map->get_rnd_coord(&col, &row, &rnd);
+      if (game->can_build_castle(pos, player)) {
+        game->build_castle(pos, player);
+      }
+    }
+    EXPECT_TRUE(player->has_castle());
+  }
+
+  game->start_ai(0);
+  for (unsigned int i = 0; game->get_player(i) != nullptr; i++) {
+    if (!game->get_ai()->has_player(i)) {
+      game->get_ai()->add_player(i);
+    }
+  }
+
+  unsigned int fights = 0;
+  for (unsigned int t = 0; t < ticks; t++) {
+    EXPECT_NO_THROW(game->update()) << "game " << number << " tick " << t;
+    for (unsigned int i = 0; game->get_player(i) != nullptr; i++) {
+      Player *player = game->get_player(i);
+      while (player->has_notification()) {
+        Message::Type type = player->pop_notification().type;
+        if (type == Message::TypeWinFight) {
+          fights++;
+        }
+      }
+    }
+
+    if (t % 1000 == 0 || ::testing::Test::HasFailure()) {
+      for (MapPos pos = 0; pos < map->get_cols() * map->get_rows(); pos++) {
+        unsigned int index = map->get_serf_index(pos);
+        if (index != 0 && game->get_serf(index) == nullptr) {
+          ADD_FAILURE() << "game " << number << " tick " << t
+                        << ": deleted serf " << index << " on the map";
+          return fights;
+        }
+      }
+
+      // Knights in the middle of fights must survive a save
+      std::stringstream str;
+      GameStore::get_instance().write(&str, game.get());
+      Game loaded;
+      EXPECT_TRUE(GameStore::get_instance().read(&str, &loaded))
+        << "game " << number << " tick " << t << ": save does not load";
+      if (::testing::Test::HasFailure()) {
+        return fights;
+      }
+    }
+  }
+
+  return fights;
+}
+
+// Games of batch-sim that crashed once the players attacked each other.
+TEST(AI, BatchGamesWithAttacks) {
+  unsigned int fights = 0;
+  for (uint16_t number : {1, 3, 6}) {
+    fights += run_batch_game(number, 60000);
+  }
+  EXPECT_LT(0u, fights);
+}
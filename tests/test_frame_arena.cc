@@ -0,0 +1,88 @@
+/*
+ * test_frame_arena.cc - Frame arena tests
+ *
+ * Copyright (C) 2026  freeserf developers
+ *
+ * This file is part of freeserf.
+ *
+ * freeserf is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * freeserf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with freeserf.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+#include "src/frame-arena.h"
+#include "src/game.h"
+#include "tests/test_helpers.h"
+
+TEST(FrameArena, Alignment) {
+  FrameArena arena(256);
+  arena.allocate(1, 1);
+  uint64_t *p = arena.allocate<uint64_t>(2);
+  EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(p) % alignof(uint64_t));
+  EXPECT_EQ(2u, arena.get_allocations());
+}
+
+TEST(FrameArena, GrowsToFitTick) {
+  FrameArena arena(64);
+  char *first = static_cast<char*>(arena.allocate(32, 1));
+  char *second = static_cast<char*>(arena.allocate(32, 1));
+  EXPECT_EQ(first + 32, second);
+
+  // Does not fit, but is still usable until reset
+  int *extra = arena.allocate<int>(100);
+  for (int i = 0; i < 100; i++) extra[i] = i;
+  EXPECT_EQ(99, extra[99]);
+
+  arena.reset();
+  EXPECT_EQ(3u, arena.get_last_allocations());
+  EXPECT_EQ(0u, arena.get_allocations());
+  EXPECT_LE(64u + 100 * sizeof(int), arena.get_size());
+}
+
+TEST(FrameArena, Containers) {
+  FrameArena arena;
+  {
+    FrameVector<int> values{FrameAllocator<int>(&arena)};
+    FrameMap<int, int> counts{FrameAllocator<char>(&arena)};
+    for (int i = 0; i < 100; i++) {
+      values.push_back(i);
+      counts[i % 10]++;
+    }
+    int sum = 0;
+    for (int value : values) sum += value;
+    EXPECT_EQ(4950, sum);
+    EXPECT_EQ(10, counts[3]);
+  }
+  EXPECT_LT(0u, arena.get_allocations());
+
+  // Without arena the allocator uses the heap
+  FrameList<int> list;
+  list.push_back(1);
+  EXPECT_EQ(1u, list.size());
+}
+
+TEST(FrameArena, ResetEachTick) {
+  Game game;
+  ASSERT_TRUE(init_test_game(&game));
+
+  size_t allocations = 0;
+  for (int i = 0; i < 1000; i++) {
+    game.update();
+    EXPECT_EQ(0u, game.get_frame_arena()->get_allocations());
+    allocations += game.get_frame_arena()->get_last_allocations();
+  }
+  EXPECT_LT(0u, allocations);
+}
@@ -0,0 +1,55 @@
+/*
+ * test_game.cc - test for game state handling
+ *
+ * Copyright (C) 2026  freeserf developers
+ *
+ * This file is part of freeserf.
+ *
+ * freeserf is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * freeserf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with freeserf.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include "src/game.h"
+#include "tests/test_helpers.h"
+
+TEST(Game, ForkIsIdentical) {
+  PGame game = create_test_game();
+  for (int i = 0; i < 300; i++) game->update();
+
+  PGame fork = game->fork();
+  ASSERT_TRUE(fork.get() != nullptr);
+  EXPECT_EQ(*game->get_map(), *fork->get_map());
+  EXPECT_EQ(save_to_string(game.get()), save_to_string(fork.get()));
+
+  // Both games must evolve identically from the fork point
+  for (int i = 0; i < 300; i++) {
+    game->update();
+    fork->update();
+  }
+  EXPECT_EQ(*game->get_map(), *fork->get_map());
+  EXPECT_EQ(save_to_string(game.get()), save_to_string(fork.get()));
+}
+
+TEST(Game, ForkIsIndependent) {
+  PGame game = create_test_game();
+  for (int i = 0; i < 100; i++) game->update();
+  std::string before = save_to_string(game.get());
+
+  PGame fork = game->fork();
+  for (int i = 0; i < 500; i++) fork->update();
+  fork = nullptr;
+
+  EXPECT_EQ(before, save_to_string(game.get()));
+}
@@ -0,0 +1,141 @@
+/*
+ * test_game_thread.cc - test for threaded game simulation
+ *
+ * Copyright (C) 2026  freeserf developers
+ *
+ * This file is part of freeserf.
+ *
+ * freeserf is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * freeserf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with freeserf.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>  // NOLINT(build/c++11)
+#include <chrono>  // NOLINT(build/c++11)
+#include <thread>  // NOLINT(build/c++11)
+
+#include "src/game-thread.h"
+#include "src/triple-buffer.h"
+#include "tests/test_helpers.h"
+
+TEST(TripleBuffer, FetchLatest) {
+  TripleBuffer<int> buffer;
+  EXPECT_FALSE(buffer.fetch());
+
+  buffer.get_back() = 1;
+  EXPECT_FALSE(buffer.publish());
+  buffer.get_back() = 2;
+  EXPECT_TRUE(buffer.publish());
+  EXPECT_EQ(1, buffer.get_back());
+
+  ASSERT_TRUE(buffer.fetch());
+  EXPECT_EQ(2, buffer.get_front());
+  EXPECT_FALSE(buffer.fetch());
+
+  buffer.get_back() = 3;
+  EXPECT_FALSE(buffer.publish());
+  ASSERT_TRUE(buffer.fetch());
+  EXPECT_EQ(3, buffer.get_front());
+}
+
+TEST(GameThread, StepMatchesUpdate) {
+  PGame game = create_test_game();
+  PGame reference = create_test_game();
+
+  GameThread thread(game, 20);
+  GameThread::State *state = thread.fetch_state();
+  ASSERT_TRUE(state != nullptr);
+  EXPECT_EQ(save_to_string(reference.get()), save_to_string(state->game.get()));
+
+  for (int i = 0; i < 200; i++) {
+    thread.step();
+    reference->update();
+    state = thread.fetch_state();
+    ASSERT_TRUE(state != nullptr);
+  }
+
+  EXPECT_EQ(save_to_string(reference.get()), save_to_string(state->game.get()));
+  EXPECT_EQ(save_to_string(reference.get()), save_to_string(game.get()));
+  EXPECT_TRUE(thread.fetch_state() == nullptr);
+}
+
+TEST(GameThread, ChangesAreNotDropped) {
+  PGame game = create_test_game();
+  GameThread thread(game, 20);
+  thread.fetch_state();
+
+  MapPos pos = game->get_map()->pos(20, 20);
+  thread.post([pos](Game *game) {
+    game->get_map()->set_height(pos, game->get_map()->get_height(pos) + 1);
+  });
+  thread.step();
+  // Not fetched in between, the change must be carried to the next state.
+  thread.step();
+
+  GameThread::State *state = thread.fetch_state();
+  ASSERT_TRUE(state != nullptr);
+  MapPos neighbour = game->get_map()->move_right(pos);
+  EXPECT_NE(std::find(state->height_changes.begin(),
+                      state->height_changes.end(), neighbour),
+            state->height_changes.end());
+  EXPECT_EQ(game->get_map()->get_height(pos),
+            state->game->get_map()->get_height(pos));
+}
+
+TEST(GameThread, ForksOnlyWhenFetched) {
+  PGame game = create_test_game();
+  GameThread thread(game, 20);
+  thread.fetch_state();
+
+  thread.step();
+  unsigned int published = game->get_const_tick();
+  thread.step();
+  thread.step();
+
+  GameThread::State *state = thread.fetch_state();
+  ASSERT_TRUE(state != nullptr);
+  EXPECT_EQ(published, state->game->get_const_tick());
+  EXPECT_TRUE(thread.fetch_state() == nullptr);
+
+  thread.step();
+  state = thread.fetch_state();
+  ASSERT_TRUE(state != nullptr);
+  EXPECT_EQ(game->get_const_tick(), state->game->get_const_tick());
+}
+
+TEST(GameThread, RunsInBackground) {
+  PGame game = create_test_game();
+  GameThread thread(game, 1);
+  thread.start();
+  EXPECT_TRUE(thread.is_running());
+
+  std::atomic<bool> applied(false);
+  thread.post([&applied](Game *) { applied = true; });
+
+  unsigned int tick = 0;
+  for (int i = 0; i < 1000 && tick < 100; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    GameThread::State *state = thread.fetch_state();
+    if (state != nullptr) {
+      tick = state->game->get_const_tick();
+    }
+  }
+  thread.stop();
+  EXPECT_FALSE(thread.is_running());
+
+  EXPECT_GE(tick, 100u);
+  EXPECT_TRUE(applied);
+  EXPECT_GE(game->get_const_tick(), tick);
+}
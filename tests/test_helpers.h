@@ -0,0 +1,58 @@
+/*
+ * test_helpers.h - Games shared by the tests
+ *
+ * Copyright (C) 2026  freeserf developers
+ *
+ * This file is part of freeserf.
+ *
+ * freeserf is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * freeserf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with freeserf.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TESTS_TEST_HELPERS_H_
+#define TESTS_TEST_HELPERS_H_
+
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include "src/game.h"
+#include "src/random.h"
+#include "src/savegame.h"
+
+static const char * const test_game_seed = "8667715887436237";
+
+// Small mission map with a single player that has built its castle.
+static inline bool
+init_test_game(Game *game) {
+  game->init(3, Random(test_game_seed));
+  game->add_player(35, 30, 40);
+  return game->build_castle(game->get_map()->pos(6, 6), game->get_player(0));
+}
+
+static inline PGame
+create_test_game() {
+  PGame game = std::make_shared<Game>();
+  init_test_game(game.get());
+  return game;
+}
+
+// The game in the text format, to compare games.
+static inline std::string
+save_to_string(Game *game) {
+  std::stringstream str;
+  GameStore::get_instance().write(&str, game);
+  return str.str();
+}
+
+#endif  // TESTS_TEST_HELPERS_H_
@@ -0,0 +1,130 @@
+/*
+ * test_lru_cache.cc - LRU cache tests
+ *
+ * Copyright (C) 2026  freeserf developers
+ *
+ * This file is part of freeserf.
+ *
+ * freeserf is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * freeserf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with freeserf.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <memory>
+
+#include "src/lru-cache.h"
+
+typedef LruCache<unsigned int, int> IntCache;
+
+static std::unique_ptr<int>
+make_value(int value) {
+  return std::unique_ptr<int>(new int(value));
+}
+
+TEST(LruCache, HitsAndMisses) {
+  IntCache cache(100);
+  EXPECT_EQ(nullptr, cache.get(1));
+  cache.insert(1, make_value(10), 10);
+  int *value = cache.get(1);
+  ASSERT_NE(nullptr, value);
+  EXPECT_EQ(10, *value);
+  EXPECT_TRUE(cache.contains(1));
+  EXPECT_FALSE(cache.contains(2));
+
+  EXPECT_EQ(1u, cache.get_stats().hits);
+  EXPECT_EQ(1u, cache.get_stats().misses);
+  EXPECT_EQ(10u, cache.get_cost());
+
+  cache.insert(1, make_value(11), 20);
+  EXPECT_EQ(11, *cache.get(1));
+  EXPECT_EQ(1u, cache.get_count());
+  EXPECT_EQ(20u, cache.get_cost());
+}
+
+TEST(LruCache, EvictsLeastRecentlyUsed) {
+  IntCache cache(30);
+  cache.insert(1, make_value(1), 10);
+  cache.insert(2, make_value(2), 10);
+  cache.insert(3, make_value(3), 10);
+
+  // Using 1 makes 2 the least recently used
+  cache.get(1);
+  cache.insert(4, make_value(4), 10);
+  EXPECT_TRUE(cache.contains(1));
+  EXPECT_FALSE(cache.contains(2));
+  EXPECT_TRUE(cache.contains(3));
+  EXPECT_TRUE(cache.contains(4));
+  EXPECT_EQ(1u, cache.get_stats().evictions);
+
+  // contains() does not count as use
+  cache.contains(3);
+  cache.set_budget(20);
+  EXPECT_FALSE(cache.contains(3));
+  EXPECT_EQ(20u, cache.get_cost());
+
+  cache.erase(1);
+  EXPECT_EQ(1u, cache.get_count());
+  cache.clear();
+  EXPECT_EQ(0u, cache.get_cost());
+}
+
+TEST(LruCache, KeepsLastInsertOverBudget) {
+  IntCache cache(10);
+  cache.insert(1, make_value(1), 5);
+  int *value = cache.insert(2, make_value(2), 50);
+  EXPECT_EQ(2, *value);
+  EXPECT_FALSE(cache.contains(1));
+  EXPECT_TRUE(cache.contains(2));
+  EXPECT_EQ(50u, cache.get_cost());
+}
+
+TEST(LruCache, KeepsObjectsInsertedTogether) {
+  IntCache cache(25);
+  cache.insert(1, make_value(1), 10);
+  cache.insert(2, make_value(2), 10);
+  cache.insert(3, make_value(3), 10, false, 2);
+  EXPECT_FALSE(cache.contains(1));
+  EXPECT_TRUE(cache.contains(2));
+  EXPECT_TRUE(cache.contains(3));
+
+  // Both stay even when together they exceed the budget
+  cache.insert(4, make_value(4), 20);
+  cache.insert(5, make_value(5), 20, false, 2);
+  EXPECT_FALSE(cache.contains(2));
+  EXPECT_FALSE(cache.contains(3));
+  EXPECT_TRUE(cache.contains(4));
+  EXPECT_TRUE(cache.contains(5));
+  EXPECT_EQ(40u, cache.get_cost());
+}
+
+TEST(LruCache, KeepsPinned) {
+  IntCache cache(20);
+  cache.insert(1, make_value(1), 10, true);
+  cache.insert(2, make_value(2), 10);
+  cache.insert(3, make_value(3), 10);
+  EXPECT_TRUE(cache.contains(1));
+  EXPECT_FALSE(cache.contains(2));
+  EXPECT_TRUE(cache.contains(3));
+
+  // Pinned objects stay even when they alone exceed the budget
+  cache.set_budget(5);
+  EXPECT_TRUE(cache.contains(1));
+  EXPECT_TRUE(cache.contains(3));
+  EXPECT_EQ(20u, cache.get_cost());
+
+  cache.set_pinned(1, false);
+  EXPECT_FALSE(cache.contains(1));
+  EXPECT_TRUE(cache.contains(3));
+  EXPECT_EQ(2u, cache.get_stats().evictions);
+}
@@ -21,14 +21,23 @@
 
 #include <gtest/gtest.h>
 
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
 #include <sstream>
 #include <memory>
+#include <string>
+#include <vector>
 
+#include "src/ai.h"
 #include "src/game.h"
 #include "src/random.h"
 #include "src/savegame.h"
+#include "src/savegame-compress.h"
+#include "src/savegame-delta.h"
 #include "src/mission.h"
+#include "tests/test_helpers.h"
 
 
 TEST(SaveGame, RandomMapSaveGame) {
@@ -77,3 +86,534 @@ TEST(SaveGame, RandomMapSaveGame) {
   // Check player land area
   EXPECT_EQ(player_0->get_land_area(), loaded_player_0->get_land_area());
 }
+
+TEST(SaveGame, NativeSaveGame) {
+  std::unique_ptr<Game> game(new Game());
+  ASSERT_TRUE(init_test_game(game.get()));
+  for (int i = 0; i < 500; i++) game->update();
+
+  std::stringstream native;
+  ASSERT_TRUE(GameStore::get_instance().write(&native, game.get(),
+                                              GameStore::FormatNative));
+  std::stringstream text;
+  ASSERT_TRUE(GameStore::get_instance().write(&text, game.get()));
+
+  EXPECT_LT(native.str().size(), text.str().size());
+
+  native.seekg(0, std::ios::beg);
+  std::unique_ptr<Game> loaded_game(new Game());
+  ASSERT_TRUE(GameStore::get_instance().read(&native, loaded_game.get()));
+
+  EXPECT_EQ(*game->get_map(), *loaded_game->get_map());
+  EXPECT_EQ(game->get_gold_total(), loaded_game->get_gold_total());
+  Player *loaded_player_0 = loaded_game->get_player(0);
+  ASSERT_TRUE(loaded_player_0 != NULL);
+  EXPECT_EQ(game->get_player(0)->get_land_area(),
+            loaded_player_0->get_land_area());
+
+  // Loading the native save restores the exact same state
+  std::stringstream reloaded;
+  ASSERT_TRUE(GameStore::get_instance().write(&reloaded, loaded_game.get()));
+  EXPECT_EQ(text.str(), reloaded.str());
+}
+
+TEST(SaveGame, NativeSaveGameChecksum) {
+  std::unique_ptr<Game> game(new Game());
+  ASSERT_TRUE(init_test_game(game.get()));
+
+  std::stringstream native;
+  ASSERT_TRUE(GameStore::get_instance().write(&native, game.get(),
+                                              GameStore::FormatNative));
+  std::string data = native.str();
+  data[data.size() / 2] ^= 0x01;
+
+  std::stringstream corrupted(data);
+  std::unique_ptr<Game> loaded_game(new Game());
+  EXPECT_FALSE(GameStore::get_instance().read(&corrupted, loaded_game.get()));
+}
+
+TEST(SaveGame, TextOrder) {
+  std::vector<unsigned int> order;
+  for (unsigned int i : SaveTextOrder(23)) order.push_back(i);
+  std::vector<unsigned int> expected = { 0, 1, 10, 11, 12, 13, 14, 15, 16, 17,
+                                         18, 19, 2, 20, 21, 22, 3, 4, 5, 6, 7,
+                                         8, 9 };
+  EXPECT_EQ(expected, order);
+
+  EXPECT_FALSE(SaveTextOrder(0).begin() != SaveTextOrder(0).end());
+  size_t count = 0;
+  for (unsigned int i : SaveTextOrder(1000)) {
+    EXPECT_GT(1000u, i);
+    count++;
+  }
+  EXPECT_EQ(1000u, count);
+}
+
+TEST(SaveGame, TextSaveIsSorted) {
+  std::unique_ptr<Game> game(new Game());
+  game->init(3, Random("8667715887436237"));
+  game->add_player(35, 30, 40);
+  game->add_player(12, 30, 40);
+  ASSERT_TRUE(game->build_castle(game->get_map()->pos(6, 6),
+                                 game->get_player(0)));
+  for (int i = 0; i < 2000; i++) game->update();
+
+  std::stringstream text;
+  ASSERT_TRUE(GameStore::get_instance().write(&text, game.get()));
+
+  // Sections and values are sorted, like ConfigFile writes them
+  text.seekg(0, std::ios::beg);
+  std::string line;
+  std::string section;
+  std::string name;
+  size_t sections = 0;
+  while (std::getline(text, line)) {
+    if (line[0] == '[') {
+      std::string next = line.substr(1, line.size() - 2);
+      EXPECT_LT(section, next);
+      section = next;
+      name.clear();
+      sections++;
+    } else {
+      std::string next = line.substr(2, line.find(" = ") - 2);
+      EXPECT_LT(name, next) << "in section " << section;
+      name = next;
+    }
+  }
+  EXPECT_LT(20u, sections);
+}
+
+TEST(SaveGame, TextValues) {
+  int val = 0;
+  SaveReaderTextValue list(" 12,-3,0,7");
+  list[1] >> val;
+  EXPECT_EQ(-3, val);
+  list[3] >> val;
+  EXPECT_EQ(7, val);
+  EXPECT_THROW(list[4], ExceptionFreeserf);
+
+  // Elements that are not plain integers are read like before
+  SaveReaderTextValue mixed("1, 2,x");
+  mixed[1] >> val;
+  EXPECT_EQ(2, val);
+  std::string str;
+  mixed[2] >> str;
+  EXPECT_EQ("x", str);
+
+  size_t face = 0;
+  SaveReaderTextValue("18446744073709551615") >> face;
+  EXPECT_EQ(static_cast<size_t>(-1), face);
+
+  SaveReaderTextValue single("42");
+  single >> val;
+  EXPECT_EQ(42, val);
+  EXPECT_THROW(single[0], ExceptionFreeserf);
+
+  // Values in a text save are read the same way
+  const char numbers[] = "5,-6,7";
+  SaveReaderTextValue view(numbers, sizeof(numbers) - 1);
+  view >> val;
+  EXPECT_EQ(5, val);
+  view[1] >> val;
+  EXPECT_EQ(-6, val);
+  view >> str;
+  EXPECT_EQ("5,-6,7", str);
+  EXPECT_THROW(view[3], ExceptionFreeserf);
+
+  const char text[] = "Name,12";
+  SaveReaderTextValue text_view(text, sizeof(text) - 1);
+  text_view >> str;
+  EXPECT_EQ("name,12", str);
+  text_view[1] >> val;
+  EXPECT_EQ(12, val);
+
+  SaveReaderTextValue(numbers, 2) >> str;
+  EXPECT_EQ("5", str);
+}
+
+TEST(SaveGame, DetectFormat) {
+  std::unique_ptr<Game> game(new Game());
+  game->init(3, Random("8667715887436237"));
+  game->add_player(35, 30, 40);
+
+  std::stringstream text;
+  ASSERT_TRUE(GameStore::get_instance().write(&text, game.get()));
+  std::string data = text.str();
+  EXPECT_EQ(GameStore::FormatText,
+            GameStore::detect_format(data.data(), data.size()));
+
+  std::stringstream native;
+  ASSERT_TRUE(GameStore::get_instance().write(&native, game.get(),
+                                              GameStore::FormatNative));
+  data = native.str();
+  EXPECT_EQ(GameStore::FormatNative,
+            GameStore::detect_format(data.data(), data.size()));
+
+  // Legacy saves are raw memory dumps
+  std::string legacy(8628, '\0');
+  legacy[0] = '[';
+  EXPECT_EQ(GameStore::FormatLegacy,
+            GameStore::detect_format(legacy.data(), legacy.size()));
+  std::unique_ptr<Game> loaded_game(new Game());
+  EXPECT_FALSE(GameStore::get_instance().load(legacy.data(), 16,
+                                              loaded_game.get()));
+}
+
+TEST(SaveGame, AsyncSave) {
+  std::unique_ptr<Game> game(new Game());
+  ASSERT_TRUE(init_test_game(game.get()));
+  for (int i = 0; i < 500; i++) game->update();
+
+  PGame snapshot = game->fork();
+  std::stringstream expected;
+  ASSERT_TRUE(GameStore::get_instance().write(&expected, snapshot.get()));
+
+  GameStore &store = GameStore::get_instance();
+  store.save_async("test_async_save.save", snapshot);
+  snapshot.reset();
+
+  // The game keeps running while the snapshot is saved
+  for (int i = 0; i < 500; i++) game->update();
+
+  store.wait_for_saves();
+  EXPECT_FALSE(store.is_saving());
+  std::vector<GameStore::SaveResult> results = store.take_save_results();
+  ASSERT_EQ(1u, results.size());
+  EXPECT_TRUE(results[0].saved);
+  EXPECT_EQ("test_async_save.save", results[0].path);
+  EXPECT_TRUE(store.take_save_results().empty());
+
+  std::unique_ptr<Game> loaded_game(new Game());
+  ASSERT_TRUE(store.load("test_async_save.save", loaded_game.get()));
+  std::stringstream loaded;
+  ASSERT_TRUE(store.write(&loaded, loaded_game.get()));
+  EXPECT_EQ(expected.str(), loaded.str());
+  std::remove("test_async_save.save");
+}
+
+static int64_t
+file_size(const std::string &path) {
+  std::ifstream file(path.c_str(), std::ios::binary | std::ios::ate);
+  if (!file.is_open()) return -1;
+  return static_cast<int64_t>(file.tellg());
+}
+
+TEST(SaveGame, DeltaSave) {
+  std::unique_ptr<Game> game(new Game());
+  ASSERT_TRUE(init_test_game(game.get()));
+  PMap map = game->get_map();
+  Player *player = game->get_player(0);
+  for (int i = 0; i < 200; i++) game->update();
+
+  SaveCheckpoint checkpoint("test_delta.save");
+  ASSERT_TRUE(checkpoint.save(game.get()));
+  EXPECT_EQ(0u, checkpoint.get_delta_count());
+
+  // Place a flag to be removed after the next checkpoint
+  MapPos flag_pos = 0;
+  bool found = false;
+  for (int y = 0; y < 16 && !found; y++) {
+    for (int x = 0; x < 16 && !found; x++) {
+      flag_pos = map->pos(x, y);
+      found = game->can_build_flag(flag_pos, player);
+    }
+  }
+  ASSERT_TRUE(found);
+  ASSERT_TRUE(game->build_flag(flag_pos, player));
+  for (int i = 0; i < 200; i++) game->update();
+
+  ASSERT_TRUE(checkpoint.save(game.get()));
+  EXPECT_EQ(1u, checkpoint.get_delta_count());
+  EXPECT_EQ(checkpoint.get_delta_path(), checkpoint.get_latest_path());
+  EXPECT_LT(file_size(checkpoint.get_delta_path()),
+            file_size(checkpoint.get_path()));
+
+  std::unique_ptr<Game> loaded(new Game());
+  ASSERT_TRUE(GameStore::get_instance().load(checkpoint.get_latest_path(),
+                                             loaded.get()));
+  EXPECT_EQ(save_to_string(game.get()), save_to_string(loaded.get()));
+
+  // Sections of the full save that no longer exist are removed on load
+  ASSERT_TRUE(game->demolish_flag(flag_pos, player));
+  for (int i = 0; i < 200; i++) game->update();
+  ASSERT_TRUE(checkpoint.save(game.get()));
+  EXPECT_EQ(2u, checkpoint.get_delta_count());
+
+  loaded.reset(new Game());
+  ASSERT_TRUE(GameStore::get_instance().load(checkpoint.get_latest_path(),
+                                             loaded.get()));
+  EXPECT_EQ(save_to_string(game.get()), save_to_string(loaded.get()));
+
+  std::remove(checkpoint.get_delta_path().c_str());
+  std::remove(checkpoint.get_path().c_str());
+}
+
+TEST(SaveGame, DeltaSaveCompaction) {
+  std::unique_ptr<Game> game(new Game());
+  ASSERT_TRUE(init_test_game(game.get()));
+
+  SaveCheckpoint checkpoint("test_delta_compact.save", 2);
+  for (unsigned int i = 0; i < 3; i++) {
+    for (int j = 0; j < 50; j++) game->update();
+    ASSERT_TRUE(checkpoint.save(game.get()));
+    EXPECT_EQ(i, checkpoint.get_delta_count());
+  }
+
+  // The next checkpoint after two deltas is a new full save
+  for (int j = 0; j < 50; j++) game->update();
+  ASSERT_TRUE(checkpoint.save(game.get()));
+  EXPECT_EQ(0u, checkpoint.get_delta_count());
+  EXPECT_EQ(checkpoint.get_path(), checkpoint.get_latest_path());
+  EXPECT_EQ(-1, file_size(checkpoint.get_delta_path()));
+
+  std::unique_ptr<Game> loaded(new Game());
+  ASSERT_TRUE(GameStore::get_instance().load(checkpoint.get_latest_path(),
+                                             loaded.get()));
+  EXPECT_EQ(save_to_string(game.get()), save_to_string(loaded.get()));
+  std::remove(checkpoint.get_path().c_str());
+}
+
+TEST(SaveGame, StaleDeltaSave) {
+  std::unique_ptr<Game> game(new Game());
+  ASSERT_TRUE(init_test_game(game.get()));
+  for (int i = 0; i < 200; i++) game->update();
+
+  SaveCheckpoint checkpoint("test_delta_stale.save");
+  ASSERT_TRUE(checkpoint.save(game.get()));
+  for (int i = 0; i < 200; i++) game->update();
+  ASSERT_TRUE(checkpoint.save(game.get()));
+  ASSERT_EQ(1u, checkpoint.get_delta_count());
+  std::string delta;
+  {
+    std::ifstream file(checkpoint.get_delta_path().c_str(),
+                       std::ios::binary);
+    delta.assign((std::istreambuf_iterator<char>(file)),
+                 std::istreambuf_iterator<char>());
+  }
+  ASSERT_FALSE(delta.empty());
+
+  // A new full save removes the delta of the old one
+  for (int i = 0; i < 200; i++) game->update();
+  SaveCheckpoint restarted(checkpoint.get_path());
+  ASSERT_TRUE(restarted.save(game.get()));
+  EXPECT_EQ(-1, file_size(checkpoint.get_delta_path()));
+
+  // The old delta, as a crash before it was removed would leave it, must
+  // not be applied to the new full save
+  {
+    std::ofstream file(checkpoint.get_delta_path().c_str(),
+                       std::ios::binary | std::ios::trunc);
+    file.write(delta.data(), delta.size());
+  }
+  std::unique_ptr<Game> loaded(new Game());
+  ASSERT_TRUE(GameStore::get_instance().load(checkpoint.get_path(),
+                                             loaded.get()));
+  EXPECT_EQ(save_to_string(game.get()), save_to_string(loaded.get()));
+
+  std::remove(checkpoint.get_delta_path().c_str());
+  std::remove(checkpoint.get_path().c_str());
+}
+
+TEST(SaveGame, DeltaSaveOfAIGame) {
+  std::unique_ptr<Game> game(new Game());
+  ASSERT_TRUE(init_test_game(game.get()));
+  game->start_ai(0);
+  game->get_ai()->add_player(0);
+
+  // Every section changed between checkpoints must be in the delta, or the
+  // loaded checkpoint would differ from the game
+  SaveCheckpoint checkpoint("test_delta_ai.save");
+  unsigned int deltas = 0;
+  for (int i = 0; i < 12; i++) {
+    for (int j = 0; j < 1500; j++) game->update();
+    ASSERT_TRUE(checkpoint.save(game.get()));
+    if (checkpoint.get_delta_count() > 0) deltas++;
+
+    std::unique_ptr<Game> loaded(new Game());
+    ASSERT_TRUE(GameStore::get_instance().load(checkpoint.get_path(),
+                                               loaded.get()));
+    ASSERT_EQ(save_to_string(game.get()), save_to_string(loaded.get()))
+      << "checkpoint " << i;
+  }
+  EXPECT_LT(0u, deltas);
+
+  std::remove(checkpoint.get_delta_path().c_str());
+  std::remove(checkpoint.get_path().c_str());
+}
+
+#ifdef SAVE_CONVERT_PATH
+TEST(SaveGame, ConvertIntoNewFolder) {
+  std::unique_ptr<Game> game(new Game());
+  ASSERT_TRUE(init_test_game(game.get()));
+  for (int i = 0; i < 100; i++) game->update();
+  ASSERT_TRUE(GameStore::get_instance().save("test_convert.save",
+                                             game.get()));
+
+  // The output folder does not exist until save-convert creates it
+  std::string folder = "test_convert_output";
+  std::string output = folder + "/test_convert.save";
+  std::remove(output.c_str());
+  std::remove(folder.c_str());
+  std::string command = std::string("\"") + SAVE_CONVERT_PATH + "\"" +
+                        " -i test_convert.save -o " + folder +
+                        " -r test_convert.csv";
+  EXPECT_EQ(0, std::system(command.c_str()));
+  std::remove("test_convert.csv");
+  std::remove("test_convert.save");
+
+  std::unique_ptr<Game> loaded(new Game());
+  ASSERT_TRUE(GameStore::get_instance().load(output, loaded.get()));
+  EXPECT_EQ(save_to_string(game.get()), save_to_string(loaded.get()));
+
+  std::remove(output.c_str());
+  std::remove(folder.c_str());
+}
+#endif  // SAVE_CONVERT_PATH
+
+TEST(SaveGame, CompressionCodecs) {
+  // Repetitive text like the map sections, with some variation
+  std::string data;
+  for (int i = 0; i < 20000; i++) {
+    data += (i % 97 == 0) ? "1,2,3," : "0,0,0,";
+    if (i % 1000 == 0) data += "[section " + std::to_string(i) + "]\n";
+  }
+
+  for (SaveCodec::Type type : { SaveCodec::TypeLZ, SaveCodec::TypeZlib }) {
+    if (!SaveCodec::is_available(type)) continue;
+
+    std::stringstream stream;
+    {
+      SaveCompressor compressor(&stream, type);
+      std::ostream os(&compressor);
+      os << data;
+      EXPECT_TRUE(compressor.finish());
+    }
+    std::string compressed = stream.str();
+    EXPECT_TRUE(SaveCompressor::is_compressed(compressed.data(),
+                                              compressed.size()));
+    EXPECT_LT(compressed.size() * 10, data.size());
+
+    std::string output;
+    SaveCompressor::decompress(compressed.data(), compressed.size(), &output);
+    EXPECT_EQ(data, output);
+
+    // Corrupt data is detected instead of read out of bounds
+    std::string truncated = compressed.substr(0, compressed.size() / 2);
+    output.clear();
+    EXPECT_THROW(SaveCompressor::decompress(truncated.data(), truncated.size(),
+                                            &output), ExceptionFreeserf);
+  }
+}
+
+TEST(SaveGame, CompressedSaveGame) {
+  std::unique_ptr<Game> game(new Game());
+  ASSERT_TRUE(init_test_game(game.get()));
+  for (int i = 0; i < 500; i++) game->update();
+  std::string expected = save_to_string(game.get());
+
+  GameStore &store = GameStore::get_instance();
+  store.set_compression(true);
+  for (GameStore::Format format : { GameStore::FormatText,
+                                    GameStore::FormatNative }) {
+    ASSERT_TRUE(store.save("test_compressed.save", game.get(), format));
+    EXPECT_LT(file_size("test_compressed.save"),
+              static_cast<int64_t>(expected.size()) / 4);
+
+    std::unique_ptr<Game> loaded(new Game());
+    ASSERT_TRUE(store.load("test_compressed.save", loaded.get()));
+    EXPECT_EQ(expected, save_to_string(loaded.get()));
+  }
+  store.set_compression(false);
+  std::remove("test_compressed.save");
+}
+
+TEST(SaveGame, CompressedDeltaSave) {
+  std::unique_ptr<Game> game(new Game());
+  ASSERT_TRUE(init_test_game(game.get()));
+  for (int i = 0; i < 200; i++) game->update();
+
+  SaveCheckpoint checkpoint("test_delta_compressed.save");
+  ASSERT_TRUE(checkpoint.save(game.get(), true));
+  for (int i = 0; i < 200; i++) game->update();
+  ASSERT_TRUE(checkpoint.save(game.get(), true));
+  ASSERT_EQ(1u, checkpoint.get_delta_count());
+
+  for (const std::string &path : { checkpoint.get_path(),
+                                    checkpoint.get_delta_path() }) {
+    std::ifstream file(path.c_str(), std::ios::binary);
+    std::string data((std::istreambuf_iterator<char>(file)),
+                     std::istreambuf_iterator<char>());
+    EXPECT_TRUE(SaveCompressor::is_compressed(data.data(), data.size()))
+      << path;
+  }
+
+  std::unique_ptr<Game> loaded(new Game());
+  ASSERT_TRUE(GameStore::get_instance().load(checkpoint.get_path(),
+                                             loaded.get()));
+  EXPECT_EQ(save_to_string(game.get()), save_to_string(loaded.get()));
+
+  std::remove(checkpoint.get_delta_path().c_str());
+  std::remove(checkpoint.get_path().c_str());
+}
+
+TEST(SaveGame, SaveIndex) {
+  std::unique_ptr<Game> game(new Game());
+  ASSERT_TRUE(init_test_game(game.get()));
+  for (int i = 0; i < 100; i++) game->update();
+
+  GameStore::SaveInfo info;
+  GameStore::describe(game.get(), &info);
+  EXPECT_TRUE(info.has_metadata);
+  EXPECT_EQ(game->get_map()->get_size(), info.map_size);
+  EXPECT_EQ(game->get_tick(), info.tick);
+  EXPECT_EQ(1u, info.player_colors.size());
+  ASSERT_EQ(static_cast<size_t>(SAVE_THUMBNAIL_SIZE * SAVE_THUMBNAIL_SIZE),
+            info.thumbnail.size());
+  size_t owned = 0;
+  for (uint8_t sample : info.thumbnail) {
+    if ((sample >> 4) == 1) owned++;
+  }
+  EXPECT_LT(0u, owned);
+
+  /* Saves written to the folder are indexed right away, saves added by
+     others once the folder is listed. The saves of the user are left
+     alone. */
+  std::string folder = "test_index_saves";
+  GameStore store(folder);
+  std::string path = folder + "/test_index.save";
+  std::string copy_path = folder + "/test_index_copy.save";
+  ASSERT_TRUE(store.save(path, game.get()));
+  GameStore::SaveInfo indexed;
+  ASSERT_TRUE(store.get_save_info(path, &indexed));
+  EXPECT_EQ(info.tick, indexed.tick);
+  EXPECT_EQ(info.thumbnail, indexed.thumbnail);
+
+  {
+    std::ifstream in(path.c_str(), std::ios::binary);
+    std::ofstream out(copy_path.c_str(), std::ios::binary);
+    out << in.rdbuf();
+  }
+  EXPECT_FALSE(store.get_save_info(copy_path, &indexed));
+  store.get_saved_games();
+  store.wait_for_index();
+  ASSERT_TRUE(store.get_save_info(copy_path, &indexed));
+  EXPECT_EQ(info.map_size, indexed.map_size);
+  EXPECT_EQ(info.player_colors, indexed.player_colors);
+
+  bool listed = false;
+  for (const GameStore::SaveInfo &save : store.get_saved_games()) {
+    if (save.path == copy_path) {
+      listed = save.has_metadata && (save.tick == info.tick);
+    }
+  }
+  EXPECT_TRUE(listed);
+
+  std::remove(path.c_str());
+  std::remove(copy_path.c_str());
+  store.get_saved_games();
+  EXPECT_FALSE(store.get_save_info(path, &indexed));
+
+  store.wait_for_index();
+  std::remove((folder + "/saves.index").c_str());
+  EXPECT_EQ(0, std::remove(folder.c_str()));
+}
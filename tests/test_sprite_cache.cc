@@ -0,0 +1,190 @@
+/*
+ * test_sprite_cache.cc - Sprite cache file tests
+ *
+ * Copyright (C) 2026  freeserf developers
+ *
+ * This file is part of freeserf.
+ *
+ * freeserf is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * freeserf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with freeserf.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+
+#include "src/sprite-cache.h"
+
+static const char * const cache_path = "test_sprite_cache.cache";
+static const uint64_t cache_hash = 0x123456789abcdefull;
+
+// Sprite with offsets and distinct pixels, like a decoded sprite.
+class SpriteTest : public Sprite {
+ public:
+  SpriteTest(unsigned int w, unsigned int h, int dx, int dy, int ox, int oy)
+    : Sprite(w, h) {
+    delta_x = dx;
+    delta_y = dy;
+    offset_x = ox;
+    offset_y = oy;
+    for (size_t i = 0; i < width * height * 4; i++) {
+      data[i] = static_cast<uint8_t>(i * 7 + w);
+    }
+  }
+};
+
+static PSprite
+make_sprite(unsigned int w, unsigned int h, int dx, int dy, int ox, int oy) {
+  return std::make_shared<SpriteTest>(w, h, dx, dy, ox, oy);
+}
+
+static void
+expect_same(const PSprite &expected, const PSprite &actual) {
+  ASSERT_EQ(expected == nullptr, actual == nullptr);
+  if (expected == nullptr) {
+    return;
+  }
+  ASSERT_EQ(expected->get_width(), actual->get_width());
+  ASSERT_EQ(expected->get_height(), actual->get_height());
+  EXPECT_EQ(expected->get_delta_x(), actual->get_delta_x());
+  EXPECT_EQ(expected->get_delta_y(), actual->get_delta_y());
+  EXPECT_EQ(expected->get_offset_x(), actual->get_offset_x());
+  EXPECT_EQ(expected->get_offset_y(), actual->get_offset_y());
+  EXPECT_EQ(0, memcmp(expected->get_data(), actual->get_data(),
+                      expected->get_width() * expected->get_height() * 4));
+}
+
+static void
+expect_cached(SpriteCache *cache, uint64_t id,
+              const DataSource::MaskImage &expected) {
+  DataSource::MaskImage parts;
+  ASSERT_TRUE(cache->get(id, &parts)) << "sprite " << id;
+  expect_same(std::get<0>(expected), std::get<0>(parts));
+  expect_same(std::get<1>(expected), std::get<1>(parts));
+}
+
+static std::string
+read_file(const std::string &path) {
+  std::ifstream file(path.c_str(), std::ios::binary);
+  return std::string((std::istreambuf_iterator<char>(file)),
+                     std::istreambuf_iterator<char>());
+}
+
+static void
+write_file(const std::string &path, const std::string &data) {
+  std::ofstream file(path.c_str(), std::ios::binary | std::ios::trunc);
+  file.write(data.data(), data.size());
+}
+
+TEST(SpriteCache, SavedSpritesAreExact) {
+  std::remove(cache_path);
+  DataSource::MaskImage first(make_sprite(3, 2, 1, -2, 0, 0),
+                              make_sprite(5, 4, -7, 3, 2, 1));
+  DataSource::MaskImage second(nullptr, make_sprite(1, 9, 0, 4, -3, 5));
+  DataSource::MaskImage third(make_sprite(16, 16, 2, 2, 0, 0), nullptr);
+
+  {
+    SpriteCache cache(cache_path, cache_hash);
+    EXPECT_FALSE(cache.open());
+    cache.add(20, first);
+    cache.add(10, second);
+    ASSERT_TRUE(cache.save());
+  }
+
+  // Sprites of the file are kept when it is written again with new ones
+  {
+    SpriteCache cache(cache_path, cache_hash);
+    ASSERT_TRUE(cache.open());
+    EXPECT_EQ(2u, cache.get_count());
+    expect_cached(&cache, 20, first);
+    expect_cached(&cache, 10, second);
+    cache.add(15, third);
+    ASSERT_TRUE(cache.save());
+    expect_cached(&cache, 15, third);
+  }
+
+  SpriteCache cache(cache_path, cache_hash);
+  ASSERT_TRUE(cache.open());
+  EXPECT_EQ(3u, cache.get_count());
+  expect_cached(&cache, 20, first);
+  expect_cached(&cache, 10, second);
+  expect_cached(&cache, 15, third);
+  DataSource::MaskImage parts;
+  EXPECT_FALSE(cache.get(11, &parts));
+
+  std::remove(cache_path);
+}
+
+TEST(SpriteCache, RejectsOtherData) {
+  {
+    SpriteCache cache(cache_path, cache_hash);
+    cache.add(1, DataSource::MaskImage(nullptr,
+                                       make_sprite(2, 2, 0, 0, 0, 0)));
+    ASSERT_TRUE(cache.save());
+  }
+
+  SpriteCache cache(cache_path, cache_hash + 1);
+  EXPECT_FALSE(cache.open());
+  EXPECT_EQ(0u, cache.get_count());
+  EXPECT_FALSE(cache.contains(1));
+
+  std::remove(cache_path);
+}
+
+TEST(SpriteCache, RejectsTruncatedFile) {
+  DataSource::MaskImage small(nullptr, make_sprite(2, 2, 0, 0, 0, 0));
+  DataSource::MaskImage large(nullptr, make_sprite(8, 8, 0, 0, 0, 0));
+  {
+    SpriteCache cache(cache_path, cache_hash);
+    cache.add(1, small);
+    cache.add(2, large);
+    ASSERT_TRUE(cache.save());
+  }
+  std::string data = read_file(cache_path);
+
+  // Pixels of the last sprite cut off
+  write_file(cache_path, data.substr(0, data.size() - 4));
+  {
+    SpriteCache cache(cache_path, cache_hash);
+    ASSERT_TRUE(cache.open());
+    expect_cached(&cache, 1, small);
+    DataSource::MaskImage parts;
+    EXPECT_FALSE(cache.get(2, &parts));
+
+    // The broken sprite is left out when the file is written again
+    ASSERT_TRUE(cache.save());
+    EXPECT_EQ(1u, cache.get_count());
+  }
+
+  // Index cut off
+  write_file(cache_path, data.substr(0, 40));
+  {
+    SpriteCache cache(cache_path, cache_hash);
+    EXPECT_FALSE(cache.open());
+    EXPECT_EQ(0u, cache.get_count());
+  }
+
+  // Header cut off
+  write_file(cache_path, data.substr(0, 8));
+  {
+    SpriteCache cache(cache_path, cache_hash);
+    EXPECT_FALSE(cache.open());
+  }
+
+  std::remove(cache_path);
+}
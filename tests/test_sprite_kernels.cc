@@ -0,0 +1,226 @@
+/*
+ * test_sprite_kernels.cc - Sprite kernel tests
+ *
+ * Copyright (C) 2026  freeserf developers
+ *
+ * This file is part of freeserf.
+ *
+ * freeserf is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * freeserf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with freeserf.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+#include "src/sprite-kernels.h"
+
+typedef std::vector<uint32_t> Pixels;
+
+/* Counts around the vector widths, plus a landscape tile. */
+static const size_t counts[] = { 0, 1, 3, 4, 5, 7, 8, 9, 15, 16, 17, 31, 33,
+                                 32 * 20 };
+
+/* Random pixels that often hit the special cases of the kernels. */
+static Pixels
+random_pixels(std::mt19937 *rnd, size_t count) {
+  Pixels pixels(count);
+  for (uint32_t &pixel : pixels) {
+    pixel = static_cast<uint32_t>((*rnd)());
+    switch ((*rnd)() % 5) {
+      case 0: pixel &= 0x00FFFFFF; break;
+      case 1: pixel |= 0xFF000000; break;
+      case 2: pixel = 0xFFFFFFFF; break;
+      default: break;
+    }
+  }
+  return pixels;
+}
+
+/* The vector kernels that can run here, to compare with the scalar ones. */
+static std::vector<SpriteKernels>
+vector_kernels() {
+  std::vector<SpriteKernels> result;
+  for (SpriteKernels::Level level : { SpriteKernels::LevelSSE2,
+                                      SpriteKernels::LevelAVX2 }) {
+    if (SpriteKernels::is_supported(level)) {
+      result.push_back(SpriteKernels::get_kernels(level));
+    }
+  }
+  return result;
+}
+
+static const SpriteKernels scalar =
+  SpriteKernels::get_kernels(SpriteKernels::LevelScalar);
+
+TEST(SpriteKernels, Mask) {
+  std::mt19937 rnd;
+  for (const SpriteKernels &kernels : vector_kernels()) {
+    for (size_t count : counts) {
+      Pixels a = random_pixels(&rnd, count);
+      Pixels b = random_pixels(&rnd, count);
+      Pixels expected(count), result(count);
+      scalar.mask(expected.data(), a.data(), b.data(), count);
+      kernels.mask(result.data(), a.data(), b.data(), count);
+      EXPECT_EQ(expected, result) << count << " pixels";
+    }
+  }
+}
+
+TEST(SpriteKernels, Compare) {
+  std::mt19937 rnd;
+  for (const SpriteKernels &kernels : vector_kernels()) {
+    for (size_t count : counts) {
+      Pixels a = random_pixels(&rnd, count);
+      Pixels b = random_pixels(&rnd, count);
+      for (size_t i = 0; i < count; i += 3) {
+        b[i] = a[i];
+      }
+      Pixels expected(count), result(count);
+      scalar.compare(expected.data(), a.data(), b.data(), count);
+      kernels.compare(result.data(), a.data(), b.data(), count);
+      EXPECT_EQ(expected, result) << count << " pixels";
+    }
+  }
+}
+
+TEST(SpriteKernels, FillMasked) {
+  std::mt19937 rnd;
+  for (const SpriteKernels &kernels : vector_kernels()) {
+    for (size_t count : counts) {
+      Pixels expected = random_pixels(&rnd, count);
+      Pixels result = expected;
+      uint32_t color = static_cast<uint32_t>(rnd());
+      scalar.fill_masked(expected.data(), color, count);
+      kernels.fill_masked(result.data(), color, count);
+      EXPECT_EQ(expected, result) << count << " pixels";
+    }
+  }
+}
+
+TEST(SpriteKernels, AddAndDel) {
+  std::mt19937 rnd;
+  for (const SpriteKernels &kernels : vector_kernels()) {
+    for (size_t count : counts) {
+      Pixels src = random_pixels(&rnd, count);
+      Pixels expected = random_pixels(&rnd, count);
+      Pixels result = expected;
+      scalar.add(expected.data(), src.data(), count);
+      kernels.add(result.data(), src.data(), count);
+      EXPECT_EQ(expected, result) << count << " pixels";
+
+      scalar.del(expected.data(), src.data(), count);
+      kernels.del(result.data(), src.data(), count);
+      EXPECT_EQ(expected, result) << count << " pixels";
+    }
+  }
+}
+
+TEST(SpriteKernels, Blend) {
+  std::mt19937 rnd;
+  for (const SpriteKernels &kernels : vector_kernels()) {
+    for (size_t count : counts) {
+      Pixels src = random_pixels(&rnd, count);
+      Pixels expected = random_pixels(&rnd, count);
+      Pixels result = expected;
+      scalar.blend(expected.data(), src.data(), count);
+      kernels.blend(result.data(), src.data(), count);
+      EXPECT_EQ(expected, result) << count << " pixels";
+    }
+  }
+}
+
+TEST(SpriteKernels, BlendAllColors) {
+  /* Every channel value against every alpha, on a varying background. */
+  for (const SpriteKernels &kernels : vector_kernels()) {
+    Pixels src, back;
+    for (uint32_t alpha = 0; alpha < 0x100; alpha++) {
+      for (uint32_t c = 0; c < 0x100; c++) {
+        src.push_back((alpha << 24) | (c << 16) | ((0xFF - c) << 8) | c);
+        back.push_back(0xFF000000 | (c << 8) | (alpha ^ c));
+      }
+    }
+    Pixels expected = back;
+    Pixels result = back;
+    scalar.blend(expected.data(), src.data(), src.size());
+    kernels.blend(result.data(), src.data(), src.size());
+    EXPECT_EQ(expected, result);
+  }
+}
+
+TEST(SpriteKernels, Stick) {
+  std::mt19937 rnd;
+  for (const SpriteKernels &kernels : vector_kernels()) {
+    for (size_t count : counts) {
+      Pixels src = random_pixels(&rnd, count);
+      Pixels expected = random_pixels(&rnd, count);
+      Pixels result = expected;
+      scalar.stick(expected.data(), src.data(), count);
+      kernels.stick(result.data(), src.data(), count);
+      EXPECT_EQ(expected, result) << count << " pixels";
+    }
+  }
+}
+
+TEST(SpriteKernels, AlphaMask) {
+  std::mt19937 rnd;
+  for (const SpriteKernels &kernels : vector_kernels()) {
+    for (size_t count : counts) {
+      Pixels expected = random_pixels(&rnd, count);
+      Pixels result = expected;
+      uint8_t expected_min = scalar.alpha_from_luminance(expected.data(),
+                                                         count);
+      uint8_t min = kernels.alpha_from_luminance(result.data(), count);
+      EXPECT_EQ(expected_min, min) << count << " pixels";
+      EXPECT_EQ(expected, result) << count << " pixels";
+
+      scalar.lower_alpha(expected.data(), expected_min, count);
+      kernels.lower_alpha(result.data(), min, count);
+      EXPECT_EQ(expected, result) << count << " pixels";
+    }
+  }
+}
+
+TEST(SpriteKernels, AlphaMaskAllColors) {
+  for (const SpriteKernels &kernels : vector_kernels()) {
+    Pixels expected;
+    for (uint32_t c = 0; c < 0x1000000; c += 0x010101) {
+      for (uint32_t d = 0; d < 0x100; d += 5) {
+        expected.push_back(0x80000000 | (c ^ (d << 8)));
+      }
+    }
+    Pixels result = expected;
+    EXPECT_EQ(scalar.alpha_from_luminance(expected.data(),
+                                          expected.size()),
+              kernels.alpha_from_luminance(result.data(), result.size()));
+    EXPECT_EQ(expected, result);
+  }
+}
+
+TEST(SpriteKernels, LowerAlphaWraps) {
+  std::mt19937 rnd;
+  for (const SpriteKernels &kernels : vector_kernels()) {
+    Pixels expected = random_pixels(&rnd, 33);
+    Pixels result = expected;
+    scalar.lower_alpha(expected.data(), 0xC0, expected.size());
+    kernels.lower_alpha(result.data(), 0xC0, result.size());
+    EXPECT_EQ(expected, result);
+  }
+}
+
+TEST(SpriteKernels, BestLevelIsSupported) {
+  SpriteKernels::Level level = SpriteKernels::get_best_level();
+  EXPECT_TRUE(SpriteKernels::is_supported(level));
+  EXPECT_EQ(level, SpriteKernels::get_instance().get_level());
+}
@@ -0,0 +1,118 @@
+/*
+ * test_thread_pool.cc - test for thread pool
+ *
+ * Copyright (C) 2026  freeserf developers
+ *
+ * This file is part of freeserf.
+ *
+ * freeserf is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * freeserf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with freeserf.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include <atomic>  // NOLINT(build/c++11)
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "src/thread-pool.h"
+#include "src/game.h"
+#include "src/random.h"
+#include "src/savegame.h"
+#include "src/debug.h"
+
+TEST(ThreadPool, RunsAllTasks) {
+  ThreadPool pool(4);
+  EXPECT_EQ(4u, pool.get_thread_count());
+
+  std::atomic<int> count(0);
+  for (int i = 0; i < 1000; i++) {
+    pool.run([&count]() { count++; });
+  }
+  pool.wait();
+  EXPECT_EQ(1000, count);
+
+  // The pool can be reused after waiting
+  pool.run([&count]() { count++; });
+  pool.wait();
+  EXPECT_EQ(1001, count);
+}
+
+TEST(ThreadPool, RunFor) {
+  ThreadPool pool(4);
+
+  std::vector<int> results(1000, 0);
+  pool.run_for(results.size(), [&results](size_t i) {
+    results[i] = static_cast<int>(i) * 2;
+  });
+  for (size_t i = 0; i < results.size(); i++) {
+    EXPECT_EQ(static_cast<int>(i) * 2, results[i]);
+  }
+
+  // Batches can be run from a task of the same pool
+  std::atomic<int> count(0);
+  for (int i = 0; i < 8; i++) {
+    pool.run([&pool, &count]() {
+      pool.run_for(100, [&count](size_t) { count++; });
+    });
+  }
+  pool.wait();
+  EXPECT_EQ(800, count);
+
+  // Failures are passed on to the caller once all calls have completed
+  count = 0;
+  EXPECT_THROW(pool.run_for(100, [&count](size_t i) {
+    count++;
+    if (i == 10) throw ExceptionFreeserf("test");
+  }), ExceptionFreeserf);
+  EXPECT_EQ(100, count);
+}
+
+static std::string
+run_game(const std::string &seed) {
+  Game game;
+  game.init(3, Random(seed));
+  game.set_random(Random(seed));
+  game.add_player(35, 30, 40);
+  game.build_castle(game.get_map()->pos(6, 6), game.get_player(0));
+  for (int i = 0; i < 500; i++) game.update();
+
+  std::stringstream str;
+  GameStore::get_instance().write(&str, &game);
+  return str.str();
+}
+
+TEST(ThreadPool, ConcurrentGames) {
+  const char *seeds[] = {
+    "8667715887436237", "2831713285431227", "4632253338621228",
+    "8667715887436237"
+  };
+  const size_t count = sizeof(seeds) / sizeof(seeds[0]);
+
+  std::vector<std::string> results(count);
+  ThreadPool pool(count);
+  for (size_t i = 0; i < count; i++) {
+    std::string *result = &results[i];
+    const char *seed = seeds[i];
+    pool.run([result, seed]() { *result = run_game(seed); });
+  }
+  pool.wait();
+
+  // Games must not influence each other
+  for (size_t i = 0; i < count; i++) {
+    EXPECT_EQ(run_game(seeds[i]), results[i]);
+  }
+  EXPECT_EQ(results[0], results[3]);
+}
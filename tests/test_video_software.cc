@@ -0,0 +1,52 @@
+/*
+ * test_video_software.cc - Software video backend tests
+ *
+ * Copyright (C) 2026  freeserf developers
+ *
+ * This file is part of freeserf.
+ *
+ * freeserf is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * freeserf is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with freeserf.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtest/gtest.h>
+
+#include "src/video-software.h"
+
+TEST(VideoSoftware, BlendPixel) {
+  // Opaque and fully transparent pixels replace or keep the background
+  EXPECT_EQ(0xff123456u, VideoSoftware::blend_pixel(0xff0000ff, 0xff123456));
+  EXPECT_EQ(0xff0000ffu, VideoSoftware::blend_pixel(0xff0000ff, 0x00123456));
+  EXPECT_EQ(0x00000000u, VideoSoftware::blend_pixel(0x00000000, 0x00ffffff));
+
+  // Half red over blue, channels are rounded
+  EXPECT_EQ(0xff80007fu, VideoSoftware::blend_pixel(0xff0000ff, 0x80ff0000));
+
+  // Colors are not premultiplied, so they darken on a transparent background
+  EXPECT_EQ(0x80808080u, VideoSoftware::blend_pixel(0x00000000, 0x80ffffff));
+  EXPECT_EQ(0xffffffffu, VideoSoftware::blend_pixel(0xffffffff, 0x01ffffff));
+}
+
+TEST(VideoSoftware, TintPixel) {
+  // White keeps the pixel, black clears it
+  Video::Color white = {0xff, 0xff, 0xff, 0xff};
+  Video::Color black = {0x00, 0x00, 0x00, 0x00};
+  EXPECT_EQ(0x80c04020u, VideoSoftware::tint_pixel(0x80c04020, white));
+  EXPECT_EQ(0x00000000u, VideoSoftware::tint_pixel(0x80c04020, black));
+
+  // Each channel is scaled by its own component, rounded
+  Video::Color color = {0xff, 0x00, 0x80, 0xff};
+  EXPECT_EQ(0xff400040u, VideoSoftware::tint_pixel(0xff40c080, color));
+  Video::Color half = {0xff, 0xff, 0xff, 0x80};
+  EXPECT_EQ(0x80ffffffu, VideoSoftware::tint_pixel(0xffffffff, half));
+}